@@ -0,0 +1,124 @@
+import os
+import re
+from datetime import datetime
+from fastapi import APIRouter, Depends, HTTPException, Request
+from fastapi.responses import FileResponse, JSONResponse
+from sqlalchemy.ext.asyncio import AsyncSession
+from sqlalchemy import select
+from backend.app.database import get_session
+from backend.app.models import AudioClip, Node
+from backend.app.schemas import ClipCreate, ClipStatus
+
+router = APIRouter(prefix="/clips", tags=["clips"])
+
+# Raw encoded blocks are stored as <CLIP_STORAGE_DIR>/<node_id>/<clip_id>.<codec>
+CLIP_STORAGE_DIR = os.getenv("CLIP_STORAGE_DIR", "clips")
+MAX_CLIP_BYTES = 1024 * 1024
+# IDs become path components, so no separators or dot-only names
+NODE_ID_RE = re.compile(r"^[A-Za-z0-9_-]{1,64}$")
+CLIP_ID_RE = re.compile(r"^[A-Za-z0-9_-]{1,96}$")
+
+
+def _status(clip: AudioClip) -> dict:
+    return {
+        "clip_id": clip.clip_id,
+        "received": clip.received_bytes,
+        "total": clip.total_bytes,
+        "complete": clip.received_bytes >= clip.total_bytes,
+    }
+
+
+@router.post("/", response_model=ClipStatus)
+async def register_clip(data: ClipCreate, session: AsyncSession = Depends(get_session)):
+    if data.total_bytes <= 0 or data.total_bytes > MAX_CLIP_BYTES:
+        raise HTTPException(status_code=400, detail="Invalid clip size")
+    if not (CLIP_ID_RE.match(data.clip_id) and NODE_ID_RE.match(data.node_id) and data.codec.isalnum()):
+        raise HTTPException(status_code=400, detail="Invalid clip or node id")
+
+    # Re-registering an existing clip is how a device resumes after a reboot;
+    # anything else under the same ID must not append to its bytes
+    clip = await session.get(AudioClip, data.clip_id)
+    if clip:
+        if (clip.node_id, clip.total_bytes, clip.codec) != (data.node_id, data.total_bytes, data.codec):
+            raise HTTPException(status_code=409, detail="Clip id already registered with different metadata")
+        return _status(clip)
+
+    node = await session.get(Node, data.node_id)
+    if not node:
+        session.add(Node(node_id=data.node_id, name=f"Auto-Reg: {data.node_id}", last_seen_at=datetime.utcnow()))
+        await session.flush()
+
+    node_dir = os.path.join(CLIP_STORAGE_DIR, data.node_id)
+    os.makedirs(node_dir, exist_ok=True)
+    clip = AudioClip(
+        clip_id=data.clip_id,
+        node_id=data.node_id,
+        codec=data.codec,
+        sample_rate=data.sample_rate,
+        block_samples=data.block_samples,
+        block_bytes=data.block_bytes,
+        total_bytes=data.total_bytes,
+        received_bytes=0,
+        pre_trigger_ms=data.pre_trigger_ms,
+        label=data.label,
+        confidence=data.confidence,
+        path=os.path.join(node_dir, f"{data.clip_id}.{data.codec}"),
+    )
+    session.add(clip)
+    await session.commit()
+    return _status(clip)
+
+
+@router.put("/{clip_id}/chunks")
+async def upload_chunk(clip_id: str, offset: int, request: Request, session: AsyncSession = Depends(get_session)):
+    clip = await session.get(AudioClip, clip_id)
+    if not clip:
+        raise HTTPException(status_code=404, detail="Unknown clip")
+
+    # Only contiguous appends; a gap means the device must resume from "received"
+    if offset > clip.received_bytes:
+        return JSONResponse(status_code=409, content=_status(clip))
+
+    data = await request.body()
+    if offset + len(data) > clip.total_bytes:
+        raise HTTPException(status_code=400, detail="Chunk exceeds clip size")
+
+    # Overlapping resends rewrite identical bytes, so retries are idempotent
+    mode = "r+b" if os.path.exists(clip.path) else "wb"
+    with open(clip.path, mode) as f:
+        f.seek(offset)
+        f.write(data)
+
+    clip.received_bytes = max(clip.received_bytes, offset + len(data))
+    if clip.received_bytes >= clip.total_bytes and clip.completed_at is None:
+        clip.completed_at = datetime.utcnow()
+    await session.commit()
+    return _status(clip)
+
+
+@router.get("/{clip_id}", response_model=ClipStatus)
+async def get_clip_status(clip_id: str, session: AsyncSession = Depends(get_session)):
+    clip = await session.get(AudioClip, clip_id)
+    if not clip:
+        raise HTTPException(status_code=404, detail="Unknown clip")
+    return _status(clip)
+
+
+@router.get("/{clip_id}/audio")
+async def download_clip(clip_id: str, session: AsyncSession = Depends(get_session)):
+    clip = await session.get(AudioClip, clip_id)
+    if not clip or not os.path.exists(clip.path):
+        raise HTTPException(status_code=404, detail="Unknown clip")
+    return FileResponse(clip.path, media_type="application/octet-stream", filename=os.path.basename(clip.path))
+
+
+@router.get("/")
+async def list_clips(node_id: str, limit: int = 20, session: AsyncSession = Depends(get_session)):
+    stmt = (
+        select(AudioClip)
+        .where(AudioClip.node_id == node_id)
+        .order_by(AudioClip.created_at.desc())
+        .limit(limit)
+    )
+    result = await session.execute(stmt)
+    return result.scalars().all()
@@ -1,3 +1,7 @@
+import asyncio
+import uuid
+from datetime import datetime
+from typing import Optional
 from fastapi import APIRouter, Depends
 from sqlalchemy.ext.asyncio import AsyncSession
 from sqlalchemy import select
@@ -7,15 +11,92 @@ from backend.app.schemas import CommandCreate, CommandResponse
 
 router = APIRouter(prefix="/commands", tags=["commands"])
 
+# Long-poll: GET /pending?wait=N parks until a command is queued for the node
+# or N seconds pass. Waiters are per process; with several workers a command
+# queued on another worker is picked up when the wait expires.
+#
+# Delivery is acknowledged when the caller passes `ack` (the firmware always
+# does, possibly empty): a command stays pending, and is returned again, until
+# a later request lists its id in `ack`. A parked request left on a half-open
+# socket can then only write commands into the void, not lose them. Without
+# `ack`, returned commands are marked sent at once, as before.
+MAX_WAIT_S = 55
+MAX_BATCH = 4           # commands per acknowledged response; CMD_ACK_MAX on the node
+_waiters: dict[str, set[asyncio.Event]] = {}
+
+
+def _notify(node_id: str):
+    for event in _waiters.get(node_id, ()):
+        event.set()
+
+
+def _ack_ids(ack: str) -> list[uuid.UUID]:
+    ids = []
+    for part in ack.split(","):
+        try:
+            ids.append(uuid.UUID(part))
+        except ValueError:
+            pass
+    return ids
+
+
+async def _take_pending(session: AsyncSession, node_id: str, ack: Optional[str] = None) -> list[Command]:
+    """Returns pending commands. Without `ack` they are marked sent, so each is
+    delivered once; with it, the listed commands are marked sent and the rest
+    stay pending until a later request acknowledges them."""
+    now = datetime.utcnow()
+    if ack:
+        stmt = select(Command).where(Command.node_id == node_id, Command.status == "pending",
+                                     Command.command_id.in_(_ack_ids(ack)))
+        for cmd in (await session.execute(stmt)).scalars().all():
+            cmd.status = "sent"
+            cmd.sent_at = now
+    stmt = select(Command).where(Command.node_id == node_id, Command.status == "pending").order_by(Command.created_at)
+    if ack is not None:
+        stmt = stmt.limit(MAX_BATCH)
+    result = await session.execute(stmt)
+    cmds = result.scalars().all()
+    if ack is None:
+        for cmd in cmds:
+            cmd.status = "sent"
+            cmd.sent_at = now
+    # Always end the transaction: a parked long-poll must not hold a connection
+    await session.commit()
+    return cmds
+
+
 @router.post("/", response_model=CommandResponse)
 async def queue_command(data: CommandCreate, session: AsyncSession = Depends(get_session)):
     cmd = Command(node_id=data.node_id, command_type=data.command_type, params=data.params)
     session.add(cmd)
     await session.commit()
+    _notify(data.node_id)
     return {"command_id": cmd.command_id, "status": "pending"}
 
+
 @router.get("/pending")
-async def get_pending_commands(node_id: str, session: AsyncSession = Depends(get_session)):
-    stmt = select(Command).where(Command.node_id == node_id, Command.status == "pending")
-    result = await session.execute(stmt)
-    return result.scalars().all()
+async def get_pending_commands(node_id: str, wait: float = 0, ack: Optional[str] = None,
+                               session: AsyncSession = Depends(get_session)):
+    wait = max(0.0, min(wait, MAX_WAIT_S))
+    if wait == 0:
+        return await _take_pending(session, node_id, ack)
+
+    # Register before the first check so a command queued in between still wakes us
+    event = asyncio.Event()
+    _waiters.setdefault(node_id, set()).add(event)
+    try:
+        cmds = await _take_pending(session, node_id, ack)
+        if cmds:
+            return cmds
+        try:
+            await asyncio.wait_for(event.wait(), timeout=wait)
+        except asyncio.TimeoutError:
+            return []
+        # The acknowledgement is already applied; keep ack mode without repeating it
+        return await _take_pending(session, node_id, "" if ack is not None else None)
+    finally:
+        waiters = _waiters.get(node_id)
+        if waiters is not None:
+            waiters.discard(event)
+            if not waiters:
+                del _waiters[node_id]
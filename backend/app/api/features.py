@@ -0,0 +1,38 @@
+from fastapi import APIRouter, Depends
+from sqlalchemy.ext.asyncio import AsyncSession
+from sqlalchemy import select
+from backend.app.database import get_session
+from backend.app.models import FeatureVector, Node
+from backend.app.schemas import FeatureCreate, record_time
+from datetime import datetime
+
+router = APIRouter(prefix="/features", tags=["features"])
+
+@router.post("/")
+async def create_features(data: FeatureCreate, session: AsyncSession = Depends(get_session)):
+    node = await session.get(Node, data.node_id)
+    if not node:
+        session.add(Node(node_id=data.node_id, name=f"Node {data.node_id}", last_seen_at=datetime.utcnow()))
+        await session.flush()
+
+    entry = FeatureVector(
+        time=record_time(data.timestamp, data.age_ms),
+        node_id=data.node_id,
+        model_type=data.model_type,
+        density=data.density,
+        values=data.values
+    )
+    session.add(entry)
+    await session.commit()
+    return {"status": "ok"}
+
+@router.get("/")
+async def get_features(node_id: str, limit: int = 100, session: AsyncSession = Depends(get_session)):
+    stmt = (
+        select(FeatureVector)
+        .where(FeatureVector.node_id == node_id)
+        .order_by(FeatureVector.time.desc())
+        .limit(limit)
+    )
+    result = await session.execute(stmt)
+    return list(reversed(result.scalars().all()))
@@ -3,7 +3,7 @@ from sqlalchemy.ext.asyncio import AsyncSession
 from sqlalchemy import select
 from backend.app.database import get_session
 from backend.app.models import InferenceResult
-from backend.app.schemas import InferenceCreate
+from backend.app.schemas import InferenceCreate, record_time
 from datetime import datetime
 
 router = APIRouter(prefix="/inference", tags=["inference"])
@@ -11,7 +11,7 @@ router = APIRouter(prefix="/inference", tags=["inference"])
 @router.post("/")
 async def create_inference(data: InferenceCreate, session: AsyncSession = Depends(get_session)):
     entry = InferenceResult(
-        time=data.timestamp or datetime.utcnow(),
+        time=record_time(data.timestamp, data.age_ms),
         node_id=data.node_id,
         model_type=data.model_type,
         classification=data.classification,
@@ -3,7 +3,7 @@ from sqlalchemy.ext.asyncio import AsyncSession
 from sqlalchemy import select
 from backend.app.database import get_session
 from backend.app.models import Telemetry, Node
-from backend.app.schemas import TelemetryCreate
+from backend.app.schemas import TelemetryCreate, record_time
 from datetime import datetime
 
 router = APIRouter(prefix="/telemetry", tags=["telemetry"])
@@ -18,7 +18,7 @@ async def create_telemetry(data: TelemetryCreate, session: AsyncSession = Depend
         node.last_seen_at = datetime.utcnow()
 
     entry = Telemetry(
-        time=data.timestamp or datetime.utcnow(),
+        time=record_time(data.timestamp, data.age_ms),
         node_id=data.node_id,
         temperature_c=data.temperature_c,
         humidity_pct=data.humidity_pct,
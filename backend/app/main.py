@@ -1,7 +1,7 @@
 from fastapi import FastAPI
 from contextlib import asynccontextmanager
 from .database import init_db
-from .api import telemetry, commands, inference, logs
+from .api import telemetry, commands, inference, logs, clips, features
 
 @asynccontextmanager
 async def lifespan(app: FastAPI):
@@ -14,6 +14,8 @@ app.include_router(telemetry.router, prefix="/api/v1")
 app.include_router(inference.router, prefix="/api/v1")
 app.include_router(commands.router, prefix="/api/v1")
 app.include_router(logs.router, prefix="/api/v1")
+app.include_router(clips.router, prefix="/api/v1")
+app.include_router(features.router, prefix="/api/v1")
 
 @app.get("/health")
 def health():
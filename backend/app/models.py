@@ -33,6 +33,14 @@ class InferenceResult(Base):
     anomaly_score = Column(Float)
     raw_outputs = Column(JSONB)
 
+class FeatureVector(Base):
+    __tablename__ = "feature_vectors"
+    time = Column(DateTime(timezone=True), primary_key=True, nullable=False)
+    node_id = Column(String(64), ForeignKey("nodes.node_id"), primary_key=True)
+    model_type = Column(String(16))
+    density = Column(Float)
+    values = Column(JSONB)
+
 class Command(Base):
     __tablename__ = "commands"
     command_id = Column(UUID(as_uuid=True), primary_key=True, default=uuid.uuid4)
@@ -49,4 +57,21 @@ class DeviceLog(Base):
     log_id = Column(Integer, primary_key=True, autoincrement=True)
     node_id = Column(String(64), ForeignKey("nodes.node_id"))
     message = Column(Text)
-    created_at = Column(DateTime(timezone=True), default=datetime.utcnow)
\ No newline at end of file
+    created_at = Column(DateTime(timezone=True), default=datetime.utcnow)
+
+class AudioClip(Base):
+    __tablename__ = "audio_clips"
+    clip_id = Column(String(96), primary_key=True)
+    node_id = Column(String(64), ForeignKey("nodes.node_id"))
+    codec = Column(String(16))
+    sample_rate = Column(Integer)
+    block_samples = Column(Integer)
+    block_bytes = Column(Integer)
+    total_bytes = Column(Integer)
+    received_bytes = Column(Integer, default=0)
+    pre_trigger_ms = Column(Integer)
+    label = Column(String(64))
+    confidence = Column(Float)
+    path = Column(Text)
+    created_at = Column(DateTime(timezone=True), default=datetime.utcnow)
+    completed_at = Column(DateTime(timezone=True))
@@ -1,6 +1,6 @@
 from pydantic import BaseModel
-from datetime import datetime
-from typing import Optional, Dict, Any
+from datetime import datetime, timedelta
+from typing import Optional, Dict, Any, List
 from uuid import UUID
 
 class TelemetryCreate(BaseModel):
@@ -11,6 +11,7 @@ class TelemetryCreate(BaseModel):
     battery_mv: int
     rssi_dbm: Optional[int] = None
     error_flags: int = 0
+    age_ms: Optional[int] = None    # replayed from the device log: time since capture
 
 class InferenceCreate(BaseModel):
     node_id: str
@@ -20,6 +21,15 @@ class InferenceCreate(BaseModel):
     confidence: Optional[float] = None
     anomaly_score: Optional[float] = None
     raw_outputs: Optional[Dict[str, float]] = None
+    age_ms: Optional[int] = None
+
+class FeatureCreate(BaseModel):
+    node_id: str
+    timestamp: Optional[datetime] = None
+    model_type: str = "summer"
+    density: float
+    values: List[float]
+    age_ms: Optional[int] = None
 
 class CommandCreate(BaseModel):
     node_id: str
@@ -29,3 +39,30 @@ class CommandCreate(BaseModel):
 class CommandResponse(BaseModel):
     command_id: UUID
     status: str
+
+class ClipCreate(BaseModel):
+    clip_id: str
+    node_id: str
+    codec: str
+    sample_rate: int
+    block_samples: int
+    block_bytes: int
+    total_bytes: int
+    pre_trigger_ms: int = 0
+    label: Optional[str] = None
+    confidence: Optional[float] = None
+
+class ClipStatus(BaseModel):
+    clip_id: str
+    received: int
+    total: int
+    complete: bool
+
+
+def record_time(timestamp: Optional[datetime], age_ms: Optional[int]) -> datetime:
+    """Explicit timestamp, else receive time minus the age reported by the device."""
+    if timestamp:
+        return timestamp
+    if age_ms:
+        return datetime.utcnow() - timedelta(milliseconds=age_ms)
+    return datetime.utcnow()
@@ -0,0 +1,142 @@
+"""
+Minimal HTTP/1.1 server with the command endpoints of the API, a stand-in for
+the FastAPI backend and its database in local tests of the command channel.
+
+Implements what fleet_sim.py, mqtt_bridge.py and the firmware use:
+
+    POST /api/v1/commands/                          queue a command
+    GET  /api/v1/commands/pending?node_id=X[&wait=S][&ack=ID,...]
+
+with the semantics of backend/app/api/commands.py (long-poll waiters, ack
+delivery, MAX_BATCH), kept in memory. Connections are keep-alive unless the
+client sends "Connection: close". Everything else answers 404.
+
+    python -m backend.scripts.api_standin --port 8000
+"""
+import argparse
+import asyncio
+import json
+import uuid
+from datetime import datetime
+from urllib.parse import parse_qs, urlsplit
+
+MAX_WAIT_S = 55
+MAX_BATCH = 4
+PREFIX = "/api/v1/commands"
+
+
+class CommandStore:
+    def __init__(self):
+        self.commands = []      # dicts in queue order
+        self.waiters = {}       # node_id -> set of asyncio.Event
+
+    def queue(self, node_id, command_type, params):
+        cmd = {"command_id": str(uuid.uuid4()), "node_id": node_id, "command_type": command_type,
+               "params": params, "status": "pending", "created_at": datetime.utcnow().isoformat(),
+               "sent_at": None, "completed_at": None}
+        self.commands.append(cmd)
+        for event in self.waiters.get(node_id, ()):
+            event.set()
+        return cmd
+
+    def take(self, node_id, ack=None):
+        now = datetime.utcnow().isoformat()
+        if ack:
+            ids = set(ack.split(","))
+            for cmd in self.commands:
+                if cmd["node_id"] == node_id and cmd["status"] == "pending" and cmd["command_id"] in ids:
+                    cmd["status"], cmd["sent_at"] = "sent", now
+        cmds = [c for c in self.commands if c["node_id"] == node_id and c["status"] == "pending"]
+        if ack is None:
+            for cmd in cmds:
+                cmd["status"], cmd["sent_at"] = "sent", now
+        else:
+            cmds = cmds[:MAX_BATCH]
+        self.commands = [c for c in self.commands if c["status"] == "pending"]
+        return [dict(c) for c in cmds]
+
+    async def pending(self, node_id, wait, ack):
+        wait = max(0.0, min(wait, MAX_WAIT_S))
+        if wait == 0:
+            return self.take(node_id, ack)
+        event = asyncio.Event()
+        self.waiters.setdefault(node_id, set()).add(event)
+        try:
+            cmds = self.take(node_id, ack)
+            if cmds:
+                return cmds
+            try:
+                await asyncio.wait_for(event.wait(), timeout=wait)
+            except asyncio.TimeoutError:
+                return []
+            return self.take(node_id, "" if ack is not None else None)
+        finally:
+            waiters = self.waiters.get(node_id)
+            if waiters is not None:
+                waiters.discard(event)
+                if not waiters:
+                    del self.waiters[node_id]
+
+
+class Server:
+    def __init__(self):
+        self.store = CommandStore()
+        self.requests = 0
+
+    async def route(self, method, target, body):
+        url = urlsplit(target)
+        q = {k: v[-1] for k, v in parse_qs(url.query, keep_blank_values=True).items()}
+        path = url.path.rstrip("/")
+        if method == "POST" and path == PREFIX:
+            data = json.loads(body or b"{}")
+            cmd = self.store.queue(data["node_id"], data["command_type"], data.get("params"))
+            return 200, {"command_id": cmd["command_id"], "status": "pending"}
+        if method == "GET" and path == PREFIX + "/pending" and "node_id" in q:
+            return 200, await self.store.pending(q["node_id"], float(q.get("wait", 0)), q.get("ack"))
+        return 404, {"detail": "Not Found"}
+
+    async def handle(self, reader, writer):
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                method, target, _ = line.decode().split(" ", 2)
+                headers = {}
+                while (h := await reader.readline()) not in (b"\r\n", b"\n", b""):
+                    k, _, v = h.decode().partition(":")
+                    headers[k.strip().lower()] = v.strip()
+                body = await reader.readexactly(int(headers.get("content-length", 0)))
+                self.requests += 1
+                status, payload = await self.route(method, target, body)
+                out = json.dumps(payload).encode()
+                close = headers.get("connection", "").lower() == "close"
+                writer.write(f"HTTP/1.1 {status} {'OK' if status == 200 else 'Not Found'}\r\n"
+                             f"content-type: application/json\r\ncontent-length: {len(out)}\r\n"
+                             f"connection: {'close' if close else 'keep-alive'}\r\n\r\n".encode() + out)
+                await writer.drain()
+                if close:
+                    break
+        except (ConnectionError, asyncio.IncompleteReadError, ValueError):
+            pass
+        finally:
+            writer.close()
+
+
+async def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8000)
+    args = parser.parse_args()
+    server = Server()
+    srv = await asyncio.start_server(server.handle, args.host, args.port, limit=1 << 16)
+    print(f"[API] Command stand-in on {args.host}:{args.port}")
+    async with srv:
+        await srv.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        print("\nShutdown")
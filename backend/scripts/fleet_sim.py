@@ -0,0 +1,191 @@
+"""
+Simulated fleet for the command channel: compares the old 2 s polling against
+long-poll on the same backend.
+
+Each simulated node fetches commands the way the firmware does, while a
+commander queues commands for random nodes. Reports idle request rate per
+node and queue-to-delivery latency.
+
+In longpoll mode nodes acknowledge each response on their next request, as
+the firmware does (--no-ack: the old fetch-marks-sent behaviour). --drop P
+makes a node abandon a fraction P of its parked requests part-way, as after
+a WiFi drop: the request stays parked on the server, its answer is never
+read, and the node carries on over a new connection. Commands that only such
+a request took show up as undelivered.
+
+    python -m backend.scripts.fleet_sim --nodes 50 --duration 120 --mode poll
+    python -m backend.scripts.fleet_sim --nodes 50 --duration 120 --mode longpoll
+    python -m backend.scripts.fleet_sim --nodes 50 --duration 120 --mode longpoll --drop 0.2
+"""
+import argparse
+import asyncio
+import random
+import statistics
+import time
+
+import httpx
+
+
+class Stats:
+    def __init__(self):
+        self.requests = 0
+        self.connections = 0
+        self.errors = 0
+        self.drops = 0
+        self.queued = {}        # command_id -> monotonic time queued
+        self.early = {}         # command_id -> time delivered before the commander saw its id
+        self.latencies = []
+
+
+class SimNode:
+    def __init__(self, node_id, api_url, mode, stats, poll_s, wait_s, ack=True, drop=0.0):
+        self.node_id = node_id
+        self.api_url = api_url
+        self.mode = mode
+        self.stats = stats
+        self.poll_s = poll_s
+        self.wait_s = wait_s
+        self.ack = ack
+        self.drop = drop
+        self.abandoned = set()
+
+    def deliver(self, cmds):
+        now = time.monotonic()
+        for cmd in cmds:
+            t0 = self.stats.queued.pop(str(cmd["command_id"]), None)
+            if t0 is not None:
+                self.stats.latencies.append(now - t0)
+            else:
+                self.stats.early.setdefault(str(cmd["command_id"]), now)
+
+    async def run_poll(self):
+        # Firmware before long-poll: a fresh connection ("Connection: close") every poll_s
+        while True:
+            async with httpx.AsyncClient(timeout=5.0) as client:
+                self.stats.connections += 1
+                self.stats.requests += 1
+                try:
+                    r = await client.get(f"{self.api_url}/commands/pending",
+                                         params={"node_id": self.node_id}, headers={"Connection": "close"})
+                    self.deliver(r.json())
+                except Exception:
+                    self.stats.errors += 1
+            await asyncio.sleep(self.poll_s)
+
+    async def run_longpoll(self):
+        # One keep-alive connection, one request parked on it at a time
+        ack = []
+        while True:
+            client = httpx.AsyncClient(timeout=self.wait_s + 10, limits=httpx.Limits(max_connections=1))
+            self.stats.connections += 1
+            while True:
+                self.stats.requests += 1
+                params = {"node_id": self.node_id, "wait": self.wait_s}
+                if self.ack:
+                    params["ack"] = ",".join(ack)
+                req = asyncio.create_task(client.get(f"{self.api_url}/commands/pending", params=params))
+                if random.random() < self.drop:
+                    await asyncio.wait([req], timeout=random.uniform(0, self.wait_s))
+                    if not req.done():
+                        self.abandon(client, req)
+                        break
+                try:
+                    r = await req
+                    cmds = r.json()
+                    self.deliver(cmds)
+                    ack = [str(c["command_id"]) for c in cmds]
+                except Exception:
+                    self.stats.errors += 1
+                    await asyncio.sleep(1)
+
+    def abandon(self, client, req):
+        # Leave the request parked and its connection open; close it unread once answered
+        self.stats.drops += 1
+        self.abandoned.add(req)
+
+        def done(task):
+            self.abandoned.discard(task)
+            asyncio.ensure_future(client.aclose())
+        req.add_done_callback(done)
+
+    async def run(self):
+        # Stagger start so polls are not synchronised
+        await asyncio.sleep(random.uniform(0, self.poll_s))
+        await (self.run_poll() if self.mode == "poll" else self.run_longpoll())
+
+
+async def commander(api_url, node_ids, stats, interval_s):
+    async with httpx.AsyncClient(timeout=5.0) as client:
+        while True:
+            await asyncio.sleep(random.expovariate(1.0 / interval_s))
+            node_id = random.choice(node_ids)
+            t0 = time.monotonic()
+            try:
+                r = await client.post(f"{api_url}/commands/", json={"node_id": node_id, "command_type": "PING"})
+                command_id = str(r.json()["command_id"])
+                # A parked node can have it before the POST returns
+                if command_id in stats.early:
+                    stats.latencies.append(stats.early.pop(command_id) - t0)
+                else:
+                    stats.queued[command_id] = t0
+            except Exception:
+                stats.errors += 1
+
+
+async def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--api", default="http://localhost:8000/api/v1", help="API URL")
+    parser.add_argument("--nodes", type=int, default=20)
+    parser.add_argument("--duration", type=float, default=120, help="seconds")
+    parser.add_argument("--mode", choices=["poll", "longpoll"], default="longpoll")
+    parser.add_argument("--poll", type=float, default=2.0, help="poll interval in poll mode")
+    parser.add_argument("--wait", type=float, default=50.0, help="long-poll wait")
+    parser.add_argument("--cmd-interval", type=float, default=10.0, help="mean seconds between commands (fleet-wide)")
+    parser.add_argument("--no-ack", action="store_true", help="longpoll without acknowledging responses")
+    parser.add_argument("--drop", type=float, default=0.0, help="fraction of long-polls a node abandons part-way")
+    parser.add_argument("--settle", type=float, help="seconds after the last command before counting "
+                        "(default 5, or the long-poll wait with --drop: an abandoning node rejoins that late)")
+    args = parser.parse_args()
+    if args.settle is None:
+        args.settle = args.wait if args.drop else 5.0
+
+    stats = Stats()
+    node_ids = [f"sim-node-{i:03d}" for i in range(args.nodes)]
+    nodes = [SimNode(n, args.api, args.mode, stats, args.poll, args.wait, not args.no_ack, args.drop)
+             for n in node_ids]
+    tasks = [asyncio.create_task(n.run()) for n in nodes]
+    t0 = time.monotonic()
+    cmd_task = asyncio.create_task(commander(args.api, node_ids, stats, args.cmd_interval))
+    try:
+        await asyncio.sleep(args.duration)
+        # Stop queueing and let the last commands reach their nodes
+        cmd_task.cancel()
+        await asyncio.sleep(args.settle)
+    finally:
+        tasks += [cmd_task] + [t for n in nodes for t in n.abandoned]
+        for t in tasks:
+            t.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+
+    elapsed = time.monotonic() - t0
+    per_node_day = stats.requests / args.nodes * 86400 / elapsed
+    conns_node_day = stats.connections / args.nodes * 86400 / elapsed
+    ack = "" if args.mode == "poll" else (", no ack" if args.no_ack else ", ack")
+    print(f"\nMode: {args.mode}{ack}, {args.nodes} nodes, {elapsed:.0f} s"
+          f"{f', {stats.drops} parked requests abandoned' if stats.drops else ''}")
+    print(f"Requests:    {stats.requests} ({per_node_day:.0f} per node per day)")
+    print(f"Connections: {stats.connections} ({conns_node_day:.0f} per node per day)")
+    print(f"Errors:      {stats.errors}")
+    if stats.latencies:
+        lat = sorted(stats.latencies)
+        p95 = lat[min(len(lat) - 1, int(len(lat) * 0.95))]
+        print(f"Latency:     {len(lat)} commands, median {statistics.median(lat) * 1000:.0f} ms, "
+              f"p95 {p95 * 1000:.0f} ms, max {lat[-1] * 1000:.0f} ms")
+    print(f"Undelivered: {len(stats.queued)}")
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        print("\nShutdown")
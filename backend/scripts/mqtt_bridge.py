@@ -0,0 +1,201 @@
+"""
+Bridges the firmware's MQTT topics to the HTTP API.
+
+    beewatch/<node>/telemetry|inference|features|log   ->  POST /api/v1/<kind>/
+    GET /commands/pending?wait=...  (per node seen)      ->  beewatch/<node>/commands
+
+Records arrive as the same JSON bodies the HTTP path posts, so the API does
+the validation and node auto-registration. Commands are fetched with the
+long-poll endpoint, published at QoS 1 and acknowledged on the next poll.
+
+The broker has already acknowledged a record to the node when the bridge sees
+it, so a record the API does not take (server down, 5xx) goes to a spool file
+instead of being lost. Spooled records are retried oldest first with
+exponential backoff, and new records queue behind them until the spool drains.
+Records the API rejects (4xx) are dropped and counted.
+
+    python -m backend.scripts.mqtt_bridge --broker localhost --api http://localhost:8000/api/v1
+"""
+import argparse
+import asyncio
+import collections
+import json
+import os
+
+import httpx
+import paho.mqtt.client as mqtt
+
+KINDS = {"telemetry", "inference", "features", "log"}
+RETRY_MIN_S = 1.0
+RETRY_MAX_S = 60.0
+SPOOL_REWRITE_EVERY = 100      # drained records between spool file rewrites
+
+
+class Bridge:
+    def __init__(self, api_url, broker, port, wait_s, spool_path):
+        self.api_url = api_url
+        self.wait_s = wait_s
+        self.loop = None
+        self.queue = None
+        self.pumps = {}                 # node_id -> command pump task
+        self.forwarded = 0
+        self.rejected = 0
+        self.spool_path = spool_path
+        self.spool = collections.deque()
+        self.spool_ready = None
+        self.mqtt = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id="beewatch-bridge")
+        self.mqtt.on_connect = self.on_connect
+        self.mqtt.on_message = self.on_message
+        self.broker, self.port = broker, port
+
+    # paho callbacks run on its network thread; hand messages to the event loop
+    def on_connect(self, client, userdata, flags, reason_code, properties):
+        print(f"[BRIDGE] Connected to broker ({reason_code})")
+        client.subscribe("beewatch/+/+", qos=1)
+
+    def on_message(self, client, userdata, msg):
+        self.loop.call_soon_threadsafe(self.queue.put_nowait, (msg.topic, msg.payload))
+
+    # --- Spool: records the API has not taken yet, oldest first ---
+
+    def load_spool(self):
+        if not os.path.exists(self.spool_path):
+            return
+        with open(self.spool_path) as f:
+            for line in f:
+                if line.strip():
+                    rec = json.loads(line)
+                    self.spool.append((rec["topic"], rec["payload"].encode()))
+        if self.spool:
+            print(f"[BRIDGE] {len(self.spool)} spooled record(s) from {self.spool_path}")
+
+    def spool_append(self, topic, payload):
+        self.spool.append((topic, payload))
+        with open(self.spool_path, "a") as f:
+            f.write(json.dumps({"topic": topic, "payload": payload.decode(errors="replace")}) + "\n")
+        self.spool_ready.set()
+
+    def spool_rewrite(self):
+        tmp = self.spool_path + ".tmp"
+        with open(tmp, "w") as f:
+            for topic, payload in self.spool:
+                f.write(json.dumps({"topic": topic, "payload": payload.decode(errors="replace")}) + "\n")
+        os.replace(tmp, self.spool_path)
+
+    async def post(self, http, topic, payload):
+        """True once the API has the record (or rejected it for good), False to retry."""
+        kind = topic.split("/")[2]
+        try:
+            r = await http.post(f"{self.api_url}/{'logs' if kind == 'log' else kind}/",
+                                content=payload, headers={"Content-Type": "application/json"})
+        except Exception as e:
+            print(f"[BRIDGE] {topic}: {e}")
+            return False
+        if r.status_code >= 500:
+            print(f"[BRIDGE] {topic}: HTTP {r.status_code}")
+            return False
+        if r.status_code >= 400:
+            self.rejected += 1
+            print(f"[BRIDGE] {topic}: rejected, HTTP {r.status_code}")
+        else:
+            self.forwarded += 1
+        return True
+
+    async def drain_spool(self, http):
+        delay = RETRY_MIN_S
+        drained = 0
+        while True:
+            if not self.spool:
+                if drained:
+                    self.spool_rewrite()
+                    print(f"[BRIDGE] Spool drained ({drained} record(s))")
+                    drained = 0
+                self.spool_ready.clear()
+                await self.spool_ready.wait()
+                continue
+            topic, payload = self.spool[0]
+            if await self.post(http, topic, payload):
+                self.spool.popleft()
+                drained += 1
+                delay = RETRY_MIN_S
+                if drained % SPOOL_REWRITE_EVERY == 0:
+                    self.spool_rewrite()
+            else:
+                await asyncio.sleep(delay)
+                delay = min(delay * 2, RETRY_MAX_S)
+
+    def start_task(self, coro, name):
+        task = asyncio.create_task(coro, name=name)
+        task.add_done_callback(self.task_done)
+        return task
+
+    @staticmethod
+    def task_done(task):
+        if not task.cancelled() and task.exception():
+            print(f"[BRIDGE] {task.get_name()} stopped: {task.exception()!r}")
+
+    async def forward(self, http):
+        while True:
+            topic, payload = await self.queue.get()
+            parts = topic.split("/")
+            if len(parts) != 3 or parts[2] not in KINDS:
+                continue
+            node_id = parts[1]
+            if node_id not in self.pumps:
+                self.pumps[node_id] = self.start_task(self.command_pump(node_id), f"commands/{node_id}")
+            # Behind a non-empty spool, or when the API does not take it: spool
+            if self.spool or not await self.post(http, topic, payload):
+                self.spool_append(topic, payload)
+
+    async def command_pump(self, node_id):
+        print(f"[BRIDGE] Relaying commands for {node_id}")
+        ack = []    # published commands, acknowledged on the next poll
+        async with httpx.AsyncClient(timeout=self.wait_s + 10) as http:
+            while True:
+                try:
+                    r = await http.get(f"{self.api_url}/commands/pending",
+                                       params={"node_id": node_id, "wait": self.wait_s, "ack": ",".join(ack)})
+                    r.raise_for_status()
+                    cmds = r.json()
+                    ack = []
+                    if cmds:
+                        self.mqtt.publish(f"beewatch/{node_id}/commands", json.dumps(cmds, default=str), qos=1)
+                        ack = [str(c["command_id"]) for c in cmds]
+                        print(f"[BRIDGE] {len(cmds)} command(s) -> {node_id}")
+                except Exception as e:
+                    print(f"[BRIDGE] Command poll for {node_id}: {e}")
+                    await asyncio.sleep(5)
+
+    async def run(self):
+        self.loop = asyncio.get_running_loop()
+        self.queue = asyncio.Queue()
+        self.spool_ready = asyncio.Event()
+        self.load_spool()
+        if self.spool:
+            self.spool_ready.set()
+        self.mqtt.connect(self.broker, self.port, keepalive=60)
+        self.mqtt.loop_start()
+        drain = None
+        try:
+            async with httpx.AsyncClient(timeout=10.0) as http:
+                drain = self.start_task(self.drain_spool(http), "spool")
+                await self.forward(http)
+        finally:
+            for task in [drain, *self.pumps.values()]:
+                if task:
+                    task.cancel()
+            self.mqtt.loop_stop()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--broker", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--api", default="http://localhost:8000/api/v1", help="API URL")
+    parser.add_argument("--wait", type=float, default=50.0, help="command long-poll wait")
+    parser.add_argument("--spool", default="mqtt_bridge.spool", help="file holding records the API has not taken")
+    args = parser.parse_args()
+    try:
+        asyncio.run(Bridge(args.api, args.broker, args.port, args.wait, args.spool).run())
+    except KeyboardInterrupt:
+        print("\nShutdown")
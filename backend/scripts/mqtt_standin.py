@@ -0,0 +1,170 @@
+"""
+Minimal MQTT 3.1.1 broker, a stand-in for Mosquitto in local tests.
+
+Supports what the firmware and mqtt_bridge.py use: CONNECT, PUBLISH at QoS 0/1,
+SUBSCRIBE with + and # wildcards, PINGREQ and DISCONNECT. No retained messages,
+persistent sessions or QoS 2. An optional --ack-delay holds back PUBACKs to model
+a radio link's round trip.
+
+    python -m backend.scripts.mqtt_standin --port 1883
+"""
+import argparse
+import asyncio
+import struct
+
+
+def topic_matches(pattern: str, topic: str) -> bool:
+    p, t = pattern.split("/"), topic.split("/")
+    for i, part in enumerate(p):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(p) == len(t)
+
+
+def encode_length(n: int) -> bytes:
+    out = bytearray()
+    while True:
+        b, n = n % 128, n // 128
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def packet(ptype: int, flags: int, body: bytes) -> bytes:
+    return bytes([(ptype << 4) | flags]) + encode_length(len(body)) + body
+
+
+def encode_str(s: str) -> bytes:
+    b = s.encode()
+    return struct.pack("!H", len(b)) + b
+
+
+async def read_packet(reader: asyncio.StreamReader):
+    first = (await reader.readexactly(1))[0]
+    length, mult = 0, 1
+    while True:
+        b = (await reader.readexactly(1))[0]
+        length += (b & 0x7F) * mult
+        mult *= 128
+        if not b & 0x80:
+            break
+    return first >> 4, first & 0x0F, await reader.readexactly(length)
+
+
+class Client:
+    def __init__(self, broker, writer):
+        self.broker = broker
+        self.writer = writer
+        self.client_id = ""
+        self.subs = {}          # pattern -> qos
+        self.next_id = 1
+
+    def send(self, data: bytes):
+        self.broker.bytes_out += len(data)
+        self.writer.write(data)
+
+    def deliver(self, topic: str, payload: bytes, qos: int):
+        body = encode_str(topic)
+        if qos:
+            body += struct.pack("!H", self.next_id)
+            self.next_id = self.next_id % 65535 + 1
+        self.send(packet(3, qos << 1, body + payload))
+
+
+class Broker:
+    def __init__(self, ack_delay=0.0, verbose=False):
+        self.clients = set()
+        self.ack_delay = ack_delay
+        self.verbose = verbose
+        self.messages = 0
+        self.bytes_in = 0
+        self.bytes_out = 0
+        self.on_publish = None  # optional hook(topic, payload)
+
+    def publish(self, topic: str, payload: bytes, qos: int = 0):
+        self.messages += 1
+        if self.on_publish:
+            self.on_publish(topic, payload)
+        for c in list(self.clients):
+            for pattern, sub_qos in c.subs.items():
+                if topic_matches(pattern, topic):
+                    c.deliver(topic, payload, min(qos, sub_qos))
+                    break
+
+    async def handle(self, reader, writer):
+        client = Client(self, writer)
+        self.clients.add(client)
+        loop = asyncio.get_running_loop()
+        try:
+            while True:
+                ptype, flags, body = await read_packet(reader)
+                self.bytes_in += 1 + len(encode_length(len(body))) + len(body)
+                if ptype == 1:      # CONNECT
+                    proto_len = struct.unpack("!H", body[:2])[0]
+                    pos = 2 + proto_len + 4
+                    id_len = struct.unpack("!H", body[pos:pos + 2])[0]
+                    client.client_id = body[pos + 2:pos + 2 + id_len].decode()
+                    client.send(packet(2, 0, b"\x00\x00"))
+                    if self.verbose:
+                        print(f"[BROKER] {client.client_id} connected")
+                elif ptype == 3:    # PUBLISH
+                    qos = (flags >> 1) & 3
+                    tlen = struct.unpack("!H", body[:2])[0]
+                    topic = body[2:2 + tlen].decode()
+                    pos = 2 + tlen
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                        ack = packet(4, 0, pid)
+                        if self.ack_delay:
+                            loop.call_later(self.ack_delay, client.send, ack)
+                        else:
+                            client.send(ack)
+                    self.publish(topic, body[pos:], qos)
+                elif ptype == 8:    # SUBSCRIBE
+                    pid, pos, granted = body[:2], 2, bytearray()
+                    while pos < len(body):
+                        tlen = struct.unpack("!H", body[pos:pos + 2])[0]
+                        pattern = body[pos + 2:pos + 2 + tlen].decode()
+                        qos = min(body[pos + 2 + tlen], 1)
+                        client.subs[pattern] = qos
+                        granted.append(qos)
+                        pos += 3 + tlen
+                    client.send(packet(9, 0, pid + bytes(granted)))
+                elif ptype == 12:   # PINGREQ
+                    client.send(packet(13, 0, b""))
+                elif ptype == 14:   # DISCONNECT
+                    break
+                # PUBACK (4) from subscribers needs no action
+                await writer.drain()
+        except (asyncio.IncompleteReadError, asyncio.CancelledError, ConnectionError):
+            pass
+        finally:
+            self.clients.discard(client)
+            writer.close()
+
+    async def serve(self, host="127.0.0.1", port=1883):
+        return await asyncio.start_server(self.handle, host, port)
+
+
+async def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--ack-delay", type=float, default=0.0, help="seconds to hold back PUBACKs")
+    args = parser.parse_args()
+
+    broker = Broker(args.ack_delay, verbose=True)
+    server = await broker.serve(args.host, args.port)
+    print(f"[BROKER] Listening on {args.host}:{args.port}")
+    async with server:
+        await server.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        print("\nShutdown")
@@ -0,0 +1,168 @@
+"""
+Compares the firmware's two uplinks for replaying logged records:
+
+    http   one connection per record, "Connection: close" (perform_http_request)
+    mqtt   one session, QoS 1 publishes with a window of in-flight records
+
+Both send the JSON bodies record_to_json() produces. By default the targets
+are local stand-ins (mqtt_standin.Broker and a minimal HTTP responder) with an
+artificial round trip, so the numbers isolate protocol cost. Point --api or
+--broker at a real backend / Mosquitto to measure those instead.
+
+    python -m backend.scripts.transport_bench --records 500 --rtt-ms 20 --window 4
+"""
+import argparse
+import asyncio
+import itertools
+import random
+import struct
+import time
+
+from backend.scripts.mqtt_standin import Broker, encode_str, packet, read_packet
+
+NODE = "pico-hive-001"
+
+
+def record_bodies(n):
+    """Same mix and formatting as the firmware: climate, features, inference."""
+    out = []
+    for i in range(n):
+        kind = ("telemetry", "features", "inference")[i % 3]
+        if kind == "telemetry":
+            body = (f'{{"node_id": "{NODE}", "temperature_c": {random.uniform(20, 35):.2f}, '
+                    f'"humidity_pct": {random.uniform(40, 80):.2f}, "battery_mv": 4200, "age_ms": {i * 1000}}}')
+        elif kind == "features":
+            vals = ", ".join(f"{random.uniform(0, 1):.6g}" for _ in range(20))
+            body = f'{{"node_id": "{NODE}", "density": {random.uniform(0, 0.02):.6f}, "values": [{vals}], "age_ms": {i * 1000}}}'
+        else:
+            body = (f'{{"node_id": "{NODE}", "model_type": "summer", "classification": "Normal", '
+                    f'"confidence": {random.uniform(0.5, 1):.2f}, "age_ms": {i * 1000}}}')
+        out.append((kind, body))
+    return out
+
+
+# --- HTTP ---
+
+async def http_responder(rtt):
+    """Answers like uvicorn does for the record endpoints, one RTT after the request."""
+    async def handle(reader, writer):
+        try:
+            head = await reader.readuntil(b"\r\n\r\n")
+            length = 0
+            for line in head.split(b"\r\n"):
+                if line.lower().startswith(b"content-length:"):
+                    length = int(line.split(b":")[1])
+            await reader.readexactly(length)
+            await asyncio.sleep(rtt)
+            body = b'{"status":"ok"}'
+            writer.write(b"HTTP/1.1 200 OK\r\ndate: Thu, 01 Jan 2026 00:00:00 GMT\r\nserver: uvicorn\r\n"
+                         b"content-length: %d\r\ncontent-type: application/json\r\nconnection: close\r\n\r\n%s"
+                         % (len(body), body))
+            await writer.drain()
+        finally:
+            writer.close()
+    return await asyncio.start_server(handle, "127.0.0.1", 0)
+
+
+async def run_http(host, port, records, rtt):
+    tx = rx = 0
+    t0 = time.perf_counter()
+    for kind, body in records:
+        await asyncio.sleep(rtt)            # TCP handshake
+        reader, writer = await asyncio.open_connection(host, port)
+        req = (f"POST /api/v1/{kind}/ HTTP/1.1\r\nHost: {host}:{port}\r\nConnection: close\r\n"
+               f"Content-Type: application/json\r\nContent-Length: {len(body)}\r\n\r\n{body}").encode()
+        writer.write(req)
+        await writer.drain()
+        resp = await reader.read()
+        writer.close()
+        if b" 200 " not in resp.split(b"\r\n", 1)[0]:
+            raise RuntimeError(f"HTTP {resp[:40]!r}")
+        tx += len(req)
+        rx += len(resp)
+    return time.perf_counter() - t0, tx, rx
+
+
+# --- MQTT ---
+
+async def run_mqtt(host, port, records, window):
+    reader, writer = await asyncio.open_connection(host, port)
+    connect = encode_str("MQTT") + bytes([4, 0x02]) + struct.pack("!H", 60) + encode_str(NODE)
+    writer.write(packet(1, 0, connect))
+    await read_packet(reader)               # CONNACK
+
+    tx = rx = 0
+    inflight = asyncio.Semaphore(window)
+    pending = {}
+    done = asyncio.Event()
+
+    async def acks():
+        nonlocal rx
+        while pending or not done.is_set():
+            ptype, _, body = await read_packet(reader)
+            rx += 2 + len(body)
+            if ptype == 4:
+                pending.pop(struct.unpack("!H", body)[0], None)
+                inflight.release()
+
+    ack_task = asyncio.create_task(acks())
+    t0 = time.perf_counter()
+    ids = itertools.cycle(range(1, 65536))
+    for kind, body in records:
+        await inflight.acquire()
+        pid = next(ids)
+        pending[pid] = True
+        data = packet(3, 1 << 1, encode_str(f"beewatch/{NODE}/{kind}") + struct.pack("!H", pid) + body.encode())
+        tx += len(data)
+        writer.write(data)
+        await writer.drain()
+    done.set()
+    while pending:
+        await asyncio.sleep(0.001)
+    elapsed = time.perf_counter() - t0
+    ack_task.cancel()
+    writer.write(packet(14, 0, b""))
+    writer.close()
+    return elapsed, tx, rx
+
+
+def report(name, n, elapsed, tx, rx):
+    print(f"{name:<14} {n / elapsed:8.1f} rec/s   {tx / n:6.0f} B/rec out   {rx / n:5.0f} B/rec in   "
+          f"{(tx + rx) / n:6.0f} B/rec total")
+
+
+async def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--records", type=int, default=300)
+    parser.add_argument("--rtt-ms", type=float, default=20.0, help="emulated round trip (stand-ins only)")
+    parser.add_argument("--window", type=int, default=4, help="MQTT in-flight window (firmware MQTT_WINDOW)")
+    parser.add_argument("--api", help="host:port of a real backend instead of the HTTP stand-in")
+    parser.add_argument("--broker", help="host:port of a real broker instead of the MQTT stand-in")
+    args = parser.parse_args()
+
+    rtt = args.rtt_ms / 1000
+    records = record_bodies(args.records)
+    print(f"{args.records} records, mean body {sum(len(b) for _, b in records) / len(records):.0f} B, "
+          f"RTT {args.rtt_ms:.0f} ms{' (stand-ins)' if not (args.api or args.broker) else ''}\n")
+
+    if args.api:
+        host, port = args.api.split(":")
+        http_rtt = 0
+    else:
+        server = await http_responder(rtt)
+        host, port = server.sockets[0].getsockname()[:2]
+        http_rtt = rtt
+    report("HTTP", args.records, *await run_http(host, int(port), records, http_rtt))
+
+    if args.broker:
+        bhost, bport = args.broker.split(":")
+    else:
+        broker = Broker(ack_delay=rtt)
+        bserver = await broker.serve("127.0.0.1", 0)
+        bhost, bport = bserver.sockets[0].getsockname()[:2]
+    for w in sorted({1, args.window}):
+        report(f"MQTT window {w}", args.records, *await run_mqtt(bhost, int(bport), records, w))
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -48,6 +48,7 @@
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 #include <memory>
+#include <new>
 
 #if EI_CLASSIFIER_LOAD_ANOMALY_H
 #include "inferencing_engines/anomaly.h"
@@ -112,8 +113,63 @@ EI_IMPULSE_ERROR ei_unscale_fmatrix(ei_learning_block_t *block, ei::matrix_t *fm
 
 static uint64_t classifier_continuous_features_written = 0;
 
+/* Upper bound on DSP blocks and output tensors per impulse, for the fixed
+ * per-call scratch below */
+#ifndef EI_CLASSIFIER_MAX_IMPULSE_BLOCKS
+#define EI_CLASSIFIER_MAX_IMPULSE_BLOCKS    8
+#endif
+
+#if EIDSP_SCRATCH_ARENA_SIZE > 0
+/* Arena for the temporaries of stateless DSP blocks, active for the duration
+ * of each extract call; peak and fallbacks tell whether the size fits */
+static uint8_t ei_dsp_default_scratch_buffer[EIDSP_SCRATCH_ARENA_SIZE] __attribute__((aligned(8)));
+static ei::ei_dsp_scratch_t ei_dsp_default_scratch = { ei_dsp_default_scratch_buffer, EIDSP_SCRATCH_ARENA_SIZE };
+#endif
+
 /* Private functions ------------------------------------------------------- */
 
+/**
+ * Per-call bookkeeping of process_impulse() and process_impulse_continuous():
+ * the feature and raw-output descriptors and the feature matrix objects live
+ * in fixed storage on the caller's stack instead of new[], so a classification
+ * makes no heap allocation of its own. Matrix buffers still come from
+ * ei_calloc(); the matrices are destroyed (and their buffers freed) on every
+ * return path.
+ */
+class ImpulseScratch {
+public:
+    ei_feature_t features[EI_CLASSIFIER_MAX_IMPULSE_BLOCKS];
+    ei_feature_t raw_outputs[EI_CLASSIFIER_MAX_IMPULSE_BLOCKS];
+
+    ImpulseScratch() : matrix_count(0) {
+        memset(features, 0, sizeof(features));
+        memset(raw_outputs, 0, sizeof(raw_outputs));
+    }
+
+    ~ImpulseScratch() {
+        for (size_t ix = 0; ix < matrix_count; ix++) {
+            reinterpret_cast<ei::matrix_t *>(matrix_storage[ix])->~ei_matrix();
+        }
+    }
+
+    /* Zeroed 1 x cols matrix, nullptr when the storage or ei_calloc runs out */
+    ei::matrix_t *add_matrix(uint32_t cols) {
+        if (matrix_count >= EI_CLASSIFIER_MAX_IMPULSE_BLOCKS) {
+            return nullptr;
+        }
+        ei::matrix_t *m = ::new (matrix_storage[matrix_count]) ei::matrix_t(1, cols);
+        matrix_count++;
+        return m->buffer ? m : nullptr;
+    }
+
+private:
+    alignas(ei::matrix_t) uint8_t matrix_storage[EI_CLASSIFIER_MAX_IMPULSE_BLOCKS][sizeof(ei::matrix_t)];
+    size_t matrix_count;
+
+    ImpulseScratch(const ImpulseScratch &) = delete;
+    ImpulseScratch &operator=(const ImpulseScratch &) = delete;
+};
+
 /* These functions (up to Public functions section) are not exposed to end-user,
 therefore changes are allowed. */
 
@@ -230,11 +286,15 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 #endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
 
     uint8_t num_results = handle->impulse->output_tensors_size;
+    uint32_t block_num = handle->impulse->dsp_blocks_size;
 
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[num_results]);
+    if (num_results > EI_CLASSIFIER_MAX_IMPULSE_BLOCKS || block_num > EI_CLASSIFIER_MAX_IMPULSE_BLOCKS) {
+        ei_printf("ERR: Impulse has more blocks than EI_CLASSIFIER_MAX_IMPULSE_BLOCKS (%d)\n", EI_CLASSIFIER_MAX_IMPULSE_BLOCKS);
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
 
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * num_results);
+    ImpulseScratch scratch;
+    result->_raw_outputs = scratch.raw_outputs;
 
 #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON)
     // Shortcut for quantized image models
@@ -249,28 +309,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     }
 #endif
 
-    uint32_t block_num = handle->impulse->dsp_blocks_size;
-
-    // smart pointer to features array
-    std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-    ei_feature_t* features = features_ptr.get();
-
-    if (features == nullptr) {
-        ei_printf("ERR: Out of memory, can't allocate features\n");
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
-
-    memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-    // have it outside of the loop to avoid going out of scope
-    std::unique_ptr<std::unique_ptr<ei::matrix_t>[]> matrix_ptrs_ptr(new std::unique_ptr<ei::matrix_t>[block_num]);
-    std::unique_ptr<ei::matrix_t> *matrix_ptrs = matrix_ptrs_ptr.get();
-
-    if (matrix_ptrs == nullptr) {
-        delete[] matrix_ptrs;
-        ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
+    ei_feature_t* features = scratch.features;
 
     uint64_t dsp_start_us = ei_read_timer_us();
 
@@ -279,19 +318,11 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     for (size_t ix = 0; ix < handle->impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = handle->impulse->dsp_blocks[ix];
 
-        matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-        if (matrix_ptrs[ix] == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
+        features[ix].matrix = scratch.add_matrix(block.n_output_features);
+        if (features[ix].matrix == nullptr) {
+            ei_printf("ERR: Out of memory, can't allocate feature matrix %lu\n", (unsigned long)ix);
             return EI_IMPULSE_ALLOC_FAILED;
         }
-
-        if (matrix_ptrs[ix]->buffer == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-            delete[] matrix_ptrs;
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-
-        features[ix].matrix = matrix_ptrs[ix].get();
         features[ix].blockId = block.blockId;
 
         if (out_features_index + block.n_output_features > handle->impulse->nn_input_frame_size) {
@@ -333,6 +364,9 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
                 return EI_IMPULSE_OUT_OF_MEMORY;
             }
         } else {
+#if EIDSP_SCRATCH_ARENA_SIZE > 0
+            ei::ei_dsp_scratch_scope dsp_scratch(&ei_dsp_default_scratch);
+#endif
             ret = block.extract_fn(internal_signal, features[ix].matrix, block.config, handle->impulse->frequency);
         }
 
@@ -427,28 +461,36 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     memset(result, 0, sizeof(ei_impulse_result_t));
 
 #if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
+    // Built once per impulse and reused: only the values change between calls
     static std::vector<ei_impulse_result_classification_t> classification_results;
-    classification_results.clear(); // todo, should not clear and re-gen this every time...
-
-    if (handle->impulse->results_type == EI_CLASSIFIER_TYPE_CLASSIFICATION ||
-        handle->impulse->results_type == EI_CLASSIFIER_TYPE_REGRESSION) {
-    #ifdef EI_DSP_RESULT_OVERRIDE
-        for (size_t ix = 0; ix < EI_DSP_RESULT_OVERRIDE; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = "",
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
-        }
-    #else
-        for (size_t ix = 0; ix < handle->impulse->label_count; ix++) {
-            ei_impulse_result_classification_t classification = {
-                .label = handle->impulse->categories[ix],
-                .value = 0.0f
-            };
-            classification_results.push_back(classification);
+    static const ei_impulse_t *classification_results_impulse = nullptr;
+
+    if (classification_results_impulse != handle->impulse) {
+        classification_results.clear();
+        if (handle->impulse->results_type == EI_CLASSIFIER_TYPE_CLASSIFICATION ||
+            handle->impulse->results_type == EI_CLASSIFIER_TYPE_REGRESSION) {
+        #ifdef EI_DSP_RESULT_OVERRIDE
+            for (size_t ix = 0; ix < EI_DSP_RESULT_OVERRIDE; ix++) {
+                ei_impulse_result_classification_t classification = {
+                    .label = "",
+                    .value = 0.0f
+                };
+                classification_results.push_back(classification);
+            }
+        #else
+            for (size_t ix = 0; ix < handle->impulse->label_count; ix++) {
+                ei_impulse_result_classification_t classification = {
+                    .label = handle->impulse->categories[ix],
+                    .value = 0.0f
+                };
+                classification_results.push_back(classification);
+            }
+        #endif
         }
-    #endif
+        classification_results_impulse = handle->impulse;
+    }
+    for (size_t ix = 0; ix < classification_results.size(); ix++) {
+        classification_results[ix].value = 0.0f;
     }
 
     result->classification = classification_results.data();
@@ -462,12 +504,16 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
 #endif // EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
 
-    // smart pointer to results array
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[handle->impulse->learning_blocks_size]);
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * handle->impulse->learning_blocks_size);
-
     auto impulse = handle->impulse;
+    if (impulse->learning_blocks_size > EI_CLASSIFIER_MAX_IMPULSE_BLOCKS ||
+        impulse->dsp_blocks_size + impulse->learning_blocks_size > EI_CLASSIFIER_MAX_IMPULSE_BLOCKS) {
+        ei_printf("ERR: Impulse has more blocks than EI_CLASSIFIER_MAX_IMPULSE_BLOCKS (%d)\n", EI_CLASSIFIER_MAX_IMPULSE_BLOCKS);
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    ImpulseScratch scratch;
+    result->_raw_outputs = scratch.raw_outputs;
+
     static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
     if (!static_features_matrix.buffer) {
         return EI_IMPULSE_ALLOC_FAILED;
@@ -514,11 +560,18 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
             return EI_IMPULSE_DSP_ERROR;
         }
-        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written);
+        auto slice_signal = signal;
 #else
         SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
-        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written);
+        auto slice_signal = swa.get_signal();
+#endif
+        int ret;
+        {
+#if EIDSP_SCRATCH_ARENA_SIZE > 0
+            ei::ei_dsp_scratch_scope dsp_scratch(&ei_dsp_default_scratch);
 #endif
+            ret = extract_fn_slice(slice_signal, &fm, block.config, impulse->frequency, &features_written);
+        }
 
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -540,42 +593,17 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
         dsp_start_us = ei_read_timer_us();
 
-        uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
-
-        // smart pointer to features array
-        std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-        ei_feature_t* features = features_ptr.get();
-        if (features == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate features\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-        memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-        // have it outside of the loop to avoid going out of scope
-        std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
-        if (matrix_ptrs == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
+        ei_feature_t* features = scratch.features;
 
         out_features_index = 0;
         // iterate over every dsp block and run normalization
         for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
             ei_model_dsp_t block = impulse->dsp_blocks[ix];
-            matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-
-            if (matrix_ptrs[ix] == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                return EI_IMPULSE_ALLOC_FAILED;
-            }
-
-            if (matrix_ptrs[ix]->buffer == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                delete[] matrix_ptrs;
+            features[ix].matrix = scratch.add_matrix(block.n_output_features);
+            if (features[ix].matrix == nullptr) {
+                ei_printf("ERR: Out of memory, can't allocate feature matrix %lu\n", (unsigned long)ix);
                 return EI_IMPULSE_ALLOC_FAILED;
             }
-
-            features[ix].matrix = matrix_ptrs[ix].get();
             features[ix].blockId = block.blockId;
 
             /* Create a copy of the matrix for normalization */
@@ -612,7 +640,6 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
         }
-        delete[] matrix_ptrs;
         ei_impulse_error = run_postprocessing(handle, result);
         if (ei_impulse_error != EI_IMPULSE_OK) {
             return ei_impulse_error;
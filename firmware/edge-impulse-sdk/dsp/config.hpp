@@ -87,6 +87,39 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
+// Size in bytes of a static scratch arena that run_classifier() activates
+// around each DSP block (see ei_dsp_scratch_scope in memory.hpp), so the
+// block's temporaries come from a bump pointer instead of the heap.
+// 0 leaves them on the heap.
+#ifndef EIDSP_SCRATCH_ARENA_SIZE
+#define EIDSP_SCRATCH_ARENA_SIZE     0
+#endif // EIDSP_SCRATCH_ARENA_SIZE
+
+// Bytes of static storage for cached kissfft plans (see fft_plans.hpp),
+// split into EIDSP_FFT_PLAN_CACHE_SLOTS equal slots. A plan takes about
+// 10 bytes per point. 0 builds a plan on every call.
+#ifndef EIDSP_FFT_PLAN_CACHE_SIZE
+#define EIDSP_FFT_PLAN_CACHE_SIZE    0
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE
+
+#ifndef EIDSP_FFT_PLAN_CACHE_SLOTS
+#define EIDSP_FFT_PLAN_CACHE_SLOTS   4
+#endif // EIDSP_FFT_PLAN_CACHE_SLOTS
+
+// Real FFTs of power-of-two sizes (64..4096) without a hardware FFT engine
+// run on the compile-time-twiddle transform in pow2_rfft.hpp instead of
+// kissfft. 0 keeps kissfft for every size.
+#ifndef EIDSP_USE_POW2_RFFT
+#define EIDSP_USE_POW2_RFFT          1
+#endif // EIDSP_USE_POW2_RFFT
+
+// On x86-64 hosts built with GCC or Clang, numpy's statistics and matrix
+// helpers run on the SSE / AVX2 kernels in host_simd.hpp, picked at run time
+// from the CPU. Has no effect on other targets. 0 keeps the scalar loops.
+#ifndef EIDSP_USE_HOST_SIMD
+#define EIDSP_USE_HOST_SIMD          1
+#endif // EIDSP_USE_HOST_SIMD
+
 // prints buffer allocations to stdout, useful when debugging
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#ifndef _EIDSP_FFT_PLANS_H_
+#define _EIDSP_FFT_PLANS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include "edge-impulse-sdk/dsp/kissfft/kiss_fftr.h"
+
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+#include <atomic>
+#endif
+
+namespace ei {
+
+/**
+ * kissfft real-FFT plans keyed by size and direction.
+ *
+ * A kiss_fftr config holds the factorization, the twiddles and a work buffer,
+ * about 10 bytes per point. Without a cache every transform allocates and
+ * builds one. With EIDSP_FFT_PLAN_CACHE_SIZE > 0 the configs are built on
+ * first use into EIDSP_FFT_PLAN_CACHE_SLOTS equal slots of a static buffer
+ * and reused; when no slot is free the least recently used idle one is
+ * rebuilt. Plans larger than a slot, and requests while every slot is held,
+ * get a per-call config as before. ei_fft_plan_preload() builds a plan ahead
+ * of time, e.g. at init.
+ *
+ * The work buffer makes a plan single-user, so a slot is held from
+ * ei_fft_plan_acquire() to ei_fft_plan_release(), and a second caller with
+ * the same key (e.g. the other core) gets a slot of its own. The slot table
+ * is guarded by a spinlock; plans are built outside it.
+ *
+ * The slots are static rather than ei_malloc'd: cached plans must outlive
+ * the DSP scratch arena and must not hold pool blocks across an inference.
+ */
+typedef struct {
+    uint32_t hits;
+    uint32_t builds;            // plans built into a slot
+    uint32_t evictions;         // builds that replaced another plan
+    uint32_t uncached;          // requests served with a per-call config
+} ei_fft_plan_stats_t;
+
+typedef struct {
+    kiss_fftr_cfg cfg;
+    int slot;                   // cache slot held, -1 for a per-call config
+    void *mem;                  // per-call config memory
+    size_t mem_size;
+} ei_fft_plan_t;
+
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+
+#define EIDSP_FFT_PLAN_SLOT_BYTES   ((EIDSP_FFT_PLAN_CACHE_SIZE / EIDSP_FFT_PLAN_CACHE_SLOTS) & ~(size_t)7)
+
+typedef struct {
+    size_t n_fft;               // 0 if empty
+    int inverse;
+    bool busy;
+    uint32_t last_use;
+} ei_fft_plan_slot_t;
+
+typedef struct {
+    ei_fft_plan_slot_t slots[EIDSP_FFT_PLAN_CACHE_SLOTS];
+    uint32_t clock;
+    ei_fft_plan_stats_t stats;
+    uint64_t storage[EIDSP_FFT_PLAN_CACHE_SLOTS][EIDSP_FFT_PLAN_SLOT_BYTES / 8];
+} ei_fft_plan_cache_t;
+
+extern ei_fft_plan_cache_t ei_fft_plan_cache;
+extern std::atomic_flag ei_fft_plan_cache_lock;
+
+__attribute__((unused)) static void ei_fft_plan_lock()
+{
+    while (ei_fft_plan_cache_lock.test_and_set(std::memory_order_acquire)) {
+    }
+}
+
+__attribute__((unused)) static void ei_fft_plan_unlock()
+{
+    ei_fft_plan_cache_lock.clear(std::memory_order_release);
+}
+
+// Claims the idle slot holding (n_fft, inverse), or the least recently used
+// idle slot to build it in. Returns -1 if every slot is held.
+__attribute__((unused)) static int ei_fft_plan_claim(size_t n_fft, int inverse, bool *build)
+{
+    ei_fft_plan_cache_t *c = &ei_fft_plan_cache;
+    int hit = -1, victim = -1;
+    for (int ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SLOTS; ix++) {
+        ei_fft_plan_slot_t *s = &c->slots[ix];
+        if (s->busy) {
+            continue;
+        }
+        if (s->n_fft == n_fft && s->inverse == inverse) {
+            hit = ix;
+            break;
+        }
+        if (victim < 0 || s->last_use < c->slots[victim].last_use) {
+            victim = ix;
+        }
+    }
+    int ix = hit >= 0 ? hit : victim;
+    if (ix < 0) {
+        return -1;
+    }
+    ei_fft_plan_slot_t *s = &c->slots[ix];
+    *build = hit < 0;
+    if (hit >= 0) {
+        c->stats.hits++;
+    }
+    else {
+        if (s->n_fft) {
+            c->stats.evictions++;
+        }
+        c->stats.builds++;
+        s->n_fft = n_fft;
+        s->inverse = inverse;
+    }
+    s->busy = true;
+    s->last_use = ++c->clock;
+    return ix;
+}
+
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE > 0
+
+/**
+ * Gets a plan for an n_fft-point real FFT (inverse != 0 for the inverse).
+ * Must be paired with ei_fft_plan_release().
+ * @returns EIDSP_OK if OK
+ */
+__attribute__((unused)) static int ei_fft_plan_acquire(ei_fft_plan_t *plan, size_t n_fft, int inverse)
+{
+    plan->cfg = nullptr;
+    plan->slot = -1;
+    plan->mem = nullptr;
+    plan->mem_size = 0;
+
+    size_t needed = 0;
+    kiss_fftr_alloc(n_fft, inverse, NULL, &needed, NULL);
+
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+    if (needed <= EIDSP_FFT_PLAN_SLOT_BYTES) {
+        bool build = false;
+        ei_fft_plan_lock();
+        int slot = ei_fft_plan_claim(n_fft, inverse, &build);
+        ei_fft_plan_unlock();
+
+        if (slot >= 0) {
+            void *mem = ei_fft_plan_cache.storage[slot];
+            if (build) {
+                size_t len = EIDSP_FFT_PLAN_SLOT_BYTES;
+                plan->cfg = kiss_fftr_alloc(n_fft, inverse, mem, &len, NULL);
+            }
+            else {
+                plan->cfg = (kiss_fftr_cfg)mem;
+            }
+            plan->slot = slot;
+            if (plan->cfg) {
+                return EIDSP_OK;
+            }
+            ei_fft_plan_lock();
+            ei_fft_plan_cache.slots[slot].n_fft = 0;
+            ei_fft_plan_cache.slots[slot].busy = false;
+            ei_fft_plan_unlock();
+            plan->slot = -1;
+        }
+    }
+    ei_fft_plan_lock();
+    ei_fft_plan_cache.stats.uncached++;
+    ei_fft_plan_unlock();
+#endif
+
+    // per-call config in DSP memory (the scratch arena when one is active)
+    plan->mem = ei_dsp_malloc(needed);
+    if (!plan->mem) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    plan->mem_size = needed;
+    plan->cfg = kiss_fftr_alloc(n_fft, inverse, plan->mem, &needed, NULL);
+    if (!plan->cfg) {
+        ei_dsp_free(plan->mem, plan->mem_size);
+        plan->mem = nullptr;
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    return EIDSP_OK;
+}
+
+__attribute__((unused)) static void ei_fft_plan_release(ei_fft_plan_t *plan)
+{
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+    if (plan->slot >= 0) {
+        ei_fft_plan_lock();
+        ei_fft_plan_cache.slots[plan->slot].busy = false;
+        ei_fft_plan_unlock();
+    }
+#endif
+    if (plan->mem) {
+        ei_dsp_free(plan->mem, plan->mem_size);
+    }
+    plan->cfg = nullptr;
+    plan->slot = -1;
+    plan->mem = nullptr;
+}
+
+/**
+ * Builds the plan for (n_fft, inverse) into the cache ahead of its first use.
+ * @returns EIDSP_OK if the plan is cached, EIDSP_NOT_SUPPORTED without a
+ *          cache or if it does not fit a slot
+ */
+__attribute__((unused)) static int ei_fft_plan_preload(size_t n_fft, int inverse)
+{
+    ei_fft_plan_t plan;
+    int ret = ei_fft_plan_acquire(&plan, n_fft, inverse);
+    if (ret != EIDSP_OK) {
+        return ret;
+    }
+    bool cached = plan.slot >= 0;
+    ei_fft_plan_release(&plan);
+    return cached ? EIDSP_OK : EIDSP_NOT_SUPPORTED;
+}
+
+__attribute__((unused)) static void ei_fft_plan_get_stats(ei_fft_plan_stats_t *stats)
+{
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+    ei_fft_plan_lock();
+    *stats = ei_fft_plan_cache.stats;
+    ei_fft_plan_unlock();
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+} // namespace ei
+
+#endif // _EIDSP_FFT_PLANS_H_
@@ -0,0 +1,552 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#ifndef _EIDSP_HOST_SIMD_H_
+#define _EIDSP_HOST_SIMD_H_
+
+#include <stddef.h>
+#include <math.h>
+#include <immintrin.h>
+
+/**
+ * SSE / AVX2 kernels behind numpy's statistics and matrix helpers (sum, dot,
+ * scale, add, rms, mean, mean_axis0, std_axis0, stdev, skew, kurtosis) on
+ * x86-64 hosts, i.e. the offline tools that featurize whole datasets with
+ * the same code as the firmware. numpy.hpp includes this header only for
+ * x86-64 builds with GCC or Clang and EIDSP_USE_HOST_SIMD set.
+ *
+ * The level is picked once per process from the CPU: AVX2 + FMA when
+ * available, else SSE2, which every x86-64 CPU has. The AVX2 kernels are
+ * compiled with a target attribute, so the build itself needs no -mavx2 and
+ * the binary still runs on older CPUs. set_level() lowers the level, down to
+ * LEVEL_NONE for numpy's scalar loops, to compare the paths in one binary.
+ *
+ * Reductions keep several vector accumulators, so sums are added in a
+ * different order than the scalar loops and results differ from them in the
+ * last bits (they are usually closer to the exact value). Element-wise
+ * kernels match the scalar loops exactly, except for FMA rounding in axpy
+ * and squared_deviation.
+ */
+
+namespace ei {
+namespace host_simd {
+
+enum level_t {
+    LEVEL_NONE = 0,     // numpy's scalar loops
+    LEVEL_SSE = 1,
+    LEVEL_AVX2 = 2,     // AVX2 + FMA
+};
+
+namespace detail {
+
+inline int detect_level()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return LEVEL_AVX2;
+    }
+    return LEVEL_SSE;
+}
+
+// inline functions, so every translation unit shares the same statics
+inline int &supported_level()
+{
+    static int level = detect_level();
+    return level;
+}
+
+inline int &selected_level()
+{
+    static int level = supported_level();
+    return level;
+}
+
+static inline float hsum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hsum(__m256 v)
+{
+    return hsum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+/* SSE2 */
+
+static inline float sum_sse(const float *x, size_t n)
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm_add_ps(a0, _mm_loadu_ps(x + i));
+        a1 = _mm_add_ps(a1, _mm_loadu_ps(x + i + 4));
+        a2 = _mm_add_ps(a2, _mm_loadu_ps(x + i + 8));
+        a3 = _mm_add_ps(a3, _mm_loadu_ps(x + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) {
+        a0 = _mm_add_ps(a0, _mm_loadu_ps(x + i));
+    }
+    float res = hsum(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+    for (; i < n; i++) {
+        res += x[i];
+    }
+    return res;
+}
+
+static inline float sum_squares_sse(const float *x, size_t n)
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128 v0 = _mm_loadu_ps(x + i), v1 = _mm_loadu_ps(x + i + 4);
+        __m128 v2 = _mm_loadu_ps(x + i + 8), v3 = _mm_loadu_ps(x + i + 12);
+        a0 = _mm_add_ps(a0, _mm_mul_ps(v0, v0));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(v1, v1));
+        a2 = _mm_add_ps(a2, _mm_mul_ps(v2, v2));
+        a3 = _mm_add_ps(a3, _mm_mul_ps(v3, v3));
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        a0 = _mm_add_ps(a0, _mm_mul_ps(v, v));
+    }
+    float res = hsum(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+    for (; i < n; i++) {
+        res += x[i] * x[i];
+    }
+    return res;
+}
+
+// Sums of (x - mean)^2, and of its third / fourth powers when M3 / M4
+template <bool M3, bool M4>
+static inline void moments_sse(const float *x, size_t n, float mean, float *s2, float *s3, float *s4)
+{
+    const __m128 mu = _mm_set1_ps(mean);
+    __m128 a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps(), a4 = _mm_setzero_ps();
+    __m128 b2 = _mm_setzero_ps(), b3 = _mm_setzero_ps(), b4 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(x + i), mu);
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(x + i + 4), mu);
+        __m128 q0 = _mm_mul_ps(d0, d0), q1 = _mm_mul_ps(d1, d1);
+        a2 = _mm_add_ps(a2, q0);
+        b2 = _mm_add_ps(b2, q1);
+        if (M3) {
+            a3 = _mm_add_ps(a3, _mm_mul_ps(q0, d0));
+            b3 = _mm_add_ps(b3, _mm_mul_ps(q1, d1));
+        }
+        if (M4) {
+            a4 = _mm_add_ps(a4, _mm_mul_ps(q0, q0));
+            b4 = _mm_add_ps(b4, _mm_mul_ps(q1, q1));
+        }
+    }
+    float r2 = hsum(_mm_add_ps(a2, b2)), r3 = hsum(_mm_add_ps(a3, b3)), r4 = hsum(_mm_add_ps(a4, b4));
+    for (; i < n; i++) {
+        float d = x[i] - mean, q = d * d;
+        r2 += q;
+        r3 += q * d;
+        r4 += q * q;
+    }
+    *s2 = r2;
+    if (M3) *s3 = r3;
+    if (M4) *s4 = r4;
+}
+
+static inline void axpy_sse(float *y, const float *x, float a, size_t n)
+{
+    const __m128 va = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+static inline void scale_sse(float *x, size_t n, float scale)
+{
+    const __m128 vs = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), vs));
+    }
+    for (; i < n; i++) {
+        x[i] *= scale;
+    }
+}
+
+static inline void add_sse(float *x, size_t n, float addition)
+{
+    const __m128 va = _mm_set1_ps(addition);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), va));
+    }
+    for (; i < n; i++) {
+        x[i] += addition;
+    }
+}
+
+static inline void accumulate_sse(float *acc, const float *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(x + i)));
+    }
+    for (; i < n; i++) {
+        acc[i] += x[i];
+    }
+}
+
+static inline void squared_deviation_sse(float *acc, const float *x, const float *mean, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(mean + i));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(d, d)));
+    }
+    for (; i < n; i++) {
+        float d = x[i] - mean[i];
+        acc[i] += d * d;
+    }
+}
+
+// x = x / d, or sqrt(x / d) when ROOT; both round as the scalar division / sqrt
+template <bool ROOT>
+static inline void divide_sse(float *x, size_t n, float d)
+{
+    const __m128 vd = _mm_set1_ps(d);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 q = _mm_div_ps(_mm_loadu_ps(x + i), vd);
+        _mm_storeu_ps(x + i, ROOT ? _mm_sqrt_ps(q) : q);
+    }
+    for (; i < n; i++) {
+        x[i] = ROOT ? sqrtf(x[i] / d) : x[i] / d;
+    }
+}
+
+/* AVX2 + FMA */
+
+__attribute__((target("avx2,fma")))
+static inline float sum_avx2(const float *x, size_t n)
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a0 = _mm256_add_ps(a0, _mm256_loadu_ps(x + i));
+        a1 = _mm256_add_ps(a1, _mm256_loadu_ps(x + i + 8));
+        a2 = _mm256_add_ps(a2, _mm256_loadu_ps(x + i + 16));
+        a3 = _mm256_add_ps(a3, _mm256_loadu_ps(x + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm256_add_ps(a0, _mm256_loadu_ps(x + i));
+    }
+    float res = hsum(_mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+    for (; i < n; i++) {
+        res += x[i];
+    }
+    return res;
+}
+
+__attribute__((target("avx2,fma")))
+static inline float sum_squares_avx2(const float *x, size_t n)
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256 v0 = _mm256_loadu_ps(x + i), v1 = _mm256_loadu_ps(x + i + 8);
+        __m256 v2 = _mm256_loadu_ps(x + i + 16), v3 = _mm256_loadu_ps(x + i + 24);
+        a0 = _mm256_fmadd_ps(v0, v0, a0);
+        a1 = _mm256_fmadd_ps(v1, v1, a1);
+        a2 = _mm256_fmadd_ps(v2, v2, a2);
+        a3 = _mm256_fmadd_ps(v3, v3, a3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        a0 = _mm256_fmadd_ps(v, v, a0);
+    }
+    float res = hsum(_mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+    for (; i < n; i++) {
+        res += x[i] * x[i];
+    }
+    return res;
+}
+
+template <bool M3, bool M4>
+__attribute__((target("avx2,fma")))
+static inline void moments_avx2(const float *x, size_t n, float mean, float *s2, float *s3, float *s4)
+{
+    const __m256 mu = _mm256_set1_ps(mean);
+    __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps(), a4 = _mm256_setzero_ps();
+    __m256 b2 = _mm256_setzero_ps(), b3 = _mm256_setzero_ps(), b4 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), mu);
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(x + i + 8), mu);
+        __m256 q0 = _mm256_mul_ps(d0, d0), q1 = _mm256_mul_ps(d1, d1);
+        a2 = _mm256_add_ps(a2, q0);
+        b2 = _mm256_add_ps(b2, q1);
+        if (M3) {
+            a3 = _mm256_fmadd_ps(q0, d0, a3);
+            b3 = _mm256_fmadd_ps(q1, d1, b3);
+        }
+        if (M4) {
+            a4 = _mm256_fmadd_ps(q0, q0, a4);
+            b4 = _mm256_fmadd_ps(q1, q1, b4);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), mu);
+        __m256 q = _mm256_mul_ps(d, d);
+        a2 = _mm256_add_ps(a2, q);
+        if (M3) a3 = _mm256_fmadd_ps(q, d, a3);
+        if (M4) a4 = _mm256_fmadd_ps(q, q, a4);
+    }
+    float r2 = hsum(_mm256_add_ps(a2, b2)), r3 = hsum(_mm256_add_ps(a3, b3)), r4 = hsum(_mm256_add_ps(a4, b4));
+    for (; i < n; i++) {
+        float d = x[i] - mean, q = d * d;
+        r2 += q;
+        r3 += q * d;
+        r4 += q * q;
+    }
+    *s2 = r2;
+    if (M3) *s3 = r3;
+    if (M4) *s4 = r4;
+}
+
+__attribute__((target("avx2,fma")))
+static inline void axpy_avx2(float *y, const float *x, float a, size_t n)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void scale_avx2(float *x, size_t n, float scale)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), vs));
+    }
+    for (; i < n; i++) {
+        x[i] *= scale;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void add_avx2(float *x, size_t n, float addition)
+{
+    const __m256 va = _mm256_set1_ps(addition);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), va));
+    }
+    for (; i < n; i++) {
+        x[i] += addition;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void accumulate_avx2(float *acc, const float *x, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_loadu_ps(x + i)));
+    }
+    for (; i < n; i++) {
+        acc[i] += x[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline void squared_deviation_avx2(float *acc, const float *x, const float *mean, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(mean + i));
+        _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(d, d, _mm256_loadu_ps(acc + i)));
+    }
+    for (; i < n; i++) {
+        float d = x[i] - mean[i];
+        acc[i] += d * d;
+    }
+}
+
+template <bool ROOT>
+__attribute__((target("avx2,fma")))
+static inline void divide_avx2(float *x, size_t n, float d)
+{
+    const __m256 vd = _mm256_set1_ps(d);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 q = _mm256_div_ps(_mm256_loadu_ps(x + i), vd);
+        _mm256_storeu_ps(x + i, ROOT ? _mm256_sqrt_ps(q) : q);
+    }
+    for (; i < n; i++) {
+        x[i] = ROOT ? sqrtf(x[i] / d) : x[i] / d;
+    }
+}
+
+template <bool M3, bool M4>
+static inline void moments_at_level(const float *x, size_t n, float mean, float *s2, float *s3, float *s4)
+{
+    if (selected_level() >= LEVEL_AVX2) {
+        moments_avx2<M3, M4>(x, n, mean, s2, s3, s4);
+    }
+    else {
+        moments_sse<M3, M4>(x, n, mean, s2, s3, s4);
+    }
+}
+
+} // namespace detail
+
+/**
+ * Level the kernels run at, LEVEL_NONE when numpy should use its scalar loops
+ */
+static inline int get_level()
+{
+    return detail::selected_level();
+}
+
+/**
+ * Select a level for the whole process, e.g. LEVEL_NONE to compare against
+ * the scalar loops. Not thread safe; call before running any DSP.
+ * @param level LEVEL_NONE, LEVEL_SSE or LEVEL_AVX2
+ * @returns the level in effect, lowered to what this CPU supports
+ */
+static inline int set_level(int level)
+{
+    if (level < LEVEL_NONE) level = LEVEL_NONE;
+    if (level > detail::supported_level()) level = detail::supported_level();
+    detail::selected_level() = level;
+    return level;
+}
+
+static inline bool enabled()
+{
+    return detail::selected_level() != LEVEL_NONE;
+}
+
+static inline const char *level_name(int level)
+{
+    switch (level) {
+        case LEVEL_SSE: return "sse2";
+        case LEVEL_AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+/* Kernels. Only call these when enabled() */
+
+static inline float sum(const float *x, size_t n)
+{
+    return get_level() >= LEVEL_AVX2 ? detail::sum_avx2(x, n) : detail::sum_sse(x, n);
+}
+
+static inline float sum_squares(const float *x, size_t n)
+{
+    return get_level() >= LEVEL_AVX2 ? detail::sum_squares_avx2(x, n) : detail::sum_squares_sse(x, n);
+}
+
+/**
+ * Central moment sums of x around mean: sum of (x - mean)^2 into s2, and of
+ * the third / fourth powers into s3 / s4 when those are not NULL
+ */
+static inline void moments(const float *x, size_t n, float mean, float *s2, float *s3, float *s4)
+{
+    if (s3 && s4) detail::moments_at_level<true, true>(x, n, mean, s2, s3, s4);
+    else if (s3) detail::moments_at_level<true, false>(x, n, mean, s2, s3, s4);
+    else if (s4) detail::moments_at_level<false, true>(x, n, mean, s2, s3, s4);
+    else detail::moments_at_level<false, false>(x, n, mean, s2, s3, s4);
+}
+
+// y += a * x
+static inline void axpy(float *y, const float *x, float a, size_t n)
+{
+    if (get_level() >= LEVEL_AVX2) detail::axpy_avx2(y, x, a, n);
+    else detail::axpy_sse(y, x, a, n);
+}
+
+static inline void scale(float *x, size_t n, float scale)
+{
+    if (get_level() >= LEVEL_AVX2) detail::scale_avx2(x, n, scale);
+    else detail::scale_sse(x, n, scale);
+}
+
+static inline void add(float *x, size_t n, float addition)
+{
+    if (get_level() >= LEVEL_AVX2) detail::add_avx2(x, n, addition);
+    else detail::add_sse(x, n, addition);
+}
+
+// acc += x, element-wise
+static inline void accumulate(float *acc, const float *x, size_t n)
+{
+    if (get_level() >= LEVEL_AVX2) detail::accumulate_avx2(acc, x, n);
+    else detail::accumulate_sse(acc, x, n);
+}
+
+// acc += (x - mean)^2, element-wise
+static inline void squared_deviation(float *acc, const float *x, const float *mean, size_t n)
+{
+    if (get_level() >= LEVEL_AVX2) detail::squared_deviation_avx2(acc, x, mean, n);
+    else detail::squared_deviation_sse(acc, x, mean, n);
+}
+
+// x = x / d, element-wise
+static inline void divide(float *x, size_t n, float d)
+{
+    if (get_level() >= LEVEL_AVX2) detail::divide_avx2<false>(x, n, d);
+    else detail::divide_sse<false>(x, n, d);
+}
+
+// x = sqrt(x / d), element-wise
+static inline void sqrt_divide(float *x, size_t n, float d)
+{
+    if (get_level() >= LEVEL_AVX2) detail::divide_avx2<true>(x, n, d);
+    else detail::divide_sse<true>(x, n, d);
+}
+
+} // namespace host_simd
+} // namespace ei
+
+#endif // _EIDSP_HOST_SIMD_H_
@@ -32,3 +32,5 @@
 
 size_t ei_memory_in_use = 0;
 size_t ei_memory_peak_use = 0;
+
+ei::ei_dsp_scratch_t *ei::ei_dsp_scratch_current = nullptr;
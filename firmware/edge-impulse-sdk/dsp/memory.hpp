@@ -34,6 +34,8 @@
 // clang-format off
 #include <functional>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
 #include <memory>
 #include "../porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
@@ -64,6 +66,168 @@ typedef std::unique_ptr<void, std::function<void(void*)>> ei_unique_ptr_t;
 
 namespace ei {
 
+/**
+ * Scratch arena for DSP temporaries (opt-in).
+ *
+ * While an arena is active (see ei_dsp_scratch_scope), ei_dsp_malloc,
+ * ei_dsp_calloc and matrix buffers are carved from a caller-provided buffer
+ * by bumping an offset. Freeing the most recent block pops it, so the
+ * per-frame temporaries of a feature loop reuse the same bytes; blocks freed
+ * out of order are popped once everything above them is gone, and whatever
+ * is left is dropped in O(1) when the scope ends. A request that does not
+ * fit goes to ei_malloc and is counted, so `peak` and `fallbacks` tell how
+ * large the buffer should be.
+ *
+ * Everything allocated inside a scope must be dead by the time it ends; a
+ * late free of an arena block is ignored. Not thread safe: DSP runs on one
+ * core at a time.
+ */
+typedef struct ei_dsp_scratch {
+    uint8_t *base;
+    size_t size;
+    size_t used;                // bump offset
+    size_t top;                 // payload offset of the newest live block, 0 if none
+    size_t peak;                // highest `used` since ei_dsp_scratch_init()
+    uint32_t allocs;            // blocks served from the arena
+    uint32_t fallbacks;         // requests that did not fit
+    size_t fallback_bytes;
+    uint32_t scopes;
+    bool active;
+} ei_dsp_scratch_t;
+
+// arena that ei_dsp_* allocations go to while it is active
+extern ei_dsp_scratch_t *ei_dsp_scratch_current;
+
+#define EI_DSP_SCRATCH_ALIGN(n)     (((n) + 7) & ~(size_t)7)
+
+// per-block header: payload offset of the block below, and whether this one was freed
+typedef struct {
+    uint32_t prev_top;
+    uint32_t freed;
+} ei_dsp_scratch_header_t;
+
+__attribute__((unused)) static void ei_dsp_scratch_init(ei_dsp_scratch_t *arena, void *buffer, size_t size)
+{
+    memset(arena, 0, sizeof(*arena));
+    // keep blocks 8-byte aligned whatever the buffer's alignment
+    size_t skew = (8 - ((uintptr_t)buffer & 7)) & 7;
+    arena->base = (uint8_t *)buffer + skew;
+    arena->size = size > skew ? size - skew : 0;
+}
+
+__attribute__((unused)) static void *ei_dsp_scratch_alloc(size_t bytes)
+{
+    ei_dsp_scratch_t *arena = ei_dsp_scratch_current;
+    if (!arena || !arena->active) {
+        return nullptr;
+    }
+    size_t hdr = EI_DSP_SCRATCH_ALIGN(arena->used);
+    size_t end = hdr + sizeof(ei_dsp_scratch_header_t) + EI_DSP_SCRATCH_ALIGN(bytes);
+    if (end > arena->size) {
+        arena->fallbacks++;
+        arena->fallback_bytes += bytes;
+        return nullptr;
+    }
+    ei_dsp_scratch_header_t *h = (ei_dsp_scratch_header_t *)(arena->base + hdr);
+    h->prev_top = (uint32_t)arena->top;
+    h->freed = 0;
+    arena->top = hdr + sizeof(ei_dsp_scratch_header_t);
+    arena->used = end;
+    if (end > arena->peak) {
+        arena->peak = end;
+    }
+    arena->allocs++;
+    return arena->base + arena->top;
+}
+
+// Returns false if ptr is not an arena block (and should go to ei_free).
+__attribute__((unused)) static bool ei_dsp_scratch_release(void *ptr)
+{
+    ei_dsp_scratch_t *arena = ei_dsp_scratch_current;
+    if (!arena || (uint8_t *)ptr < arena->base || (uint8_t *)ptr >= arena->base + arena->size) {
+        return false;
+    }
+    if (!arena->active) {
+        return true;
+    }
+    ei_dsp_scratch_header_t *h = (ei_dsp_scratch_header_t *)((uint8_t *)ptr - sizeof(ei_dsp_scratch_header_t));
+    h->freed = 1;
+    while (arena->top) {
+        h = (ei_dsp_scratch_header_t *)(arena->base + arena->top - sizeof(ei_dsp_scratch_header_t));
+        if (!h->freed) {
+            break;
+        }
+        arena->used = arena->top - sizeof(ei_dsp_scratch_header_t);
+        arena->top = h->prev_top;
+    }
+    return true;
+}
+
+// ei_malloc / ei_calloc / ei_free that use the active arena first
+__attribute__((unused)) static void *ei_dsp_scratch_malloc(size_t size)
+{
+    void *ptr = ei_dsp_scratch_alloc(size);
+    return ptr ? ptr : ei_malloc(size);
+}
+
+__attribute__((unused)) static void *ei_dsp_scratch_calloc(size_t num, size_t size)
+{
+    void *ptr = ei_dsp_scratch_alloc(num * size);
+    if (ptr) {
+        memset(ptr, 0, num * size);
+        return ptr;
+    }
+    return ei_calloc(num, size);
+}
+
+__attribute__((unused)) static void ei_dsp_scratch_free(void *ptr)
+{
+    if (ptr && !ei_dsp_scratch_release(ptr)) {
+        ei_free(ptr);
+    }
+}
+
+/**
+ * Activates an arena for the lifetime of the object, e.g. around one call to
+ * a feature extraction function. Scopes nest: an inner scope on the same
+ * arena allocates above the outer one's blocks and pops back to them when it
+ * ends, and the previous arena is restored at the end.
+ */
+class ei_dsp_scratch_scope {
+public:
+    explicit ei_dsp_scratch_scope(ei_dsp_scratch_t *arena)
+        : arena(arena), prev(ei_dsp_scratch_current), was_active(arena->active),
+          saved_used(arena->active ? arena->used : 0), saved_top(arena->active ? arena->top : 0)
+    {
+        arena->used = saved_used;
+        arena->top = saved_top;
+        arena->active = true;
+        arena->scopes++;
+        ei_dsp_scratch_current = arena;
+    }
+
+    ~ei_dsp_scratch_scope()
+    {
+        arena->active = was_active;
+        arena->used = saved_used;
+        arena->top = saved_top;
+        // the outermost arena stays current, so late frees of its blocks are recognised
+        if (prev) {
+            ei_dsp_scratch_current = prev;
+        }
+    }
+
+private:
+    ei_dsp_scratch_t *arena;
+    ei_dsp_scratch_t *prev;
+    bool was_active;
+    size_t saved_used;
+    size_t saved_top;
+
+    ei_dsp_scratch_scope(const ei_dsp_scratch_scope &) = delete;
+    ei_dsp_scratch_scope &operator=(const ei_dsp_scratch_scope &) = delete;
+};
+
 /**
  * These are macros used to track allocations when running DSP processes.
  * Enable memory tracking through the EIDSP_TRACK_ALLOCATIONS macro.
@@ -138,9 +302,9 @@ namespace ei {
     #define ei_dsp_register_matrix_alloc(...) (void)0
     #define ei_dsp_register_free(...) (void)0
     #define ei_dsp_register_matrix_free(...) (void)0
-    #define ei_dsp_malloc ei_malloc
-    #define ei_dsp_calloc ei_calloc
-    #define ei_dsp_free(ptr, size) ei_free(ptr)
+    #define ei_dsp_malloc ei::ei_dsp_scratch_malloc
+    #define ei_dsp_calloc ei::ei_dsp_scratch_calloc
+    #define ei_dsp_free(ptr, size) ei::ei_dsp_scratch_free(ptr)
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
@@ -157,7 +321,7 @@ public:
      * @param size The size of the memory block, in bytes.
      */
     static void *ei_wrapped_malloc(const char *fn, const char *file, int line, size_t size) {
-        void *ptr = ei_malloc(size);
+        void *ptr = ei_dsp_scratch_malloc(size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, size, ptr);
         }
@@ -171,7 +335,7 @@ public:
      * @param size Size of each element
      */
     static void *ei_wrapped_calloc(const char *fn, const char *file, int line, size_t num, size_t size) {
-        void *ptr = ei_calloc(num, size);
+        void *ptr = ei_dsp_scratch_calloc(num, size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, num * size, ptr);
         }
@@ -184,7 +348,7 @@ public:
      * @param size Size of the block of memory previously allocated.
      */
     static void ei_wrapped_free(const char *fn, const char *file, int line, void *ptr, size_t size) {
-        ei_free(ptr);
+        ei_dsp_scratch_free(ptr);
         ei_dsp_register_free_internal(fn, file, line, size, ptr);
     }
 };
@@ -192,7 +356,7 @@ public:
 
 // This needs to be a real function so I can bind with a lambda
 __attribute__((unused)) static void ei_dsp_free_func(void *ptr, size_t size) {
-    ei_free(ptr);
+    ei_dsp_scratch_free(ptr);
 #if EIDSP_TRACK_ALLOCATIONS
     ei_dsp_register_free_internal("unique_ptr free", "", 0, size, ptr);
 #endif
@@ -212,7 +376,7 @@ static ei_unique_ptr_t make_tracked_unique_ptr(void* ptr_in, size_t size) {
     auto ptr = reinterpret_cast<void**>(ptr_in);
     *ptr = ei_dsp_malloc(size);
     return ei_unique_ptr_t(*ptr, [size](void *ptr) {
-        ei_free(ptr);
+        ei_dsp_scratch_free(ptr);
         ei_dsp_register_free_internal("unique_ptr", "", 0, size, ptr);
     });
 }
@@ -231,8 +395,8 @@ __attribute__((warn_unused_result)) __attribute__((unused))
 static ei_unique_ptr_t make_tracked_unique_ptr(void* ptr_in, size_t size)
 {
     auto ptr = reinterpret_cast<void**>(ptr_in);
-    *ptr = ei_malloc(size);
-    return ei_unique_ptr_t(*ptr, ei_free);
+    *ptr = ei_dsp_scratch_malloc(size);
+    return ei_unique_ptr_t(*ptr, ei_dsp_scratch_free);
 }
 #endif
 
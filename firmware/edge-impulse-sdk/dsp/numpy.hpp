@@ -61,6 +61,7 @@
 #include "ei_utils.h"
 #include "dct/fast-dct-fft.h"
 #include "kissfft/kiss_fftr.h"
+#include "fft_plans.hpp"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 
 #if __has_include("model-parameters/model_metadata.h")
@@ -80,6 +81,14 @@
 #else
 #define EIDSP_INCLUDE_KISSFFT 1
 #include "edge-impulse-sdk/dsp/dsp_engines/ei_no_hw_dsp.h"
+#if EIDSP_USE_POW2_RFFT
+#include "edge-impulse-sdk/dsp/pow2_rfft.hpp"
+#define EIDSP_POW2_RFFT_ACTIVE 1
+#endif
+#if EIDSP_USE_HOST_SIMD && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include "edge-impulse-sdk/dsp/host_simd.hpp"
+#define EIDSP_HOST_SIMD_ACTIVE 1
+#endif
 #endif
 
 // More decisions on kissfft
@@ -229,6 +238,11 @@ public:
     }
 
     static float sum(float *input_array, size_t input_array_size) {
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            return host_simd::sum(input_array, input_array_size);
+        }
+#endif
         float res = 0.0f;
         for (size_t ix = 0; ix < input_array_size; ix++) {
             res += input_array[ix];
@@ -342,6 +356,16 @@ public:
             EIDSP_ERR(status);
         }
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            // walk matrix2 by rows instead of columns: out_row += row[k] * matrix2[k]
+            float *out_row = out_matrix->buffer + (i * matrix2->cols);
+            for (size_t k = 0; k < matrix1_cols; k++) {
+                host_simd::axpy(out_row, matrix2->buffer + (k * matrix2->cols), row[k], matrix2->cols);
+            }
+            return EIDSP_OK;
+        }
+#endif
         for (size_t j = 0; j < matrix2->cols; j++) {
             float tmp = 0.0f;
             for (size_t k = 0; k < matrix1_cols; k++) {
@@ -788,6 +812,12 @@ public:
             return status;
         }
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            host_simd::scale(matrix->buffer, matrix->rows * matrix->cols, scale);
+            return EIDSP_OK;
+        }
+#endif
         for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] *= scale;
         }
@@ -829,6 +859,12 @@ public:
      * @returns 0 if OK
      */
     static int add(matrix_t *matrix, float addition) {
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            host_simd::add(matrix->buffer, matrix->rows * matrix->cols, addition);
+            return EIDSP_OK;
+        }
+#endif
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] += addition;
         }
@@ -868,6 +904,12 @@ public:
      * @returns 0 if OK
      */
     static int subtract(matrix_t *matrix, float subtraction) {
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            host_simd::add(matrix->buffer, matrix->rows * matrix->cols, -subtraction);
+            return EIDSP_OK;
+        }
+#endif
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] -= subtraction;
         }
@@ -921,6 +963,13 @@ public:
             arm_rms_f32(matrix->buffer + (row * matrix->cols), matrix->cols, &rms_result);
             output_matrix->buffer[row] = rms_result;
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+            if (host_simd::enabled()) {
+                float sum = host_simd::sum_squares(matrix->buffer + (row * matrix->cols), matrix->cols);
+                output_matrix->buffer[row] = sqrt(sum / static_cast<float>(matrix->cols));
+                continue;
+            }
+#endif
             float sum = 0.0;
             for(size_t ix = 0; ix < matrix->cols; ix++) {
                 float v = matrix->buffer[(row * matrix->cols) + ix];
@@ -952,6 +1001,13 @@ public:
             arm_mean_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &mean);
             output_matrix->buffer[row] = mean;
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+            if (host_simd::enabled()) {
+                float sum = host_simd::sum(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols);
+                output_matrix->buffer[row] = sum / input_matrix->cols;
+                continue;
+            }
+#endif
             float sum = 0.0f;
 
             for (size_t col = 0; col < input_matrix->cols; col++) {
@@ -980,6 +1036,19 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            // sum whole rows into the output instead of walking each column
+            memset(output_matrix->buffer, 0, input_matrix->cols * sizeof(float));
+            for (size_t row = 0; row < input_matrix->rows; row++) {
+                host_simd::accumulate(output_matrix->buffer, input_matrix->buffer + (row * input_matrix->cols),
+                    input_matrix->cols);
+            }
+            host_simd::divide(output_matrix->buffer, input_matrix->cols, input_matrix->rows);
+            return EIDSP_OK;
+        }
+#endif
+
         for (size_t col = 0; col < input_matrix->cols; col++) {
             // Note - not using CMSIS-DSP here
             // gathering up the current columnand moving it into sequential memory to use
@@ -1018,6 +1087,27 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_HOST_SIMD_ACTIVE
+        if (host_simd::enabled()) {
+            EI_DSP_MATRIX(mean_matrix, input_matrix->cols, 1);
+            if (!mean_matrix.buffer) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            int ret = mean_axis0(input_matrix, &mean_matrix);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+
+            memset(output_matrix->buffer, 0, input_matrix->cols * sizeof(float));
+            for (size_t row = 0; row < input_matrix->rows; row++) {
+                host_simd::squared_deviation(output_matrix->buffer, input_matrix->buffer + (row * input_matrix->cols),
+                    mean_matrix.buffer, input_matrix->cols);
+            }
+            host_simd::sqrt_divide(output_matrix->buffer, input_matrix->cols, input_matrix->rows);
+            return EIDSP_OK;
+        }
+#endif
+
         for (size_t col = 0; col < input_matrix->cols; col++) {
             float sum = 0.0f;
 
@@ -1134,6 +1224,16 @@ public:
             arm_sqrt_f32(var, &std);
             output_matrix->buffer[row] = std;
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+            if (host_simd::enabled()) {
+                const float *x = input_matrix->buffer + (row * input_matrix->cols);
+                float mean = host_simd::sum(x, input_matrix->cols) / input_matrix->cols;
+                float std;
+                host_simd::moments(x, input_matrix->cols, mean, &std, NULL, NULL);
+                output_matrix->buffer[row] = sqrt(std / input_matrix->cols);
+                continue;
+            }
+#endif
             float sum = 0.0f;
 
             for (size_t col = 0; col < input_matrix->cols; col++) {
@@ -1193,6 +1293,19 @@ public:
                 output_matrix->buffer[row] = m_3 / var;
             }
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+            if (host_simd::enabled()) {
+                const float *x = input_matrix->buffer + (row * input_matrix->cols);
+                float mean = host_simd::sum(x, input_matrix->cols) / input_matrix->cols;
+                float m_2, m_3;
+                host_simd::moments(x, input_matrix->cols, mean, &m_2, &m_3, NULL);
+                m_3 = m_3 / input_matrix->cols;
+                m_2 = m_2 / input_matrix->cols;
+                m_2 = sqrt(m_2 * m_2 * m_2);
+                output_matrix->buffer[row] = (m_2 == 0.0f) ? 0.0f : m_3 / m_2;
+                continue;
+            }
+#endif
             float sum = 0.0f;
             float mean;
 
@@ -1264,6 +1377,19 @@ public:
                 output_matrix->buffer[row] = (m_4 / var) - 3.0f;
             }
 #else
+#if EIDSP_HOST_SIMD_ACTIVE
+            if (host_simd::enabled()) {
+                const float *x = input_matrix->buffer + (row * input_matrix->cols);
+                float mean = host_simd::sum(x, input_matrix->cols) / input_matrix->cols;
+                float variance, m_4;
+                host_simd::moments(x, input_matrix->cols, mean, &variance, NULL, &m_4);
+                m_4 = m_4 / input_matrix->cols;
+                variance = variance / input_matrix->cols;
+                variance = variance * variance;
+                output_matrix->buffer[row] = (variance == 0.0f) ? -3.0f : (m_4 / variance) - 3.0f;
+                continue;
+            }
+#endif
             // Calculate the mean
             float mean = 0.0f;
             float sum = 0.0f;
@@ -1363,6 +1489,14 @@ public:
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
+#if EIDSP_POW2_RFFT_ACTIVE
+        // no hardware FFT: power-of-two sizes read src directly and use
+        // fft_input as the transform's work buffer
+        if (ei::fft::pow2_r2c_supported(n_fft)) {
+            return ei::fft::pow2_r2c_fft(src, src_size, fft_input.buffer, output, n_fft);
+        }
+#endif
+
         // If the buffer wasn't assigned to source above, let's copy and pad
         // copy from src to fft_input
         memcpy(fft_input.buffer, src, src_size * sizeof(float));
@@ -1744,20 +1878,17 @@ public:
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
     #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
-        // create fftr context
-        size_t kiss_fftr_mem_length;
-
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        // fftr context from the plan cache, or built for this call
+        ei_fft_plan_t plan;
+        int ret = ei_fft_plan_acquire(&plan, n_fft, 0);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
-        kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
+        kiss_fftr(plan.cfg, fft_input, (kiss_fft_cpx*)output);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        ei_fft_plan_release(&plan);
 
         return EIDSP_OK;
     #else
@@ -45,9 +45,9 @@
 #include "config.hpp"
 #include "edge-impulse-sdk/dsp/returntypes.h"
 
-#if EIDSP_TRACK_ALLOCATIONS
+#ifdef __cplusplus
 #include "memory.hpp"
-#endif
+#endif // __cplusplus
 
 #ifdef __cplusplus
 namespace ei {
@@ -104,7 +104,7 @@ typedef struct ei_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (float*)ei_calloc(n_rows * n_cols * sizeof(float), 1);
+            buffer = (float*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(float), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -129,7 +129,7 @@ typedef struct ei_matrix {
 
     ~ei_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -219,7 +219,7 @@ typedef struct ei_matrix_i8 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (int8_t*)ei_calloc(n_rows * n_cols * sizeof(int8_t), 1);
+            buffer = (int8_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(int8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -244,7 +244,7 @@ typedef struct ei_matrix_i8 {
 
     ~ei_matrix_i8() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -330,7 +330,7 @@ typedef struct ei_matrix_i32 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (int32_t*)ei_calloc(n_rows * n_cols * sizeof(int32_t), 1);
+            buffer = (int32_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(int32_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -355,7 +355,7 @@ typedef struct ei_matrix_i32 {
 
     ~ei_matrix_i32() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -452,7 +452,7 @@ typedef struct ei_quantized_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (uint8_t*)ei_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
+            buffer = (uint8_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -477,7 +477,7 @@ typedef struct ei_quantized_matrix {
 
     ~ei_quantized_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -563,7 +563,7 @@ typedef struct ei_matrix_u8 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (uint8_t*)ei_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
+            buffer = (uint8_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -588,7 +588,7 @@ typedef struct ei_matrix_u8 {
 
     ~ei_matrix_u8() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#ifndef _EIDSP_POW2_RFFT_H_
+#define _EIDSP_POW2_RFFT_H_
+
+#include <stddef.h>
+#include <type_traits>
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+
+/**
+ * Real FFT for power-of-two sizes POW2_RFFT_MIN_SIZE..POW2_RFFT_MAX_SIZE,
+ * used by numpy::rfft when no hardware FFT engine is selected.
+ *
+ * An N-point real transform is an N/2-point complex FFT of the packed sample
+ * pairs (x[2m] + i x[2m+1]) followed by one split pass. The complex FFT is
+ * decimation in time on separate real / imaginary arrays: the bit reversal is
+ * done while packing the input, then radix-4 stages (three complex multiplies
+ * per four points) run, after one radix-2 stage when log2(N/2) is odd. Inner
+ * loops walk contiguous data and per-stage twiddles, which lets compilers
+ * vectorize them (NEON, AVX2).
+ *
+ * Twiddles are computed at compile time into a constexpr table per size, so
+ * they live in flash on MCU targets and a call allocates nothing beyond the
+ * caller's work buffer of N floats. Other sizes stay on kissfft.
+ */
+
+namespace ei {
+namespace fft {
+
+constexpr size_t POW2_RFFT_MIN_SIZE = 64;
+constexpr size_t POW2_RFFT_MAX_SIZE = 4096;
+
+namespace pow2_detail {
+
+struct sincos_t {
+    double c, s;
+};
+
+constexpr double sin_poly(double x)
+{
+    double term = x, sum = x;
+    for (int i = 1; i < 12; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos_poly(double x)
+{
+    double term = 1.0, sum = 1.0;
+    for (int i = 1; i < 12; i++) {
+        term *= -x * x / ((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * cos and sin of 2 pi k / n. The angle is folded into [0, pi/4] with integer
+ * arithmetic, so symmetric twiddles come out exactly symmetric.
+ */
+constexpr sincos_t sincos_turn(size_t k, size_t n)
+{
+    k %= n;
+    const size_t quadrant = (4 * k) / n;
+    const size_t r = 4 * k - quadrant * n; // angle within the quadrant, in (pi/2)/n
+    const double half_pi = 1.57079632679489661923;
+    double c = 0.0, s = 0.0;
+    if (2 * r <= n) {
+        const double x = half_pi * (double)r / (double)n;
+        c = cos_poly(x);
+        s = sin_poly(x);
+    }
+    else {
+        const double x = half_pi * (double)(n - r) / (double)n;
+        c = sin_poly(x);
+        s = cos_poly(x);
+    }
+    switch (quadrant) {
+        case 0: return { c, s };
+        case 1: return { -s, c };
+        case 2: return { -c, -s };
+        default: return { s, -c };
+    }
+}
+
+constexpr unsigned log2_pow2(size_t n)
+{
+    unsigned bits = 0;
+    while (n > 1) {
+        n >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * Twiddles for one size. A radix-4 stage with quarter size h stores, for
+ * j < h, W^j, W^2j and W^3j of W = exp(-2 pi i / 4h) as six runs of h floats
+ * (re, im of each). The split pass stores exp(-2 pi i k / N) for k <= N/4.
+ */
+template <size_t N>
+struct pow2_rfft_tables {
+    static constexpr size_t M = N / 2;
+    static constexpr size_t FIRST_H = (log2_pow2(M) & 1) ? 2 : 1;
+    static constexpr size_t STAGE_FLOATS = 6 * (M / 3 + 1);
+
+    float stage[STAGE_FLOATS];
+    float split_re[M / 2 + 1];
+    float split_im[M / 2 + 1];
+
+    constexpr pow2_rfft_tables() : stage(), split_re(), split_im()
+    {
+        size_t off = 0;
+        for (size_t h = FIRST_H; 4 * h <= M; h *= 4) {
+            for (size_t j = 0; j < h; j++) {
+                for (size_t p = 1; p <= 3; p++) {
+                    const sincos_t w = sincos_turn(p * j, 4 * h);
+                    stage[off + (2 * p - 2) * h + j] = (float)w.c;
+                    stage[off + (2 * p - 1) * h + j] = (float)-w.s;
+                }
+            }
+            off += 6 * h;
+        }
+        for (size_t k = 0; k <= M / 2; k++) {
+            const sincos_t w = sincos_turn(k, N);
+            split_re[k] = (float)w.c;
+            split_im[k] = (float)-w.s;
+        }
+    }
+};
+
+} // namespace pow2_detail
+
+template <size_t N>
+class pow2_rfft {
+public:
+    static_assert(N >= 8 && (N & (N - 1)) == 0, "pow2_rfft needs a power-of-two size");
+
+    /**
+     * Forward real FFT, unscaled, same result as kiss_fftr.
+     * @param src Real input, zero padded to N (extra samples are ignored)
+     * @param src_size Number of samples in src
+     * @param work Work buffer of N floats
+     * @param output N / 2 + 1 complex bins
+     */
+    static void run(const float *src, size_t src_size, float *work, fft_complex_t *output)
+    {
+        float *re = work;
+        float *im = work + M;
+
+        pack(src, src_size, re, im);
+        if (tables_t::FIRST_H == 2) {
+            radix2(re, im);
+        }
+        radix4_stages<tables_t::FIRST_H>(re, im, tables.stage, stage_tag<tables_t::FIRST_H>());
+        split(re, im, output);
+    }
+
+private:
+    typedef pow2_detail::pow2_rfft_tables<N> tables_t;
+    static constexpr size_t M = N / 2;
+    static constexpr tables_t tables = tables_t();
+
+    // true while a radix-4 stage of quarter size H fits
+    template <size_t H>
+    using stage_tag = std::integral_constant<bool, (4 * H <= M)>;
+
+    // Sample pairs to complex points, written in bit-reversed order
+    static void pack(const float *src, size_t src_size, float *re, float *im)
+    {
+        size_t rev = 0;
+        for (size_t m = 0; m < M; m++) {
+            const size_t ix = 2 * m;
+            re[rev] = ix < src_size ? src[ix] : 0.0f;
+            im[rev] = ix + 1 < src_size ? src[ix + 1] : 0.0f;
+            // increment rev as a bit-reversed counter
+            size_t bit = M >> 1;
+            while (rev & bit) {
+                rev ^= bit;
+                bit >>= 1;
+            }
+            rev |= bit;
+        }
+    }
+
+    static void radix2(float *re, float *im)
+    {
+        for (size_t m = 0; m < M; m += 2) {
+            const float ar = re[m], ai = im[m], br = re[m + 1], bi = im[m + 1];
+            re[m] = ar + br;
+            im[m] = ai + bi;
+            re[m + 1] = ar - br;
+            im[m + 1] = ai - bi;
+        }
+    }
+
+    // Stages run from quarter size FIRST_H up by 4; H is a constant in each
+    // so the inner loops have fixed trip counts
+    template <size_t H>
+    static void radix4_stages(float *re, float *im, const float *tw, std::true_type)
+    {
+        for (size_t b = 0; b < M; b += 4 * H) {
+            radix4_block<H>(re + b, im + b, tw);
+        }
+        radix4_stages<4 * H>(re, im, tw + 6 * H, stage_tag<4 * H>());
+    }
+
+    template <size_t H>
+    static void radix4_stages(float *, float *, const float *, std::false_type)
+    {
+    }
+
+    // One radix-4 group of 4H points. The quarters do not overlap, which
+    // __restrict tells the compiler so the loop over j vectorizes.
+    template <size_t H>
+    static void radix4_block(float *__restrict re, float *__restrict im, const float *__restrict tw)
+    {
+        float *__restrict r0 = re, *__restrict r1 = re + H, *__restrict r2 = re + 2 * H, *__restrict r3 = re + 3 * H;
+        float *__restrict i0 = im, *__restrict i1 = im + H, *__restrict i2 = im + 2 * H, *__restrict i3 = im + 3 * H;
+        const float *w1r = tw, *w1i = tw + H;
+        const float *w2r = tw + 2 * H, *w2i = tw + 3 * H;
+        const float *w3r = tw + 4 * H, *w3i = tw + 5 * H;
+
+        for (size_t j = 0; j < H; j++) {
+            // bit-reversed input: the second quarter takes W^2j, the third W^j
+            const float x1r = r1[j] * w2r[j] - i1[j] * w2i[j];
+            const float x1i = r1[j] * w2i[j] + i1[j] * w2r[j];
+            const float x2r = r2[j] * w1r[j] - i2[j] * w1i[j];
+            const float x2i = r2[j] * w1i[j] + i2[j] * w1r[j];
+            const float x3r = r3[j] * w3r[j] - i3[j] * w3i[j];
+            const float x3i = r3[j] * w3i[j] + i3[j] * w3r[j];
+
+            const float s0r = r0[j] + x1r, s0i = i0[j] + x1i;
+            const float d0r = r0[j] - x1r, d0i = i0[j] - x1i;
+            const float s1r = x2r + x3r, s1i = x2i + x3i;
+            const float d1r = x2r - x3r, d1i = x2i - x3i;
+
+            r0[j] = s0r + s1r;
+            i0[j] = s0i + s1i;
+            r1[j] = d0r + d1i;
+            i1[j] = d0i - d1r;
+            r2[j] = s0r - s1r;
+            i2[j] = s0i - s1i;
+            r3[j] = d0r - d1i;
+            i3[j] = d0i + d1r;
+        }
+    }
+
+    // N/2-point complex spectrum Z to the N-point real spectrum X
+    static void split(const float *re, const float *im, fft_complex_t *output)
+    {
+        output[0].r = re[0] + im[0];
+        output[0].i = 0.0f;
+        output[M].r = re[0] - im[0];
+        output[M].i = 0.0f;
+        for (size_t k = 1; k <= M / 2; k++) {
+            // even and odd halves from Z[k] and conj(Z[M - k])
+            const float ar = re[k], ai = im[k];
+            const float br = re[M - k], bi = -im[M - k];
+            const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+            const float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+            // t = W^k * odd, with odd = -i * d
+            const float c = tables.split_re[k], s = tables.split_im[k];
+            const float tr = c * di + s * dr;
+            const float ti = s * di - c * dr;
+            output[k].r = er + tr;
+            output[k].i = ei + ti;
+            output[M - k].r = er - tr;
+            output[M - k].i = ti - ei;
+        }
+    }
+};
+
+template <size_t N>
+constexpr pow2_detail::pow2_rfft_tables<N> pow2_rfft<N>::tables;
+
+static inline bool pow2_r2c_supported(size_t n_fft)
+{
+    return n_fft >= POW2_RFFT_MIN_SIZE && n_fft <= POW2_RFFT_MAX_SIZE && (n_fft & (n_fft - 1)) == 0;
+}
+
+/**
+ * Real-to-complex FFT through pow2_rfft for a size picked at run time.
+ * @param src Real input, zero padded to n_fft
+ * @param src_size Number of samples in src
+ * @param work Work buffer of n_fft floats
+ * @param output n_fft / 2 + 1 complex bins
+ * @param n_fft FFT size
+ * @returns EIDSP_OK if OK, EIDSP_FFT_SIZE_NOT_SUPPORTED for other sizes
+ */
+static inline int pow2_r2c_fft(const float *src, size_t src_size, float *work, fft_complex_t *output, size_t n_fft)
+{
+    switch (n_fft) {
+        case 64: pow2_rfft<64>::run(src, src_size, work, output); break;
+        case 128: pow2_rfft<128>::run(src, src_size, work, output); break;
+        case 256: pow2_rfft<256>::run(src, src_size, work, output); break;
+        case 512: pow2_rfft<512>::run(src, src_size, work, output); break;
+        case 1024: pow2_rfft<1024>::run(src, src_size, work, output); break;
+        case 2048: pow2_rfft<2048>::run(src, src_size, work, output); break;
+        case 4096: pow2_rfft<4096>::run(src, src_size, work, output); break;
+        default: return EIDSP_FFT_SIZE_NOT_SUPPORTED;
+    }
+    return EIDSP_OK;
+}
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_POW2_RFFT_H_
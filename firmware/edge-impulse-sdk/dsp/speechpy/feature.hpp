@@ -43,54 +43,174 @@
 namespace ei {
 namespace speechpy {
 
+/**
+ * Triangular mel filterbank stored as one run of non-zero weights per filter
+ * (first bin, run length, weights) rather than a dense num_filters x
+ * coefficients matrix. A filter only covers the bins between its outer
+ * edges, so the runs hold about two weights per FFT bin in total; apply()
+ * visits those and nothing else. Built once per feature call and reused for
+ * every frame.
+ */
+class sparse_filterbank {
+public:
+    uint16_t num_filters;
+    uint16_t coefficients;
+    uint16_t *start;    // first bin of each filter
+    uint16_t *length;   // number of weights of each filter
+    float *weights;     // runs of all filters, back to back
+
+    sparse_filterbank()
+        : num_filters(0), coefficients(0), start(nullptr), length(nullptr), weights(nullptr), mem_size(0)
+    {
+    }
+
+    ~sparse_filterbank()
+    {
+        if (weights) {
+            ei_dsp_free(weights, mem_size);
+        }
+    }
+
+    /**
+     * Build the filterbank from the filter edges.
+     * @param edges num_filters + 2 FFT bin indices; filter i rises from
+     *              edges[i] to a peak of 1.0 at edges[i + 1] and falls to
+     *              edges[i + 2]
+     * @param n_filters Number of filters
+     * @param n_coefficients Power spectrum size (fft_length / 2 + 1)
+     * @param speechpy_weights Reproduce feature::filterbanks() exactly: a
+     *              filter whose three edges fall on one bin is empty, and with
+     *              EIDSP_QUANTIZE_FILTERBANK the weights are rounded to the
+     *              same 8-bit table. Otherwise such a filter passes its bin
+     *              with weight 1.0 (as mfe() always did) and weights are exact.
+     * @returns EIDSP_OK if OK
+     */
+    int build(const uint16_t *edges, uint16_t n_filters, uint16_t n_coefficients, bool speechpy_weights)
+    {
+        if (weights) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        size_t max_weights = 0;
+        for (uint16_t i = 0; i < n_filters; i++) {
+            if (edges[i] > edges[i + 1] || edges[i + 1] > edges[i + 2] || edges[i + 2] >= n_coefficients) {
+                EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+            }
+            max_weights += edges[i + 2] - edges[i] + 1;
+        }
+
+        mem_size = max_weights * sizeof(float) + 2 * n_filters * sizeof(uint16_t);
+        weights = (float*)ei_dsp_malloc(mem_size);
+        if (!weights) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        start = reinterpret_cast<uint16_t*>(weights + max_weights);
+        length = start + n_filters;
+        num_filters = n_filters;
+        coefficients = n_coefficients;
+
+        float *w = weights;
+        for (uint16_t i = 0; i < n_filters; i++) {
+            int left = edges[i];
+            int middle = edges[i + 1];
+            int right = edges[i + 2];
+
+            // trim the zero weights at both ends of the triangle
+            int first = left, last = right;
+            while (first <= right && weight_at(first, left, middle, right, speechpy_weights) == 0.0f) {
+                first++;
+            }
+            while (last >= first && weight_at(last, left, middle, right, speechpy_weights) == 0.0f) {
+                last--;
+            }
+            for (int bin = first; bin <= last; bin++) {
+                w[bin - first] = weight_at(bin, left, middle, right, speechpy_weights);
+            }
+
+            start[i] = first <= last ? first : 0;
+            length[i] = first <= last ? last - first + 1 : 0;
+            w += length[i];
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Mel energies of one power spectrum frame.
+     * @param power_spectrum Frame of `coefficients` values
+     * @param out num_filters values
+     */
+    void apply(const float *power_spectrum, float *out) const
+    {
+        const float *w = weights;
+        for (uint16_t i = 0; i < num_filters; i++) {
+            const float *ps = power_spectrum + start[i];
+            float acc = 0.0f;
+            for (uint16_t k = 0; k < length[i]; k++) {
+                acc += w[k] * ps[k];
+            }
+            out[i] = acc;
+            w += length[i];
+        }
+    }
+
+private:
+    size_t mem_size;
+
+    static float weight_at(int bin, int left, int middle, int right, bool speechpy_weights)
+    {
+        float weight;
+        if (bin == middle) {
+            weight = (speechpy_weights && left == right) ? 0.0f : 1.0f;
+        }
+        else if (bin < middle) {
+            weight = (static_cast<float>(bin) - left) / (middle - left);
+        }
+        else {
+            weight = (right - static_cast<float>(bin)) / (right - middle);
+        }
+#if EIDSP_QUANTIZE_FILTERBANK
+        if (speechpy_weights) {
+            weight = numpy::dequantize_zero_one(numpy::quantize_zero_one(weight));
+        }
+#endif
+        return weight;
+    }
+
+    sparse_filterbank(const sparse_filterbank &) = delete;
+    sparse_filterbank &operator=(const sparse_filterbank &) = delete;
+};
+
 class feature {
 public:
     /**
-     * Compute the Mel-filterbanks. Each filter will be stored in one rows.
-     * The columns correspond to fft bins.
+     * Compute the FFT bin edges of the Mel-filterbanks, as speechpy does:
+     * filter i rises from edges[i], peaks at edges[i + 1] and falls to
+     * edges[i + 2].
      *
-     * @param filterbanks Matrix of size num_filter * coefficients
+     * @param edges Output, num_filter + 2 bin indices
      * @param num_filter the number of filters in the filterbank
      * @param coefficients (fftpoints//2 + 1)
      * @param sampling_freq  the samplerate of the signal we are working
      *                       with. It affects mel spacing.
      * @param low_freq lowest band edge of mel filters, default 0 Hz
      * @param high_freq highest band edge of mel filters, default samplerate / 2
-     * @param output_transposed If set to true this will transpose the matrix (memory efficient).
-     *                          This is more efficient than calling this function and then transposing
-     *                          as the latter requires the filterbank to be allocated twice (for a short while).
      * @returns EIDSP_OK if OK
      */
-    static int filterbanks(
-#if EIDSP_QUANTIZE_FILTERBANK
-        quantized_matrix_t *filterbanks,
-#else
-        matrix_t *filterbanks,
-#endif
+    static int filterbank_edges(
+        uint16_t *edges,
         uint16_t num_filter, int coefficients, uint32_t sampling_freq,
-        uint32_t low_freq, uint32_t high_freq,
-        bool output_transposed = false
+        uint32_t low_freq, uint32_t high_freq
         )
     {
         const size_t mels_mem_size = (num_filter + 2) * sizeof(float);
         const size_t hertz_mem_size = (num_filter + 2) * sizeof(float);
-        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
 
         float *mels = (float*)ei_dsp_malloc(mels_mem_size);
         if (!mels) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
-            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-        }
-
-#if EIDSP_QUANTIZE_FILTERBANK
-        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(uint8_t));
-#else
-        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(float));
-#endif
-
         // Computing the Mel filterbank
         // converting the upper and lower frequencies to Mels.
         // num_filter + 2 is because for num_filter filterbanks we need
@@ -130,15 +250,62 @@ public:
         // The frequency resolution required to put filters at the
         // exact points calculated above should be extracted.
         //  So we should round those frequencies to the closest FFT bin.
-        int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
+        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
+            edges[ix] = static_cast<uint16_t>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+        }
+        ei_dsp_free(hertz, hertz_mem_size);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Compute the Mel-filterbanks. Each filter will be stored in one rows.
+     * The columns correspond to fft bins.
+     *
+     * @param filterbanks Matrix of size num_filter * coefficients
+     * @param num_filter the number of filters in the filterbank
+     * @param coefficients (fftpoints//2 + 1)
+     * @param sampling_freq  the samplerate of the signal we are working
+     *                       with. It affects mel spacing.
+     * @param low_freq lowest band edge of mel filters, default 0 Hz
+     * @param high_freq highest band edge of mel filters, default samplerate / 2
+     * @param output_transposed If set to true this will transpose the matrix (memory efficient).
+     *                          This is more efficient than calling this function and then transposing
+     *                          as the latter requires the filterbank to be allocated twice (for a short while).
+     * @returns EIDSP_OK if OK
+     */
+    static int filterbanks(
+#if EIDSP_QUANTIZE_FILTERBANK
+        quantized_matrix_t *filterbanks,
+#else
+        matrix_t *filterbanks,
+#endif
+        uint16_t num_filter, int coefficients, uint32_t sampling_freq,
+        uint32_t low_freq, uint32_t high_freq,
+        bool output_transposed = false
+        )
+    {
+        const size_t freq_index_mem_size = (num_filter + 2) * sizeof(uint16_t);
+
+        if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+#if EIDSP_QUANTIZE_FILTERBANK
+        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(uint8_t));
+#else
+        memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(float));
+#endif
+
+        uint16_t *freq_index = (uint16_t*)ei_dsp_malloc(freq_index_mem_size);
         if (!freq_index) {
-            ei_dsp_free(hertz, hertz_mem_size);
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
-            freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
+        int ret = filterbank_edges(freq_index, num_filter, coefficients, sampling_freq, low_freq, high_freq);
+        if (ret != EIDSP_OK) {
+            ei_dsp_free(freq_index, freq_index_mem_size);
+            EIDSP_ERR(ret);
         }
-        ei_dsp_free(hertz, hertz_mem_size);
 
         for (size_t i = 0; i < num_filter; i++) {
             int left = freq_index[i];
@@ -309,6 +476,13 @@ public:
         mels[MELS_SIZE-1] -= 0.001;
         bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
 
+        // now we have weights and locations to move from fft to mel sgram
+        sparse_filterbank filterbank;
+        ret = filterbank.build(bins, num_filters, power_spectrum_frame_size, false);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
         EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
         if (!power_spectrum_frame.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -356,34 +530,7 @@ public:
                 out_energies->buffer[ix] = energy;
             }
 
-            auto row_ptr = out_features->get_row_ptr(ix);
-            for (size_t i = 0; i < num_filters; i++) {
-                size_t left = bins[i];
-                size_t middle = bins[i+1];
-                size_t right = bins[i+2];
-
-                assert(right < power_spectrum_frame_size);
-                // now we have weights and locations to move from fft to mel sgram
-                // both left and right become zero weights, so skip them
-
-                // middle always has weight of 1.0
-                // since we skip left and right, if left = middle we need to handle that
-                row_ptr[i] = power_spectrum_frame.buffer[middle];
-
-                for (size_t bin = left+1; bin < right; bin++) {
-                    if (bin < middle) {
-                        row_ptr[i] +=
-                            ((static_cast<float>(bin) - left) / (middle - left)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                    // intentionally skip middle, handled above
-                    if (bin > middle) {
-                        row_ptr[i] +=
-                            ((right - static_cast<float>(bin)) / (right - middle)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                }
-            }
+            filterbank.apply(power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
 
             if (ret != 0) {
                 EIDSP_ERR(ret);
@@ -468,20 +615,17 @@ public:
 
         uint16_t coefficients = fft_length / 2 + 1;
 
-        // calculate the filterbanks first... preferably I would want to do the matrix multiplications
-        // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        // calculate the filterbanks first, as sparse runs: the same weights as
+        // feature::filterbanks() without the num_filters x coefficients matrix
+        uint16_t *edges = (uint16_t*)ei_dsp_malloc((num_filters + 2) * sizeof(uint16_t));
+        EI_ERR_AND_RETURN_ON_NULL(edges, EIDSP_OUT_OF_MEM);
+        ret = filterbank_edges(edges, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency);
+        sparse_filterbank filterbank;
+        if (ret == EIDSP_OK) {
+            ret = filterbank.build(edges, num_filters, coefficients, true);
         }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
-        if (ret != 0) {
+        ei_dsp_free(edges, (num_filters + 2) * sizeof(uint16_t));
+        if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
@@ -534,17 +678,7 @@ public:
             }
 
             // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+            filterbank.apply(power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
         }
 
         numpy::zero_handling(out_features);
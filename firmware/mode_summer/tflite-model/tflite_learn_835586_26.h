@@ -51,8 +51,12 @@
 
 #include "edge-impulse-sdk/third_party/incbin/incbin.h"
 
+// Overridable from the build (TFLITE_ARENA_SIZE) with the size measured by
+// the firmware 'r' arena report.
+#ifndef EI_CLASSIFIER_TFLITE_LEARN_835586_26_ARENA_SIZE
 #define EI_CLASSIFIER_TFLITE_LEARN_835586_26_ARENA_SIZE     7744
-const size_t tflite_learn_835586_26_arena_size = 7744;
+#endif
+const size_t tflite_learn_835586_26_arena_size = EI_CLASSIFIER_TFLITE_LEARN_835586_26_ARENA_SIZE;
 
 INCBIN(incbin_tflite_learn_835586_26, "tflite-model/tflite_learn_835586_26.tflite");
 
@@ -0,0 +1,148 @@
+/*
+ * arena_report.h
+ * Diagnostic pass that measures the real TFLM arena footprint of the loaded
+ * model. Runs the graph through RecordingMicroAllocator (greedy planner) and
+ * a plain MicroAllocator with the linear planner, prints the breakdown and
+ * the smallest arena that still allocates.
+ *
+ * Feed the suggested size back into the build with
+ *   cmake -DTFLITE_ARENA_SIZE=<bytes> ..
+ */
+#ifndef ARENA_REPORT_H
+#define ARENA_REPORT_H
+
+#include <stdio.h>
+#include <new>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/recording_micro_allocator.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/linear_memory_planner.h"
+
+// Probe arena used for the measurement runs. Must be larger than any model we
+// ship; it only lives for the duration of the report.
+#define ARENA_PROBE_SIZE     (32 * 1024)
+// TFLM wants 16-byte aligned arenas; used_bytes() excludes that slack.
+#define ARENA_ALIGN_SLACK    16
+
+struct ArenaReport {
+    size_t configured;          // arena_size compiled into the model
+    size_t greedy_used;         // arena_used_bytes() with the greedy planner
+    size_t linear_used;         // arena_used_bytes() with the linear planner
+    size_t head_used;           // non-persistent: activations + scratch
+    size_t tail_used;           // persistent: tensor structs, op data
+    size_t minimal;             // smallest verified arena
+};
+
+static const ei_config_tflite_graph_t* arena_graph_config() {
+    const ei_impulse_t* impulse = ei_default_impulse.impulse;
+    if (impulse->learning_blocks_size == 0) return nullptr;
+    ei_learning_block_config_tflite_graph_t* block =
+        (ei_learning_block_config_tflite_graph_t*)impulse->learning_blocks[0].config;
+    return (const ei_config_tflite_graph_t*)block->graph_config;
+}
+
+static void print_recorded(const tflite::RecordingMicroAllocator* rec,
+                           tflite::RecordedAllocationType type, const char* name) {
+    tflite::RecordedAllocation a = rec->GetRecordedAllocation(type);
+    printf("[ARENA]   %-22s %6u B (req %6u, n=%u)\n", name,
+           (unsigned)a.used_bytes, (unsigned)a.requested_bytes, (unsigned)a.count);
+}
+
+// Returns true if the model allocates in exactly `size` bytes of arena.
+static bool arena_fits(const tflite::Model* model, const tflite::MicroOpResolver& resolver,
+                       uint8_t* buf, size_t size) {
+    tflite::MicroInterpreter interp(model, resolver, buf, size);
+    return interp.AllocateTensors(true) == kTfLiteOk;
+}
+
+// Greedy planner (what run_classifier uses), recorded per allocation type.
+static bool arena_measure_greedy(const tflite::Model* model, const tflite::MicroOpResolver& resolver,
+                                 uint8_t* probe, ArenaReport* r) {
+    tflite::RecordingMicroAllocator* rec = tflite::RecordingMicroAllocator::Create(probe, ARENA_PROBE_SIZE);
+    tflite::MicroInterpreter interp(model, resolver, rec);
+    if (interp.AllocateTensors(true) != kTfLiteOk) {
+        printf("[ARENA] AllocateTensors failed in %d B probe\n", ARENA_PROBE_SIZE);
+        return false;
+    }
+    r->greedy_used = interp.arena_used_bytes();
+    r->head_used = rec->GetSimpleMemoryAllocator()->GetNonPersistentUsedBytes();
+    r->tail_used = rec->GetSimpleMemoryAllocator()->GetPersistentUsedBytes();
+
+    printf("[ARENA] Greedy planner: %u B used\n", (unsigned)r->greedy_used);
+    print_recorded(rec, tflite::RecordedAllocationType::kTfLiteEvalTensorData, "eval tensors");
+    print_recorded(rec, tflite::RecordedAllocationType::kPersistentTfLiteTensorData, "persistent tensors");
+    print_recorded(rec, tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData, "quant params");
+    print_recorded(rec, tflite::RecordedAllocationType::kPersistentBufferData, "persistent buffers");
+    print_recorded(rec, tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData, "variable buffers");
+    print_recorded(rec, tflite::RecordedAllocationType::kNodeAndRegistrationArray, "node+registration");
+    print_recorded(rec, tflite::RecordedAllocationType::kOpData, "op data");
+    printf("[ARENA]   head (activations+scratch) %u B, tail (persistent) %u B\n",
+           (unsigned)r->head_used, (unsigned)r->tail_used);
+    return true;
+}
+
+// Linear planner: no buffer reuse, shown for comparison only.
+static void arena_measure_linear(const tflite::Model* model, const tflite::MicroOpResolver& resolver,
+                                 uint8_t* probe, ArenaReport* r) {
+    tflite::LinearMemoryPlanner linear;
+    tflite::MicroAllocator* alloc = tflite::MicroAllocator::Create(probe, ARENA_PROBE_SIZE, &linear);
+    tflite::MicroInterpreter interp(model, resolver, alloc);
+    if (interp.AllocateTensors(true) != kTfLiteOk) {
+        printf("[ARENA] Linear planner: does not fit in probe\n");
+        return;
+    }
+    r->linear_used = interp.arena_used_bytes();
+    printf("[ARENA] Linear planner: %u B used (%+d vs greedy)\n",
+           (unsigned)r->linear_used, (int)r->linear_used - (int)r->greedy_used);
+}
+
+// Verify the tightened size on the same allocator path run_classifier uses,
+// growing in alignment steps until it fits.
+static bool arena_find_minimal(const tflite::Model* model, const tflite::MicroOpResolver& resolver,
+                               uint8_t* probe, ArenaReport* r) {
+    for (r->minimal = r->greedy_used + ARENA_ALIGN_SLACK; r->minimal <= ARENA_PROBE_SIZE;
+         r->minimal += ARENA_ALIGN_SLACK) {
+        memset(probe, 0, ARENA_PROBE_SIZE);
+        if (arena_fits(model, resolver, probe, r->minimal)) return true;
+    }
+    printf("[ARENA] Could not verify minimal arena\n");
+    return false;
+}
+
+static bool report_arena_usage(ArenaReport* out) {
+    const ei_config_tflite_graph_t* graph = arena_graph_config();
+    if (!graph) { printf("[ARENA] No TFLite learning block\n"); return false; }
+
+    const tflite::Model* model = tflite::GetModel(graph->model);
+#ifdef EI_TFLITE_RESOLVER
+    EI_TFLITE_RESOLVER
+#else
+    static tflite::AllOpsResolver resolver;
+#endif
+
+    uint8_t* probe = (uint8_t*)ei_aligned_calloc(16, ARENA_PROBE_SIZE);
+    if (!probe) { printf("[ARENA] Probe alloc failed (%d B)\n", ARENA_PROBE_SIZE); return false; }
+
+    ArenaReport r = {};
+    r.configured = graph->arena_size;
+
+    bool ok = arena_measure_greedy(model, resolver, probe, &r);
+    if (ok) {
+        memset(probe, 0, ARENA_PROBE_SIZE);
+        arena_measure_linear(model, resolver, probe, &r);
+        ok = arena_find_minimal(model, resolver, probe, &r);
+    }
+    if (ok) {
+        printf("[ARENA] Configured: %u B, minimal: %u B, reclaimable: %d B\n",
+               (unsigned)r.configured, (unsigned)r.minimal, (int)r.configured - (int)r.minimal);
+        printf("[ARENA] Build with: -DTFLITE_ARENA_SIZE=%u\n", (unsigned)r.minimal);
+    }
+
+    ei_aligned_free(probe);
+    if (out) *out = r;
+    return ok;
+}
+
+#endif
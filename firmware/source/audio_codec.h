@@ -0,0 +1,212 @@
+/*
+ * audio_codec.h
+ * Sample codecs for 12-bit ADC audio, shared by USB streaming and clip upload.
+ *
+ *   PACK12  lossless, 3 bytes per 2 samples
+ *   ADPCM   IMA-ADPCM, 4 bits per sample, each block self-contained
+ *   RICE    lossless, first-order delta + zigzag + Rice(k), k chosen per block
+ *
+ * Every encoder works on one block at a time and carries no state between
+ * blocks, so a lost frame never corrupts its neighbours. The Python decoder
+ * in tools/audio_codec.py mirrors these formats bit for bit.
+ */
+#ifndef AUDIO_CODEC_H
+#define AUDIO_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum AudioCodec {
+    CODEC_PACK12 = 0,
+    CODEC_ADPCM  = 1,
+    CODEC_RICE   = 2,
+};
+
+static const char* codec_name(int codec) {
+    switch (codec) {
+        case CODEC_PACK12: return "pack12";
+        case CODEC_ADPCM:  return "adpcm";
+        case CODEC_RICE:   return "rice";
+        default:           return "?";
+    }
+}
+
+// Worst-case encoded size of n samples (Rice escapes bound the RICE case).
+#define CODEC_MAX_BYTES(n)   ((n) * 29 / 8 + 8)
+
+// --- CRC-32 (IEEE 802.3, reflected, same as zlib.crc32) ---
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+// --- PACK12: each sample pair is one little-endian 24-bit word s0 | s1 << 12 ---
+
+#define PACK12_BYTES(n)      (((n) * 3 + 1) / 2)
+
+static size_t pack12_encode(const uint16_t* in, int n, uint8_t* out) {
+    uint8_t* p = out;
+    int i = 0;
+    for (; i + 1 < n; i += 2) {
+        uint32_t w = (uint32_t)(in[i] & 0x0FFF) | ((uint32_t)(in[i + 1] & 0x0FFF) << 12);
+        p[0] = (uint8_t)w;
+        p[1] = (uint8_t)(w >> 8);
+        p[2] = (uint8_t)(w >> 16);
+        p += 3;
+    }
+    if (i < n) {
+        uint16_t a = in[i] & 0x0FFF;
+        p[0] = (uint8_t)a;
+        p[1] = (uint8_t)(a >> 8);
+        p += 2;
+    }
+    return (size_t)(p - out);
+}
+
+// Hot path for the packed capture store: four samples per iteration from
+// two 24-bit words, byte loads only (pair offsets are not word aligned).
+static void pack12_decode(const uint8_t* in, int n, uint16_t* out) {
+    int i = 0;
+    for (; i + 3 < n; i += 4) {
+        uint32_t w0 = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16);
+        uint32_t w1 = (uint32_t)in[3] | ((uint32_t)in[4] << 8) | ((uint32_t)in[5] << 16);
+        out[i]     = (uint16_t)(w0 & 0x0FFF);
+        out[i + 1] = (uint16_t)(w0 >> 12);
+        out[i + 2] = (uint16_t)(w1 & 0x0FFF);
+        out[i + 3] = (uint16_t)(w1 >> 12);
+        in += 6;
+    }
+    for (; i + 1 < n; i += 2) {
+        uint32_t w = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16);
+        out[i]     = (uint16_t)(w & 0x0FFF);
+        out[i + 1] = (uint16_t)(w >> 12);
+        in += 3;
+    }
+    if (i < n) out[i] = (uint16_t)(in[0] | ((in[1] & 0x0F) << 8));
+}
+
+// --- IMA-ADPCM on 12-bit samples (scaled to 16-bit, centred on 2048) ---
+
+static const int16_t IMA_STEP[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+static const int8_t IMA_INDEX[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static inline int16_t adc_to_s16(uint16_t s) { return (int16_t)(((int)(s & 0x0FFF) - 2048) << 4); }
+
+// Block layout: predictor (int16 LE), step index (uint8), pad, then two
+// nibbles per byte, low nibble first. The first sample is the predictor.
+static size_t adpcm_encode(const uint16_t* in, int n, uint8_t* out) {
+    if (n <= 0) return 0;
+    int pred = adc_to_s16(in[0]);
+    int index = 0;
+    // Seed the step size from the first delta so loud blocks converge fast.
+    if (n > 1) {
+        int d = adc_to_s16(in[1]) - pred; if (d < 0) d = -d;
+        while (index < 88 && IMA_STEP[index] < d) index++;
+    }
+    out[0] = (uint8_t)(pred & 0xFF); out[1] = (uint8_t)((pred >> 8) & 0xFF);
+    out[2] = (uint8_t)index; out[3] = 0;
+    uint8_t* p = out + 4;
+
+    for (int i = 1; i < n; i++) {
+        int step = IMA_STEP[index];
+        int diff = adc_to_s16(in[i]) - pred;
+        int code = 0;
+        if (diff < 0) { code = 8; diff = -diff; }
+        int delta = step >> 3;
+        if (diff >= step) { code |= 4; diff -= step; delta += step; }
+        step >>= 1;
+        if (diff >= step) { code |= 2; diff -= step; delta += step; }
+        step >>= 1;
+        if (diff >= step) { code |= 1; delta += step; }
+
+        pred += (code & 8) ? -delta : delta;
+        if (pred > 32767) pred = 32767; else if (pred < -32768) pred = -32768;
+        index += IMA_INDEX[code & 7];
+        if (index < 0) index = 0; else if (index > 88) index = 88;
+
+        int k = i - 1;
+        if (k & 1) p[k >> 1] |= (uint8_t)(code << 4);
+        else p[k >> 1] = (uint8_t)code;
+    }
+    return 4 + (size_t)(n / 2);
+}
+
+// --- RICE: delta + zigzag, Rice parameter k per block ---
+
+#define RICE_ESCAPE   16        // unary run that introduces a raw 13-bit value
+#define RICE_RAW_BITS 13
+
+struct BitWriter {
+    uint8_t* out;
+    size_t pos;
+    uint32_t acc;
+    int bits;
+};
+
+static inline void bw_put(BitWriter* w, uint32_t value, int nbits) {
+    // MSB-first bit packing.
+    for (int b = nbits - 1; b >= 0; b--) {
+        w->acc = (w->acc << 1) | ((value >> b) & 1u);
+        if (++w->bits == 8) { w->out[w->pos++] = (uint8_t)w->acc; w->acc = 0; w->bits = 0; }
+    }
+}
+
+static inline void bw_flush(BitWriter* w) {
+    if (w->bits) { w->out[w->pos++] = (uint8_t)(w->acc << (8 - w->bits)); w->acc = 0; w->bits = 0; }
+}
+
+static inline uint32_t zigzag(int v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+// Block layout: k (uint8), first sample (12 bits), then n-1 codes.
+static size_t rice_encode(const uint16_t* in, int n, uint8_t* out) {
+    if (n <= 0) return 0;
+    // k ~= log2(mean |delta|) is within one bit of optimal for Laplacian deltas.
+    uint32_t sum = 0;
+    for (int i = 1; i < n; i++) {
+        int d = (int)(in[i] & 0x0FFF) - (int)(in[i - 1] & 0x0FFF);
+        sum += zigzag(d);
+    }
+    uint32_t mean = (n > 1) ? sum / (uint32_t)(n - 1) : 0;
+    int k = 0;
+    while (k < 12 && (1u << (k + 1)) <= mean + 1) k++;
+
+    out[0] = (uint8_t)k;
+    BitWriter w = { out + 1, 0, 0, 0 };
+    bw_put(&w, in[0] & 0x0FFF, 12);
+    for (int i = 1; i < n; i++) {
+        uint32_t u = zigzag((int)(in[i] & 0x0FFF) - (int)(in[i - 1] & 0x0FFF));
+        uint32_t q = u >> k;
+        if (q < RICE_ESCAPE) {
+            bw_put(&w, (1u << (q + 1)) - 2u, (int)q + 1);      // q ones, then a zero
+            if (k) bw_put(&w, u & ((1u << k) - 1u), k);
+        } else {
+            bw_put(&w, (1u << RICE_ESCAPE) - 1u, RICE_ESCAPE);
+            bw_put(&w, u, RICE_RAW_BITS);
+        }
+    }
+    bw_flush(&w);
+    return 1 + w.pos;
+}
+
+static size_t codec_encode(int codec, const uint16_t* in, int n, uint8_t* out) {
+    switch (codec) {
+        case CODEC_ADPCM: return adpcm_encode(in, n, out);
+        case CODEC_RICE:  return rice_encode(in, n, out);
+        default:          return pack12_encode(in, n, out);
+    }
+}
+
+#endif
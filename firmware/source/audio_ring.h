@@ -0,0 +1,142 @@
+/*
+ * audio_ring.h
+ * Continuous ADC capture into a ring of fixed-size blocks.
+ *
+ * Two DMA channels are chained ping-pong style: while one fills block N the
+ * other is already armed for block N+1. Each completion IRQ advances the head
+ * and re-arms the finished channel two blocks ahead, so capture never stops
+ * and the consumer (USB streaming, DSP) drains whole blocks at its own pace.
+ * If the consumer falls more than RING_NUM_BLOCKS-2 blocks behind, the oldest
+ * blocks are dropped and counted as overruns.
+ *
+ * The IRQ can run late: flash programs and erases (record log, config saves)
+ * run with interrupts off for tens to hundreds of ms, several blocks' worth.
+ * A channel that is chained into again before its re-arm restarts from where
+ * it stopped, so both channels use the DMA's write-address ring: g_ring is
+ * aligned to its own size and every write wraps inside it. A late IRQ then
+ * costs blocks (counted as overruns; the re-arms put both channels back on
+ * the grid within two blocks) instead of running off the end into .bss.
+ */
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define RING_SAMPLE_RATE_HZ  16000
+#define RING_BLOCK_SAMPLES   512    // one FFT window, 32 ms at 16 kHz
+#define RING_NUM_BLOCKS      16     // 512 ms of slack for the consumer
+#define RING_WRAP_BITS       14     // log2 of the ring's bytes, for the DMA write ring
+
+static uint16_t g_ring[RING_NUM_BLOCKS][RING_BLOCK_SAMPLES] __attribute__((aligned(1 << RING_WRAP_BITS)));
+static_assert(sizeof(g_ring) == (1u << RING_WRAP_BITS), "DMA write ring must cover g_ring exactly");
+static volatile uint32_t g_ring_head = 0;   // blocks completed by DMA
+static uint32_t g_ring_tail = 0;            // blocks released by the consumer
+static uint32_t g_ring_overruns = 0;
+static volatile uint32_t g_ring_late = 0;   // late re-arms, folded into overruns by ring_peek()
+static uint32_t g_ring_late_seen = 0;
+static int g_ring_chan[2] = {-1, -1};
+static bool g_ring_running = false;
+
+static void ring_dma_irq() {
+    for (int i = 0; i < 2; i++) {
+        int ch = g_ring_chan[i];
+        if (ch < 0 || !dma_channel_get_irq0_status(ch)) continue;
+        dma_channel_acknowledge_irq0(ch);
+        uint32_t done = g_ring_head;
+        g_ring_head = done + 1;
+        // Chained into again before this IRQ ran: it is rewriting an old
+        // block inside the ring. Leave it; its next completion re-arms it.
+        if (dma_channel_is_busy(ch)) { g_ring_late = g_ring_late + 1; continue; }
+        // The partner channel is already running block done+1.
+        dma_channel_set_write_addr(ch, g_ring[(done + 2) % RING_NUM_BLOCKS], false);
+        dma_channel_set_trans_count(ch, RING_BLOCK_SAMPLES, false);
+    }
+}
+
+static void ring_init() {
+    if (g_ring_chan[0] >= 0) return;
+    g_ring_chan[0] = dma_claim_unused_channel(true);
+    g_ring_chan[1] = dma_claim_unused_channel(true);
+    irq_add_shared_handler(DMA_IRQ_0, ring_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+}
+
+// Starts capture at `rate_hz`; ring_start() uses the audio rate.
+static void ring_start_rate(uint32_t rate_hz) {
+    ring_init();
+    g_ring_head = 0; g_ring_tail = 0; g_ring_overruns = 0;
+    g_ring_late = 0; g_ring_late_seen = 0;
+
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(g_ring_chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_dreq(&c, DREQ_ADC);
+        channel_config_set_chain_to(&c, g_ring_chan[i ^ 1]);
+        channel_config_set_ring(&c, true, RING_WRAP_BITS);
+        dma_channel_configure(g_ring_chan[i], &c, g_ring[i], &adc_hw->fifo, RING_BLOCK_SAMPLES, false);
+        dma_channel_set_irq0_enabled(g_ring_chan[i], true);
+    }
+
+    adc_fifo_drain();
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(48000000.0f / rate_hz - 1.0f);
+    dma_channel_start(g_ring_chan[0]);
+    adc_run(true);
+    g_ring_running = true;
+}
+
+static void ring_start() {
+    ring_start_rate(RING_SAMPLE_RATE_HZ);
+}
+
+static void ring_stop() {
+    if (!g_ring_running) return;
+    adc_run(false);
+    for (int i = 0; i < 2; i++) dma_channel_set_irq0_enabled(g_ring_chan[i], false);
+    // Break the chain before aborting so neither channel re-triggers the other.
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(g_ring_chan[i]);
+        channel_config_set_chain_to(&c, g_ring_chan[i]);
+        dma_channel_configure(g_ring_chan[i], &c, g_ring[i], &adc_hw->fifo, 0, false);
+        dma_channel_abort(g_ring_chan[i]);
+        dma_channel_acknowledge_irq0(g_ring_chan[i]);
+    }
+    adc_fifo_drain();
+    g_ring_running = false;
+}
+
+static inline uint32_t ring_available() {
+    return g_ring_head - g_ring_tail;
+}
+
+// Oldest completed block, or NULL if none is ready. Stays valid until
+// ring_release(); the DMA never writes within two blocks of the tail.
+static const uint16_t* ring_peek() {
+    uint32_t head = g_ring_head;
+    uint32_t late = g_ring_late;
+    g_ring_overruns += late - g_ring_late_seen;
+    g_ring_late_seen = late;
+    if (head - g_ring_tail > RING_NUM_BLOCKS - 2) {
+        g_ring_overruns += (head - g_ring_tail) - (RING_NUM_BLOCKS - 2);
+        g_ring_tail = head - (RING_NUM_BLOCKS - 2);
+    }
+    if (head == g_ring_tail) return NULL;
+    return g_ring[g_ring_tail % RING_NUM_BLOCKS];
+}
+
+static inline void ring_release() {
+    g_ring_tail++;
+}
+
+// Blocking variant used by fixed-length consumers.
+static const uint16_t* ring_wait_block() {
+    const uint16_t* blk;
+    while ((blk = ring_peek()) == NULL) tight_loop_contents();
+    return blk;
+}
+
+#endif
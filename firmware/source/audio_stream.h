@@ -0,0 +1,97 @@
+/*
+ * audio_stream.h
+ * Framed binary audio streaming over USB CDC.
+ *
+ * Capture runs continuously through the DMA block ring; every block becomes
+ * one frame written with a single bulk stdio call:
+ *
+ *   offset  size  field
+ *   0       2     sync 0xBEE5 (LE: E5 BE)
+ *   2       1     version (1)
+ *   3       1     codec (AudioCodec)
+ *   4       4     sequence number
+ *   8       2     sample count (0 = end of stream)
+ *   10      2     payload length
+ *   12      n     payload
+ *   12+n    4     CRC-32 of bytes 0 .. 12+n-1
+ *
+ * The stream is announced by a text line "BIN:<ver>:<codec>:<rate>:<block>"
+ * and followed by "END" and a stats line. Duration 0 streams until any key
+ * is received. Decoder: tools/audio_capture.py --binary.
+ */
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "audio_ring.h"
+#include "audio_codec.h"
+
+#define STREAM_SYNC          0xBEE5
+#define STREAM_VERSION       1
+#define STREAM_HDR_BYTES     12
+#define STREAM_CRC_BYTES     4
+
+static uint8_t g_stream_frame[STREAM_HDR_BYTES + CODEC_MAX_BYTES(RING_BLOCK_SAMPLES) + STREAM_CRC_BYTES];
+
+static inline void put_le16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put_le32(uint8_t* p, uint32_t v) { put_le16(p, (uint16_t)v); put_le16(p + 2, (uint16_t)(v >> 16)); }
+
+// Builds one frame in g_stream_frame and returns its total length.
+static size_t stream_build_frame(int codec, uint32_t seq, const uint16_t* samples, int n) {
+    uint8_t* f = g_stream_frame;
+    size_t len = (n > 0) ? codec_encode(codec, samples, n, f + STREAM_HDR_BYTES) : 0;
+    put_le16(f, STREAM_SYNC);
+    f[2] = STREAM_VERSION;
+    f[3] = (uint8_t)codec;
+    put_le32(f + 4, seq);
+    put_le16(f + 8, (uint16_t)n);
+    put_le16(f + 10, (uint16_t)len);
+    put_le32(f + STREAM_HDR_BYTES + len, crc32_update(0, f, STREAM_HDR_BYTES + len));
+    return STREAM_HDR_BYTES + len + STREAM_CRC_BYTES;
+}
+
+static void stream_audio_framed(int codec, int seconds) {
+    uint32_t target_blocks = (seconds > 0) ? (uint32_t)((seconds * RING_SAMPLE_RATE_HZ + RING_BLOCK_SAMPLES - 1) / RING_BLOCK_SAMPLES) : 0;
+    printf("BIN:%d:%d:%d:%d\n", STREAM_VERSION, codec, RING_SAMPLE_RATE_HZ, RING_BLOCK_SAMPLES);
+    stdio_flush();
+
+    uint32_t seq = 0;
+    uint64_t bytes = 0, write_us = 0, encode_us = 0;
+    uint64_t t_start = time_us_64();
+    ring_start();
+
+    while (target_blocks == 0 || seq < target_blocks) {
+        if (target_blocks == 0 && getchar_timeout_us(0) != PICO_ERROR_TIMEOUT) break;
+        const uint16_t* blk = ring_peek();
+        if (!blk) { tight_loop_contents(); continue; }
+
+        uint64_t t0 = time_us_64();
+        size_t len = stream_build_frame(codec, seq, blk, RING_BLOCK_SAMPLES);
+        ring_release();
+        uint64_t t1 = time_us_64();
+        stdio_put_string((const char*)g_stream_frame, (int)len, false, false);
+        write_us += time_us_64() - t1;
+        encode_us += t1 - t0;
+        bytes += len;
+        seq++;
+    }
+
+    ring_stop();
+    size_t len = stream_build_frame(codec, seq, NULL, 0);
+    stdio_put_string((const char*)g_stream_frame, (int)len, false, false);
+    stdio_flush();
+
+    float secs = (float)(time_us_64() - t_start) / 1e6f;
+    printf("\nEND\n");
+    // Link rate = bytes / time spent inside the USB writes, i.e. the headroom
+    // over the real-time audio rate.
+    printf("[STREAM] %u frames, %llu B, %.1f kB/s avg, link %.1f kB/s, encode %.1f us/frame, overruns %u\n",
+           (unsigned)seq, (unsigned long long)bytes, secs > 0 ? bytes / secs / 1000.0f : 0.0f,
+           write_us ? bytes * 1000.0f / (float)write_us : 0.0f,
+           seq ? (float)encode_us / seq : 0.0f, (unsigned)g_ring_overruns);
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * bee_dsp.h
+ * Per-window audio DSP shared by the batch and streaming feature paths.
+ *
+ * One FFT_SIZE window of 12-bit ADC samples goes through DC removal, gain,
+ * the HP / LP / LP biquad chain (its state carries across windows, reset with
+ * reset_filters() at the start of a capture), a Hann window and a direct DFT
+ * of the first NUM_FREQ_BINS bins from precomputed cos/sin tables.
+ *
+ * With BEE_DSP_FIXED=1, bee_dsp_window() runs the same chain in integer
+ * arithmetic instead (see "Integer path" below) and the float tables are
+ * left out of the build; without it the integer tables are. A host tool that
+ * compares the two paths defines BEE_DSP_INTEGER=1 to build both.
+ *
+ * No hardware access, so host tools build the same code. The state one
+ * capture works on (filter memories, window buffers) is declared
+ * BEE_DSP_STATE, plain static by default; host tools that featurize on several
+ * threads define it as `static thread_local` and call bee_dsp_init() once,
+ * before starting them, for the shared tables.
+ */
+#ifndef BEE_DSP_H
+#define BEE_DSP_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define FFT_SIZE            512
+#define FFT_HOP             512
+#define NUM_FREQ_BINS       20
+#define BEE_FIRST_BIN       4       // lowest bin the summer model uses
+
+#ifndef BEE_DSP_FIXED
+#define BEE_DSP_FIXED       0
+#endif
+
+#ifndef BEE_DSP_INTEGER
+#define BEE_DSP_INTEGER     BEE_DSP_FIXED
+#endif
+
+#ifndef BEE_DSP_STATE
+#define BEE_DSP_STATE       static
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if !BEE_DSP_FIXED
+BEE_DSP_STATE float g_fft_input[FFT_SIZE];
+static float g_hanning_window[FFT_SIZE];
+static float g_cos_table[NUM_FREQ_BINS][FFT_SIZE];
+static float g_sin_table[NUM_FREQ_BINS][FFT_SIZE];
+#endif
+
+// Filter State
+BEE_DSP_STATE float hp_w1 = 0, hp_w2 = 0;
+BEE_DSP_STATE float lp1_w1 = 0;
+BEE_DSP_STATE float lp2_w1 = 0, lp2_w2 = 0;
+
+static const float HP_B0 = 0.9726139f; static const float HP_B1 = -1.9452278f; static const float HP_B2 = 0.9726139f;
+static const float HP_A1 = -1.9444777f; static const float HP_A2 = 0.9459779f;
+static const float LP1_B0 = 0.4459029f; static const float LP1_B1 = 0.4459029f; static const float LP1_B2 = 0.0f;
+static const float LP1_A1 = 0.4142136f; static const float LP1_A2 = 0.0f;
+static const float LP2_B0 = 0.3913f; static const float LP2_B1 = 0.7827f; static const float LP2_B2 = 0.3913f;
+static const float LP2_A1 = -0.3695f; static const float LP2_A2 = -0.1958f;
+
+static inline float biquad_hp(float x) {
+    float y = HP_B0 * x + hp_w1; hp_w1 = HP_B1 * x - HP_A1 * y + hp_w2; hp_w2 = HP_B2 * x - HP_A2 * y; return y;
+}
+static inline float biquad_lp1(float x) {
+    float y = LP1_B0 * x + lp1_w1; lp1_w1 = LP1_B1 * x - LP1_A1 * y; return y;
+}
+static inline float biquad_lp2(float x) {
+    float y = LP2_B0 * x + lp2_w1; lp2_w1 = LP2_B1 * x - LP2_A1 * y + lp2_w2; lp2_w2 = LP2_B2 * x - LP2_A2 * y; return y;
+}
+
+#if !BEE_DSP_FIXED
+static float compute_bin_magnitude_accurate(const float* windowed_data, int k) {
+    double real_sum = 0.0, imag_sum = 0.0;
+    for (int n = 0; n < FFT_SIZE; n++) {
+        real_sum += windowed_data[n] * g_cos_table[k][n];
+        imag_sum += windowed_data[n] * g_sin_table[k][n];
+    }
+    return (float)sqrt(real_sum * real_sum + imag_sum * imag_sum);
+}
+
+static inline double bee_dsp_window_float(const uint16_t* raw, float dc_offset, float gain, float* mags) {
+    double sumsq = 0;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        float sample = ((float)raw[i] - dc_offset) / 2048.0f;
+        sample *= gain;
+        sample = biquad_lp2(biquad_lp1(biquad_hp(sample)));
+        sumsq += sample * sample;
+        g_fft_input[i] = sample * g_hanning_window[i];
+    }
+    for (int k = 0; k < NUM_FREQ_BINS; k++) mags[k] = compute_bin_magnitude_accurate(g_fft_input, k);
+    return sumsq;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Integer path
+//
+// The biquads run direct form I on Q21 samples in int32 (1.0 = 2048 ADC
+// counts) with Q30 coefficients, a 64-bit accumulator and error feedback, so
+// the HP section's high-gain poles do not amplify rounding noise. Their output
+// is rounded to Q13 in int16, which leaves two bits of headroom for the LP
+// chain's passband gain of ~2.3; the Hann window and a single cos table (sin
+// read a quarter turn on) are Q15, and the DFT of bins BEE_FIRST_BIN and up
+// accumulates in 64 bits. The chain is linear, so the gain is applied with
+// the conversion to float at those 16 bins. Lower bins are not computed and
+// read 0. tools/fixed_eval.cpp compares this path against the float one.
+// ---------------------------------------------------------------------------
+
+#if BEE_DSP_INTEGER
+#define Q30_ONE             (1 << 30)
+#define Q21_GUARD           8       // bits kept below Q13 inside the filters
+
+struct BiquadQ30Coef {
+    int32_t b0, b1, b2, a1, a2;
+};
+
+struct BiquadQ30 {
+    int32_t x1, x2, y1, y2;
+    int64_t err;                    // rounding remainder fed into the next sample
+};
+
+BEE_DSP_STATE int16_t g_window_q13[FFT_SIZE];
+static int16_t g_hann_q15[FFT_SIZE];
+static int16_t g_twiddle_q15[FFT_SIZE];     // cos(2 pi m / FFT_SIZE)
+static BiquadQ30Coef g_hp_q30c, g_lp1_q30c, g_lp2_q30c;    // set up by bee_dsp_init()
+BEE_DSP_STATE BiquadQ30 g_hp_q30, g_lp1_q30, g_lp2_q30;     // cleared by reset_filters()
+
+static int32_t q30(float x) { return (int32_t)lround((double)x * Q30_ONE); }
+
+static void biquad_q30_coef(BiquadQ30Coef* c, float b0, float b1, float b2, float a1, float a2) {
+    *c = {q30(b0), q30(b1), q30(b2), q30(a1), q30(a2)};
+}
+
+static inline int32_t biquad_q30(const BiquadQ30Coef* c, BiquadQ30* f, int32_t x) {
+    int64_t acc = (int64_t)c->b0 * x + (int64_t)c->b1 * f->x1 + (int64_t)c->b2 * f->x2
+                - (int64_t)c->a1 * f->y1 - (int64_t)c->a2 * f->y2 + f->err;
+    int32_t y = (int32_t)(acc >> 30);
+    f->err = acc - ((int64_t)y << 30);
+    f->x2 = f->x1; f->x1 = x;
+    f->y2 = f->y1; f->y1 = y;
+    return y;
+}
+
+static inline double bee_dsp_window_fixed(const uint16_t* raw, float dc_offset, float gain, float* mags) {
+    const int32_t dc_q21 = (int32_t)lroundf(dc_offset * (float)(4 << Q21_GUARD));
+    const BiquadQ30Coef hp = g_hp_q30c, lp1 = g_lp1_q30c, lp2 = g_lp2_q30c;   // locals stay in registers
+    int64_t sumsq = 0;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        int32_t x = ((int32_t)raw[i] << (2 + Q21_GUARD)) - dc_q21;
+        x = biquad_q30(&lp2, &g_lp2_q30, biquad_q30(&lp1, &g_lp1_q30, biquad_q30(&hp, &g_hp_q30, x)));
+        int32_t y = (x + (1 << (Q21_GUARD - 1))) >> Q21_GUARD;
+        if (y > INT16_MAX) y = INT16_MAX;
+        if (y < INT16_MIN) y = INT16_MIN;
+        sumsq += (int64_t)y * y;
+        g_window_q13[i] = (int16_t)((y * g_hann_q15[i] + (1 << 14)) >> 15);
+    }
+
+    const float scale = gain / (float)(1 << 28);                     // Q13 * Q15 -> float
+    for (int k = 0; k < BEE_FIRST_BIN; k++) mags[k] = 0.0f;
+    for (int k = BEE_FIRST_BIN; k < NUM_FREQ_BINS; k++) {
+        int64_t re = 0, im = 0;
+        uint32_t m = 0;
+        for (int n = 0; n < FFT_SIZE; n++, m += k) {
+            int32_t w = g_window_q13[n];
+            re += w * g_twiddle_q15[m & (FFT_SIZE - 1)];
+            im -= w * g_twiddle_q15[(m + FFT_SIZE * 3 / 4) & (FFT_SIZE - 1)];
+        }
+        float fr = (float)re * scale, fi = (float)im * scale;
+        mags[k] = sqrtf(fr * fr + fi * fi);
+    }
+    return (double)sumsq * gain * gain / (double)(1 << 26);
+}
+#endif
+
+static void bee_dsp_init() {
+#if !BEE_DSP_FIXED
+    for (int i = 0; i < FFT_SIZE; i++) g_hanning_window[i] = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * (float)i / (float)(FFT_SIZE - 1)));
+    for (int k = 0; k < NUM_FREQ_BINS; k++) {
+        for (int n = 0; n < FFT_SIZE; n++) {
+            double angle = -2.0 * M_PI * k * n / FFT_SIZE;
+            g_cos_table[k][n] = (float)cos(angle);
+            g_sin_table[k][n] = (float)sin(angle);
+        }
+    }
+#endif
+#if BEE_DSP_INTEGER
+    for (int i = 0; i < FFT_SIZE; i++) {
+        g_hann_q15[i] = (int16_t)lround(32767.0 * 0.5 * (1.0 - cos(2.0 * M_PI * i / (FFT_SIZE - 1))));
+        g_twiddle_q15[i] = (int16_t)lround(32767.0 * cos(2.0 * M_PI * i / FFT_SIZE));
+    }
+    biquad_q30_coef(&g_hp_q30c, HP_B0, HP_B1, HP_B2, HP_A1, HP_A2);
+    biquad_q30_coef(&g_lp1_q30c, LP1_B0, LP1_B1, LP1_B2, LP1_A1, LP1_A2);
+    biquad_q30_coef(&g_lp2_q30c, LP2_B0, LP2_B1, LP2_B2, LP2_A1, LP2_A2);
+#endif
+}
+
+static void reset_filters() {
+    hp_w1 = hp_w2 = 0; lp1_w1 = 0; lp2_w1 = lp2_w2 = 0;
+#if BEE_DSP_INTEGER
+    g_hp_q30 = g_lp1_q30 = g_lp2_q30 = BiquadQ30{};
+#endif
+}
+
+// Filters and transforms one window. Writes the NUM_FREQ_BINS magnitudes to
+// mags and returns the sum of squares of the filtered samples (for density).
+static inline double bee_dsp_window(const uint16_t* raw, float dc_offset, float gain, float* mags) {
+#if BEE_DSP_FIXED
+    return bee_dsp_window_fixed(raw, dc_offset, gain, mags);
+#else
+    return bee_dsp_window_float(raw, dc_offset, gain, mags);
+#endif
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * bee_features.h
+ * Summer feature stage: from one capture's ADC samples to the 20-feature
+ * vector of the summer model (docs/ML_MODEL_GUIDE.md, 1.1).
+ *
+ * A capture goes window by window through bee_dsp.h into a BeeCapture, which
+ * averages the bin magnitudes and turns the mean square of the filtered
+ * samples into the density (RMS). The spike ratio compares that density with
+ * the mean density of the last BEE_HISTORY_SIZE scheduled captures, kept in a
+ * BeeHistory. bee_summer_vector() lays out temperature, humidity, hour, spike
+ * and bins 4..19.
+ *
+ * main.cpp builds its features with these functions, and so do
+ * tools/batch_infer.cpp and the Python module in tools/bee_features, so
+ * features computed offline match the node's bit for bit. Fixed arrays only,
+ * no hardware access.
+ */
+#ifndef BEE_FEATURES_H
+#define BEE_FEATURES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "bee_dsp.h"
+
+#define BEE_FEATURES_VERSION    1       // bump when the feature math or layout changes
+#define BEE_SUMMER_FEATURES     20
+#define BEE_HISTORY_SIZE        12      // captures in the spike ratio's rolling mean
+#define BEE_DEFAULT_HOUR        14.0f   // the node has no wall clock; the hour feature is fixed
+
+struct BeeCapture {
+    double bins[NUM_FREQ_BINS];     // magnitude sums, means after bee_capture_end()
+    double sumsq;                   // of the filtered samples
+    uint32_t windows;
+};
+
+struct BeeHistory {
+    float density[BEE_HISTORY_SIZE];    // oldest first
+    uint32_t count;
+};
+
+// Starts a capture: clears the sums and the filter state.
+static void bee_capture_begin(BeeCapture* c) {
+    memset(c, 0, sizeof(*c));
+    reset_filters();
+}
+
+static inline void bee_capture_window(BeeCapture* c, const uint16_t* raw, float dc_offset, float gain) {
+    float mags[NUM_FREQ_BINS];
+    c->sumsq += bee_dsp_window(raw, dc_offset, gain, mags);
+    for (int k = 0; k < NUM_FREQ_BINS; k++) c->bins[k] += mags[k];
+    c->windows++;
+}
+
+// Turns the bin sums into means and returns the density.
+static float bee_capture_end(BeeCapture* c) {
+    if (!c->windows) return 0.0f;
+    for (int k = 0; k < NUM_FREQ_BINS; k++) c->bins[k] /= c->windows;
+    return sqrtf((float)(c->sumsq / ((double)c->windows * FFT_SIZE)));
+}
+
+// A whole capture in memory: DC from the mean of all n samples (as
+// capture_store_mean()), then every whole window. Returns the density.
+static float bee_capture_samples(BeeCapture* c, const uint16_t* s, size_t n, float gain) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += s[i];
+    float dc_offset = n ? (float)((double)sum / n) : 0.0f;
+    bee_capture_begin(c);
+    for (size_t off = 0; off + FFT_SIZE <= n; off += FFT_HOP) bee_capture_window(c, s + off, dc_offset, gain);
+    return bee_capture_end(c);
+}
+
+static void bee_history_clear(BeeHistory* h) {
+    h->count = 0;
+}
+
+static void bee_history_push(BeeHistory* h, float density) {
+    if (h->count == BEE_HISTORY_SIZE) {
+        memmove(h->density, h->density + 1, (BEE_HISTORY_SIZE - 1) * sizeof(float));
+        h->count--;
+    }
+    h->density[h->count++] = density;
+}
+
+// density over the mean of the history; about 1 while the history is empty
+static float bee_spike_ratio(const BeeHistory* h, float density) {
+    float rolling = 0;
+    for (uint32_t i = 0; i < h->count; i++) rolling += h->density[i];
+    rolling = h->count ? rolling / h->count : density;
+    return density / (rolling + 1e-6f);
+}
+
+static void bee_summer_vector(const double* bins, float temp, float hum, float hour, float spike, float* out) {
+    out[0] = temp;
+    out[1] = hum;
+    out[2] = hour;
+    out[3] = spike;
+    for (int i = 0; i < BEE_SUMMER_FEATURES - 4; i++) out[4 + i] = (float)bins[BEE_FIRST_BIN + i];
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * capture_store.h
+ * Packed 12-bit capture buffer for the 6 s inference window.
+ *
+ * The ADC delivers 12-bit samples, so storing them as uint16_t wastes a
+ * quarter of the largest buffer in the firmware. Capture runs through the DMA
+ * block ring and packs each completed block (3 bytes per 2 samples) while the
+ * next one fills; the DSP and streaming paths unpack windows on the fly with
+ * pack12_decode(). The sum and sum of squares are accumulated during packing,
+ * so DC removal needs no extra pass over the buffer.
+ *
+ *   uint16_t[96000]  192000 B
+ *   packed 12-bit    144000 B   (-25%)
+ */
+#ifndef CAPTURE_STORE_H
+#define CAPTURE_STORE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "audio_ring.h"
+#include "audio_codec.h"
+
+#define CAPTURE_STORE_SAMPLES  (RING_SAMPLE_RATE_HZ * 6)
+#define CAPTURE_STORE_BYTES    PACK12_BYTES(CAPTURE_STORE_SAMPLES)
+
+static uint8_t g_capture_store[CAPTURE_STORE_BYTES];
+static int g_capture_len = 0;           // samples in the store
+static uint64_t g_capture_sum = 0;
+static uint64_t g_capture_sumsq = 0;
+
+static void capture_store_reset() {
+    g_capture_len = 0;
+    g_capture_sum = 0;
+    g_capture_sumsq = 0;
+}
+
+// Packs one block (even length) after the stored samples; false once full.
+static bool capture_store_push(const uint16_t* blk, int n) {
+    if (g_capture_len + n > CAPTURE_STORE_SAMPLES) return false;
+    uint64_t sum = 0, sumsq = 0;
+    for (int i = 0; i < n; i++) { uint32_t s = blk[i] & 0x0FFF; sum += s; sumsq += s * s; }
+    // g_capture_len is a multiple of the (even) block size, so pairs never straddle blocks
+    pack12_encode(blk, n, g_capture_store + g_capture_len / 2 * 3);
+    g_capture_len += n;
+    g_capture_sum += sum;
+    g_capture_sumsq += sumsq;
+    return true;
+}
+
+// Blocks until `samples` samples have been captured and packed.
+static void capture_store_record(int samples) {
+    if (samples > CAPTURE_STORE_SAMPLES) samples = CAPTURE_STORE_SAMPLES;
+    capture_store_reset();
+    ring_start();
+    for (int off = 0; off < samples; off += RING_BLOCK_SAMPLES) {
+        int n = samples - off < RING_BLOCK_SAMPLES ? samples - off : RING_BLOCK_SAMPLES;
+        capture_store_push(ring_wait_block(), n);
+        ring_release();
+    }
+    ring_stop();
+    if (g_ring_overruns) printf("[REC] WARNING: %u blocks overrun\n", (unsigned)g_ring_overruns);
+}
+
+// Unpacks samples [offset, offset + n) of the store; offset must be even.
+static inline void capture_store_read(int offset, int n, uint16_t* out) {
+    pack12_decode(g_capture_store + offset / 2 * 3, n, out);
+}
+
+static float capture_store_mean() {
+    return g_capture_len ? (float)((double)g_capture_sum / g_capture_len) : 0.0f;
+}
+
+static float capture_store_std() {
+    if (!g_capture_len) return 0.0f;
+    double mean = (double)g_capture_sum / g_capture_len;
+    double var = (double)g_capture_sumsq / g_capture_len - mean * mean;
+    return var > 0 ? (float)sqrt(var) : 0.0f;
+}
+
+// Unpack cost over the whole store, against copying the same number of
+// uint16_t samples out of the ring (what an unpacked buffer costs to read).
+static void capture_store_benchmark(int iterations) {
+    static uint16_t window[RING_BLOCK_SAMPLES];
+    if (iterations <= 0) iterations = 10;
+    uint32_t check = 0;
+
+    uint64_t t0 = time_us_64();
+    for (int it = 0; it < iterations; it++) {
+        for (int off = 0; off < CAPTURE_STORE_SAMPLES; off += RING_BLOCK_SAMPLES) {
+            int n = CAPTURE_STORE_SAMPLES - off < RING_BLOCK_SAMPLES ? CAPTURE_STORE_SAMPLES - off : RING_BLOCK_SAMPLES;
+            capture_store_read(off, n, window);
+            check += window[0];
+        }
+    }
+    uint64_t t_unpack = time_us_64() - t0;
+
+    t0 = time_us_64();
+    for (int it = 0; it < iterations; it++) {
+        for (int off = 0; off < CAPTURE_STORE_SAMPLES; off += RING_BLOCK_SAMPLES) {
+            int n = CAPTURE_STORE_SAMPLES - off < RING_BLOCK_SAMPLES ? CAPTURE_STORE_SAMPLES - off : RING_BLOCK_SAMPLES;
+            memcpy(window, g_ring[(off / RING_BLOCK_SAMPLES) % RING_NUM_BLOCKS], n * 2);
+            check += window[0];
+        }
+    }
+    uint64_t t_copy = time_us_64() - t0;
+
+    float samples = (float)CAPTURE_STORE_SAMPLES * iterations;
+    printf("[CAP] Store: %d B packed vs %d B uint16 (-%d%%)\n", CAPTURE_STORE_BYTES,
+           CAPTURE_STORE_SAMPLES * 2, 100 - CAPTURE_STORE_BYTES * 100 / (CAPTURE_STORE_SAMPLES * 2));
+    printf("[CAP] Unpack: %.2f ns/sample (%.0f Msamples/s), %.2f ms per 6 s buffer\n",
+           t_unpack * 1000.0f / samples, samples / (float)t_unpack, (float)t_unpack / iterations / 1000.0f);
+    printf("[CAP] Copy:   %.2f ns/sample, %.2f ms per 6 s buffer (chk %u)\n",
+           t_copy * 1000.0f / samples, (float)t_copy / iterations / 1000.0f, (unsigned)check);
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * cascade_gate.h
+ * First stage of the summer classifier: a logistic gate on the spike ratio.
+ *
+ * The summer model is dominated by the spike ratio (docs/ML_MODEL_GUIDE.md,
+ * 1.4), so a one-feature logistic reproduces it away from the boundary:
+ *
+ *   p_event = 1 / (1 + exp(-(bias + w * ln(spike))))
+ *
+ *   p_event >= 1 - margin   -> Event,  decided here
+ *   p_event <= margin       -> Normal, decided here
+ *   otherwise               -> deferred to run_classifier
+ *
+ * The coefficients are fitted to the model's own sweep in the guide
+ * (spike 0.5 -> Normal 0.87, spike 0.8 -> Normal 0.07), which puts the
+ * boundary at spike ~0.61; a larger margin decides more captures here and
+ * agrees less often with the network. The mean of bins 4..7 guards the
+ * gate: outside the range the model was trained on (about a decade around
+ * the 0.02 the guide reports) the capture always goes to the network.
+ *
+ * Pure arithmetic on the 20-feature vector, no SDK or hardware access.
+ */
+#ifndef CASCADE_GATE_H
+#define CASCADE_GATE_H
+
+#include <stdint.h>
+#include <math.h>
+
+struct GateModel {
+    float bias;
+    float w_log_spike;
+    int band_first, band_last;      // feature indices of the guard bins
+    float band_min, band_max;       // mean magnitude range where the gate may decide
+};
+
+static constexpr GateModel GATE_MODEL = { 4.72f, 9.55f, 4, 7, 0.002f, 0.2f };
+
+static_assert(GATE_MODEL.w_log_spike > 0.0f, "a higher spike ratio must mean Event");
+static_assert(GATE_MODEL.band_first >= 4 && GATE_MODEL.band_last < 20 &&
+              GATE_MODEL.band_first <= GATE_MODEL.band_last, "guard bins must be FFT features");
+
+#define GATE_DEFAULT_MARGIN     0.05f
+#define GATE_MAX_MARGIN         0.45f
+
+enum GateVerdict { GATE_NORMAL, GATE_EVENT, GATE_DEFER };
+
+static float gate_p_event(const float* features) {
+    float spike = features[3] > 1e-6f ? features[3] : 1e-6f;
+    float z = GATE_MODEL.bias + GATE_MODEL.w_log_spike * logf(spike);
+    return 1.0f / (1.0f + expf(-z));
+}
+
+static bool gate_in_range(const float* features) {
+    float band = 0.0f;
+    for (int i = GATE_MODEL.band_first; i <= GATE_MODEL.band_last; i++) band += features[i];
+    band /= (float)(GATE_MODEL.band_last - GATE_MODEL.band_first + 1);
+    return band >= GATE_MODEL.band_min && band <= GATE_MODEL.band_max;
+}
+
+// Decides clear cases; margin 0 defers everything.
+static GateVerdict gate_decide(const float* features, float margin, float* p_event) {
+    *p_event = gate_p_event(features);
+    if (margin <= 0.0f || !gate_in_range(features)) return GATE_DEFER;
+    if (*p_event >= 1.0f - margin) return GATE_EVENT;
+    if (*p_event <= margin) return GATE_NORMAL;
+    return GATE_DEFER;
+}
+
+static const char* gate_label(GateVerdict v) {
+    return v == GATE_EVENT ? "Event" : (v == GATE_NORMAL ? "Normal" : "Deferred");
+}
+
+struct GateStats {
+    uint32_t normal, event, deferred;   // verdicts
+    uint32_t audited, disagreed;        // gate verdicts also checked against the network
+    uint32_t nn_runs;
+    uint64_t nn_us;
+};
+
+#endif
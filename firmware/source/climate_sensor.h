@@ -0,0 +1,170 @@
+/*
+ * climate_sensor.h
+ * Split-phase climate sensing: start a conversion, collect it later.
+ *
+ * A ClimateSensor exposes start() and fetch() instead of one blocking read,
+ * so the conversion time overlaps other work. The inference path starts a
+ * measurement when audio capture begins and collects it once capture ends;
+ * the SHT3x's 15 ms conversion disappears behind the 6 s capture and only
+ * the bus transfers remain (< 1 ms at 100 kHz):
+ *
+ *   before:  [write cmd][sleep 15 ms][read 6 B][ capture 6 s ]
+ *   after:   [write cmd][ capture 6 s ][read 6 B]
+ *
+ * Drivers fill in a ClimateSensor; the SHT3x one below uses single-shot
+ * mode without clock stretching (the sensor NACKs its address until data is
+ * ready, so an early fetch reports busy rather than holding the bus) and
+ * checks the CRC-8 of both words in the 6-byte frame.
+ */
+#ifndef CLIMATE_SENSOR_H
+#define CLIMATE_SENSOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+enum SensorStatus { SENSOR_OK = 0, SENSOR_BUSY = 1, SENSOR_ERROR = -1, SENSOR_CRC = -2 };
+
+struct ClimateReading {
+    float temp_c;
+    float hum_pct;
+    uint64_t t_us;              // completion time
+};
+
+struct ClimateSensor {
+    const char* name;
+    void* ctx;
+    uint32_t conversion_us;     // worst case start -> data ready
+    SensorStatus (*start)(void* ctx);
+    SensorStatus (*fetch)(void* ctx, ClimateReading* out);
+};
+
+// Measurement state on top of a driver
+struct ClimateChannel {
+    ClimateSensor sensor;
+    bool pending;
+    uint64_t started_us;
+    ClimateReading last;
+    bool valid;
+
+    // Stats since boot
+    uint32_t reads, busy, crc_errors, bus_errors;
+    uint32_t max_bus_us;        // longest time spent in start() or fetch()
+};
+
+// --- SHT3x (I2C, 0x44/0x45) ---
+
+#define SHT3X_CMD_SINGLE_HIGH   0x2400  // single shot, high repeatability, no clock stretching
+#define SHT3X_CONVERSION_US     16000   // 15.5 ms max at high repeatability
+#define SHT3X_BUS_TIMEOUT_US    3000
+
+struct Sht3x {
+    i2c_inst_t* i2c;
+    uint8_t addr;
+};
+
+// CRC-8 from the SHT3x datasheet: poly 0x31, init 0xFF, no reflection.
+static uint8_t sht3x_crc8(const uint8_t* data, int len) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+static SensorStatus sht3x_start(void* ctx) {
+    Sht3x* dev = (Sht3x*)ctx;
+    uint8_t cmd[2] = { SHT3X_CMD_SINGLE_HIGH >> 8, SHT3X_CMD_SINGLE_HIGH & 0xFF };
+    int n = i2c_write_timeout_us(dev->i2c, dev->addr, cmd, 2, false, SHT3X_BUS_TIMEOUT_US);
+    return n == 2 ? SENSOR_OK : SENSOR_ERROR;
+}
+
+static SensorStatus sht3x_fetch(void* ctx, ClimateReading* out) {
+    Sht3x* dev = (Sht3x*)ctx;
+    uint8_t d[6];
+    int n = i2c_read_timeout_us(dev->i2c, dev->addr, d, 6, false, SHT3X_BUS_TIMEOUT_US);
+    if (n == PICO_ERROR_GENERIC) return SENSOR_BUSY;        // address NACK: conversion running
+    if (n != 6) return SENSOR_ERROR;
+    if (sht3x_crc8(d, 2) != d[2] || sht3x_crc8(d + 3, 2) != d[5]) return SENSOR_CRC;
+    uint16_t t_raw = (d[0] << 8) | d[1];
+    uint16_t h_raw = (d[3] << 8) | d[4];
+    out->temp_c = -45.0f + 175.0f * (float)t_raw / 65535.0f;
+    out->hum_pct = 100.0f * (float)h_raw / 65535.0f;
+    return SENSOR_OK;
+}
+
+static void sht3x_init(Sht3x* dev, ClimateSensor* sensor, i2c_inst_t* i2c, uint8_t addr) {
+    dev->i2c = i2c;
+    dev->addr = addr;
+    sensor->name = "SHT3x";
+    sensor->ctx = dev;
+    sensor->conversion_us = SHT3X_CONVERSION_US;
+    sensor->start = sht3x_start;
+    sensor->fetch = sht3x_fetch;
+}
+
+// --- Channel ---
+
+static void climate_note_bus(ClimateChannel* ch, uint64_t t0) {
+    uint32_t dt = (uint32_t)(time_us_64() - t0);
+    if (dt > ch->max_bus_us) ch->max_bus_us = dt;
+}
+
+// Starts a conversion unless one is already running. Non-blocking apart from
+// the 2-byte command write.
+static bool climate_start(ClimateChannel* ch) {
+    if (ch->pending) return true;
+    uint64_t t0 = time_us_64();
+    SensorStatus s = ch->sensor.start(ch->sensor.ctx);
+    climate_note_bus(ch, t0);
+    if (s != SENSOR_OK) { ch->bus_errors++; return false; }
+    ch->pending = true;
+    ch->started_us = t0;
+    return true;
+}
+
+// Collects a started conversion if it is due. Returns SENSOR_BUSY while the
+// sensor is still converting; on SENSOR_OK the result is in ch->last.
+static SensorStatus climate_poll(ClimateChannel* ch) {
+    if (!ch->pending) return SENSOR_ERROR;
+    if (time_us_64() - ch->started_us < ch->sensor.conversion_us) return SENSOR_BUSY;
+    uint64_t t0 = time_us_64();
+    ClimateReading r;
+    SensorStatus s = ch->sensor.fetch(ch->sensor.ctx, &r);
+    climate_note_bus(ch, t0);
+    if (s == SENSOR_BUSY) { ch->busy++; return s; }
+    ch->pending = false;        // a CRC or bus error ends the measurement too
+    if (s == SENSOR_CRC) ch->crc_errors++;
+    else if (s != SENSOR_OK) ch->bus_errors++;
+    else {
+        r.t_us = time_us_64();
+        ch->last = r;
+        ch->valid = true;
+        ch->reads++;
+    }
+    return s;
+}
+
+// Waits for the running conversion; starts one first if none is pending.
+static bool climate_wait(ClimateChannel* ch, uint32_t timeout_ms) {
+    if (!ch->pending && !climate_start(ch)) return false;
+    uint64_t deadline = ch->started_us + ch->sensor.conversion_us + timeout_ms * 1000ull;
+    while (true) {
+        SensorStatus s = climate_poll(ch);
+        if (s == SENSOR_OK) return true;
+        if (s != SENSOR_BUSY) return false;
+        if (time_us_64() > deadline) { ch->pending = false; ch->bus_errors++; return false; }
+        sleep_us(500);
+    }
+}
+
+static void climate_print_status(const ClimateChannel* ch) {
+    printf("[SENSOR] %s: %u reads, %u busy polls, %u CRC errors, %u bus errors, longest bus op %u us\n",
+           ch->sensor.name, (unsigned)ch->reads, (unsigned)ch->busy, (unsigned)ch->crc_errors,
+           (unsigned)ch->bus_errors, (unsigned)ch->max_bus_us);
+}
+
+#endif
@@ -0,0 +1,350 @@
+/*
+ * clip_upload.h
+ * Event-triggered audio clips: pre-trigger ring plus resumable chunked upload.
+ *
+ * Every capture feeds its last CLIP_PRE_SECONDS into a ring of fixed-size
+ * encoded blocks (IMA-ADPCM by default, see audio_codec.h); live mode pushes
+ * each DMA block as it arrives. When inference reports an Event,
+ * clip_trigger() records CLIP_POST_SECONDS more through the DMA block ring,
+ * freezes the pre + post blocks and queues an upload. It starts and stops the
+ * ring itself, so a caller streaming from the ring stops it first.
+ *
+ * clip_poll() is called from the main loop and drives a non-blocking lwIP
+ * state machine, one small step per call:
+ *
+ *   POST /api/v1/clips/                      register clip metadata
+ *   PUT  /api/v1/clips/<id>/chunks?offset=N  CLIP_CHUNK_BYTES of raw blocks
+ *   GET  /api/v1/clips/<id>                  after an error: resume offset
+ *
+ * The server answers every request with {"received": N}; the device always
+ * continues from the server's count, so a dropped connection costs at most
+ * one chunk. Sampling and inference keep running while a clip uploads; only
+ * their pre-trigger copies are dropped once the ring is full.
+ */
+#ifndef CLIP_UPLOAD_H
+#define CLIP_UPLOAD_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "pico/stdlib.h"
+#include "lwip/tcp.h"
+#include "flash_config.h"
+#include "audio_ring.h"
+#include "audio_codec.h"
+
+#ifndef CLIP_CODEC
+#define CLIP_CODEC          CODEC_ADPCM
+#endif
+#define CLIP_PRE_SECONDS    3
+#define CLIP_POST_SECONDS   2
+#define CLIP_BLOCK_SAMPLES  RING_BLOCK_SAMPLES
+#define CLIP_BLOCK_BYTES    ((CLIP_CODEC == CODEC_ADPCM) ? (4 + CLIP_BLOCK_SAMPLES / 2) : (CLIP_BLOCK_SAMPLES * 3 / 2))
+#define CLIP_PRE_BLOCKS     ((CLIP_PRE_SECONDS * RING_SAMPLE_RATE_HZ) / CLIP_BLOCK_SAMPLES)
+#define CLIP_POST_BLOCKS    ((CLIP_POST_SECONDS * RING_SAMPLE_RATE_HZ + CLIP_BLOCK_SAMPLES - 1) / CLIP_BLOCK_SAMPLES)
+#define CLIP_RING_BLOCKS    (CLIP_PRE_BLOCKS + CLIP_POST_BLOCKS + 4)
+
+#define CLIP_CHUNK_BYTES    4096
+#define CLIP_TIMEOUT_MS     5000
+#define CLIP_RETRY_MS       2000
+#define CLIP_MAX_RETRIES    20
+
+// --- Pre-trigger ring ---
+
+static uint8_t g_clip_ring[CLIP_RING_BLOCKS][CLIP_BLOCK_BYTES];
+static uint32_t g_clip_head = 0;        // blocks written since boot
+static uint32_t g_clip_first = 0;       // first block of the frozen clip
+static uint32_t g_clip_blocks = 0;
+static uint32_t g_clip_dropped = 0;     // pre-trigger blocks lost while frozen
+static bool g_clip_frozen = false;
+
+static void clip_push_block(const uint16_t* samples) {
+    if (g_clip_frozen && g_clip_head >= g_clip_first + CLIP_RING_BLOCKS) { g_clip_dropped++; return; }
+    codec_encode(CLIP_CODEC, samples, CLIP_BLOCK_SAMPLES, g_clip_ring[g_clip_head % CLIP_RING_BLOCKS]);
+    g_clip_head++;
+}
+
+// Keeps the last CLIP_PRE_SECONDS of a finished capture (packed 12-bit store).
+static void clip_feed(const uint8_t* packed, int n) {
+    static uint16_t block[CLIP_BLOCK_SAMPLES];
+    int start = n - CLIP_PRE_BLOCKS * CLIP_BLOCK_SAMPLES;
+    if (start < 0) start = n % CLIP_BLOCK_SAMPLES;
+    start &= ~1;
+    for (int off = start; off + CLIP_BLOCK_SAMPLES <= n; off += CLIP_BLOCK_SAMPLES) {
+        pack12_decode(packed + off / 2 * 3, CLIP_BLOCK_SAMPLES, block);
+        clip_push_block(block);
+    }
+}
+
+// Contiguous bytes of the frozen clip starting at byte offset `pos`.
+static const uint8_t* clip_bytes(uint32_t pos, uint32_t* avail) {
+    uint32_t blk = pos / CLIP_BLOCK_BYTES, in = pos % CLIP_BLOCK_BYTES;
+    *avail = CLIP_BLOCK_BYTES - in;
+    return &g_clip_ring[(g_clip_first + blk) % CLIP_RING_BLOCKS][in];
+}
+
+// --- Upload state machine ---
+
+enum ClipStep { CLIP_REGISTER, CLIP_QUERY, CLIP_CHUNK };
+
+struct ClipUpload {
+    char id[48];                // <node_id>-<clip_seq>
+    char label[16];
+    float confidence;
+    uint32_t total;             // clip size in bytes
+    uint32_t pre_blocks;
+    uint32_t offset;            // bytes the server has confirmed
+    ClipStep next;
+    int retries;
+    uint32_t retry_at_ms;
+
+    // Request in flight
+    struct tcp_pcb* pcb;
+    bool busy, done, failed;
+    uint32_t started_ms;
+    char hdr[320];
+    char json[320];
+    int hdr_len, hdr_sent;
+    uint32_t body_len, body_sent;
+    bool body_is_clip;
+    char rx[256];
+    int rx_len;
+
+    // Stats
+    uint32_t chunks, resumes;
+    uint64_t t_start_us;
+};
+static ClipUpload g_clip;
+
+static void clip_pump(struct tcp_pcb* pcb) {
+    while (g_clip.hdr_sent < g_clip.hdr_len) {
+        uint32_t n = g_clip.hdr_len - g_clip.hdr_sent;
+        if (n > tcp_sndbuf(pcb)) n = tcp_sndbuf(pcb);
+        if (n == 0 || tcp_write(pcb, g_clip.hdr + g_clip.hdr_sent, n, TCP_WRITE_FLAG_COPY) != ERR_OK) break;
+        g_clip.hdr_sent += n;
+    }
+    while (g_clip.hdr_sent == g_clip.hdr_len && g_clip.body_sent < g_clip.body_len) {
+        uint32_t avail;
+        const uint8_t* src;
+        if (g_clip.body_is_clip) src = clip_bytes(g_clip.offset + g_clip.body_sent, &avail);
+        else { src = (const uint8_t*)g_clip.json + g_clip.body_sent; avail = g_clip.body_len - g_clip.body_sent; }
+        uint32_t n = g_clip.body_len - g_clip.body_sent;
+        if (n > avail) n = avail;
+        if (n > tcp_sndbuf(pcb)) n = tcp_sndbuf(pcb);
+        if (n == 0 || tcp_write(pcb, src, n, TCP_WRITE_FLAG_COPY) != ERR_OK) break;
+        g_clip.body_sent += n;
+    }
+    tcp_output(pcb);
+}
+
+static err_t clip_connected_cb(void* arg, struct tcp_pcb* pcb, err_t err) {
+    if (err != ERR_OK) { g_clip.failed = true; return err; }
+    clip_pump(pcb);
+    return ERR_OK;
+}
+
+static err_t clip_sent_cb(void* arg, struct tcp_pcb* pcb, u16_t len) {
+    clip_pump(pcb);
+    return ERR_OK;
+}
+
+static err_t clip_recv_cb(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+    if (!p) {
+        tcp_arg(pcb, NULL); tcp_sent(pcb, NULL); tcp_recv(pcb, NULL); tcp_err(pcb, NULL);
+        tcp_close(pcb);
+        g_clip.pcb = NULL;
+        g_clip.done = true;
+        return ERR_OK;
+    }
+    int room = (int)sizeof(g_clip.rx) - 1 - g_clip.rx_len;
+    int n = p->tot_len < room ? p->tot_len : room;
+    if (n > 0) g_clip.rx_len += pbuf_copy_partial(p, g_clip.rx + g_clip.rx_len, n, 0);
+    g_clip.rx[g_clip.rx_len] = 0;
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void clip_err_cb(void* arg, err_t err) {
+    printf("[CLIP] TCP Error: %d\n", err);
+    g_clip.pcb = NULL;          // lwIP has already freed it
+    g_clip.failed = true;
+}
+
+static void clip_abort() {
+    if (g_clip.pcb) {
+        tcp_arg(g_clip.pcb, NULL); tcp_sent(g_clip.pcb, NULL); tcp_recv(g_clip.pcb, NULL); tcp_err(g_clip.pcb, NULL);
+        tcp_abort(g_clip.pcb);
+        g_clip.pcb = NULL;
+    }
+    g_clip.busy = false;
+}
+
+static bool clip_begin_request(const char* method, const char* path, const char* content_type, uint32_t body_len, bool body_is_clip) {
+    g_clip.hdr_len = snprintf(g_clip.hdr, sizeof(g_clip.hdr),
+        "%s /api/v1/%s HTTP/1.1\r\n"
+        "Host: %s:%d\r\n"
+        "Connection: close\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %u\r\n"
+        "\r\n",
+        method, path, sys_config.server_ip, sys_config.server_port, content_type, (unsigned)body_len);
+    g_clip.hdr_sent = 0;
+    g_clip.body_len = body_len;
+    g_clip.body_sent = 0;
+    g_clip.body_is_clip = body_is_clip;
+    g_clip.rx_len = 0; g_clip.rx[0] = 0;
+    g_clip.done = g_clip.failed = false;
+    g_clip.started_ms = to_ms_since_boot(get_absolute_time());
+
+    ip_addr_t server_ip;
+    ip4addr_aton(sys_config.server_ip, &server_ip);
+    g_clip.pcb = tcp_new();
+    if (!g_clip.pcb) return false;
+    tcp_err(g_clip.pcb, clip_err_cb);
+    tcp_recv(g_clip.pcb, clip_recv_cb);
+    tcp_sent(g_clip.pcb, clip_sent_cb);
+    if (tcp_connect(g_clip.pcb, &server_ip, sys_config.server_port, clip_connected_cb) != ERR_OK) {
+        clip_abort();
+        return false;
+    }
+    g_clip.busy = true;
+    return true;
+}
+
+static bool clip_start_next() {
+    char path[96];
+    switch (g_clip.next) {
+        case CLIP_REGISTER: {
+            uint32_t len = snprintf(g_clip.json, sizeof(g_clip.json),
+                "{\"clip_id\": \"%s\", \"node_id\": \"%s\", \"codec\": \"%s\", \"sample_rate\": %d, "
+                "\"block_samples\": %d, \"block_bytes\": %d, \"total_bytes\": %u, \"pre_trigger_ms\": %d, "
+                "\"label\": \"%s\", \"confidence\": %.2f}",
+                g_clip.id, sys_config.node_id, codec_name(CLIP_CODEC), RING_SAMPLE_RATE_HZ,
+                CLIP_BLOCK_SAMPLES, CLIP_BLOCK_BYTES, (unsigned)g_clip.total,
+                (int)((uint64_t)g_clip.pre_blocks * CLIP_BLOCK_SAMPLES * 1000 / RING_SAMPLE_RATE_HZ),
+                g_clip.label, g_clip.confidence);
+            return clip_begin_request("POST", "clips/", "application/json", len, false);
+        }
+        case CLIP_QUERY:
+            snprintf(path, sizeof(path), "clips/%s", g_clip.id);
+            return clip_begin_request("GET", path, "application/json", 0, false);
+        case CLIP_CHUNK: {
+            uint32_t len = g_clip.total - g_clip.offset;
+            if (len > CLIP_CHUNK_BYTES) len = CLIP_CHUNK_BYTES;
+            snprintf(path, sizeof(path), "clips/%s/chunks?offset=%u", g_clip.id, (unsigned)g_clip.offset);
+            return clip_begin_request("PUT", path, "application/octet-stream", len, true);
+        }
+    }
+    return false;
+}
+
+static void clip_finish(bool ok) {
+    float secs = (float)(time_us_64() - g_clip.t_start_us) / 1e6f;
+    if (ok) printf("[CLIP] %s uploaded: %u B in %u chunks, %.1f s, %u resumes\n",
+                   g_clip.id, (unsigned)g_clip.total, (unsigned)g_clip.chunks, secs, (unsigned)g_clip.resumes);
+    else printf("[CLIP] %s abandoned at %u/%u B after %d retries\n",
+                g_clip.id, (unsigned)g_clip.offset, (unsigned)g_clip.total, g_clip.retries);
+    g_clip_frozen = false;
+}
+
+// Parses the status line and {"received": N}; false if the request failed.
+static bool clip_handle_response() {
+    int status = 0;
+    if (strncmp(g_clip.rx, "HTTP/1.", 7) == 0) status = atoi(g_clip.rx + 9);
+    const char* r = strstr(g_clip.rx, "\"received\"");
+    if (r && (r = strchr(r, ':'))) {
+        uint32_t received = (uint32_t)strtoul(r + 1, NULL, 10);
+        if (g_clip.next == CLIP_CHUNK && status == 200) g_clip.chunks++;
+        if (g_clip.next == CLIP_QUERY) g_clip.resumes++;
+        g_clip.offset = received < g_clip.total ? received : g_clip.total;
+        g_clip.next = CLIP_CHUNK;
+        if (status == 200 || status == 409) return true;
+    }
+    // Clip unknown to the server (restarted, or registration lost)
+    if (status == 404) { g_clip.next = CLIP_REGISTER; g_clip.offset = 0; }
+    return false;
+}
+
+static void clip_schedule_retry() {
+    g_clip.retries++;
+    if (g_clip.next != CLIP_REGISTER) g_clip.next = CLIP_QUERY;
+    g_clip.retry_at_ms = to_ms_since_boot(get_absolute_time()) + CLIP_RETRY_MS * (g_clip.retries < 5 ? g_clip.retries : 5);
+    if (g_clip.retries > CLIP_MAX_RETRIES) clip_finish(false);
+}
+
+// Drives the upload; cheap enough to call every main loop iteration.
+static void clip_poll(bool online) {
+    if (!g_clip_frozen) return;
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    if (g_clip.busy) {
+        if (g_clip.done) {
+            g_clip.busy = false;
+            if (!clip_handle_response()) clip_schedule_retry();
+            else {
+                g_clip.retries = 0;
+                if (g_clip.offset >= g_clip.total) clip_finish(true);
+            }
+        } else if (g_clip.failed || now - g_clip.started_ms > CLIP_TIMEOUT_MS) {
+            clip_abort();
+            clip_schedule_retry();
+        }
+        return;
+    }
+
+    if (!online || (int32_t)(now - g_clip.retry_at_ms) < 0) return;
+    if (!clip_start_next()) clip_schedule_retry();
+}
+
+// Records the post-trigger audio and queues the clip. Blocks for
+// CLIP_POST_SECONDS while sampling; the upload itself runs from clip_poll().
+static bool clip_trigger(const char* label, float confidence) {
+    if (g_clip_frozen) {
+        printf("[CLIP] Upload of %s in progress, event not recorded\n", g_clip.id);
+        return false;
+    }
+    uint32_t pre = g_clip_head < CLIP_PRE_BLOCKS ? g_clip_head : CLIP_PRE_BLOCKS;
+    g_clip_first = g_clip_head - pre;
+    g_clip_frozen = true;
+
+    ring_start();
+    for (int i = 0; i < CLIP_POST_BLOCKS; i++) {
+        clip_push_block(ring_wait_block());
+        ring_release();
+    }
+    ring_stop();
+    g_clip_blocks = g_clip_head - g_clip_first;
+
+    // The number comes from flash so IDs stay unique across reboots; the
+    // server keys clips by ID alone, hence the node prefix.
+    sys_config.clip_seq++;
+    save_config();
+    memset(&g_clip, 0, sizeof(g_clip));
+    snprintf(g_clip.id, sizeof(g_clip.id), "%s-%lu", sys_config.node_id, (unsigned long)sys_config.clip_seq);
+    strncpy(g_clip.label, label, sizeof(g_clip.label) - 1);
+    g_clip.confidence = confidence;
+    g_clip.total = g_clip_blocks * CLIP_BLOCK_BYTES;
+    g_clip.pre_blocks = pre;
+    g_clip.next = CLIP_REGISTER;
+    g_clip.retry_at_ms = to_ms_since_boot(get_absolute_time());
+    g_clip.t_start_us = time_us_64();
+
+    printf("[CLIP] %s: %u blocks (%u pre), %u B %s queued\n", g_clip.id, (unsigned)g_clip_blocks,
+           (unsigned)pre, (unsigned)g_clip.total, codec_name(CLIP_CODEC));
+    return true;
+}
+
+static void clip_print_status() {
+    printf("[CLIP] Ring: %u/%d blocks of %d B (%s), dropped %u\n",
+           (unsigned)(g_clip_head < CLIP_RING_BLOCKS ? g_clip_head : CLIP_RING_BLOCKS), CLIP_RING_BLOCKS,
+           CLIP_BLOCK_BYTES, codec_name(CLIP_CODEC), (unsigned)g_clip_dropped);
+    if (g_clip_frozen)
+        printf("[CLIP] Uploading %s: %u/%u B, %u chunks, %u resumes, %d retries\n", g_clip.id,
+               (unsigned)g_clip.offset, (unsigned)g_clip.total, (unsigned)g_clip.chunks,
+               (unsigned)g_clip.resumes, g_clip.retries);
+    else printf("[CLIP] Idle\n");
+}
+
+#endif
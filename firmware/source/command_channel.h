@@ -0,0 +1,239 @@
+/*
+ * command_channel.h
+ * Server-to-node commands over HTTP long-poll on one keep-alive connection.
+ *
+ * Instead of opening a connection to commands/pending every 2 s, the node
+ * keeps a single TCP connection and leaves one request parked on it:
+ *
+ *   GET /api/v1/commands/pending?node_id=X&wait=CMD_WAIT_S&ack=ID,...
+ *
+ * The server answers as soon as a command is queued for the node, or with []
+ * when the wait expires, and the next request goes out immediately. Idle
+ * traffic drops from one connection per 2 s to one request per CMD_WAIT_S on a
+ * connection that lives until either side drops it, while a queued command
+ * reaches the node in about one round trip instead of up to 2 s.
+ *
+ * `ack` lists the ids of the commands in the previous response. The server
+ * keeps a command pending, and sends it again, until a request acknowledges
+ * it, so a response written to a connection that died on the way (WiFi drop,
+ * a request still parked on the old socket) is delivered on the next one.
+ * The list is kept until a request carrying it is answered.
+ *
+ * cmd_channel_poll() is called from the main loop and never blocks. Errors
+ * and non-200 replies reconnect with exponential backoff.
+ */
+#ifndef COMMAND_CHANNEL_H
+#define COMMAND_CHANNEL_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "pico/stdlib.h"
+#include "lwip/tcp.h"
+#include "flash_config.h"
+
+#define CMD_WAIT_S          50      // below common 60 s proxy idle timeouts
+#define CMD_GRACE_MS        10000   // extra time on top of the wait before giving up
+#define CMD_BACKOFF_MIN_MS  1000
+#define CMD_BACKOFF_MAX_MS  30000
+#define CMD_RX_SIZE         2048
+#define CMD_ACK_MAX         4       // MAX_BATCH in backend/app/api/commands.py
+#define CMD_ID_LEN          36      // UUID string
+
+struct CommandChannel {
+    struct tcp_pcb* pcb;
+    bool connected;
+    bool in_flight;
+    bool failed;
+    char rx[CMD_RX_SIZE];
+    int rx_len;
+    uint32_t sent_ms;
+    uint32_t retry_at_ms;
+    uint32_t backoff_ms;
+    char ack[CMD_ACK_MAX][CMD_ID_LEN + 1];  // ids to acknowledge on the next request
+    int ack_count;
+
+    // Stats since boot
+    uint32_t connections, requests, responses, commands, errors;
+    uint32_t max_response_ms;
+};
+
+static CommandChannel g_cmd;
+
+// --- lwIP callbacks ---
+
+static err_t cmd_recv_cb(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err) {
+    if (!p) {
+        // Server closed the connection; an answered request stays valid
+        tcp_arg(pcb, NULL); tcp_recv(pcb, NULL); tcp_err(pcb, NULL);
+        tcp_close(pcb);
+        g_cmd.pcb = NULL;
+        g_cmd.connected = false;
+        return ERR_OK;
+    }
+    int room = CMD_RX_SIZE - 1 - g_cmd.rx_len;
+    int n = p->tot_len < room ? p->tot_len : room;
+    if (n > 0) g_cmd.rx_len += pbuf_copy_partial(p, g_cmd.rx + g_cmd.rx_len, n, 0);
+    g_cmd.rx[g_cmd.rx_len] = 0;
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void cmd_err_cb(void* arg, err_t err) {
+    printf("[CMD] TCP Error: %d\n", err);
+    g_cmd.pcb = NULL;           // lwIP has already freed it
+    g_cmd.connected = false;
+    g_cmd.failed = true;
+}
+
+static err_t cmd_connected_cb(void* arg, struct tcp_pcb* pcb, err_t err) {
+    if (err != ERR_OK) { g_cmd.failed = true; return err; }
+    g_cmd.connected = true;
+    return ERR_OK;
+}
+
+static void cmd_abort() {
+    if (g_cmd.pcb) {
+        tcp_arg(g_cmd.pcb, NULL); tcp_recv(g_cmd.pcb, NULL); tcp_err(g_cmd.pcb, NULL);
+        tcp_abort(g_cmd.pcb);
+        g_cmd.pcb = NULL;
+    }
+    g_cmd.connected = false;
+    g_cmd.in_flight = false;
+}
+
+static void cmd_schedule_retry(uint32_t now) {
+    g_cmd.errors++;
+    cmd_abort();
+    g_cmd.backoff_ms = g_cmd.backoff_ms ? g_cmd.backoff_ms * 2 : CMD_BACKOFF_MIN_MS;
+    if (g_cmd.backoff_ms > CMD_BACKOFF_MAX_MS) g_cmd.backoff_ms = CMD_BACKOFF_MAX_MS;
+    g_cmd.retry_at_ms = now + g_cmd.backoff_ms;
+}
+
+static bool cmd_connect() {
+    ip_addr_t server_ip;
+    ip4addr_aton(sys_config.server_ip, &server_ip);
+    g_cmd.failed = false;
+    g_cmd.pcb = tcp_new();
+    if (!g_cmd.pcb) return false;
+    tcp_err(g_cmd.pcb, cmd_err_cb);
+    tcp_recv(g_cmd.pcb, cmd_recv_cb);
+    if (tcp_connect(g_cmd.pcb, &server_ip, sys_config.server_port, cmd_connected_cb) != ERR_OK) {
+        cmd_abort();
+        return false;
+    }
+    g_cmd.connections++;
+    return true;
+}
+
+// Replaces the ack list with the command ids in a response body.
+static void cmd_collect_ids(const char* body) {
+    g_cmd.ack_count = 0;
+    const char* p = body;
+    while (g_cmd.ack_count < CMD_ACK_MAX && (p = strstr(p, "\"command_id\"")) != NULL) {
+        p += 12;
+        const char* q = strchr(p, ':');
+        if (!q) break;
+        while (*++q == ' ') {}
+        if (*q != '"') continue;
+        const char* end = strchr(++q, '"');
+        if (!end || end - q != CMD_ID_LEN) continue;
+        memcpy(g_cmd.ack[g_cmd.ack_count], q, CMD_ID_LEN);
+        g_cmd.ack[g_cmd.ack_count++][CMD_ID_LEN] = 0;
+        p = end;
+    }
+}
+
+static bool cmd_send_request(uint32_t now) {
+    char ack[CMD_ACK_MAX * (CMD_ID_LEN + 1) + 1];
+    int n = 0;
+    ack[0] = 0;
+    for (int i = 0; i < g_cmd.ack_count; i++)
+        n += snprintf(ack + n, sizeof(ack) - n, "%s%s", i ? "," : "", g_cmd.ack[i]);
+
+    char req[512];
+    int len = snprintf(req, sizeof(req),
+        "GET /api/v1/commands/pending?node_id=%s&wait=%d&ack=%s HTTP/1.1\r\n"
+        "Host: %s:%d\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n",
+        sys_config.node_id, CMD_WAIT_S, ack, sys_config.server_ip, sys_config.server_port);
+    if (len >= (int)sizeof(req)) return false;
+    if (tcp_write(g_cmd.pcb, req, len, TCP_WRITE_FLAG_COPY) != ERR_OK) return false;
+    tcp_output(g_cmd.pcb);
+    g_cmd.rx_len = 0; g_cmd.rx[0] = 0;
+    g_cmd.in_flight = true;
+    g_cmd.sent_ms = now;
+    g_cmd.requests++;
+    return true;
+}
+
+// Returns the body once a full response (headers + Content-Length bytes) is
+// buffered, or the buffer is full, else NULL. Sets *status to the HTTP status code.
+static const char* cmd_response_body(int* status) {
+    const char* body = strstr(g_cmd.rx, "\r\n\r\n");
+    if (!body) return NULL;
+    body += 4;
+    const char* cl = strstr(g_cmd.rx, "content-length:");
+    if (!cl) cl = strstr(g_cmd.rx, "Content-Length:");
+    if (cl && cl < body) {
+        int want = atoi(cl + 15);
+        if ((g_cmd.rx + g_cmd.rx_len) - body < want && g_cmd.rx_len < CMD_RX_SIZE - 1) return NULL;
+    } else if (g_cmd.connected && g_cmd.rx_len < CMD_RX_SIZE - 1) {
+        return NULL;            // no length: the body ends when the server closes
+    }
+    *status = strncmp(g_cmd.rx, "HTTP/1.", 7) == 0 ? atoi(g_cmd.rx + 9) : 0;
+    return body;
+}
+
+// Drives the channel; on_commands receives each response body (a JSON list).
+static void cmd_channel_poll(bool online, void (*on_commands)(const char* body)) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (!online) {
+        if (g_cmd.pcb) cmd_abort();
+        return;
+    }
+
+    if (g_cmd.in_flight) {
+        int status = 0;
+        const char* body = cmd_response_body(&status);
+        if (body) {
+            uint32_t dt = now - g_cmd.sent_ms;
+            if (dt > g_cmd.max_response_ms) g_cmd.max_response_ms = dt;
+            g_cmd.in_flight = false;
+            g_cmd.responses++;
+            if (status != 200) { printf("[CMD] HTTP %d\n", status); cmd_schedule_retry(now); return; }
+            g_cmd.backoff_ms = 0;
+            cmd_collect_ids(body);      // the request just answered carried the old list
+            if (strchr(body, '{')) { g_cmd.commands++; on_commands(body); }
+        } else if (g_cmd.failed || (!g_cmd.pcb && !g_cmd.connected) ||
+                   now - g_cmd.sent_ms > CMD_WAIT_S * 1000 + CMD_GRACE_MS) {
+            cmd_schedule_retry(now);
+        }
+        return;
+    }
+
+    if (!g_cmd.pcb) {
+        if ((int32_t)(now - g_cmd.retry_at_ms) < 0) return;
+        if (!cmd_connect()) cmd_schedule_retry(now);
+        g_cmd.sent_ms = now;    // connect timeout reference
+        return;
+    }
+    if (!g_cmd.connected) {
+        if (g_cmd.failed || now - g_cmd.sent_ms > CMD_GRACE_MS) cmd_schedule_retry(now);
+        return;
+    }
+    if (!cmd_send_request(now)) cmd_schedule_retry(now);
+}
+
+static void cmd_channel_print_status() {
+    printf("[CMD] Long-poll %s, wait %d s: %u requests on %u connections, %u with commands\n",
+           g_cmd.in_flight ? "parked" : (g_cmd.connected ? "idle" : "down"), CMD_WAIT_S,
+           (unsigned)g_cmd.requests, (unsigned)g_cmd.connections, (unsigned)g_cmd.commands);
+    printf("[CMD] Errors %u, backoff %u ms, longest response %u ms, %d to acknowledge\n",
+           (unsigned)g_cmd.errors, (unsigned)g_cmd.backoff_ms, (unsigned)g_cmd.max_response_ms, g_cmd.ack_count);
+}
+
+#endif
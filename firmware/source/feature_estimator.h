@@ -0,0 +1,94 @@
+/*
+ * feature_estimator.h
+ * Sequential estimation of the capture features, for adaptive capture length.
+ *
+ * The summer features are per-window averages: bins 4..19 of the DFT and the
+ * density (RMS over all samples, i.e. the root of the mean per-window mean
+ * square). Instead of always averaging 187 windows (6 s), the streaming
+ * capture feeds each window to est_add(), which keeps Welford running means
+ * and variances, and stops once every estimate is tight enough:
+ *
+ *   z * sqrt(var / n) / mean  <  rel_ci     for each used bin
+ *   the same, halved, for the mean square   (density = sqrt, so half the relative error)
+ *
+ * The check only starts after EST_MIN_WINDOWS, and at EST_MAX_WINDOWS the
+ * capture stops whatever the spread. The maximum is twice the 6 s store, so
+ * noisy conditions extend the capture: the store keeps the first 6 s for
+ * clips and streaming, and the features keep averaging.
+ *
+ * A bin of broadband noise has a Rayleigh-like magnitude (relative spread
+ * ~0.5), which 187 windows pin down to about +-7.5%: EST_DEFAULT_CI matches
+ * the fixed capture there, and steadier tonal bins stop sooner. Windows of
+ * one capture are not independent (the hum drifts), so the interval is a
+ * stopping heuristic, not a guarantee; tools/capture_eval.cpp measures the
+ * resulting feature error and capture time against fixed 6 s captures.
+ */
+#ifndef FEATURE_ESTIMATOR_H
+#define FEATURE_ESTIMATOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "bee_dsp.h"
+
+#define EST_MIN_WINDOWS     31      // ~1 s at 16 kHz
+#define EST_MAX_WINDOWS     374     // ~12 s, twice the 6 s store
+#define EST_FIRST_BIN       4       // bins the summer model uses
+#define EST_LAST_BIN        19
+#define EST_Z               1.96f   // two-sided 95%
+#define EST_DEFAULT_CI      0.08f   // `cap adapt on`; about what 187 windows give noise-like bins
+
+struct FeatureEstimator {
+    float rel_ci;               // target relative half-width of the intervals
+    uint32_t n;                 // windows added
+    double mean[NUM_FREQ_BINS];
+    double m2[NUM_FREQ_BINS];
+    double ms_mean, ms_m2;      // per-window mean square of the filtered signal
+    float worst;                // largest relative half-width at the last check
+    int worst_bin;              // its bin, -1 for density
+};
+
+static void est_init(FeatureEstimator* e, float rel_ci) {
+    memset(e, 0, sizeof(*e));
+    e->rel_ci = rel_ci;
+    e->worst_bin = -1;
+}
+
+static void est_add(FeatureEstimator* e, const float* mags, double mean_square) {
+    e->n++;
+    double inv_n = 1.0 / e->n;
+    for (int k = 0; k < NUM_FREQ_BINS; k++) {
+        double d = mags[k] - e->mean[k];
+        e->mean[k] += d * inv_n;
+        e->m2[k] += d * (mags[k] - e->mean[k]);
+    }
+    double d = mean_square - e->ms_mean;
+    e->ms_mean += d * inv_n;
+    e->ms_m2 += d * (mean_square - e->ms_mean);
+}
+
+static float est_rel_halfwidth(double mean, double m2, uint32_t n) {
+    if (n < 2 || mean <= 0.0) return INFINITY;
+    return (float)(EST_Z * sqrt(m2 / (n - 1) / n) / mean);
+}
+
+// True once the capture can stop: all intervals below rel_ci after the
+// minimum, or the maximum reached.
+static bool est_done(FeatureEstimator* e) {
+    if (e->n >= EST_MAX_WINDOWS) return true;
+    if (e->n < EST_MIN_WINDOWS) return false;
+    e->worst = 0.5f * est_rel_halfwidth(e->ms_mean, e->ms_m2, e->n);
+    e->worst_bin = -1;
+    for (int k = EST_FIRST_BIN; k <= EST_LAST_BIN; k++) {
+        float w = est_rel_halfwidth(e->mean[k], e->m2[k], e->n);
+        if (w > e->worst) { e->worst = w; e->worst_bin = k; }
+    }
+    return e->worst < e->rel_ci;
+}
+
+static float est_density(const FeatureEstimator* e) {
+    return (float)sqrt(e->ms_mean);
+}
+
+#endif
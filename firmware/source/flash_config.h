@@ -1,17 +1,45 @@
 /*
  * flash_config.h
- * Persists WiFi credentials and Server Config to the last page of Flash.
+ * Persists WiFi credentials, server and tuning config as a journal in a
+ * sector pair at the top of flash.
+ *
+ * Every save appends one page-sized record {magic, version, size, seq, crc,
+ * SystemConfig} to the next erased page of the active sector: a single page
+ * program, no erase. Load takes the CRC-valid record with the highest seq, so
+ * a save torn by a power cut leaves the previous record in charge. When the
+ * active sector is full the other sector is erased and the new record becomes
+ * its first entry (compaction); the full sector keeps the previous config
+ * until the next compaction.
+ *
+ *   2 sectors x 16 slots -> one erase per 16 saves, alternating sectors
+ *
+ * Records carry the payload size, so a record written by older firmware
+ * loads its known prefix and takes defaults for fields added since. The
+ * pre-journal layout (raw SystemConfig at the start of the last sector) is
+ * migrated on first boot.
  */
 #ifndef FLASH_CONFIG_H
 #define FLASH_CONFIG_H
 
-#include "hardware/flash.h"
-#include "hardware/sync.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
-// Use the very last sector of flash for config
-#define FLASH_TARGET_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
-#define CONFIG_MAGIC 0xBEEFCAFE
+#include "flash_ops.h"
+#include "audio_codec.h"    // crc32_update
+
+// Top two of the FLASH_CONFIG_SECTORS reserved sectors; the last one is
+// where the pre-journal config lived.
+#define CONFIG_STORE_SECTORS    2
+#define CONFIG_MAGIC            0xBEEFCAFE      // legacy single-copy layout
+#define CONFIG_REC_MAGIC        0x47464343      // "CCFG"
+#define CONFIG_VERSION          7
+#define CONFIG_SLOTS_PER_SECTOR (FLASH_OPS_SECTOR / FLASH_OPS_PAGE)
+
+#define CONFIG_DEFAULT_GAIN     0.4f
+
+enum { TRANSPORT_HTTP = 0, TRANSPORT_MQTT = 1 };
 
 struct SystemConfig {
     uint32_t magic;
@@ -20,35 +48,241 @@ struct SystemConfig {
     char server_ip[16];
     int server_port;
     char node_id[32];
+    // v2
+    float gain;                     // audio gain compensation
+    uint32_t sample_interval_s;     // background inference cadence, 0 = off
+    // v3
+    uint16_t mqtt_port;             // broker on server_ip
+    uint8_t transport;              // TRANSPORT_HTTP / TRANSPORT_MQTT
+    uint8_t reserved;
+    // v4
+    float wake_ratio;               // wake-on-sound spike ratio, 0 = off
+    // v5
+    float gate_margin;              // cascade gate confidence margin, 0 = off
+    // v6
+    uint32_t clip_seq;              // last event clip number issued
+    // v7
+    float adapt_ci;                 // adaptive capture CI target, 0 = fixed length
+};
+
+#define CONFIG_V1_SIZE  (offsetof(SystemConfig, gain))
+
+struct ConfigRecHdr {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          // payload bytes
+    uint32_t seq;
+    uint32_t crc;           // over header (crc = 0) and payload
+};
+
+static_assert(sizeof(ConfigRecHdr) + sizeof(SystemConfig) <= FLASH_OPS_PAGE, "config record must fit one page");
+
+struct ConfigStore {
+    const FlashOps* ops;
+    bool has_record;
+    uint32_t seq;           // seq of the current record
+    uint32_t sector;        // active sector
+    uint32_t next_slot;     // next slot to try in the active sector
+    uint32_t writes, compactions, failed;
 };
 
 // Global config instance
 static SystemConfig sys_config;
 
+static void config_defaults(SystemConfig* c) {
+    memset(c, 0, sizeof(*c));
+    c->magic = CONFIG_MAGIC;
+    strcpy(c->node_id, "pico-hive-001");
+    strcpy(c->server_ip, "192.168.1.50"); // Default dev IP
+    c->server_port = 8000;
+    c->gain = CONFIG_DEFAULT_GAIN;
+    c->sample_interval_s = 0;
+    c->mqtt_port = 1883;
+    c->transport = TRANSPORT_HTTP;
+    c->wake_ratio = 0.0f;
+    c->gate_margin = 0.0f;
+    c->clip_seq = 0;
+    c->adapt_ci = 0.0f;
+}
+
+static inline uint32_t config_slot_off(uint32_t sector, uint32_t slot) {
+    return sector * FLASH_OPS_SECTOR + slot * FLASH_OPS_PAGE;
+}
+
+static uint32_t config_rec_crc(const ConfigRecHdr* h, const uint8_t* payload) {
+    ConfigRecHdr tmp = *h;
+    tmp.crc = 0;
+    uint32_t crc = crc32_update(0, (const uint8_t*)&tmp, sizeof(tmp));
+    return crc32_update(crc, payload, h->size);
+}
+
+// Reads the record in one slot into `page`; returns its header or NULL.
+static const ConfigRecHdr* config_read_slot(const FlashOps* ops, uint32_t off, uint8_t* page) {
+    ops->read(ops->ctx, off, page, FLASH_OPS_PAGE);
+    const ConfigRecHdr* h = (const ConfigRecHdr*)page;
+    if (h->magic != CONFIG_REC_MAGIC || h->size == 0 || h->size > FLASH_OPS_PAGE - sizeof(ConfigRecHdr)) return NULL;
+    if (config_rec_crc(h, page + sizeof(ConfigRecHdr)) != h->crc) return NULL;
+    return h;
+}
+
+// Scans both sectors for the newest valid record. Returns false (and leaves
+// `out` untouched) when the store holds none.
+static bool config_store_load(ConfigStore* s, const FlashOps* ops, SystemConfig* out) {
+    static uint8_t page[FLASH_OPS_PAGE];
+    memset(s, 0, sizeof(*s));
+    s->ops = ops;
+    uint32_t used[CONFIG_STORE_SECTORS] = {};
+
+    for (uint32_t sec = 0; sec < CONFIG_STORE_SECTORS; sec++) {
+        for (uint32_t slot = 0; slot < CONFIG_SLOTS_PER_SECTOR; slot++) {
+            uint32_t off = config_slot_off(sec, slot);
+            const ConfigRecHdr* h = config_read_slot(ops, off, page);
+            if (h) {
+                // seq wraps after 2^32 saves; compare by signed distance
+                if (!s->has_record || (int32_t)(h->seq - s->seq) > 0) {
+                    s->has_record = true;
+                    s->seq = h->seq;
+                    s->sector = sec;
+                    uint32_t n = h->size < sizeof(SystemConfig) ? h->size : sizeof(SystemConfig);
+                    config_defaults(out);
+                    memcpy(out, page + sizeof(ConfigRecHdr), n);
+                }
+                used[sec] = slot + 1;
+            } else if (!flash_is_erased(ops, off, FLASH_OPS_PAGE)) {
+                used[sec] = slot + 1;   // torn write: skip the slot
+            }
+        }
+    }
+    s->next_slot = used[s->sector];
+    return s->has_record;
+}
+
+static bool config_write_slot(ConfigStore* s, const uint8_t* page) {
+    static uint8_t check[FLASH_OPS_PAGE];
+    uint32_t off = config_slot_off(s->sector, s->next_slot++);
+    s->ops->program(s->ops->ctx, off, page, FLASH_OPS_PAGE);
+    s->ops->read(s->ops->ctx, off, check, FLASH_OPS_PAGE);
+    return memcmp(check, page, FLASH_OPS_PAGE) == 0;
+}
+
+// Appends `cfg` as a new record. Returns false if flash did not take it.
+static bool config_store_save(ConfigStore* s, const SystemConfig* cfg) {
+    static uint8_t page[FLASH_OPS_PAGE];
+    memset(page, 0xFF, sizeof(page));
+    ConfigRecHdr h = { CONFIG_REC_MAGIC, CONFIG_VERSION, (uint16_t)sizeof(SystemConfig), s->seq + 1, 0 };
+    memcpy(page + sizeof(h), cfg, sizeof(SystemConfig));
+    h.crc = config_rec_crc(&h, page + sizeof(h));
+    memcpy(page, &h, sizeof(h));
+
+    // One retry covers a slot that fails verification
+    for (int attempt = 0; attempt < 2; attempt++) {
+        while (s->next_slot < CONFIG_SLOTS_PER_SECTOR &&
+               !flash_is_erased(s->ops, config_slot_off(s->sector, s->next_slot), FLASH_OPS_PAGE))
+            s->next_slot++;
+        if (s->next_slot >= CONFIG_SLOTS_PER_SECTOR) {
+            // With no record yet, reclaim the active sector rather than the
+            // other one, which may still hold the legacy config.
+            if (s->has_record) s->sector = (s->sector + 1) % CONFIG_STORE_SECTORS;
+            s->ops->erase(s->ops->ctx, s->sector * FLASH_OPS_SECTOR);
+            s->next_slot = 0;
+            s->compactions++;
+        }
+        if (config_write_slot(s, page)) {
+            s->has_record = true;
+            s->seq = h.seq;
+            s->writes++;
+            return true;
+        }
+        s->failed++;
+    }
+    return false;
+}
+
+// Pre-journal layout: a raw v1 SystemConfig at the start of the last store
+// sector. Copies it into `out` and journals it from the first sector; the
+// legacy copy survives until compaction reaches its sector, so a save torn
+// here is simply migrated again on the next boot.
+static bool config_store_migrate(ConfigStore* s, SystemConfig* out) {
+    uint8_t legacy[CONFIG_V1_SIZE];
+    s->ops->read(s->ops->ctx, (CONFIG_STORE_SECTORS - 1) * FLASH_OPS_SECTOR, legacy, sizeof(legacy));
+    uint32_t magic;
+    memcpy(&magic, legacy, sizeof(magic));
+    if (magic != CONFIG_MAGIC) return false;
+    config_defaults(out);
+    memcpy(out, legacy, sizeof(legacy));
+    s->sector = 0;
+    s->next_slot = 0;
+    config_store_save(s, out);
+    return true;
+}
+
+// Saves through a RAM-simulated pair: cost per save and erase amortisation.
+static void config_store_benchmark(int saves, uint64_t (*clock_us)()) {
+    if (saves <= 0) saves = 100;
+    FlashSim sim;
+    FlashOps ops;
+    if (!flash_sim_init(&sim, &ops, CONFIG_STORE_SECTORS)) { printf("[CONF] Bench: out of memory\n"); return; }
+
+    ConfigStore st;
+    SystemConfig cfg, back;
+    config_defaults(&cfg);
+    config_store_load(&st, &ops, &back);
+    uint64_t t0 = clock_us();
+    for (int i = 0; i < saves; i++) {
+        cfg.gain = 0.01f * (i % 100);
+        config_store_save(&st, &cfg);
+    }
+    uint64_t t_save = clock_us() - t0;
+
+    t0 = clock_us();
+    bool ok = config_store_load(&st, &ops, &back) && memcmp(&back, &cfg, sizeof(cfg)) == 0;
+    uint64_t t_load = clock_us() - t0;
+
+    printf("[CONF] Bench: %d saves, %u page programs, %u erases (1 per %.1f saves), %.1f us/save (sim)\n",
+           saves, (unsigned)sim.programs, (unsigned)sim.erases,
+           sim.erases ? (float)saves / sim.erases : (float)saves, (float)t_save / saves);
+    printf("[CONF] Bench: load scan %u us, round trip %s\n", (unsigned)t_load, ok ? "OK" : "FAILED");
+    flash_sim_free(&sim);
+}
+
+#ifndef FLASH_OPS_HOST
+#define CONFIG_REGION_OFFSET (PICO_FLASH_SIZE_BYTES - CONFIG_STORE_SECTORS * FLASH_SECTOR_SIZE)
+
+static FlashRegion g_config_region;
+static FlashOps g_config_ops;
+static ConfigStore g_config_store;
+
 static void load_config() {
-    const uint8_t *flash_target_contents = (const uint8_t *) (XIP_BASE + FLASH_TARGET_OFFSET);
-    memcpy(&sys_config, flash_target_contents, sizeof(SystemConfig));
-    
-    if (sys_config.magic != CONFIG_MAGIC) {
-        printf("[CONF] No valid config found. Using defaults.\n");
-        // Set safe defaults or empty strings
-        memset(&sys_config, 0, sizeof(SystemConfig));
-        sys_config.magic = CONFIG_MAGIC;
-        strcpy(sys_config.node_id, "pico-hive-001");
-        strcpy(sys_config.server_ip, "192.168.1.50"); // Default dev IP
-        sys_config.server_port = 8000;
+    flash_pico_init(&g_config_region, &g_config_ops, CONFIG_REGION_OFFSET, CONFIG_STORE_SECTORS * FLASH_SECTOR_SIZE);
+    if (config_store_load(&g_config_store, &g_config_ops, &sys_config)) {
+        printf("[CONF] Config #%u loaded. SSID: %s, Server: %s\n",
+               (unsigned)g_config_store.seq, sys_config.wifi_ssid, sys_config.server_ip);
+        return;
+    }
+
+    config_defaults(&sys_config);
+    if (config_store_migrate(&g_config_store, &sys_config)) {
+        printf("[CONF] Migrated legacy config. SSID: %s, Server: %s\n", sys_config.wifi_ssid, sys_config.server_ip);
     } else {
-        printf("[CONF] Config loaded. SSID: %s, Server: %s\n", sys_config.wifi_ssid, sys_config.server_ip);
+        printf("[CONF] No valid config found. Using defaults.\n");
     }
 }
 
 static void save_config() {
-    // Flash programming must be done with interrupts disabled
-    uint32_t ints = save_and_disable_interrupts();
-    flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
-    flash_range_program(FLASH_TARGET_OFFSET, (uint8_t*)&sys_config, FLASH_PAGE_SIZE);
-    restore_interrupts(ints);
-    printf("[CONF] Config saved to flash.\n");
+    if (config_store_save(&g_config_store, &sys_config))
+        printf("[CONF] Config #%u saved (sector %u, slot %u/%u).\n", (unsigned)g_config_store.seq,
+               (unsigned)g_config_store.sector, (unsigned)g_config_store.next_slot, CONFIG_SLOTS_PER_SECTOR);
+    else
+        printf("[CONF] ERR: Config save failed.\n");
 }
 
+static void print_config_store() {
+    printf("[CONF] Record #%u, sector %u, %u/%u slots used\n", (unsigned)g_config_store.seq,
+           (unsigned)g_config_store.sector, (unsigned)g_config_store.next_slot, CONFIG_SLOTS_PER_SECTOR);
+    printf("[CONF] This boot: %u saves, %u compactions, %u failed writes\n",
+           (unsigned)g_config_store.writes, (unsigned)g_config_store.compactions, (unsigned)g_config_store.failed);
+    printf("[CONF] Gain %.2f, background interval %u s\n", sys_config.gain, (unsigned)sys_config.sample_interval_s);
+}
+#endif
+
 #endif
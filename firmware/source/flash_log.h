@@ -0,0 +1,365 @@
+/*
+ * flash_log.h
+ * Append-only record log in a reserved flash region, for store-and-forward.
+ *
+ * The region is a circle of sectors written strictly in order, so every
+ * sector sees the same number of erases. Each sector starts with a header
+ * carrying a monotonic sector sequence, the sequence number of its first
+ * record and the last acknowledged record at the time it was opened:
+ *
+ *   sector:  [LogSectorHdr 20 B][record][record]...[0xFF...]
+ *   record:  [LogRecHdr 16 B][payload][pad to 16 B]   CRC-32 over both
+ *
+ * Boot scan reads one header per sector to find the newest sector, then
+ * walks only that sector for the write position, the last boot number and
+ * any ACK records. A torn record (power cut mid-write) fails its CRC; the
+ * sector is closed and writing continues in the next one.
+ *
+ * Replay is at-least-once: log_peek() returns the oldest unacknowledged
+ * record, log_ack() consumes it, and log_commit_ack() persists the position
+ * as a small ACK record. log_read_next() reads ahead of the tail, so several
+ * records can be in flight before the oldest is acknowledged. When the
+ * circle wraps over records that were never acknowledged they are dropped
+ * and counted.
+ */
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_ops.h"
+#include "audio_codec.h"    // crc32_update
+
+#define LOG_SECTOR_MAGIC    0x474F4C42u     // "BLOG"
+#define LOG_REC_MAGIC       0xB10Cu
+#define LOG_ALIGN           16
+#define LOG_MAX_PAYLOAD     (FLASH_OPS_PAGE - sizeof(LogRecHdr))
+#define LOG_ACK_EVERY       16              // replayed records per persisted ACK
+
+enum LogType {
+    LOG_FEATURES  = 1,
+    LOG_CLIMATE   = 2,
+    LOG_INFERENCE = 3,
+    LOG_ACK       = 0x7F,                   // meta: payload is the acked seq
+};
+
+struct LogSectorHdr {
+    uint32_t magic;
+    uint32_t sector_seq;
+    uint32_t first_seq;
+    uint32_t acked_seq;
+    uint16_t boot;              // boot number when the sector was opened
+    uint16_t reserved;
+};
+
+struct LogRecHdr {
+    uint16_t magic;
+    uint16_t len;               // payload bytes
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t boot;
+    uint32_t seq;               // data records only; 0 for ACK
+    uint32_t crc;
+};
+
+struct FlashLog {
+    const FlashOps* ops;
+    uint32_t sectors;
+    uint32_t head_sector, head_off;
+    uint32_t sector_seq;
+    uint32_t next_seq;          // seq of the next data record
+    uint32_t acked_seq;         // everything <= acked_seq is replayed
+    uint32_t persisted_ack;
+    uint16_t boot;
+
+    // Replay cursor (record acked_seq + 1), found lazily
+    bool tail_valid;
+    uint32_t tail_sector, tail_off;
+
+    // Stats
+    uint32_t appends, bytes, erases, dropped, torn;
+    uint32_t scan_us;
+};
+
+static inline uint32_t log_align(uint32_t n) { return (n + LOG_ALIGN - 1) & ~(uint32_t)(LOG_ALIGN - 1); }
+
+static bool log_read_sector_hdr(const FlashLog* log, uint32_t s, LogSectorHdr* h) {
+    log->ops->read(log->ops->ctx, s * FLASH_OPS_SECTOR, h, sizeof(*h));
+    return h->magic == LOG_SECTOR_MAGIC;
+}
+
+// Reads and verifies the record at (s, off). Returns its padded size, 0 at
+// the erased end of the sector, or -1 if the bytes there are not a record.
+static int log_read_record(const FlashLog* log, uint32_t s, uint32_t off, LogRecHdr* h, uint8_t* payload) {
+    if (off + sizeof(LogRecHdr) > FLASH_OPS_SECTOR) return 0;
+    uint32_t base = s * FLASH_OPS_SECTOR + off;
+    log->ops->read(log->ops->ctx, base, h, sizeof(*h));
+    if (h->magic == 0xFFFF && h->len == 0xFFFF) return flash_is_erased(log->ops, base, sizeof(*h)) ? 0 : -1;
+    if (h->magic != LOG_REC_MAGIC || h->len > LOG_MAX_PAYLOAD || off + sizeof(*h) + h->len > FLASH_OPS_SECTOR) return -1;
+
+    static uint8_t scratch[LOG_MAX_PAYLOAD];
+    uint8_t* p = payload ? payload : scratch;
+    log->ops->read(log->ops->ctx, base + sizeof(*h), p, h->len);
+    LogRecHdr tmp = *h;
+    tmp.crc = 0;
+    uint32_t crc = crc32_update(0, (const uint8_t*)&tmp, sizeof(tmp));
+    crc = crc32_update(crc, p, h->len);
+    if (crc != h->crc) return -1;
+    return (int)log_align(sizeof(*h) + h->len);
+}
+
+static void log_open_sector(FlashLog* log, uint32_t s) {
+    // Records still unacknowledged in the sector being recycled are lost.
+    LogSectorHdr old, after;
+    if (log_read_sector_hdr(log, s, &old) && old.sector_seq != log->sector_seq) {
+        uint32_t end = log->next_seq - 1;
+        uint32_t ns = (s + 1) % log->sectors;
+        if (log_read_sector_hdr(log, ns, &after) && after.sector_seq == old.sector_seq + 1) end = after.first_seq - 1;
+        if ((int32_t)(end - log->acked_seq) > 0) {
+            log->dropped += end - log->acked_seq;
+            log->acked_seq = end;
+        }
+    }
+    if (log->tail_valid && log->tail_sector == s) log->tail_valid = false;
+
+    log->ops->erase(log->ops->ctx, s * FLASH_OPS_SECTOR);
+    log->erases++;
+    log->sector_seq++;
+    LogSectorHdr h = { LOG_SECTOR_MAGIC, log->sector_seq, log->next_seq, log->acked_seq, log->boot, 0xFFFF };
+    flash_write_bytes(log->ops, s * FLASH_OPS_SECTOR, &h, sizeof(h));
+    log->persisted_ack = log->acked_seq;
+    log->head_sector = s;
+    log->head_off = sizeof(LogSectorHdr);
+}
+
+// Finds head, next sequence number, acked position and boot number.
+static void log_scan(FlashLog* log) {
+    bool found = false;
+    uint32_t best = 0;
+    uint16_t last_boot = 0;
+    LogSectorHdr h;
+    for (uint32_t s = 0; s < log->sectors; s++) {
+        if (!log_read_sector_hdr(log, s, &h)) continue;
+        if (!found || (int32_t)(h.sector_seq - log->sector_seq) > 0) {
+            found = true; best = s;
+            log->sector_seq = h.sector_seq; log->next_seq = h.first_seq; log->acked_seq = h.acked_seq;
+            last_boot = h.boot;
+        }
+    }
+    log->boot = 1;
+    if (!found) {
+        log->sector_seq = 0; log->next_seq = 1; log->acked_seq = 0;
+        log_open_sector(log, 0);
+        return;
+    }
+
+    log->head_sector = best;
+    uint32_t off = sizeof(LogSectorHdr);
+    LogRecHdr r;
+    uint8_t payload[LOG_MAX_PAYLOAD];
+    while (true) {
+        int n = log_read_record(log, best, off, &r, payload);
+        if (n == 0) break;
+        if (n < 0) { log->torn++; off = FLASH_OPS_SECTOR; break; }   // close the sector
+        if (r.type == LOG_ACK) {
+            uint32_t ack;
+            memcpy(&ack, payload, sizeof(ack));
+            if ((int32_t)(ack - log->acked_seq) > 0) log->acked_seq = ack;
+        }
+        else log->next_seq = r.seq + 1;
+        last_boot = r.boot;
+        off += n;
+    }
+    log->boot = (uint16_t)(last_boot + 1);
+    log->head_off = off;
+    log->persisted_ack = log->acked_seq;
+}
+
+static bool log_init(FlashLog* log, const FlashOps* ops, uint64_t (*clock_us)()) {
+    memset(log, 0, sizeof(*log));
+    log->ops = ops;
+    log->sectors = ops->size / FLASH_OPS_SECTOR;
+    if (log->sectors < 2) return false;
+    uint64_t t0 = clock_us ? clock_us() : 0;
+    log_scan(log);
+    log->scan_us = clock_us ? (uint32_t)(clock_us() - t0) : 0;
+    return true;
+}
+
+static bool log_write(FlashLog* log, uint8_t type, uint32_t seq, const void* payload, uint16_t len) {
+    if (len > LOG_MAX_PAYLOAD) return false;
+    uint32_t total = log_align(sizeof(LogRecHdr) + len);
+    if (log->head_off + total > FLASH_OPS_SECTOR) log_open_sector(log, (log->head_sector + 1) % log->sectors);
+
+    static uint8_t rec[FLASH_OPS_PAGE];
+    LogRecHdr h = { LOG_REC_MAGIC, len, type, 0xFF, log->boot, seq, 0 };
+    uint32_t crc = crc32_update(0, (const uint8_t*)&h, sizeof(h));
+    h.crc = crc32_update(crc, (const uint8_t*)payload, len);
+    memcpy(rec, &h, sizeof(h));
+    memcpy(rec + sizeof(h), payload, len);
+    memset(rec + sizeof(h) + len, 0xFF, total - sizeof(h) - len);
+    flash_write_bytes(log->ops, log->head_sector * FLASH_OPS_SECTOR + log->head_off, rec, total);
+    log->head_off += total;
+    log->bytes += total;
+    return true;
+}
+
+// Appends a data record; returns its sequence number (0 on error).
+static uint32_t log_append(FlashLog* log, uint8_t type, const void* payload, uint16_t len) {
+    uint32_t seq = log->next_seq;
+    if (!log_write(log, type, seq, payload, len)) return 0;
+    log->next_seq++;
+    log->appends++;
+    return seq;
+}
+
+static inline uint32_t log_pending(const FlashLog* log) {
+    return log->next_seq - 1 - log->acked_seq;
+}
+
+// Locates record acked_seq + 1, starting from the sector whose first_seq
+// covers it.
+static bool log_find_tail(FlashLog* log) {
+    uint32_t want = log->acked_seq + 1;
+    LogSectorHdr h;
+    bool found = false;
+    uint32_t best_seq = 0;
+    for (uint32_t s = 0; s < log->sectors; s++) {
+        if (!log_read_sector_hdr(log, s, &h) || (int32_t)(h.first_seq - want) > 0) continue;
+        if (!found || (int32_t)(h.first_seq - best_seq) > 0) {
+            found = true; best_seq = h.first_seq; log->tail_sector = s;
+        }
+    }
+    if (!found) return false;
+    log->tail_off = sizeof(LogSectorHdr);
+    log->tail_valid = true;
+    return true;
+}
+
+// Next data record at or after (*sector, *off) with seq >= from_seq,
+// following the sector chain towards the head. Leaves the position on it.
+static bool log_walk(FlashLog* log, uint32_t* sector, uint32_t* off, uint32_t from_seq, LogRecHdr* hdr, uint8_t* payload) {
+    for (uint32_t guard = 0; guard < 4 * log->sectors; ) {
+        int n = log_read_record(log, *sector, *off, hdr, payload);
+        if (n <= 0) {
+            // End (or torn tail) of this sector: continue in the next one.
+            LogSectorHdr cur, nxt;
+            uint32_t ns = (*sector + 1) % log->sectors;
+            log_read_sector_hdr(log, *sector, &cur);
+            if (*sector == log->head_sector || !log_read_sector_hdr(log, ns, &nxt) ||
+                nxt.sector_seq != cur.sector_seq + 1) return false;
+            *sector = ns;
+            *off = sizeof(LogSectorHdr);
+            guard++;
+            continue;
+        }
+        if (hdr->type == LOG_ACK || (int32_t)(hdr->seq - from_seq) < 0) { *off += n; continue; }
+        return true;
+    }
+    return false;
+}
+
+// Oldest unacknowledged record; false when the log is drained.
+static bool log_peek(FlashLog* log, LogRecHdr* hdr, uint8_t* payload) {
+    if (log_pending(log) > 0 && (log->tail_valid || log_find_tail(log)) &&
+        log_walk(log, &log->tail_sector, &log->tail_off, log->acked_seq + 1, hdr, payload))
+        return true;
+    // Nothing readable is left: treat the rest as lost rather than spin.
+    if (log_pending(log) > 0) { log->dropped += log_pending(log); log->acked_seq = log->next_seq - 1; }
+    return false;
+}
+
+// Read-ahead for pipelined replay: returns the records after the tail one
+// by one without consuming them. Invalidate the cursor to restart at the tail.
+struct LogCursor {
+    bool valid;
+    uint32_t sector, off;
+    uint32_t from_seq;          // log_read_all() only
+};
+
+static bool log_read_next(FlashLog* log, LogCursor* c, LogRecHdr* hdr, uint8_t* payload) {
+    if (!c->valid) {
+        if (!log_peek(log, hdr, payload)) return false;
+        c->sector = log->tail_sector;
+        c->off = log->tail_off;
+        c->valid = true;
+    }
+    if (!log_walk(log, &c->sector, &c->off, log->acked_seq + 1, hdr, payload)) return false;
+    c->off += log_align(sizeof(LogRecHdr) + hdr->len);
+    return true;
+}
+
+// Every data record still on flash, acknowledged or not, oldest first, for
+// re-processing the stored history. Start with an invalidated cursor.
+static bool log_read_all(FlashLog* log, LogCursor* c, LogRecHdr* hdr, uint8_t* payload) {
+    if (!c->valid) {
+        LogSectorHdr h;
+        bool found = false;
+        for (uint32_t s = 0; s < log->sectors; s++) {
+            if (!log_read_sector_hdr(log, s, &h)) continue;
+            if (!found || (int32_t)(h.sector_seq - c->from_seq) < 0) {
+                found = true; c->sector = s; c->from_seq = h.sector_seq;
+            }
+        }
+        if (!found) return false;
+        log_read_sector_hdr(log, c->sector, &h);
+        c->from_seq = h.first_seq;
+        c->off = sizeof(LogSectorHdr);
+        c->valid = true;
+    }
+    if (!log_walk(log, &c->sector, &c->off, c->from_seq, hdr, payload)) return false;
+    c->off += log_align(sizeof(LogRecHdr) + hdr->len);
+    return true;
+}
+
+static void log_commit_ack(FlashLog* log) {
+    if (log->persisted_ack == log->acked_seq) return;
+    log_write(log, LOG_ACK, 0, &log->acked_seq, sizeof(log->acked_seq));
+    log->persisted_ack = log->acked_seq;
+}
+
+// Consumes the record returned by the last log_peek().
+static void log_ack(FlashLog* log, const LogRecHdr* hdr) {
+    log->acked_seq = hdr->seq;
+    log->tail_off += log_align(sizeof(LogRecHdr) + hdr->len);
+    if (log_pending(log) == 0 || log->acked_seq - log->persisted_ack >= LOG_ACK_EVERY) log_commit_ack(log);
+}
+
+// Append / boot scan / replay throughput on a RAM-simulated region, so the
+// numbers reflect the log itself rather than flash program and erase times.
+static void log_benchmark(int records, uint64_t (*clock_us)()) {
+    if (records <= 0) records = 500;
+    FlashSim sim;
+    FlashOps ops;
+    if (!flash_sim_init(&sim, &ops, 16)) { printf("[LOG] Bench: no RAM for simulator\n"); return; }
+    static FlashLog log;
+    log_init(&log, &ops, clock_us);
+
+    uint8_t payload[88];
+    memset(payload, 0x5A, sizeof(payload));
+    uint64_t t0 = clock_us();
+    for (int i = 0; i < records; i++) { payload[0] = (uint8_t)i; log_append(&log, LOG_FEATURES, payload, sizeof(payload)); }
+    uint64_t t_append = clock_us() - t0;
+
+    log_init(&log, &ops, clock_us);
+    uint32_t pending = log_pending(&log);
+
+    LogRecHdr h;
+    uint8_t buf[LOG_MAX_PAYLOAD];
+    uint32_t replayed = 0;
+    t0 = clock_us();
+    while (log_peek(&log, &h, buf)) { log_ack(&log, &h); replayed++; }
+    uint64_t t_replay = clock_us() - t0;
+
+    printf("[LOG] Bench (RAM sim, 16 sectors, %u B records): %d appends\n", (unsigned)sizeof(payload), records);
+    printf("[LOG]   append %.2f us/rec, scan %u us, replay %.2f us/rec (%u of %u pending)\n",
+           (float)t_append / records, (unsigned)log.scan_us, replayed ? (float)t_replay / replayed : 0.0f,
+           (unsigned)replayed, (unsigned)pending);
+    printf("[LOG]   %u page programs, %u erases, %u dropped on wrap\n",
+           (unsigned)sim.programs, (unsigned)sim.erases, (unsigned)(records - pending));
+    flash_sim_free(&sim);
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * flash_ops.h
+ * Minimal NOR flash interface shared by the record log and the config store.
+ *
+ * A FlashOps covers one reserved region; offsets are relative to its start.
+ * Two backends:
+ *   - pico:  XIP reads, flash_range_program/erase with interrupts disabled
+ *            (left out when FLASH_OPS_HOST is defined for off-target builds)
+ *   - sim:   RAM array with NOR semantics (erase -> 0xFF, program can only
+ *            clear bits), operation counters and an optional power-cut point,
+ *            so the storage code can be exercised and benchmarked off-flash
+ *
+ * flash_write_bytes() programs an arbitrary byte range by padding the
+ * surrounding page(s) with 0xFF, which leaves already programmed bytes intact.
+ */
+#ifndef FLASH_OPS_H
+#define FLASH_OPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef FLASH_OPS_HOST
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#define FLASH_OPS_SECTOR    FLASH_SECTOR_SIZE
+#define FLASH_OPS_PAGE      FLASH_PAGE_SIZE
+#else
+#define FLASH_OPS_SECTOR    4096
+#define FLASH_OPS_PAGE      256
+#endif
+
+// Top of flash: config store, then the record log below it.
+#define FLASH_CONFIG_SECTORS 4
+#define FLASH_LOG_SECTORS    64     // 256 KB
+
+struct FlashOps {
+    void* ctx;
+    uint32_t size;              // bytes, whole sectors
+    void (*read)(void* ctx, uint32_t off, void* dst, uint32_t len);
+    void (*program)(void* ctx, uint32_t off, const uint8_t* src, uint32_t len);    // whole pages
+    void (*erase)(void* ctx, uint32_t off);                                         // one sector
+};
+
+// --- Byte-granular write on top of page programming ---
+
+static void flash_write_bytes(const FlashOps* ops, uint32_t off, const void* data, uint32_t len) {
+    static uint8_t page[FLASH_OPS_PAGE];
+    const uint8_t* src = (const uint8_t*)data;
+    while (len > 0) {
+        uint32_t base = off & ~(uint32_t)(FLASH_OPS_PAGE - 1);
+        uint32_t in = off - base;
+        uint32_t n = FLASH_OPS_PAGE - in;
+        if (n > len) n = len;
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page + in, src, n);
+        ops->program(ops->ctx, base, page, FLASH_OPS_PAGE);
+        off += n; src += n; len -= n;
+    }
+}
+
+static bool flash_is_erased(const FlashOps* ops, uint32_t off, uint32_t len) {
+    uint8_t buf[32];
+    while (len > 0) {
+        uint32_t n = len < sizeof(buf) ? len : sizeof(buf);
+        ops->read(ops->ctx, off, buf, n);
+        for (uint32_t i = 0; i < n; i++) if (buf[i] != 0xFF) return false;
+        off += n; len -= n;
+    }
+    return true;
+}
+
+// --- RAM simulator ---
+
+struct FlashSim {
+    uint8_t* mem;
+    uint32_t size;
+    uint32_t reads, programs, erases;
+    uint32_t bytes_programmed;
+    int32_t fail_after;         // >= 0: data bytes still programmable before a simulated power cut
+};
+
+static void sim_read(void* ctx, uint32_t off, void* dst, uint32_t len) {
+    FlashSim* s = (FlashSim*)ctx;
+    s->reads++;
+    memcpy(dst, s->mem + off, len);
+}
+
+static void sim_program(void* ctx, uint32_t off, const uint8_t* src, uint32_t len) {
+    FlashSim* s = (FlashSim*)ctx;
+    s->programs++;
+    for (uint32_t i = 0; i < len; i++) {
+        if (src[i] == 0xFF) continue;           // padding, leaves the cell alone
+        if (s->fail_after == 0) return;
+        if (s->fail_after > 0) s->fail_after--;
+        s->mem[off + i] &= src[i];
+        s->bytes_programmed++;
+    }
+}
+
+static void sim_erase(void* ctx, uint32_t off) {
+    FlashSim* s = (FlashSim*)ctx;
+    if (s->fail_after == 0) return;
+    s->erases++;
+    memset(s->mem + off, 0xFF, FLASH_OPS_SECTOR);
+}
+
+// Allocates an erased region of `sectors` sectors; release with flash_sim_free().
+static bool flash_sim_init(FlashSim* sim, FlashOps* ops, uint32_t sectors) {
+    memset(sim, 0, sizeof(*sim));
+    memset(ops, 0, sizeof(*ops));
+    sim->size = sectors * FLASH_OPS_SECTOR;
+    sim->mem = (uint8_t*)malloc(sim->size);
+    if (!sim->mem) return false;
+    memset(sim->mem, 0xFF, sim->size);
+    sim->fail_after = -1;
+    ops->ctx = sim;
+    ops->size = sim->size;
+    ops->read = sim_read;
+    ops->program = sim_program;
+    ops->erase = sim_erase;
+    return true;
+}
+
+static void flash_sim_free(FlashSim* sim) {
+    free(sim->mem);
+    sim->mem = NULL;
+}
+
+// --- Pico backend ---
+
+#ifndef FLASH_OPS_HOST
+struct FlashRegion {
+    uint32_t base;              // offset from start of flash
+};
+
+static void pico_flash_read(void* ctx, uint32_t off, void* dst, uint32_t len) {
+    memcpy(dst, (const uint8_t*)(XIP_BASE + ((FlashRegion*)ctx)->base + off), len);
+}
+
+static void pico_flash_program(void* ctx, uint32_t off, const uint8_t* src, uint32_t len) {
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_program(((FlashRegion*)ctx)->base + off, src, len);
+    restore_interrupts(ints);
+}
+
+static void pico_flash_erase(void* ctx, uint32_t off) {
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(((FlashRegion*)ctx)->base + off, FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+}
+
+static void flash_pico_init(FlashRegion* region, FlashOps* ops, uint32_t base, uint32_t size) {
+    region->base = base;
+    ops->ctx = region;
+    ops->size = size;
+    ops->read = pico_flash_read;
+    ops->program = pico_flash_program;
+    ops->erase = pico_flash_erase;
+}
+#endif
+
+#endif
@@ -32,6 +32,12 @@
 #define LWIP_SO_RCVTIMEO            1
 #define LWIP_SO_RCVBUF              1
 
+// MQTT app (BEEWATCH_MQTT): room for a replay window of JSON records
+#define MQTT_OUTPUT_RINGBUF_SIZE    2048
+#define MQTT_REQ_MAX_IN_FLIGHT      8
+#define MQTT_VAR_HEADER_BUFFER_LEN  256
+#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
+
 // Trace/Debug settings (optional)
 #define LWIP_DEBUG                  0
 #define LWIP_STATS                  0
@@ -8,6 +8,7 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cctype>
 #include <numeric>
 
 #include "pico/stdlib.h"
@@ -23,6 +24,23 @@
 #include "lwip/init.h"
 
 #include "flash_config.h"
+#include "flash_log.h"
+#include "arena_report.h"
+#include "pool_alloc.h"
+#include "audio_stream.h"
+#include "capture_store.h"
+#include "clip_upload.h"
+#include "command_channel.h"
+#include "mqtt_transport.h"
+#include "climate_sensor.h"
+#include "bee_dsp.h"
+#include "bee_features.h"
+#include "feature_estimator.h"
+#include "wifi_manager.h"
+#include "sample_scheduler.h"
+#include "wake_detector.h"
+#include "cascade_gate.h"
+#include "rolling_features.h"
 #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
 #include "edge-impulse-sdk/dsp/numpy.hpp"
 
@@ -30,10 +48,6 @@
 #define SAMPLE_RATE_HZ      16000
 #define CAPTURE_SECONDS     6
 #define AUDIO_BUFFER_SIZE   (SAMPLE_RATE_HZ * CAPTURE_SECONDS)
-#define FFT_SIZE            512
-#define FFT_HOP             512
-#define HISTORY_SIZE        12
-#define NUM_FREQ_BINS       20
 
 #define MIC_PIN             26
 #define ADC_CHANNEL         0
@@ -42,52 +56,48 @@
 #define SHT_SDA_PIN         4
 #define SHT_SCL_PIN         5
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+static_assert(AUDIO_BUFFER_SIZE == CAPTURE_STORE_SAMPLES, "capture store must hold one inference window");
 
 // --- GLOBALS ---
-static uint16_t g_audio_buffer[AUDIO_BUFFER_SIZE];
-static float g_fft_input[FFT_SIZE];
-static float g_hanning_window[FFT_SIZE];
-static float g_features_summer[20];
+// Audio lives packed 12-bit in g_capture_store (capture_store.h)
+static uint16_t g_window_raw[FFT_SIZE];
+static float g_features_summer[BEE_SUMMER_FEATURES];
 static float g_features_winter[5];
 static double g_bin_accum[NUM_FREQ_BINS];
-static std::vector<float> g_density_history;
+static BeeHistory g_density_history;    // densities of scheduled captures
 static std::vector<float> g_temp_history;
 static float g_last_temp = 0.0f;
 static float g_last_hum = 0.0f;
-static int g_dma_chan;
-static dma_channel_config g_dma_cfg;
+
+static Sht3x g_sht3x;
+static ClimateChannel g_climate;
 
 static bool g_mock_mode = false;
 static float g_mock_temp = 25.0f;
 static float g_mock_hum = 50.0f;
 static float g_mock_hour = 14.0f;
-static float g_gain_compensation = 0.4f;
-
-// Filter State
-static float hp_w1 = 0, hp_w2 = 0;
-static float lp1_w1 = 0;
-static float lp2_w1 = 0, lp2_w2 = 0;
-static float g_cos_table[NUM_FREQ_BINS][FFT_SIZE];
-static float g_sin_table[NUM_FREQ_BINS][FFT_SIZE];
-
-static const float HP_B0 = 0.9726139f; static const float HP_B1 = -1.9452278f; static const float HP_B2 = 0.9726139f;
-static const float HP_A1 = -1.9444777f; static const float HP_A2 = 0.9459779f;
-static const float LP1_B0 = 0.4459029f; static const float LP1_B1 = 0.4459029f; static const float LP1_B2 = 0.0f;
-static const float LP1_A1 = 0.4142136f; static const float LP1_A2 = 0.0f;
-static const float LP2_B0 = 0.3913f; static const float LP2_B1 = 0.7827f; static const float LP2_B2 = 0.3913f;
-static const float LP2_A1 = -0.3695f; static const float LP2_A2 = -0.1958f;
 
 // --- NETWORK GLOBALS ---
 #define HTTP_BUF_SIZE 4096
 static char http_rx_buffer[HTTP_BUF_SIZE];
 static int http_rx_index = 0;
 static bool http_complete = false;
+static int http_tx_len = 0;             // bytes of the last request
 static bool wifi_connected = false;
-static uint32_t last_sync_time = 0;
-#define SYNC_INTERVAL_MS 2000 
+static SampleScheduler g_sched;
+static WakeDetector g_wake;
+static uint64_t g_wake_us = 0;          // time spent in wake_feed()
+static uint32_t g_wake_jobs = 0;
+static uint32_t g_first_sample_ms = 0;  // boot -> end of the first audio capture
+static uint32_t g_adapt_captures = 0, g_adapt_windows = 0, g_adapt_extended = 0, g_adapt_capped = 0;
+static GateStats g_gate;
+static bool g_gate_audit = false;       // run the network on gate verdicts too and compare
+static RollingFeatures g_roll;          // live mode, 6 s sliding averages
+static uint32_t g_live_hop = 0;         // windows between live results, 0 = off
+static uint32_t g_live_changes = 0;
+static uint64_t g_live_dsp_us = 0, g_live_nn_us = 0, g_live_since_us = 0;
+static const char* g_live_label = NULL;
+#define BACKGROUND_DEFAULT_S 900     // 15 min: BEE_HISTORY_SIZE covers 3 h
 
 struct Command {
     std::string type;   
@@ -100,6 +110,8 @@ static std::vector<Command> cmd_queue;
 static void led_set(bool on);
 void process_command(Command cmd);
 static bool read_climate();
+static void begin_climate();
+static bool finish_climate();
 static void capture_audio();
 static float process_and_compute_features();
 static void run_summer_inference(float density);
@@ -173,7 +185,7 @@ static bool perform_http_request(const char* method, const char* path, const cha
 
     char request[1024];
     // FIX: Add Connection: close header to prevent server keeping link open
-    int len = snprintf(request, sizeof(request), 
+    http_tx_len = snprintf(request, sizeof(request), 
         "%s /api/v1/%s HTTP/1.1\r\n"
         "Host: %s:%d\r\n"
         "Connection: close\r\n" 
@@ -212,144 +224,334 @@ static void log_to_server(const char* msg) {
     if(!wifi_connected) return;
     char json[256];
     snprintf(json, sizeof(json), "{\"node_id\": \"%s\", \"message\": \"%s\"}", sys_config.node_id, msg);
+#ifdef BEEWATCH_MQTT
+    if (mqtt_active()) { mqtt_log(json); return; }
+#endif
     perform_http_request("POST", "logs/", json);
 }
 
-// Simple JSON Parser to extract commands from Server Response
-// Expects: [{"command_type": "RUN_INFERENCE", "params": {...}}]
-static void parse_server_commands() {
-    // Find body (after double newline)
-    char* body = strstr(http_rx_buffer, "\r\n\r\n");
-    if (!body) return;
-    body += 4; // Skip CRLFCRLF
+// Simple JSON Parser to extract commands from a commands/pending response body
+// Expects: [{"command_type": "RUN_INFERENCE", "params": {...}}, ...]
+static void parse_server_commands(const char* body) {
+    const char* cur = strstr(body, "\"command_type\"");
+    while (cur) {
+        const char* next = strstr(cur + 14, "\"command_type\"");
+        std::string obj = next ? std::string(cur, next - cur) : std::string(cur);
 
-    // Basic parsing logic
-    if (strstr(body, "RUN_INFERENCE")) {
-        std::string params = "";
-        if (strstr(body, "winter")) params = "winter";
-        else params = "summer";
-        cmd_queue.push_back({"RUN_INFERENCE", params, true});
-        printf("[NET] CMD Received: RUN_INFERENCE (%s)\n", params.c_str());
-    }
-    else if (strstr(body, "READ_CLIMATE")) {
-        cmd_queue.push_back({"READ_CLIMATE", "", true});
-        printf("[NET] CMD Received: READ_CLIMATE\n");
-    }
-    else if (strstr(body, "PING")) {
-        cmd_queue.push_back({"PING", "", true});
+        if (obj.find("RUN_INFERENCE") != std::string::npos) {
+            std::string params = obj.find("winter") != std::string::npos ? "winter" : "summer";
+            cmd_queue.push_back({"RUN_INFERENCE", params, true});
+            printf("[NET] CMD Received: RUN_INFERENCE (%s)\n", params.c_str());
+        }
+        else if (obj.find("READ_CLIMATE") != std::string::npos) {
+            cmd_queue.push_back({"READ_CLIMATE", "", true});
+            printf("[NET] CMD Received: READ_CLIMATE\n");
+        }
+        else if (obj.find("PING") != std::string::npos) {
+            cmd_queue.push_back({"PING", "", true});
+        }
+        cur = next;
     }
 }
 
 // =================================================================================
-// SENSORS & DSP (Preserved)
+// OFFLINE RECORD LOG (store-and-forward)
 // =================================================================================
 
-static void reset_filters() {
-    hp_w1 = hp_w2 = 0; lp1_w1 = 0; lp2_w1 = lp2_w2 = 0;
+#define LOG_REGION_OFFSET   (PICO_FLASH_SIZE_BYTES - (FLASH_CONFIG_SECTORS + FLASH_LOG_SECTORS) * FLASH_SECTOR_SIZE)
+#define REPLAY_BACKOFF_MS   5000
+
+struct LogFeaturesRec { uint32_t uptime_ms; float density; float features[20]; };
+struct LogClimateRec { uint32_t uptime_ms; float temp; float hum; };
+struct LogInferenceRec { uint32_t uptime_ms; float confidence; char model[8]; char label[16]; };
+
+extern char __flash_binary_end;
+static FlashRegion g_log_region;
+static FlashOps g_log_ops;
+static FlashLog g_log;
+static bool g_log_ok = false;
+static uint32_t g_replay_next_ms = 0;
+static TransportStats g_http_stats;
+
+static uint32_t uptime_ms() { return to_ms_since_boot(get_absolute_time()); }
+
+static void setup_record_log() {
+    if ((uintptr_t)&__flash_binary_end - XIP_BASE > LOG_REGION_OFFSET) {
+        printf("[LOG] ERR: firmware overlaps log region, offline log disabled\n");
+        return;
+    }
+    flash_pico_init(&g_log_region, &g_log_ops, LOG_REGION_OFFSET, FLASH_LOG_SECTORS * FLASH_SECTOR_SIZE);
+    g_log_ok = log_init(&g_log, &g_log_ops, time_us_64);
+    printf("[LOG] Boot %u: %u records pending, next #%u (scan %u us)\n",
+           g_log.boot, (unsigned)log_pending(&g_log), (unsigned)g_log.next_seq, (unsigned)g_log.scan_us);
+}
+
+static void record_climate() {
+    if (!g_log_ok) return;
+    LogClimateRec r = { uptime_ms(), g_last_temp, g_last_hum };
+    log_append(&g_log, LOG_CLIMATE, &r, sizeof(r));
+}
+
+static void record_features(float density, const float* features) {
+    if (!g_log_ok) return;
+    LogFeaturesRec r = { uptime_ms(), density, {} };
+    memcpy(r.features, features, sizeof(r.features));
+    log_append(&g_log, LOG_FEATURES, &r, sizeof(r));
+}
+
+static void record_inference(const char* model, const char* label, float confidence) {
+    if (!g_log_ok) return;
+    LogInferenceRec r = { uptime_ms(), confidence, {}, {} };
+    strncpy(r.model, model, sizeof(r.model) - 1);
+    strncpy(r.label, label, sizeof(r.label) - 1);
+    log_append(&g_log, LOG_INFERENCE, &r, sizeof(r));
+}
+
+// Formats one record as the JSON body for its endpoint. Records from this
+// boot carry their age so the server can back-date them.
+static const char* record_to_json(const LogRecHdr* h, const uint8_t* payload, char* json, size_t size) {
+    uint32_t t;
+    memcpy(&t, payload, sizeof(t));
+    char age[32] = "";
+    if (h->boot == g_log.boot) snprintf(age, sizeof(age), ", \"age_ms\": %u", (unsigned)(uptime_ms() - t));
+
+    if (h->type == LOG_CLIMATE) {
+        LogClimateRec r; memcpy(&r, payload, sizeof(r));
+        snprintf(json, size, "{\"node_id\": \"%s\", \"temperature_c\": %.2f, \"humidity_pct\": %.2f, \"battery_mv\": 4200%s}",
+                 sys_config.node_id, r.temp, r.hum, age);
+        return "telemetry/";
+    }
+    if (h->type == LOG_INFERENCE) {
+        LogInferenceRec r; memcpy(&r, payload, sizeof(r));
+        snprintf(json, size, "{\"node_id\": \"%s\", \"model_type\": \"%s\", \"classification\": \"%s\", \"confidence\": %.2f%s}",
+                 sys_config.node_id, r.model, r.label, r.confidence, age);
+        return "inference/";
+    }
+    if (h->type == LOG_FEATURES) {
+        LogFeaturesRec r; memcpy(&r, payload, sizeof(r));
+        int n = snprintf(json, size, "{\"node_id\": \"%s\", \"density\": %.6f, \"values\": [", sys_config.node_id, r.density);
+        for (int i = 0; i < 20 && n < (int)size; i++) n += snprintf(json + n, size - n, i ? ", %.6g" : "%.6g", r.features[i]);
+        if (n < (int)size) snprintf(json + n, size - n, "]%s}", age);
+        return "features/";
+    }
+    return NULL;
 }
 
-static inline float biquad_hp(float x) {
-    float y = HP_B0 * x + hp_w1; hp_w1 = HP_B1 * x - HP_A1 * y + hp_w2; hp_w2 = HP_B2 * x - HP_A2 * y; return y;
+// Uploads the oldest pending record over HTTP; one per main loop pass.
+static void replay_record_log() {
+    if (!g_log_ok || !wifi_connected || log_pending(&g_log) == 0) return;
+    if ((int32_t)(uptime_ms() - g_replay_next_ms) < 0) return;
+
+    LogRecHdr h;
+    uint8_t payload[LOG_MAX_PAYLOAD];
+    if (!log_peek(&g_log, &h, payload)) return;
+
+    char json[512];
+    const char* path = record_to_json(&h, payload, json, sizeof(json));
+    if (!path) { log_ack(&g_log, &h); return; }
+    uint64_t t0 = time_us_64();
+    bool ok = perform_http_request("POST", path, json) && strstr(http_rx_buffer, " 200 ");
+    g_http_stats.busy_us += time_us_64() - t0;
+    g_http_stats.tx_bytes += http_tx_len;
+    g_http_stats.rx_bytes += http_rx_index;
+    if (ok) {
+        g_http_stats.records++;
+        log_ack(&g_log, &h);
+    } else {
+        printf("[LOG] Replay of #%u failed, %u pending\n", (unsigned)h.seq, (unsigned)log_pending(&g_log));
+        g_replay_next_ms = uptime_ms() + REPLAY_BACKOFF_MS;
+    }
 }
-static inline float biquad_lp1(float x) {
-    float y = LP1_B0 * x + lp1_w1; lp1_w1 = LP1_B1 * x - LP1_A1 * y; return y;
+
+static void print_record_log() {
+    if (!g_log_ok) { printf("[LOG] Disabled\n"); return; }
+    printf("[LOG] Boot %u, %u pending (#%u..#%u), head sector %u+%u, %u sectors\n",
+           g_log.boot, (unsigned)log_pending(&g_log), (unsigned)(g_log.acked_seq + 1), (unsigned)(g_log.next_seq - 1),
+           (unsigned)g_log.head_sector, (unsigned)g_log.head_off, (unsigned)g_log.sectors);
+    printf("[LOG] Appends %u (%u B), erases %u, dropped %u, torn %u, scan %u us\n",
+           (unsigned)g_log.appends, (unsigned)g_log.bytes, (unsigned)g_log.erases,
+           (unsigned)g_log.dropped, (unsigned)g_log.torn, (unsigned)g_log.scan_us);
 }
-static inline float biquad_lp2(float x) {
-    float y = LP2_B0 * x + lp2_w1; lp2_w1 = LP2_B1 * x - LP2_A1 * y + lp2_w2; lp2_w2 = LP2_B2 * x - LP2_A2 * y; return y;
+
+// Connectivity events from wifi_poll(); records sampled while down are
+// already in the log and replay as soon as the link is back.
+static void on_wifi_change(bool up, uint32_t outage_ms) {
+    wifi_connected = up;
+    if (!up) return;
+    g_replay_next_ms = uptime_ms();
+    sched_uplink_begin(&g_sched);
+    if (g_wifi.connects == 1) log_to_server("System Booted");
+    else {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "WiFi reconnected after %u ms", (unsigned)outage_ms);
+        log_to_server(msg);
+    }
 }
 
-static float compute_bin_magnitude_accurate(const float* windowed_data, int k) {
-    double real_sum = 0.0, imag_sum = 0.0;
-    for (int n = 0; n < FFT_SIZE; n++) {
-        real_sum += windowed_data[n] * g_cos_table[k][n];
-        imag_sum += windowed_data[n] * g_sin_table[k][n];
+// Radio power save while the scheduler is idle between jobs and uplinks
+static void apply_radio_pm() {
+    static int low = -1;
+    int want = sched_idle(&g_sched) ? 1 : 0;
+    if (want == low || !g_wifi.ready) return;
+    cyw43_wifi_pm(&cyw43_state, want ? CYW43_AGGRESSIVE_PM : CYW43_DEFAULT_PM);
+    low = want;
+}
+
+// Wake-on-sound: while the scheduler is idle the ring samples at WAKE_RATE_HZ
+// and every block passes through the detector. Returns true on a spike.
+// sched_idle() is never true with the background interval at 0, so the
+// detector only listens between scheduled jobs (`b`), not with the node idle.
+static bool wake_poll() {
+    if (sys_config.wake_ratio <= 0.0f || g_live_hop || !sched_idle(&g_sched)) return false;
+    if (!g_ring_running) ring_start_rate(WAKE_RATE_HZ);
+    bool hit = false;
+    const uint16_t* blk;
+    while ((blk = ring_peek()) != NULL) {
+        uint64_t t0 = time_us_64();
+        hit |= wake_feed(&g_wake, blk, RING_BLOCK_SAMPLES);
+        g_wake_us += time_us_64() - t0;
+        ring_release();
     }
-    return (float)sqrt(real_sum * real_sum + imag_sum * imag_sum);
+    return hit;
+}
+
+// Frees the ADC and ring for a full-rate capture
+static void wake_pause() {
+    if (g_ring_running) ring_stop();
+}
+
+static void print_wake_status() {
+    if (sys_config.wake_ratio <= 0.0f) printf("[WAKE] Off\n");
+    else if (!g_sched.interval_ms) printf("[WAKE] Ratio %.2f, inactive: listens between scheduled jobs, set a cadence with 'b'\n", g_wake.ratio);
+    else printf("[WAKE] Ratio %.2f at %d Hz, %s\n", g_wake.ratio, WAKE_RATE_HZ, g_ring_running ? "listening" : "paused");
+    uint64_t samples = (uint64_t)g_wake.blocks * RING_BLOCK_SAMPLES;
+    float hours = samples / (float)WAKE_RATE_HZ / 3600.0f;
+    printf("[WAKE] %u blocks (%.2f h), %u triggers (%.1f/h), %u jobs, last ratio %.2f, peak %.2f\n",
+           (unsigned)g_wake.blocks, hours, (unsigned)g_wake.triggers, hours > 0 ? g_wake.triggers / hours : 0.0f,
+           (unsigned)g_wake_jobs, g_wake.last_ratio, g_wake.peak_ratio);
+    printf("[WAKE] Detector %.1f ns/sample, %.3f%% of real time\n",
+           samples ? g_wake_us * 1000.0f / samples : 0.0f,
+           samples ? 100.0f * g_wake_us / (samples * 1e6f / WAKE_RATE_HZ) : 0.0f);
 }
 
+// =================================================================================
+// SENSORS & DSP (Preserved)
+// =================================================================================
+
 static void led_set(bool on) { cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, on); }
 
 static void setup_hardware() {
+    pool_init(POOL_MODE_PERSISTENT);
     stdio_init_all();
     load_config(); 
+    setup_record_log();
 
-    if (cyw43_arch_init()) { printf("[ERR] WiFi init failed\n"); return; }
-    cyw43_arch_enable_sta_mode();
-
-    if (strlen(sys_config.wifi_ssid) > 0) {
-        printf("[NET] Connecting to %s...\n", sys_config.wifi_ssid);
-        int retries = 3;
-        while (retries > 0 && !wifi_connected) {
-            led_set(true);
-            int err = cyw43_arch_wifi_connect_timeout_ms(sys_config.wifi_ssid, sys_config.wifi_pass, CYW43_AUTH_WPA2_AES_PSK, 15000);
-            led_set(false);
-            if (err == 0) {
-                printf("[NET] Connected! IP: %s\n", ip4addr_ntoa(netif_ip4_addr(netif_list)));
-                wifi_connected = true;
-            } else {
-                printf("[NET] WiFi Failed (%d). Retrying...\n", err);
-                sleep_ms(2000);
-                retries--;
-            }
-        }
-    }
+    // Joins in the background; wifi_poll() in the main loop finishes it
+    wifi_init();
 
     i2c_init(I2C_INST, 100 * 1000);
     gpio_set_function(SHT_SDA_PIN, GPIO_FUNC_I2C); gpio_set_function(SHT_SCL_PIN, GPIO_FUNC_I2C);
     gpio_pull_up(SHT_SDA_PIN); gpio_pull_up(SHT_SCL_PIN);
+    sht3x_init(&g_sht3x, &g_climate.sensor, I2C_INST, SHT_ADDR);
 
     adc_init(); adc_gpio_init(MIC_PIN); adc_select_input(ADC_CHANNEL);
+    ring_init();
+
+    bee_dsp_init();
 
-    g_dma_chan = dma_claim_unused_channel(true);
-    g_dma_cfg = dma_channel_get_default_config(g_dma_chan);
-    channel_config_set_transfer_data_size(&g_dma_cfg, DMA_SIZE_16);
-    channel_config_set_read_increment(&g_dma_cfg, false);
-    channel_config_set_write_increment(&g_dma_cfg, true);
-    channel_config_set_dreq(&g_dma_cfg, DREQ_ADC);
-
-    for (int i = 0; i < FFT_SIZE; i++) g_hanning_window[i] = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * (float)i / (float)(FFT_SIZE - 1)));
-    for (int k = 0; k < NUM_FREQ_BINS; k++) {
-        for (int n = 0; n < FFT_SIZE; n++) {
-            double angle = -2.0 * M_PI * k * n / FFT_SIZE;
-            g_cos_table[k][n] = (float)cos(angle);
-            g_sin_table[k][n] = (float)sin(angle);
-        }
-    }
-    
     printf("[INIT] Ready. Node: %s\n", sys_config.node_id);
-    if(wifi_connected) log_to_server("System Booted");
 }
 
-static bool read_climate() {
+// Starts a conversion that runs while the caller does other work (capture).
+static void begin_climate() {
+    if (!g_mock_mode) climate_start(&g_climate);
+}
+
+// Collects the conversion started by begin_climate(), or a fresh one.
+static bool finish_climate() {
     if (g_mock_mode) {
         g_last_temp = g_mock_temp; g_last_hum = g_mock_hum;
         printf("[SENSOR] MOCK: %.2fC %.2f%%\n", g_last_temp, g_last_hum);
         return true;
     }
-    uint8_t cmd[2] = {0x24, 0x00};
-    i2c_write_blocking(I2C_INST, SHT_ADDR, cmd, 2, false);
-    sleep_ms(15);
-    uint8_t data[6];
-    if (i2c_read_blocking(I2C_INST, SHT_ADDR, data, 6, false) == PICO_ERROR_GENERIC) return false;
-    uint16_t t_raw = (data[0] << 8) | data[1];
-    uint16_t h_raw = (data[3] << 8) | data[4];
-    g_last_temp = -45.0f + (175.0f * (float)t_raw / 65535.0f);
-    g_last_hum = 100.0f * ((float)h_raw / 65535.0f);
+    if (!climate_wait(&g_climate, 20)) {
+        printf("[SENSOR] Read failed (%u CRC, %u bus errors)\n", (unsigned)g_climate.crc_errors, (unsigned)g_climate.bus_errors);
+        return false;
+    }
+    g_last_temp = g_climate.last.temp_c;
+    g_last_hum = g_climate.last.hum_pct;
     printf("[SENSOR] %.2fC %.2f%%\n", g_last_temp, g_last_hum);
     return true;
 }
 
+static bool read_climate() {
+    begin_climate();
+    return finish_climate();
+}
+
+static void capture_done() {
+    if (!g_first_sample_ms) {
+        g_first_sample_ms = uptime_ms();
+        printf("[REC] First sample %u ms after boot\n", (unsigned)g_first_sample_ms);
+    }
+    clip_feed(g_capture_store, g_capture_len);
+}
+
 static void capture_audio() {
     printf("[REC] Capturing %d samples...\n", AUDIO_BUFFER_SIZE);
     led_set(true);
-    adc_fifo_drain();
-    adc_fifo_setup(true, true, 1, false, false);
-    adc_set_clkdiv(3000.0f - 1.0f);
-    dma_channel_configure(g_dma_chan, &g_dma_cfg, g_audio_buffer, &adc_hw->fifo, AUDIO_BUFFER_SIZE, true);
-    adc_run(true);
-    dma_channel_wait_for_finish_blocking(g_dma_chan);
-    adc_run(false);
+    capture_store_record(AUDIO_BUFFER_SIZE);
     led_set(false);
+    capture_done();
+}
+
+// Adaptive length: the DSP runs on each block as it arrives and the ring
+// stops once feature_estimator.h reports converged averages (1..12 s). The
+// store keeps the first 6 s; DC removal uses the running mean.
+static float capture_and_process_adaptive() {
+    printf("[REC] Adaptive capture, target CI %.1f%%...\n", sys_config.adapt_ci * 100.0f);
+    static_assert(FFT_SIZE == RING_BLOCK_SAMPLES && FFT_HOP == FFT_SIZE, "one ring block per DSP window");
+    FeatureEstimator est;
+    est_init(&est, sys_config.adapt_ci);
+    float mags[NUM_FREQ_BINS];
+    uint64_t sum = 0, count = 0;
+    reset_filters();
+    capture_store_reset();
+    led_set(true);
+    ring_start();
+    while (!est_done(&est)) {
+        const uint16_t* blk = ring_wait_block();
+        for (int i = 0; i < FFT_SIZE; i++) sum += blk[i] & 0x0FFF;
+        count += FFT_SIZE;
+        capture_store_push(blk, FFT_SIZE);
+        double sumsq = bee_dsp_window(blk, (float)((double)sum / count), sys_config.gain, mags);
+        ring_release();
+        est_add(&est, mags, sumsq / FFT_SIZE);
+    }
+    ring_stop();
+    led_set(false);
+    if (g_ring_overruns) printf("[REC] WARNING: %u blocks overrun\n", (unsigned)g_ring_overruns);
+    capture_done();
+
+    for (int k = 0; k < NUM_FREQ_BINS; k++) g_bin_accum[k] = est.mean[k];
+    float density = est_density(&est);
+    g_adapt_captures++;
+    g_adapt_windows += est.n;
+    if (est.n > AUDIO_BUFFER_SIZE / FFT_SIZE) g_adapt_extended++;
+    if (est.n >= EST_MAX_WINDOWS) g_adapt_capped++;
+    printf("[DSP] %u windows (%.2f s), worst CI %.1f%% (%s%d), density %.6f\n", (unsigned)est.n,
+           est.n * FFT_SIZE / (float)SAMPLE_RATE_HZ, est.worst * 100.0f,
+           est.worst_bin < 0 ? "density" : "bin ", est.worst_bin < 0 ? 0 : est.worst_bin, density);
+    return density;
+}
+
+static void print_adaptive_status() {
+    if (sys_config.adapt_ci <= 0.0f) printf("[CAP] Adaptive capture off (fixed %d s)\n", CAPTURE_SECONDS);
+    else printf("[CAP] Adaptive capture, target CI %.1f%%, %d..%d windows\n", sys_config.adapt_ci * 100.0f, EST_MIN_WINDOWS, EST_MAX_WINDOWS);
+    if (g_adapt_captures)
+        printf("[CAP] %u captures, mean %.2f s (%u extended past %d s, %u at the maximum)\n",
+               (unsigned)g_adapt_captures, (float)g_adapt_windows / g_adapt_captures * FFT_SIZE / SAMPLE_RATE_HZ,
+               (unsigned)g_adapt_extended, CAPTURE_SECONDS, (unsigned)g_adapt_capped);
 }
 
 static void stream_audio(int seconds) {
@@ -357,28 +559,22 @@ static void stream_audio(int seconds) {
     int samples = seconds * SAMPLE_RATE_HZ;
     printf("[STREAM] Capturing %d samples...\n", samples);
     led_set(true);
-    adc_fifo_drain();
-    adc_fifo_setup(true, true, 1, false, false);
-    adc_set_clkdiv(3000.0f - 1.0f);
-    dma_channel_configure(g_dma_chan, &g_dma_cfg, g_audio_buffer, &adc_hw->fifo, samples, true);
-    adc_run(true);
-    dma_channel_wait_for_finish_blocking(g_dma_chan);
-    adc_run(false);
+    capture_store_record(samples);
     led_set(false);
     
     // Header
-    uint64_t sum = 0, var_sum = 0;
-    for(int i=0; i<samples; i++) sum += g_audio_buffer[i];
-    float mean = (float)sum / samples;
-    for(int i=0; i<samples; i++) { float diff = g_audio_buffer[i] - mean; var_sum += (uint64_t)(diff * diff); }
-    float std_dev = sqrtf((float)var_sum / samples);
+    float std_dev = capture_store_std();
     
     printf("HDR:%u:%u:%.1f\n", samples * 2, samples, std_dev);
     stdio_flush();
     sleep_ms(10);
-    for (int i = 0; i < samples; i++) {
-        putchar_raw(g_audio_buffer[i] & 0xFF);
-        putchar_raw((g_audio_buffer[i] >> 8) & 0xFF);
+    for (int off = 0; off < samples; off += FFT_SIZE) {
+        int n = (samples - off < FFT_SIZE) ? samples - off : FFT_SIZE;
+        capture_store_read(off, n, g_window_raw);
+        for (int i = 0; i < n; i++) {
+            putchar_raw(g_window_raw[i] & 0xFF);
+            putchar_raw((g_window_raw[i] >> 8) & 0xFF);
+        }
     }
     stdio_flush();
     sleep_ms(10);
@@ -387,79 +583,252 @@ static void stream_audio(int seconds) {
 
 static float process_and_compute_features() {
     printf("[DSP] Processing...\n");
-    for (int k = 0; k < NUM_FREQ_BINS; k++) g_bin_accum[k] = 0.0;
-    
-    double dc_sum = 0;
-    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) dc_sum += g_audio_buffer[i];
-    float dc_offset = (float)(dc_sum / AUDIO_BUFFER_SIZE);
-    
+    float dc_offset = capture_store_mean();
     int num_windows = (AUDIO_BUFFER_SIZE - FFT_SIZE) / FFT_HOP + 1;
-    reset_filters();
-    
-    double rms_sum = 0; int rms_count = 0;
-    
+
+    BeeCapture cap;
+    bee_capture_begin(&cap);
     for (int w = 0; w < num_windows; w++) {
-        int offset = w * FFT_HOP;
-        for (int i = 0; i < FFT_SIZE; i++) {
-            float sample = ((float)g_audio_buffer[offset + i] - dc_offset) / 2048.0f;
-            sample *= g_gain_compensation;
-            sample = biquad_lp2(biquad_lp1(biquad_hp(sample)));
-            rms_sum += sample * sample; rms_count++;
-            g_fft_input[i] = sample * g_hanning_window[i];
-        }
-        for (int k = 0; k < NUM_FREQ_BINS; k++) g_bin_accum[k] += compute_bin_magnitude_accurate(g_fft_input, k);
+        capture_store_read(w * FFT_HOP, FFT_SIZE, g_window_raw);
+        bee_capture_window(&cap, g_window_raw, dc_offset, sys_config.gain);
     }
-    float density = sqrtf((float)(rms_sum / rms_count));
-    for (int k = 0; k < NUM_FREQ_BINS; k++) g_bin_accum[k] /= num_windows;
+    float density = bee_capture_end(&cap);
+    memcpy(g_bin_accum, cap.bins, sizeof(g_bin_accum));
     printf("[DSP] Density: %.6f\n", density);
     return density;
 }
 
-static void run_summer_inference(float current_density) {
-    if (g_density_history.size() >= HISTORY_SIZE) g_density_history.erase(g_density_history.begin());
-    g_density_history.push_back(current_density);
-    float rolling = 0; for(float d: g_density_history) rolling += d;
-    rolling = (g_density_history.size() > 0) ? rolling / g_density_history.size() : current_density;
-    float spike = current_density / (rolling + 1e-6f);
-    
-    g_features_summer[0] = g_last_temp;
-    g_features_summer[1] = g_last_hum;
-    g_features_summer[2] = 14.0f; 
-    g_features_summer[3] = spike;
-    for (int i = 0; i < 16; i++) g_features_summer[4 + i] = (float)g_bin_accum[4 + i];
-    
+// Second stage: the Edge Impulse network on the 20-feature vector.
+static void classify_summer(const float* features, const char** label, float* score) {
     signal_t signal;
-    numpy::signal_from_buffer(g_features_summer, 20, &signal);
+    numpy::signal_from_buffer(features, BEE_SUMMER_FEATURES, &signal);
     ei_impulse_result_t result = {0};
+    uint64_t t0 = time_us_64();
+    pool_inference_begin();
     run_classifier(&signal, &result, false);
-    
-    const char* label = "Unknown"; float score = 0.0f;
+    pool_inference_done();
+    g_gate.nn_us += time_us_64() - t0;
+    g_gate.nn_runs++;
+
+    *label = "Unknown"; *score = 0.0f;
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-        if (result.classification[ix].value > score) {
-            score = result.classification[ix].value;
-            label = result.classification[ix].label;
+        if (result.classification[ix].value > *score) {
+            *score = result.classification[ix].value;
+            *label = result.classification[ix].label;
         }
     }
+}
+
+static void print_gate_status() {
+    if (sys_config.gate_margin <= 0.0f) printf("[GATE] Off, every capture runs the network\n");
+    else printf("[GATE] Margin %.3f: Event at p >= %.3f, Normal at p <= %.3f (spike > %.2f / < %.2f)%s\n",
+                sys_config.gate_margin, 1.0f - sys_config.gate_margin, sys_config.gate_margin,
+                expf((logf((1.0f - sys_config.gate_margin) / sys_config.gate_margin) - GATE_MODEL.bias) / GATE_MODEL.w_log_spike),
+                expf((logf(sys_config.gate_margin / (1.0f - sys_config.gate_margin)) - GATE_MODEL.bias) / GATE_MODEL.w_log_spike),
+                g_gate_audit ? ", audit on" : "");
+    uint32_t total = g_gate.normal + g_gate.event + g_gate.deferred;
+    printf("[GATE] %u captures: %u Normal, %u Event by the gate, %u deferred (%.0f%% decided)\n", (unsigned)total,
+           (unsigned)g_gate.normal, (unsigned)g_gate.event, (unsigned)g_gate.deferred,
+           total ? 100.0f * (g_gate.normal + g_gate.event) / total : 0.0f);
+    if (g_gate.audited)
+        printf("[GATE] Audit: %u of %u gate verdicts agree with the network (%.1f%%)\n",
+               (unsigned)(g_gate.audited - g_gate.disagreed), (unsigned)g_gate.audited,
+               100.0f * (g_gate.audited - g_gate.disagreed) / g_gate.audited);
+    if (g_gate.nn_runs)
+        printf("[GATE] Network %u runs, mean %.2f ms\n", (unsigned)g_gate.nn_runs, g_gate.nn_us / 1000.0f / g_gate.nn_runs);
+}
+
+// Replays the feature records still in the flash log through both stages and
+// tabulates, per margin, how many the gate would decide and how many of those
+// match the network.
+static void gate_replay(int max_records) {
+    static const float margins[] = { 0.01f, 0.02f, 0.05f, 0.1f, 0.2f, 0.3f, GATE_MAX_MARGIN };
+    const int nm = sizeof(margins) / sizeof(margins[0]);
+    if (!g_log_ok) { printf("[GATE] No record log\n"); return; }
+    if (max_records <= 0) max_records = 500;
+    uint32_t decided[nm] = {}, agreed[nm] = {};
+    uint32_t records = 0, out_of_range = 0;
+    uint64_t nn_us = 0;
+    LogCursor c = {};
+    LogRecHdr h;
+    static uint8_t payload[LOG_MAX_PAYLOAD];
+    while ((int)records < max_records && log_read_all(&g_log, &c, &h, payload)) {
+        if (h.type != LOG_FEATURES || h.len < sizeof(LogFeaturesRec)) continue;
+        LogFeaturesRec r; memcpy(&r, payload, sizeof(r));
+        const char* nn_label; float nn_score;
+        uint64_t t0 = time_us_64();
+        classify_summer(r.features, &nn_label, &nn_score);
+        nn_us += time_us_64() - t0;
+        records++;
+        if (!gate_in_range(r.features)) out_of_range++;
+        for (int m = 0; m < nm; m++) {
+            float p;
+            GateVerdict v = gate_decide(r.features, margins[m], &p);
+            if (v == GATE_DEFER) continue;
+            decided[m]++;
+            if (strcmp(gate_label(v), nn_label) == 0) agreed[m]++;
+        }
+    }
+    if (!records) { printf("[GATE] No feature records on flash\n"); return; }
+    float nn_ms = nn_us / 1000.0f / records;
+    printf("[GATE] Replay: %u feature records, network %.2f ms each, %u outside the guard band\n",
+           (unsigned)records, nn_ms, (unsigned)out_of_range);
+    printf("[GATE] margin  decided  gate agrees  overall agrees  network ms/capture\n");
+    for (int m = 0; m < nm; m++)
+        printf("[GATE] %6.2f  %6.1f%%  %10.1f%%  %13.1f%%  %8.2f\n", margins[m], 100.0f * decided[m] / records,
+               decided[m] ? 100.0f * agreed[m] / decided[m] : 100.0f,
+               100.0f * (records - decided[m] + agreed[m]) / records, nn_ms * (records - decided[m]) / records);
+}
+
+// Scheduled captures push their density into the rolling history; live
+// updates only compare against it, so BEE_HISTORY_SIZE keeps its time span.
+static void fill_summer_features(const double* bins, float current_density, bool push_history) {
+    if (push_history) bee_history_push(&g_density_history, current_density);
+    float spike = bee_spike_ratio(&g_density_history, current_density);
+    bee_summer_vector(bins, g_last_temp, g_last_hum, BEE_DEFAULT_HOUR, spike, g_features_summer);
+}
+
+// The gate, then the network for the captures it defers (and, with audit
+// on, for its verdicts too). Returns the label; *by_gate tells which stage.
+static const char* classify_cascade(const float* features, float* score, bool* by_gate, bool verbose) {
+    float p_event;
+    GateVerdict verdict = gate_decide(features, sys_config.gate_margin, &p_event);
+    const char* label = gate_label(verdict);
+    *score = verdict == GATE_EVENT ? p_event : 1.0f - p_event;
+    if (verdict == GATE_DEFER) {
+        g_gate.deferred++;
+        if (verbose) printf("[AI] Gate: deferred (p_event %.3f)\n", p_event);
+        classify_summer(features, &label, score);
+    } else {
+        if (verdict == GATE_EVENT) g_gate.event++; else g_gate.normal++;
+        if (g_gate_audit) {
+            const char* nn_label; float nn_score;
+            classify_summer(features, &nn_label, &nn_score);
+            bool agree = strcmp(nn_label, label) == 0;
+            g_gate.audited++;
+            if (!agree) g_gate.disagreed++;
+            if (verbose || !agree)
+                printf("[AI] Gate: %s (p_event %.3f), network %s (%.1f%%) %s\n", label, p_event, nn_label,
+                       nn_score * 100, agree ? "agrees" : "DISAGREES");
+            label = nn_label; *score = nn_score;
+        }
+        else if (verbose) printf("[AI] Gate: %s (p_event %.3f), network skipped\n", label, p_event);
+    }
+    *by_gate = verdict != GATE_DEFER && !g_gate_audit;
+    return label;
+}
+
+static void run_summer_inference(float current_density) {
+    fill_summer_features(g_bin_accum, current_density, true);
+    float score; bool by_gate;
+    const char* label = classify_cascade(g_features_summer, &score, &by_gate, true);
+
+    printf("[AI] Result: %s (%.1f%%) [%s]\n", label, score*100, by_gate ? "gate" : "network");
+    if (strcmp(label, "Event") == 0) clip_trigger(label, score);
     
-    printf("[AI] Result: %s (%.1f%%)\n", label, score*100);
-    
-    if (wifi_connected) {
-        char json[256];
-        snprintf(json, sizeof(json), 
-            "{\"node_id\": \"%s\", \"model_type\": \"summer\", \"classification\": \"%s\", \"confidence\": %.2f, \"timestamp\": \"2023-01-01T00:00:00\"}",
-            sys_config.node_id, label, score);
-        perform_http_request("POST", "inference/", json);
-        log_to_server("Inference Completed");
+    // Results reach the server through the record log, also when offline
+    record_features(current_density, g_features_summer);
+    record_inference("summer", label, score);
+    if (wifi_connected) log_to_server(by_gate ? "Inference Completed (gate)" : "Inference Completed");
+}
+
+// Live mode: between jobs the ring runs at full rate and every block goes
+// through the DSP into g_roll and into the clip ring; each hop classifies the
+// last 6 s. Only label changes are logged to flash, so the log sees
+// transitions, not every hop. An Event stops the ring before clip_trigger()
+// takes the ADC for the post-trigger audio; the next call restarts it.
+static void live_poll() {
+    if (!g_live_hop || g_sched.in_job) return;
+    if (!g_ring_running) {
+        // (Re)start after a job or command used the ADC: older audio is stale
+        roll_init(&g_roll, g_live_hop);
+        reset_filters();
+        ring_start();
+    }
+    const uint16_t* blk;
+    float mags[NUM_FREQ_BINS];
+    while ((blk = ring_peek()) != NULL) {
+        uint64_t t0 = time_us_64();
+        uint32_t raw_sum = 0;
+        for (int i = 0; i < FFT_SIZE; i++) raw_sum += blk[i] & 0x0FFF;
+        double sumsq = bee_dsp_window(blk, roll_dc(&g_roll, blk), sys_config.gain, mags);
+        clip_push_block(blk);
+        ring_release();
+        bool ready = roll_add(&g_roll, mags, (float)(sumsq / FFT_SIZE), raw_sum);
+        g_live_dsp_us += time_us_64() - t0;
+        if (!ready) continue;
+
+        t0 = time_us_64();
+        double bins[NUM_FREQ_BINS];
+        roll_bins(&g_roll, bins);
+        float density = roll_density(&g_roll);
+        fill_summer_features(bins, density, false);
+        float score; bool by_gate;
+        const char* label = classify_cascade(g_features_summer, &score, &by_gate, false);
+        g_live_nn_us += time_us_64() - t0;
+        printf("[LIVE] density %.6f, spike %.2f -> %s (%.1f%%) [%s]\n", density, g_features_summer[3],
+               label, score * 100, by_gate ? "gate" : "network");
+        if (!g_live_label || strcmp(label, g_live_label) != 0) {
+            if (g_live_label) g_live_changes++;
+            g_live_label = label;
+            record_features(density, g_features_summer);
+            record_inference("summer", label, score);
+            sched_uplink_begin(&g_sched);   // send it now, not after the next job
+            if (strcmp(label, "Event") == 0) {
+                wake_pause();
+                clip_trigger(label, score);
+                return;
+            }
+        }
     }
 }
 
+static void print_live_status() {
+    if (!g_live_hop) printf("[LIVE] Off\n");
+    else printf("[LIVE] Every %u windows (%.2f s) over the last %d (%.2f s)%s\n", (unsigned)g_live_hop,
+                g_live_hop * FFT_SIZE / (float)SAMPLE_RATE_HZ, ROLL_WINDOWS, ROLL_WINDOWS * FFT_SIZE / (float)SAMPLE_RATE_HZ,
+                g_ring_running ? "" : ", paused");
+    uint64_t elapsed = time_us_64() - g_live_since_us;
+    printf("[LIVE] %u windows, %u results, %u label changes, %u resums, %u ring overruns\n",
+           (unsigned)g_roll.windows, (unsigned)g_roll.emits, (unsigned)g_live_changes, (unsigned)g_roll.resums,
+           (unsigned)g_ring_overruns);
+    if (g_roll.windows)
+        printf("[LIVE] DSP %.2f ms/window, classify %.2f ms/result, %.1f%% CPU\n",
+               g_live_dsp_us / 1000.0f / g_roll.windows, g_roll.emits ? g_live_nn_us / 1000.0f / g_roll.emits : 0.0f,
+               elapsed ? 100.0f * (g_live_dsp_us + g_live_nn_us) / elapsed : 0.0f);
+}
+
 static void run_winter_inference(float density) {
     printf("[AI] Winter logic placeholder\n");
     if(wifi_connected) log_to_server("Winter Logic Run");
 }
 
+// Scratch arena the SDK hands to each DSP block (EIDSP_SCRATCH_ARENA_SIZE).
+static void print_dsp_scratch() {
+#if EIDSP_SCRATCH_ARENA_SIZE > 0
+    const ei::ei_dsp_scratch_t& s = ei_dsp_default_scratch;
+    printf("[POOL] DSP scratch: %u B, peak %u B over %u blocks, %u allocs, %u fallbacks (%u B)\n",
+           (unsigned)s.size, (unsigned)s.peak, (unsigned)s.scopes, (unsigned)s.allocs,
+           (unsigned)s.fallbacks, (unsigned)s.fallback_bytes);
+#else
+    printf("[POOL] DSP scratch: off, temporaries use the pool (build with -DDSP_SCRATCH_SIZE=<bytes>)\n");
+#endif
+}
+
+static void print_fft_plans() {
+#if EIDSP_FFT_PLAN_CACHE_SIZE > 0
+    ei::ei_fft_plan_stats_t s;
+    ei::ei_fft_plan_get_stats(&s);
+    printf("[POOL] FFT plans: %u B in %u slots, %u hits, %u builds, %u evictions, %u uncached\n",
+           (unsigned)EIDSP_FFT_PLAN_CACHE_SIZE, (unsigned)EIDSP_FFT_PLAN_CACHE_SLOTS, (unsigned)s.hits,
+           (unsigned)s.builds, (unsigned)s.evictions, (unsigned)s.uncached);
+#else
+    printf("[POOL] FFT plans: off, kissfft configs are built per call (build with -DFFT_PLAN_CACHE_SIZE=<bytes>)\n");
+#endif
+}
+
 static void debug_features() {
-    read_climate(); capture_audio(); process_and_compute_features();
+    begin_climate(); capture_audio(); finish_climate(); process_and_compute_features();
     printf("Density: %.6f\n", 0.0f); // Placeholder print
 }
 
@@ -469,32 +838,168 @@ static void debug_features() {
 
 void process_command(Command cmd) {
     if (cmd.type == "READ_CLIMATE") {
-        read_climate();
-        if (cmd.from_network && wifi_connected) {
-            char json[128];
-            snprintf(json, sizeof(json), 
-                "{\"node_id\":\"%s\",\"temperature_c\":%.2f,\"humidity_pct\":%.2f,\"battery_mv\":4200}", 
-                sys_config.node_id, g_last_temp, g_last_hum);
-            perform_http_request("POST", "telemetry/", json);
-        }
+        if (read_climate() && cmd.from_network) record_climate();
+        if (!cmd.from_network && !g_mock_mode) climate_print_status(&g_climate);
     }
     else if (cmd.type == "RUN_INFERENCE") {
-        read_climate(); capture_audio();
-        float density = process_and_compute_features();
+        // The climate conversion overlaps the capture
+        begin_climate();
+        bool adaptive = sys_config.adapt_ci > 0.0f;
+        float density = 0.0f;
+        if (adaptive) density = capture_and_process_adaptive();
+        else capture_audio();
+        if (finish_climate()) record_climate();
+        if (!adaptive) density = process_and_compute_features();
         if (cmd.params == "winter") run_winter_inference(density);
         else run_summer_inference(density);
     }
-    else if (cmd.type == "CAPTURE_AUDIO") stream_audio(6);
+    else if (cmd.type == "CAPTURE_AUDIO") stream_audio(atoi(cmd.params.c_str()));
+    else if (cmd.type == "STREAM_AUDIO") {
+        char codec[16] = "pack12"; int seconds = 0;
+        sscanf(cmd.params.c_str(), "%15s %d", codec, &seconds);
+        int c = CODEC_PACK12;
+        if (strcmp(codec, "adpcm") == 0) c = CODEC_ADPCM;
+        else if (strcmp(codec, "rice") == 0) c = CODEC_RICE;
+        led_set(true);
+        stream_audio_framed(c, seconds);
+        led_set(false);
+    }
     else if (cmd.type == "TOGGLE_MOCK") {
         g_mock_mode = !g_mock_mode;
         printf("[CONF] Mock: %d\n", g_mock_mode);
         if(wifi_connected) log_to_server(g_mock_mode ? "Mock Enabled" : "Mock Disabled");
     }
     else if (cmd.type == "CLEAR_HISTORY") {
-        g_density_history.clear();
+        bee_history_clear(&g_density_history);
         printf("[CONF] History Cleared\n");
     }
     else if (cmd.type == "DEBUG_DUMP") debug_features();
+    else if (cmd.type == "ARENA_REPORT") report_arena_usage(nullptr);
+    else if (cmd.type == "POOL") {
+        if (cmd.params == "reset") pool_set_mode(POOL_MODE_RESET);
+        else if (cmd.params == "persist") pool_set_mode(POOL_MODE_PERSISTENT);
+        else if (cmd.params.rfind("bench", 0) == 0) pool_benchmark(atoi(cmd.params.c_str() + 5));
+        else { pool_print_stats(); print_dsp_scratch(); print_fft_plans(); }
+    }
+    else if (cmd.type == "CAPTURE_STORE") {
+        if (cmd.params.rfind("bench", 0) == 0) capture_store_benchmark(atoi(cmd.params.c_str() + 5));
+        else if (cmd.params.rfind("adapt", 0) == 0) {
+            float ci = -1.0f;
+            if (cmd.params == "adapt on") ci = EST_DEFAULT_CI;
+            else if (cmd.params == "adapt off") ci = 0.0f;
+            else if (cmd.params.size() > 5) {
+                float pct = atof(cmd.params.c_str() + 5);
+                if (pct >= 0.0f && pct <= 50.0f) ci = pct / 100.0f;
+                else printf("[CAP] ERR: CI out of range [0, 50] %%\n");
+            }
+            if (ci >= 0.0f) { sys_config.adapt_ci = ci; save_config(); }
+            print_adaptive_status();
+        }
+        else printf("[CAP] %d samples, %d B packed, mean %.1f, std %.1f\n",
+                    g_capture_len, PACK12_BYTES(g_capture_len), capture_store_mean(), capture_store_std());
+    }
+    else if (cmd.type == "RECORD_LOG") {
+        if (cmd.params.rfind("bench", 0) == 0) log_benchmark(atoi(cmd.params.c_str() + 5), time_us_64);
+        else print_record_log();
+    }
+    else if (cmd.type == "CONFIG_STORE") {
+        if (cmd.params.rfind("bench", 0) == 0) config_store_benchmark(atoi(cmd.params.c_str() + 5), time_us_64);
+        else print_config_store();
+    }
+    else if (cmd.type == "SET_GAIN") {
+        if (!cmd.params.empty()) {
+            float g = atof(cmd.params.c_str());
+            if (g > 0.0f && g <= 10.0f) { sys_config.gain = g; save_config(); }
+            else printf("[CONF] ERR: gain out of range (0, 10]\n");
+        }
+        printf("[CONF] Gain: %.2f\n", sys_config.gain);
+    }
+    else if (cmd.type == "BACKGROUND") {
+        if (!cmd.params.empty()) sys_config.sample_interval_s = atoi(cmd.params.c_str());
+        else sys_config.sample_interval_s = sys_config.sample_interval_s ? 0 : BACKGROUND_DEFAULT_S;
+        save_config();
+        sched_set_interval(&g_sched, sys_config.sample_interval_s);
+        wake_init(&g_wake, sys_config.wake_ratio);
+        if (sys_config.sample_interval_s) printf("[CONF] Background sampling every %u s\n", (unsigned)sys_config.sample_interval_s);
+        else printf("[CONF] Background sampling off\n");
+    }
+    else if (cmd.type == "NET_STATUS") {
+        if (cmd.params == "join") wifi_restart();
+        wifi_print_status();
+        if (g_first_sample_ms) printf("[NET] First sample %u ms after boot\n", (unsigned)g_first_sample_ms);
+        else printf("[NET] No sample yet\n");
+    }
+    else if (cmd.type == "WAKE") {
+        if (!cmd.params.empty()) {
+            float r = cmd.params == "off" ? 0.0f : (cmd.params == "on" ? WAKE_DEFAULT_RATIO : atof(cmd.params.c_str()));
+            if (r == 0.0f || (r > 1.0f && r <= 20.0f)) {
+                sys_config.wake_ratio = r;
+                save_config();
+                wake_init(&g_wake, r);
+            }
+            else printf("[WAKE] ERR: ratio out of range (1, 20]\n");
+        }
+        print_wake_status();
+    }
+    else if (cmd.type == "LIVE") {
+        if (!cmd.params.empty()) {
+            float sec = cmd.params == "off" ? 0.0f : (cmd.params == "on" ? ROLL_DEFAULT_HOP * FFT_SIZE / (float)SAMPLE_RATE_HZ
+                                                                          : atof(cmd.params.c_str()));
+            uint32_t hop = (uint32_t)(sec * SAMPLE_RATE_HZ / FFT_SIZE + 0.5f);
+            if (sec == 0.0f || (hop >= 1 && hop <= ROLL_WINDOWS)) {
+                g_live_hop = hop;
+                g_live_label = NULL;
+                g_live_changes = 0;
+                g_live_dsp_us = g_live_nn_us = 0;
+                g_live_since_us = time_us_64();
+                roll_init(&g_roll, hop);
+            }
+            else printf("[LIVE] ERR: hop out of range [0.032, 6] s\n");
+        }
+        print_live_status();
+    }
+    else if (cmd.type == "GATE") {
+        if (cmd.params.rfind("replay", 0) == 0) gate_replay(atoi(cmd.params.c_str() + 6));
+        else if (cmd.params == "audit") g_gate_audit = !g_gate_audit;
+        else if (!cmd.params.empty()) {
+            float m = cmd.params == "off" ? 0.0f : (cmd.params == "on" ? GATE_DEFAULT_MARGIN : atof(cmd.params.c_str()));
+            if (m >= 0.0f && m <= GATE_MAX_MARGIN) {
+                sys_config.gate_margin = m;
+                save_config();
+            }
+            else printf("[GATE] ERR: margin out of range [0, %.2f]\n", GATE_MAX_MARGIN);
+        }
+        if (cmd.params.rfind("replay", 0) != 0) print_gate_status();
+    }
+    else if (cmd.type == "SCHEDULER") {
+        if (cmd.params.rfind("sim", 0) == 0) {
+            uint32_t job_ms = g_sched.jobs ? (uint32_t)(g_sched.job_us / g_sched.jobs / 1000) : 8000;
+            sched_simulate(atoi(cmd.params.c_str() + 3), sys_config.sample_interval_s, job_ms, 2000);
+        }
+        else sched_print_status(&g_sched, "SCHED");
+    }
+    else if (cmd.type == "CMD_CHANNEL") {
+        cmd_channel_print_status();
+    }
+    else if (cmd.type == "TRANSPORT") {
+        if (cmd.params == "on" || cmd.params == "off") {
+#ifdef BEEWATCH_MQTT
+            sys_config.transport = cmd.params == "on" ? TRANSPORT_MQTT : TRANSPORT_HTTP;
+            save_config();
+#else
+            printf("[MQTT] Not built in (configure with -DBEEWATCH_MQTT=ON)\n");
+#endif
+        }
+#ifdef BEEWATCH_MQTT
+        mqtt_print_status();
+        transport_print_stats("MQTT", &g_mqtt.stats);
+#endif
+        transport_print_stats("HTTP", &g_http_stats);
+    }
+    else if (cmd.type == "CLIP") {
+        if (cmd.params == "event") clip_trigger("Manual", 1.0f);
+        else clip_print_status();
+    }
     else if (cmd.type == "PING") {
         printf("PONG\n");
         if(wifi_connected) log_to_server("PONG");
@@ -512,6 +1017,11 @@ int main() {
     
     printf("\n>>> BeeWatch Node Ready.\n");
 
+    // Start sampling right away; the uplink catches up once WiFi joins
+    sched_init(&g_sched, time_us_64);
+    sched_set_interval(&g_sched, sys_config.sample_interval_s);
+    wake_init(&g_wake, sys_config.wake_ratio);
+
     while (true) {
         int c = getchar_timeout_us(0);
         if (c != PICO_ERROR_TIMEOUT) {
@@ -522,14 +1032,85 @@ int main() {
                     if (strcmp(token, "s") == 0) cmd_queue.push_back({"RUN_INFERENCE", "summer", false});
                     else if (strcmp(token, "w") == 0) cmd_queue.push_back({"RUN_INFERENCE", "winter", false});
                     else if (strcmp(token, "t") == 0) cmd_queue.push_back({"READ_CLIMATE", "", false});
-                    else if (strcmp(token, "a") == 0) cmd_queue.push_back({"CAPTURE_AUDIO", "", false});
+                    else if (strcmp(token, "ab") == 0) {
+                        char* c = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = c ? c : "pack12";
+                        params += std::string(" ") + (n ? n : "0");
+                        cmd_queue.push_back({"STREAM_AUDIO", params, false});
+                    }
+                    else if (token[0] == 'a' && (token[1] == '\0' || isdigit((unsigned char)token[1])))
+                        cmd_queue.push_back({"CAPTURE_AUDIO", token + 1, false});
                     else if (strcmp(token, "m") == 0) cmd_queue.push_back({"TOGGLE_MOCK", "", false});
                     else if (strcmp(token, "c") == 0) cmd_queue.push_back({"CLEAR_HISTORY", "", false});
                     else if (strcmp(token, "d") == 0) cmd_queue.push_back({"DEBUG_DUMP", "", false});
                     else if (strcmp(token, "p") == 0) cmd_queue.push_back({"PING", "", false});
+                    else if (strcmp(token, "r") == 0) cmd_queue.push_back({"ARENA_REPORT", "", false});
+                    else if (strcmp(token, "pool") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"POOL", params, false});
+                    }
+                    else if (strcmp(token, "cap") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"CAPTURE_STORE", params, false});
+                    }
+                    else if (strcmp(token, "log") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"RECORD_LOG", params, false});
+                    }
+                    else if (strcmp(token, "conf") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"CONFIG_STORE", params, false});
+                    }
+                    else if (strcmp(token, "gate") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"GATE", params, false});
+                    }
+                    else if (token[0] == 'g' && (token[1] == '\0' || token[1] == '.' || isdigit((unsigned char)token[1])))
+                        cmd_queue.push_back({"SET_GAIN", token + 1, false});
+                    else if (strcmp(token, "b") == 0) {
+                        char* n = strtok(NULL, " ");
+                        cmd_queue.push_back({"BACKGROUND", n ? n : "", false});
+                    }
+                    else if (strcmp(token, "mqtt") == 0) {
+                        char* sub = strtok(NULL, " ");
+                        cmd_queue.push_back({"TRANSPORT", sub ? sub : "", false});
+                    }
+                    else if (strcmp(token, "wake") == 0) {
+                        char* v = strtok(NULL, " ");
+                        cmd_queue.push_back({"WAKE", v ? v : "", false});
+                    }
+                    else if (strcmp(token, "live") == 0) {
+                        char* v = strtok(NULL, " ");
+                        cmd_queue.push_back({"LIVE", v ? v : "", false});
+                    }
+                    else if (strcmp(token, "sched") == 0) {
+                        char* sub = strtok(NULL, " "); char* n = strtok(NULL, " ");
+                        std::string params = sub ? sub : "";
+                        if (n) params += std::string(" ") + n;
+                        cmd_queue.push_back({"SCHEDULER", params, false});
+                    }
+                    else if (strcmp(token, "cmd") == 0) cmd_queue.push_back({"CMD_CHANNEL", "", false});
+                    else if (strcmp(token, "net") == 0) {
+                        char* sub = strtok(NULL, " ");
+                        cmd_queue.push_back({"NET_STATUS", sub ? sub : "", false});
+                    }
+                    else if (strcmp(token, "clip") == 0) {
+                        char* sub = strtok(NULL, " ");
+                        cmd_queue.push_back({"CLIP", sub ? sub : "", false});
+                    }
                     else if (strcmp(token, "wifi") == 0) {
                         char* s = strtok(NULL, " "); char* p = strtok(NULL, " ");
-                        if(s && p) { strncpy(sys_config.wifi_ssid, s, 31); strncpy(sys_config.wifi_pass, p, 63); save_config(); printf("Saved WiFi.\n"); }
+                        if(s && p) { strncpy(sys_config.wifi_ssid, s, 31); strncpy(sys_config.wifi_pass, p, 63); save_config(); printf("Saved WiFi.\n"); wifi_restart(); }
                     }
                     else if (strcmp(token, "server") == 0) {
                         char* i = strtok(NULL, " ");
@@ -546,25 +1127,55 @@ int main() {
             }
         }
 
-        // 2. Poll Network
-        if (wifi_connected && (to_ms_since_boot(get_absolute_time()) - last_sync_time > SYNC_INTERVAL_MS)) {
-            last_sync_time = to_ms_since_boot(get_absolute_time());
-            char query[128];
-            snprintf(query, 128, "commands/pending?node_id=%s", sys_config.node_id);
-            if (perform_http_request("GET", query, "")) {
-                parse_server_commands();
-            }
+        // 2. Connectivity, then server commands: MQTT subscription or HTTP long-poll (non-blocking)
+        wifi_poll(on_wifi_change);
+#ifdef BEEWATCH_MQTT
+        mqtt_poll(wifi_connected, g_log_ok && sched_uplink_open(&g_sched) ? &g_log : NULL, record_to_json, parse_server_commands);
+#endif
+        cmd_channel_poll(wifi_connected && !mqtt_active(), parse_server_commands);
+
+        // Capture -> features -> inference at the persisted cadence (the
+        // heartbeat) and, with wake-on-sound on, whenever the detector fires
+        bool woke = wake_poll();
+        live_poll();
+        if (sched_due(&g_sched) || woke) {
+            if (woke) { g_wake_jobs++; printf("[WAKE] Spike %.2fx baseline\n", g_wake.last_ratio); }
+            wake_pause();
+            sched_job_begin(&g_sched);
+            apply_radio_pm();
+            process_command({"RUN_INFERENCE", "summer", false});
+            sched_job_end(&g_sched);
         }
-        
-        // 3. Execute Queue
+
+        // 3. Advance clip upload (non-blocking) and replay offline records in
+        //    the uplink window after a job; the window closes once drained
+        clip_poll(wifi_connected);
+        if (sched_uplink_open(&g_sched)) {
+            if (!mqtt_active()) replay_record_log();
+            if (!wifi_connected || !g_log_ok || log_pending(&g_log) == 0) sched_uplink_done(&g_sched);
+        }
+        apply_radio_pm();
+
+        // 4. Execute Queue
         if (!cmd_queue.empty()) {
             Command cmd = cmd_queue.front();
             cmd_queue.erase(cmd_queue.begin());
+            wake_pause();
+            uint32_t logged = g_log.next_seq;
             process_command(cmd);
+            // Records from a commanded run go out now, not in the next job's window
+            if (g_log_ok && g_log.next_seq != logged) sched_uplink_begin(&g_sched);
         }
         
         cyw43_arch_poll();
-        sleep_ms(10);
+        // Between jobs, wait for radio work or the next nap deadline instead
+        uint32_t nap = sched_nap_ms(&g_sched, !cmd_queue.empty());
+        if (nap) {
+            uint64_t t0 = time_us_64();
+            cyw43_arch_wait_for_work_until(make_timeout_time_ms(nap));
+            sched_note_sleep(&g_sched, time_us_64() - t0);
+        }
+        else sleep_ms(10);
     }
     return 0;
 }
@@ -0,0 +1,265 @@
+/*
+ * mqtt_transport.h
+ * Alternative uplink: one persistent MQTT session (lwIP MQTT app) instead of
+ * one HTTP connection per record and per command poll.
+ *
+ *   beewatch/<node>/telemetry|inference|features   QoS1, from the record log
+ *   beewatch/<node>/log                            QoS0, console messages
+ *   beewatch/<node>/commands                       subscribed, QoS1
+ *
+ * Replay keeps up to MQTT_WINDOW QoS1 publishes in flight, read ahead of the
+ * log tail with log_read_next(). PUBACKs retire the window in log order, so
+ * log_ack() still sees records oldest-first; a timeout or a dropped session
+ * rewinds to the tail and resends (at-least-once, like the HTTP path).
+ * Command payloads use the commands/pending JSON, so parse_server_commands()
+ * handles both. backend/scripts/mqtt_bridge.py connects the topics to the API.
+ *
+ * Compiled in with -DBEEWATCH_MQTT=ON (links pico_lwip_mqtt) and selected at
+ * run time with the `mqtt on|off` command, stored in SystemConfig.transport.
+ */
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "flash_config.h"
+
+// Per-transport replay accounting, for comparing HTTP and MQTT
+struct TransportStats {
+    uint32_t records;
+    uint64_t tx_bytes, rx_bytes;    // application bytes on the wire (TCP payload)
+    uint64_t busy_us;               // time with a record outstanding
+};
+
+static void transport_print_stats(const char* name, const TransportStats* s) {
+    if (!s->records) { printf("[NET] %-4s: no records sent\n", name); return; }
+    printf("[NET] %-4s: %u records, %u B/record out, %u B/record in, %.1f records/s while busy\n", name,
+           (unsigned)s->records, (unsigned)(s->tx_bytes / s->records), (unsigned)(s->rx_bytes / s->records),
+           s->busy_us ? s->records * 1e6f / (float)s->busy_us : 0.0f);
+}
+
+#ifdef BEEWATCH_MQTT
+
+#include "lwip/apps/mqtt.h"
+#include "flash_log.h"
+
+#define MQTT_WINDOW         4       // QoS1 publishes in flight, <= MQTT_REQ_MAX_IN_FLIGHT
+#define MQTT_KEEPALIVE_S    60
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 30000
+#define MQTT_RX_SIZE        1024
+
+struct MqttSlot {
+    uint32_t seq;
+    bool acked;
+};
+
+struct MqttTransport {
+    mqtt_client_t* client;
+    bool connecting, connected;
+    uint32_t retry_at_ms, backoff_ms;
+    char cmd_topic[64];
+
+    // Replay window, oldest first
+    MqttSlot window[MQTT_WINDOW];
+    int win_count;
+    bool rewind;
+    LogCursor cursor;
+    uint64_t last_poll_us;
+
+    // Incoming publish being assembled
+    char rx[MQTT_RX_SIZE];
+    int rx_len;
+    bool rx_is_cmd;
+    void (*on_commands)(const char* body);
+
+    TransportStats stats;
+    uint32_t connects, resends, commands;
+};
+
+static MqttTransport g_mqtt;
+
+static inline bool mqtt_active() {
+    return sys_config.transport == TRANSPORT_MQTT;
+}
+
+// Bytes of a PUBLISH packet: fixed header, topic, packet id (QoS > 0), payload.
+static uint32_t mqtt_publish_bytes(uint32_t topic_len, uint32_t payload_len, int qos) {
+    uint32_t rem = 2 + topic_len + (qos ? 2 : 0) + payload_len;
+    return 1 + (rem < 128 ? 1 : rem < 16384 ? 2 : 3) + rem;
+}
+
+// --- lwIP MQTT callbacks ---
+
+static void mqtt_pub_cb(void* arg, err_t err) {
+    uint32_t seq = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < g_mqtt.win_count; i++) {
+        if (g_mqtt.window[i].seq != seq) continue;
+        if (err == ERR_OK) { g_mqtt.window[i].acked = true; g_mqtt.stats.rx_bytes += 4; }   // PUBACK
+        else g_mqtt.rewind = true;
+        return;
+    }
+}
+
+static void mqtt_incoming_publish_cb(void* arg, const char* topic, u32_t tot_len) {
+    g_mqtt.rx_len = 0;
+    g_mqtt.rx_is_cmd = strcmp(topic, g_mqtt.cmd_topic) == 0;
+}
+
+static void mqtt_incoming_data_cb(void* arg, const u8_t* data, u16_t len, u8_t flags) {
+    if (!g_mqtt.rx_is_cmd) return;
+    int n = len < MQTT_RX_SIZE - 1 - g_mqtt.rx_len ? len : MQTT_RX_SIZE - 1 - g_mqtt.rx_len;
+    memcpy(g_mqtt.rx + g_mqtt.rx_len, data, n);
+    g_mqtt.rx_len += n;
+    g_mqtt.rx[g_mqtt.rx_len] = 0;
+    if ((flags & MQTT_DATA_FLAG_LAST) && g_mqtt.on_commands) {
+        g_mqtt.commands++;
+        g_mqtt.on_commands(g_mqtt.rx);
+    }
+}
+
+static void mqtt_sub_cb(void* arg, err_t err) {
+    if (err != ERR_OK) printf("[MQTT] Subscribe to %s failed: %d\n", g_mqtt.cmd_topic, err);
+}
+
+static void mqtt_schedule_retry(uint32_t now) {
+    g_mqtt.backoff_ms = g_mqtt.backoff_ms ? g_mqtt.backoff_ms * 2 : MQTT_BACKOFF_MIN_MS;
+    if (g_mqtt.backoff_ms > MQTT_BACKOFF_MAX_MS) g_mqtt.backoff_ms = MQTT_BACKOFF_MAX_MS;
+    g_mqtt.retry_at_ms = now + g_mqtt.backoff_ms;
+}
+
+static void mqtt_connection_cb(mqtt_client_t* client, void* arg, mqtt_connection_status_t status) {
+    g_mqtt.connecting = false;
+    // mqtt_disconnect() reports status 0 as well; only a live session counts
+    if (status == MQTT_CONNECT_ACCEPTED && mqtt_client_is_connected(client)) {
+        g_mqtt.connected = true;
+        g_mqtt.backoff_ms = 0;
+        g_mqtt.connects++;
+        g_mqtt.rewind = true;       // anything in flight on the old session is resent
+        mqtt_subscribe(client, g_mqtt.cmd_topic, 1, mqtt_sub_cb, NULL);
+        printf("[MQTT] Connected to %s:%u\n", sys_config.server_ip, sys_config.mqtt_port);
+    } else {
+        if (g_mqtt.connected) printf("[MQTT] Session lost (%d)\n", (int)status);
+        g_mqtt.connected = false;
+        mqtt_schedule_retry(to_ms_since_boot(get_absolute_time()));
+    }
+}
+
+static void mqtt_start_connect(uint32_t now) {
+    if (!g_mqtt.client) {
+        g_mqtt.client = mqtt_client_new();
+        if (!g_mqtt.client) { mqtt_schedule_retry(now); return; }
+        mqtt_set_inpub_callback(g_mqtt.client, mqtt_incoming_publish_cb, mqtt_incoming_data_cb, NULL);
+    }
+    snprintf(g_mqtt.cmd_topic, sizeof(g_mqtt.cmd_topic), "beewatch/%s/commands", sys_config.node_id);
+
+    struct mqtt_connect_client_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.client_id = sys_config.node_id;
+    info.keep_alive = MQTT_KEEPALIVE_S;
+
+    ip_addr_t broker;
+    ip4addr_aton(sys_config.server_ip, &broker);
+    if (mqtt_client_connect(g_mqtt.client, &broker, sys_config.mqtt_port, mqtt_connection_cb, NULL, &info) == ERR_OK)
+        g_mqtt.connecting = true;
+    else
+        mqtt_schedule_retry(now);
+}
+
+static void mqtt_stop() {
+    if (g_mqtt.client && (g_mqtt.connected || g_mqtt.connecting)) mqtt_disconnect(g_mqtt.client);
+    g_mqtt.connected = g_mqtt.connecting = false;
+    g_mqtt.win_count = 0;
+    g_mqtt.cursor.valid = false;
+}
+
+// QoS0 console line; dropped when the session is down.
+static void mqtt_log(const char* json) {
+    if (!g_mqtt.connected) return;
+    char topic[64];
+    snprintf(topic, sizeof(topic), "beewatch/%s/log", sys_config.node_id);
+    mqtt_publish(g_mqtt.client, topic, json, strlen(json), 0, 0, NULL, NULL);
+}
+
+// Keeps the session up and the replay window full. Call every main loop pass.
+// format() turns a record into its JSON body and returns the endpoint name
+// ("telemetry/", ...), or NULL for records that are not uploaded.
+static void mqtt_poll(bool online, FlashLog* log,
+                      const char* (*format)(const LogRecHdr*, const uint8_t*, char*, size_t),
+                      void (*on_commands)(const char* body)) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint64_t now_us = time_us_64();
+    if (g_mqtt.win_count > 0) g_mqtt.stats.busy_us += now_us - g_mqtt.last_poll_us;
+    g_mqtt.last_poll_us = now_us;
+    g_mqtt.on_commands = on_commands;
+
+    if (!online || !mqtt_active()) { if (g_mqtt.connected || g_mqtt.connecting) mqtt_stop(); return; }
+    if (g_mqtt.connected && !mqtt_client_is_connected(g_mqtt.client)) {
+        g_mqtt.connected = false;
+        mqtt_schedule_retry(now);
+    }
+    if (!g_mqtt.connected) {
+        if (!g_mqtt.connecting && (int32_t)(now - g_mqtt.retry_at_ms) >= 0) mqtt_start_connect(now);
+        return;
+    }
+    if (!log) return;
+
+    // Retire acknowledged records in log order
+    LogRecHdr h;
+    static uint8_t payload[LOG_MAX_PAYLOAD];
+    while (g_mqtt.win_count > 0 && g_mqtt.window[0].acked) {
+        if (log_peek(log, &h, payload) && h.seq == g_mqtt.window[0].seq) {
+            log_ack(log, &h);
+            g_mqtt.stats.records++;
+        }
+        memmove(g_mqtt.window, g_mqtt.window + 1, (g_mqtt.win_count - 1) * sizeof(MqttSlot));
+        g_mqtt.win_count--;
+    }
+    if (g_mqtt.rewind) {
+        g_mqtt.resends += g_mqtt.win_count;
+        g_mqtt.win_count = 0;
+        g_mqtt.cursor.valid = false;
+        g_mqtt.rewind = false;
+    }
+
+    // Top up the window
+    static char json[512];
+    char topic[64];
+    while (g_mqtt.win_count < MQTT_WINDOW && log_pending(log) > (uint32_t)g_mqtt.win_count) {
+        LogCursor saved = g_mqtt.cursor;
+        if (!log_read_next(log, &g_mqtt.cursor, &h, payload)) break;
+        MqttSlot* slot = &g_mqtt.window[g_mqtt.win_count];
+        slot->seq = h.seq;
+        slot->acked = false;
+        const char* path = format(&h, payload, json, sizeof(json));
+        if (!path) { slot->acked = true; g_mqtt.win_count++; continue; }
+
+        int tl = snprintf(topic, sizeof(topic), "beewatch/%s/%.*s", sys_config.node_id, (int)strlen(path) - 1, path);
+        uint16_t len = strlen(json);
+        if (mqtt_publish(g_mqtt.client, topic, json, len, 1, 0, mqtt_pub_cb, (void*)(uintptr_t)h.seq) != ERR_OK) {
+            g_mqtt.cursor = saved;      // output buffer or request slots full: retry next pass
+            break;
+        }
+        g_mqtt.stats.tx_bytes += mqtt_publish_bytes(tl, len, 1);
+        g_mqtt.win_count++;
+    }
+}
+
+static void mqtt_print_status() {
+    printf("[MQTT] %s, broker %s:%u, transport %s\n",
+           g_mqtt.connected ? "connected" : (g_mqtt.connecting ? "connecting" : "down"),
+           sys_config.server_ip, sys_config.mqtt_port, mqtt_active() ? "MQTT" : "HTTP");
+    printf("[MQTT] Sessions %u, window %d/%d, resends %u, commands %u\n", (unsigned)g_mqtt.connects,
+           g_mqtt.win_count, MQTT_WINDOW, (unsigned)g_mqtt.resends, (unsigned)g_mqtt.commands);
+}
+
+#else
+
+static inline bool mqtt_active() { return false; }
+
+#endif  // BEEWATCH_MQTT
+
+#endif
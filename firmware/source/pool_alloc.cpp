@@ -0,0 +1,277 @@
+/*
+ * pool_alloc.cpp
+ * Size-class pool behind ei_malloc / ei_calloc / ei_free. See pool_alloc.h.
+ */
+#include "pool_alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef POOL_ALLOC_HOST
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#else
+// Off-target builds (tools/pool_bench.cpp) are single-threaded: the lock is a
+// no-op and the clock is the host's monotonic one.
+#include <time.h>
+typedef int critical_section_t;
+static inline void critical_section_init(critical_section_t*) {}
+static inline void critical_section_enter_blocking(critical_section_t*) {}
+static inline void critical_section_exit(critical_section_t*) {}
+static inline uint64_t time_us_64() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+#endif
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#define POOL_MAGIC           0xB33Fu
+#define POOL_CLASS_OVERFLOW  0xFF
+
+// 8-byte header in front of every block keeps payloads 8-byte aligned.
+struct BlockHeader {
+    uint8_t cls;
+    uint8_t reserved;
+    uint16_t magic;
+    uint32_t requested;
+};
+
+struct FreeNode {
+    FreeNode* next;
+};
+
+static uint8_t g_pool[POOL_HEAP_SIZE] __attribute__((aligned(16)));
+static uint32_t g_pool_top = 0;
+static FreeNode* g_free_lists[POOL_NUM_CLASSES];
+static PoolStats g_pool_stats;
+static PoolMode g_pool_mode = POOL_MODE_PERSISTENT;
+static uint32_t g_overflow_live = 0;
+static uint32_t g_frame_mark = 0;           // g_pool_top at pool_inference_begin()
+static uint32_t g_frame_live = 0;           // live blocks at or above g_frame_mark
+static critical_section_t g_pool_lock;
+static bool g_pool_ready = false;
+
+static inline uint32_t class_size(int cls) { return 1u << (cls + POOL_MIN_CLASS_SHIFT); }
+
+static int class_for(size_t total) {
+    for (int c = 0; c < POOL_NUM_CLASSES; c++) {
+        if (total <= class_size(c)) return c;
+    }
+    return -1;
+}
+
+// Blocks at or above the frame mark are the ones a rewind would reclaim.
+static inline bool in_frame(const void* h) { return (const uint8_t*)h >= &g_pool[g_frame_mark]; }
+
+static void pool_lazy_init() {
+    if (g_pool_ready) return;
+    critical_section_init(&g_pool_lock);
+    g_pool_ready = true;
+}
+
+// Drops everything carved since the frame mark. Blocks that outlive an
+// inference (e.g. the impulse handle's post-processing state) sit below the
+// mark and are untouched; free-list entries above it are unlinked.
+static void pool_rewind_locked() {
+    for (int c = 0; c < POOL_NUM_CLASSES; c++) {
+        FreeNode** link = &g_free_lists[c];
+        while (*link) {
+            if ((uint8_t*)*link >= &g_pool[g_frame_mark]) *link = (*link)->next;
+            else link = &(*link)->next;
+        }
+    }
+    g_pool_top = g_frame_mark;
+    g_pool_stats.carved = g_pool_top;
+    g_pool_stats.resets++;
+}
+
+static void* pool_alloc(size_t size) {
+    pool_lazy_init();
+    size_t total = size + sizeof(BlockHeader);
+    int cls = class_for(total);
+
+    if (cls < 0) {
+        // Larger than any class: hand to newlib but keep the accounting.
+        BlockHeader* h = (BlockHeader*)malloc(total);
+        if (!h) return NULL;
+        h->cls = POOL_CLASS_OVERFLOW; h->magic = POOL_MAGIC; h->requested = (uint32_t)size;
+        critical_section_enter_blocking(&g_pool_lock);
+        g_pool_stats.overflow++;
+        g_overflow_live++;
+        critical_section_exit(&g_pool_lock);
+        return h + 1;
+    }
+
+    critical_section_enter_blocking(&g_pool_lock);
+    BlockHeader* h = NULL;
+    if (g_free_lists[cls]) {
+        h = (BlockHeader*)g_free_lists[cls];
+        g_free_lists[cls] = g_free_lists[cls]->next;
+    } else if (g_pool_top + class_size(cls) <= POOL_HEAP_SIZE) {
+        h = (BlockHeader*)&g_pool[g_pool_top];
+        g_pool_top += class_size(cls);
+        g_pool_stats.carved = g_pool_top;
+        if (g_pool_top > g_pool_stats.carved_high_water) g_pool_stats.carved_high_water = g_pool_top;
+    }
+
+    if (!h) {
+        g_pool_stats.failures++;
+        critical_section_exit(&g_pool_lock);
+        return NULL;
+    }
+
+    h->cls = (uint8_t)cls; h->magic = POOL_MAGIC; h->requested = (uint32_t)size;
+    g_pool_stats.allocs++;
+    g_pool_stats.live_blocks++;
+    if (in_frame(h)) g_frame_live++;
+    g_pool_stats.in_use += class_size(cls);
+    g_pool_stats.requested += (uint32_t)size;
+    if (g_pool_stats.in_use > g_pool_stats.high_water) g_pool_stats.high_water = g_pool_stats.in_use;
+    if (++g_pool_stats.class_live[cls] > g_pool_stats.class_peak[cls]) g_pool_stats.class_peak[cls] = g_pool_stats.class_live[cls];
+    critical_section_exit(&g_pool_lock);
+    return h + 1;
+}
+
+static void pool_free(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* h = (BlockHeader*)ptr - 1;
+    if (h->magic != POOL_MAGIC) {
+        printf("[POOL] Bad free %p\n", ptr);
+        return;
+    }
+
+    if (h->cls == POOL_CLASS_OVERFLOW) {
+        h->magic = 0;
+        critical_section_enter_blocking(&g_pool_lock);
+        g_overflow_live--;
+        critical_section_exit(&g_pool_lock);
+        free(h);
+        return;
+    }
+
+    int cls = h->cls;
+    critical_section_enter_blocking(&g_pool_lock);
+    g_pool_stats.frees++;
+    g_pool_stats.live_blocks--;
+    if (in_frame(h)) g_frame_live--;
+    g_pool_stats.in_use -= class_size(cls);
+    g_pool_stats.requested -= h->requested;
+    g_pool_stats.class_live[cls]--;
+    h->magic = 0;
+    FreeNode* node = (FreeNode*)h;
+    node->next = g_free_lists[cls];
+    g_free_lists[cls] = node;
+    critical_section_exit(&g_pool_lock);
+}
+
+// --- Edge Impulse porting hooks (override the weak newlib versions) ---
+
+void* ei_malloc(size_t size) {
+    return pool_alloc(size);
+}
+
+void* ei_calloc(size_t nitems, size_t size) {
+    if (size && nitems > SIZE_MAX / size) return NULL;
+    size_t total = nitems * size;
+    void* p = pool_alloc(total);
+    if (p) memset(p, 0, total);
+    return p;
+}
+
+void ei_free(void* ptr) {
+    pool_free(ptr);
+}
+
+// --- Control & statistics ---
+
+void pool_init(PoolMode mode) {
+    pool_lazy_init();
+    g_pool_mode = mode;
+}
+
+void pool_set_mode(PoolMode mode) {
+    g_pool_mode = mode;
+    printf("[POOL] Mode: %s\n", mode == POOL_MODE_RESET ? "reset-per-inference" : "persistent");
+}
+
+PoolMode pool_get_mode() { return g_pool_mode; }
+
+void pool_inference_begin() {
+    pool_lazy_init();
+    critical_section_enter_blocking(&g_pool_lock);
+    g_frame_mark = g_pool_top;
+    g_frame_live = 0;                       // nothing is carved above the top yet
+    critical_section_exit(&g_pool_lock);
+}
+
+void pool_inference_done() {
+    if (g_pool_mode != POOL_MODE_RESET) return;
+    pool_lazy_init();
+    critical_section_enter_blocking(&g_pool_lock);
+    // Counted by address, not by live totals: a block from before the frame
+    // freed during it must not cover for a frame block that is still in use.
+    uint32_t leaked = g_frame_live;
+    if (leaked == 0) pool_rewind_locked();
+    critical_section_exit(&g_pool_lock);
+    if (leaked) printf("[POOL] %u blocks still live, skipping reset\n", (unsigned)leaked);
+}
+
+void pool_get_stats(PoolStats* out) {
+    pool_lazy_init();
+    critical_section_enter_blocking(&g_pool_lock);
+    *out = g_pool_stats;
+    critical_section_exit(&g_pool_lock);
+}
+
+void pool_print_stats() {
+    PoolStats s;
+    pool_get_stats(&s);
+    // Internal: rounding up to the class size. External: carved bytes sitting
+    // in free lists, unusable by other classes until the next reset.
+    float internal = s.in_use ? 100.0f * (1.0f - (float)s.requested / (float)s.in_use) : 0.0f;
+    float external = s.carved ? 100.0f * (float)(s.carved - s.in_use) / (float)s.carved : 0.0f;
+
+    printf("[POOL] Mode: %s, size %u B\n", g_pool_mode == POOL_MODE_RESET ? "reset" : "persistent", POOL_HEAP_SIZE);
+    printf("[POOL] In use: %u B (%u req) in %u blocks, high-water %u B\n",
+           (unsigned)s.in_use, (unsigned)s.requested, (unsigned)s.live_blocks, (unsigned)s.high_water);
+    printf("[POOL] Carved: %u B, peak %u B (%.1f%% of pool)\n",
+           (unsigned)s.carved, (unsigned)s.carved_high_water, 100.0f * s.carved_high_water / POOL_HEAP_SIZE);
+    printf("[POOL] Fragmentation: internal %.1f%%, external %.1f%%\n", internal, external);
+    printf("[POOL] Allocs %u, frees %u, failures %u, overflow %u (%u live), resets %u\n",
+           (unsigned)s.allocs, (unsigned)s.frees, (unsigned)s.failures, (unsigned)s.overflow,
+           (unsigned)g_overflow_live, (unsigned)s.resets);
+    for (int c = 0; c < POOL_NUM_CLASSES; c++) {
+        if (s.class_peak[c] == 0) continue;
+        printf("[POOL]   %5u B: live %u, peak %u\n", (unsigned)class_size(c), s.class_live[c], s.class_peak[c]);
+    }
+}
+
+// Replays the allocation pattern of one summer inference (TFLite arena,
+// output tensor list, DSP matrix, small SDK structs) against malloc and the pool.
+void pool_benchmark(int iterations) {
+    static const size_t sizes[] = { 7764, 16, 80, 24, 48, 128, 512, 32 };
+    const int n = sizeof(sizes) / sizeof(sizes[0]);
+    void* ptrs[n];
+    if (iterations <= 0) iterations = 1000;
+
+    uint64_t t0 = time_us_64();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < n; i++) ptrs[i] = malloc(sizes[i]);
+        for (int i = n - 1; i >= 0; i--) free(ptrs[i]);
+    }
+    uint64_t t_malloc = time_us_64() - t0;
+
+    t0 = time_us_64();
+    for (int it = 0; it < iterations; it++) {
+        for (int i = 0; i < n; i++) ptrs[i] = pool_alloc(sizes[i]);
+        for (int i = n - 1; i >= 0; i--) pool_free(ptrs[i]);
+    }
+    uint64_t t_pool = time_us_64() - t0;
+
+    float ops = 2.0f * n * iterations;
+    printf("[POOL] Bench %d x %d allocs: malloc %.0f ns/op, pool %.0f ns/op (%.1fx)\n",
+           iterations, n, 1000.0f * t_malloc / ops, 1000.0f * t_pool / ops,
+           t_pool ? (float)t_malloc / (float)t_pool : 0.0f);
+}
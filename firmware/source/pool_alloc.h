@@ -0,0 +1,57 @@
+/*
+ * pool_alloc.h
+ * Static size-class pool that backs the Edge Impulse ei_malloc / ei_calloc /
+ * ei_free hooks, keeping SDK allocations (TFLite arena, DSP matrices, output
+ * tensors) off the newlib heap next to the audio buffer.
+ *
+ * Blocks are carved from one static region on first use and recycled through
+ * per-class free lists: O(1), no coalescing, no heap walks. Requests larger
+ * than the biggest class fall through to malloc and are counted as overflow.
+ * All entry points take a critical section, so both cores may allocate.
+ */
+#ifndef POOL_ALLOC_H
+#define POOL_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define POOL_HEAP_SIZE       (48 * 1024)
+#define POOL_MIN_CLASS_SHIFT 4      // 16 B
+#define POOL_NUM_CLASSES     11     // 16 B .. 16 KB
+
+enum PoolMode {
+    POOL_MODE_PERSISTENT = 0,       // free lists live across inferences
+    POOL_MODE_RESET      = 1,       // whole pool rewinds after each inference
+};
+
+struct PoolStats {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;              // class exhausted and pool full
+    uint32_t overflow;              // too large for any class, sent to malloc
+    uint32_t resets;
+    uint32_t live_blocks;
+    uint32_t in_use;                // block bytes handed out (incl. headers)
+    uint32_t requested;             // bytes the callers asked for
+    uint32_t carved;                // bytes taken from the static region
+    uint32_t high_water;            // peak in_use
+    uint32_t carved_high_water;     // peak carved (worst-case pool footprint)
+    uint16_t class_live[POOL_NUM_CLASSES];
+    uint16_t class_peak[POOL_NUM_CLASSES];
+};
+
+void pool_init(PoolMode mode);
+void pool_set_mode(PoolMode mode);
+PoolMode pool_get_mode();
+
+// Bracket each run_classifier call. In POOL_MODE_RESET, done() rewinds the
+// pool to the begin() mark if every block allocated in between was freed,
+// otherwise it reports the leak and keeps going.
+void pool_inference_begin();
+void pool_inference_done();
+
+void pool_get_stats(PoolStats* out);
+void pool_print_stats();
+void pool_benchmark(int iterations);
+
+#endif
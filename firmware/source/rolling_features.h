@@ -0,0 +1,110 @@
+/*
+ * rolling_features.h
+ * Sliding 6 s feature averages for continuous classification.
+ *
+ * The batch path averages 187 windows of one capture. In continuous mode
+ * each window's bin magnitudes, mean square and raw sample sum go into a
+ * ring of ROLL_WINDOWS slots, and running sums are updated on every window:
+ *
+ *   sum += new window;  sum -= window that falls out of the ring
+ *
+ * so the 6 s averages cost O(bins) per window instead of re-running the DSP
+ * over the whole capture. Every `hop` windows (after the ring has filled once)
+ * roll_add() reports that a fresh feature vector is ready. The sums are
+ * rebuilt from the ring once per wrap, which bounds floating-point drift.
+ *
+ * DC removal uses the mean of the raw samples in the ring, i.e. of the last
+ * 6 s, which is what the batch path uses at steady state.
+ *
+ * Fixed arrays only: nothing is allocated after roll_init().
+ */
+#ifndef ROLLING_FEATURES_H
+#define ROLLING_FEATURES_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "bee_dsp.h"
+
+#define ROLL_WINDOWS        187     // (6 s - one window) / hop + 1, as the batch path
+#define ROLL_DEFAULT_HOP    31      // ~1 s of 512-sample windows at 16 kHz
+
+struct RollingFeatures {
+    uint32_t hop;                   // windows between emitted vectors
+    uint32_t head;                  // next slot to write
+    uint32_t count;                 // slots filled, up to ROLL_WINDOWS
+    uint32_t since_emit;
+    float mags[ROLL_WINDOWS][NUM_FREQ_BINS];
+    float mean_square[ROLL_WINDOWS];
+    uint32_t raw_sum[ROLL_WINDOWS]; // sum of the window's 12-bit samples
+    double sum_mags[NUM_FREQ_BINS];
+    double sum_ms;
+    uint64_t sum_raw;
+
+    // Stats since roll_init()
+    uint32_t windows, emits, resums;
+};
+
+static void roll_init(RollingFeatures* r, uint32_t hop) {
+    memset(r, 0, sizeof(*r));
+    r->hop = hop ? hop : ROLL_DEFAULT_HOP;
+}
+
+// DC offset for the next window: mean of the raw samples in the ring, or of
+// the window itself while the ring is empty.
+static float roll_dc(const RollingFeatures* r, const uint16_t* raw) {
+    if (r->count) return (float)((double)r->sum_raw / ((uint64_t)r->count * FFT_SIZE));
+    uint32_t s = 0;
+    for (int i = 0; i < FFT_SIZE; i++) s += raw[i] & 0x0FFF;
+    return (float)s / FFT_SIZE;
+}
+
+static void roll_resum(RollingFeatures* r) {
+    memset(r->sum_mags, 0, sizeof(r->sum_mags));
+    r->sum_ms = 0;
+    r->sum_raw = 0;
+    for (uint32_t w = 0; w < r->count; w++) {
+        for (int k = 0; k < NUM_FREQ_BINS; k++) r->sum_mags[k] += r->mags[w][k];
+        r->sum_ms += r->mean_square[w];
+        r->sum_raw += r->raw_sum[w];
+    }
+    r->resums++;
+}
+
+// Adds one window. Returns true when a hop completes on a full ring.
+static bool roll_add(RollingFeatures* r, const float* mags, float mean_square, uint32_t raw_sum) {
+    uint32_t slot = r->head;
+    if (r->count == ROLL_WINDOWS) {
+        for (int k = 0; k < NUM_FREQ_BINS; k++) r->sum_mags[k] -= r->mags[slot][k];
+        r->sum_ms -= r->mean_square[slot];
+        r->sum_raw -= r->raw_sum[slot];
+    } else {
+        r->count++;
+    }
+    memcpy(r->mags[slot], mags, sizeof(r->mags[slot]));
+    r->mean_square[slot] = mean_square;
+    r->raw_sum[slot] = raw_sum;
+    for (int k = 0; k < NUM_FREQ_BINS; k++) r->sum_mags[k] += mags[k];
+    r->sum_ms += mean_square;
+    r->sum_raw += raw_sum;
+
+    r->head = (slot + 1) % ROLL_WINDOWS;
+    if (r->head == 0) roll_resum(r);
+    r->windows++;
+    if (r->count < ROLL_WINDOWS || ++r->since_emit < r->hop) return false;
+    r->since_emit = 0;
+    r->emits++;
+    return true;
+}
+
+static void roll_bins(const RollingFeatures* r, double* out) {
+    for (int k = 0; k < NUM_FREQ_BINS; k++) out[k] = r->count ? r->sum_mags[k] / r->count : 0.0;
+}
+
+static float roll_density(const RollingFeatures* r) {
+    double ms = r->count ? r->sum_ms / r->count : 0.0;
+    return (float)sqrt(ms > 0.0 ? ms : 0.0);
+}
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ * sample_scheduler.h
+ * Duty-cycled background sampling: job, uplink burst, then idle until due.
+ *
+ * With a cadence set (`b N`, sys_config.sample_interval_s) the main loop runs
+ * capture -> features -> inference whenever sched_due() says so, on a fixed
+ * grid anchored at the first job, so the HISTORY_SIZE rolling window spans a
+ * known time (12 x 15 min = 3 h). A job that overruns a slot skips it rather
+ * than running back to back.
+ *
+ *   |job|uplink|........ idle (nap, radio power save) ........|job|uplink|...
+ *   ^ due                                                     ^ due + interval
+ *
+ * Records are only replayed in the uplink window that follows a job (or a
+ * reconnect, a server or serial command that logged records, a live-mode
+ * label change), until the log is drained or SCHED_UPLINK_MAX_MS passes, so
+ * the radio wakes once per cycle instead of per record. In between, the main
+ * loop naps in bounded steps (SCHED_NAP_MAX_MS keeps the serial console and
+ * command channel responsive) and the radio sits in its power-save mode.
+ *
+ * The logic takes an injected clock and does no I/O besides printf, so
+ * sched_simulate() runs it against a virtual clock on the device (`sched sim`)
+ * or on the host (tools/sched_sim.cpp). Awake time is everything outside naps.
+ */
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SCHED_UPLINK_MAX_MS     30000   // longest uplink burst after a job
+#define SCHED_NAP_MAX_MS        250     // console/command latency bound while idle
+
+struct SampleScheduler {
+    uint64_t (*clock_us)();
+    uint32_t interval_ms;       // 0 = off: no jobs, uplink always open, no naps
+    uint64_t next_due_us;
+    bool in_job;
+    bool uplink;
+    uint64_t uplink_until_us;
+    uint64_t mark_us;           // start of the running job or uplink window
+
+    // Stats since sched_set_interval()
+    uint64_t since_us;
+    uint64_t asleep_us, job_us, uplink_us;
+    uint32_t jobs, skipped, naps, uplinks;
+    uint32_t max_job_ms, max_late_ms;
+};
+
+static void sched_reset_stats(SampleScheduler* s) {
+    s->since_us = s->clock_us();
+    s->asleep_us = s->job_us = s->uplink_us = 0;
+    s->jobs = s->skipped = s->naps = s->uplinks = 0;
+    s->max_job_ms = s->max_late_ms = 0;
+}
+
+static void sched_init(SampleScheduler* s, uint64_t (*clock_us)()) {
+    memset(s, 0, sizeof(*s));
+    s->clock_us = clock_us;
+    sched_reset_stats(s);
+}
+
+// Sets the cadence; the first job is due immediately.
+static void sched_set_interval(SampleScheduler* s, uint32_t interval_s) {
+    s->interval_ms = interval_s * 1000;
+    s->next_due_us = s->clock_us();
+    sched_reset_stats(s);
+}
+
+// True when a job should start now. Advances the grid; slots that already
+// passed (a long job, a blocking command) are skipped and counted.
+static bool sched_due(SampleScheduler* s) {
+    if (!s->interval_ms || s->in_job) return false;
+    uint64_t now = s->clock_us();
+    if (now < s->next_due_us) return false;
+    uint64_t period = (uint64_t)s->interval_ms * 1000;
+    uint32_t late_ms = (uint32_t)((now - s->next_due_us) / 1000);
+    if (late_ms > s->max_late_ms) s->max_late_ms = late_ms;
+    s->next_due_us += period;
+    while (s->next_due_us <= now) { s->next_due_us += period; s->skipped++; }
+    return true;
+}
+
+// Opens an uplink window, e.g. when the link comes back between jobs.
+static void sched_uplink_begin(SampleScheduler* s) {
+    if (s->uplink) return;
+    s->uplink = true;
+    s->uplinks++;
+    s->mark_us = s->clock_us();
+    s->uplink_until_us = s->mark_us + SCHED_UPLINK_MAX_MS * 1000ull;
+}
+
+static void sched_uplink_done(SampleScheduler* s) {
+    if (!s->uplink) return;
+    s->uplink = false;
+    s->uplink_us += s->clock_us() - s->mark_us;
+}
+
+static void sched_job_begin(SampleScheduler* s) {
+    sched_uplink_done(s);
+    s->in_job = true;
+    s->mark_us = s->clock_us();
+}
+
+// Ends a job and opens the uplink window for its records.
+static void sched_job_end(SampleScheduler* s) {
+    uint64_t dt = s->clock_us() - s->mark_us;
+    s->in_job = false;
+    s->jobs++;
+    s->job_us += dt;
+    if (dt / 1000 > s->max_job_ms) s->max_job_ms = (uint32_t)(dt / 1000);
+    sched_uplink_begin(s);
+}
+
+// Whether records may be sent now. Closes the window when its time is up.
+static bool sched_uplink_open(SampleScheduler* s) {
+    if (!s->interval_ms) return true;
+    if (s->uplink && s->clock_us() >= s->uplink_until_us) sched_uplink_done(s);
+    return s->uplink;
+}
+
+// True between jobs and uplinks, when the radio can sit in power save.
+static bool sched_idle(const SampleScheduler* s) {
+    return s->interval_ms && !s->in_job && !s->uplink;
+}
+
+// How long the main loop may nap now, 0 if it should keep polling.
+static uint32_t sched_nap_ms(SampleScheduler* s, bool busy) {
+    if (busy || !sched_idle(s)) return 0;
+    uint64_t now = s->clock_us();
+    if (now >= s->next_due_us) return 0;
+    uint64_t left_ms = (s->next_due_us - now) / 1000;
+    return left_ms < SCHED_NAP_MAX_MS ? (uint32_t)left_ms : SCHED_NAP_MAX_MS;
+}
+
+static void sched_note_sleep(SampleScheduler* s, uint64_t slept_us) {
+    s->asleep_us += slept_us;
+    s->naps++;
+}
+
+static void sched_print_status(SampleScheduler* s, const char* tag) {
+    uint64_t now = s->clock_us();
+    uint64_t total = now - s->since_us;
+    uint64_t awake = total - s->asleep_us;
+    if (!s->interval_ms) printf("[%s] Scheduler off\n", tag);
+    else printf("[%s] Every %u s, next job in %u s%s\n", tag, (unsigned)(s->interval_ms / 1000),
+                (unsigned)(s->next_due_us > now ? (s->next_due_us - now) / 1000000 : 0),
+                s->in_job ? " (running)" : (s->uplink ? " (uplink open)" : ""));
+    printf("[%s] %u jobs (%u slots skipped, max %u ms, max late %u ms), %u uplink windows\n", tag,
+           (unsigned)s->jobs, (unsigned)s->skipped, (unsigned)s->max_job_ms, (unsigned)s->max_late_ms,
+           (unsigned)s->uplinks);
+    printf("[%s] Awake %.1f s of %.1f s (duty cycle %.2f%%): jobs %.1f s, uplink %.1f s, %u naps\n", tag,
+           awake / 1e6, total / 1e6, total ? 100.0 * awake / total : 0.0,
+           s->job_us / 1e6, s->uplink_us / 1e6, (unsigned)s->naps);
+}
+
+// --- Virtual-clock simulation ---
+
+static uint64_t g_sched_vclock_us;
+static uint64_t sched_vclock() { return g_sched_vclock_us; }
+
+// Runs the main-loop shape below for `jobs` jobs on a virtual clock. Each job
+// takes job_ms and leaves uplink_ms of records to send; the uplink drains in
+// loop passes of SCHED_SIM_PASS_US while its window is open and carries what
+// is left to the next window. Reports the resulting duty cycle and the mean
+// period between job starts.
+#define SCHED_SIM_PASS_US   10000
+
+static void sched_simulate(int jobs, uint32_t interval_s, uint32_t job_ms, uint32_t uplink_ms) {
+    if (jobs <= 0) jobs = 96;
+    if (!interval_s) interval_s = 900;
+    SampleScheduler s;
+    g_sched_vclock_us = 0;
+    sched_init(&s, sched_vclock);
+    sched_set_interval(&s, interval_s);
+
+    uint64_t first_start = 0, last_start = 0;
+    uint64_t backlog_us = 0;
+    uint32_t passes = 0;
+    while (s.jobs < (uint32_t)jobs) {
+        passes++;
+        if (sched_due(&s)) {
+            if (!s.jobs) first_start = g_sched_vclock_us;
+            last_start = g_sched_vclock_us;
+            sched_job_begin(&s);
+            g_sched_vclock_us += job_ms * 1000ull;
+            sched_job_end(&s);
+            backlog_us += uplink_ms * 1000ull;
+            continue;
+        }
+        if (s.uplink && sched_uplink_open(&s)) {
+            uint64_t step = backlog_us < SCHED_SIM_PASS_US ? backlog_us : SCHED_SIM_PASS_US;
+            g_sched_vclock_us += step;
+            backlog_us -= step;
+            if (!backlog_us) sched_uplink_done(&s);
+            continue;
+        }
+        uint32_t nap = sched_nap_ms(&s, false);
+        if (nap) { g_sched_vclock_us += nap * 1000ull; sched_note_sleep(&s, nap * 1000ull); }
+        else g_sched_vclock_us += SCHED_SIM_PASS_US;
+    }
+    printf("[SCHED] Sim: %d jobs every %u s, job %u ms, uplink %u ms, %u loop passes\n",
+           jobs, (unsigned)interval_s, (unsigned)job_ms, (unsigned)uplink_ms, (unsigned)passes);
+    if (jobs > 1) printf("[SCHED]   mean period %.3f s, %.1f s of uplink still queued\n",
+                         (last_start - first_start) / 1e6 / (jobs - 1), backlog_us / 1e6);
+    sched_print_status(&s, "SCHED");
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * wake_detector.h
+ * Always-on band-energy detector that decides when the full pipeline runs.
+ *
+ * Between scheduled jobs the ADC keeps sampling at WAKE_RATE_HZ into the DMA
+ * ring and each block goes through wake_feed(): a few integer operations per
+ * sample (DC tracker, one-pole low-pass, square-and-accumulate) give the
+ * block's energy in roughly the 80-440 Hz hum band. Once per block that
+ * energy is compared with a slow baseline of quiet blocks. This is the same
+ * "current vs rolling" ratio as the summer model's spike feature, computed
+ * on a band instead of the full DSP pass:
+ *
+ *   trigger:  WAKE_HOLD_BLOCKS blocks in a row with  E > ratio^2 * baseline
+ *             and E > WAKE_FLOOR, outside the refractory period
+ *
+ * Blocks above the threshold do not move the baseline, so a long event does
+ * not raise its own bar. The scheduler cadence remains as a heartbeat; a
+ * trigger adds a job in between.
+ *
+ * No hardware access: tools/wake_eval.cpp builds this header on a host and
+ * replays recorded WAVs through it.
+ */
+#ifndef WAKE_DETECTOR_H
+#define WAKE_DETECTOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define WAKE_RATE_HZ            4000
+#define WAKE_HP_SHIFT           3       // DC tracker, ~80 Hz at 4 kHz
+#define WAKE_LP_SHIFT           1       // one-pole low-pass, ~440 Hz at 4 kHz
+#define WAKE_BASE_SHIFT         7       // baseline follows quiet blocks over ~128 blocks
+#define WAKE_WARMUP_BLOCKS      16      // blocks averaged before triggering is armed
+#define WAKE_HOLD_BLOCKS        2
+#define WAKE_REFRACTORY_BLOCKS  80      // ~10 s at 512-sample blocks
+#define WAKE_FLOOR              64.0f   // mean square (12-bit ADC counts^2) below which nothing triggers
+#define WAKE_DEFAULT_RATIO      2.0f
+
+struct WakeDetector {
+    float ratio;                // RMS ratio over baseline that counts as a spike
+    int32_t dc;                 // Q4 ADC counts
+    int32_t lp;                 // Q4, band signal
+    float baseline;             // mean square of quiet blocks, ADC counts^2
+    uint32_t above;             // consecutive blocks over the threshold
+    uint32_t refractory;        // blocks left before the next trigger
+
+    // Stats since wake_init()
+    uint32_t blocks, triggers;
+    float last_ratio, peak_ratio;
+};
+
+static void wake_init(WakeDetector* d, float ratio) {
+    memset(d, 0, sizeof(*d));
+    d->ratio = ratio;
+    d->dc = 2048 << 4;
+}
+
+// Feeds one block of 12-bit samples; returns true when it completes a trigger.
+static bool wake_feed(WakeDetector* d, const uint16_t* s, int n) {
+    if (n <= 0) return false;
+    int32_t dc = d->dc, lp = d->lp;
+    int64_t acc = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t x = ((int32_t)(s[i] & 0x0FFF) << 4) - dc;
+        dc += x >> WAKE_HP_SHIFT;
+        lp += (x - lp) >> WAKE_LP_SHIFT;
+        acc += (int64_t)lp * lp;
+    }
+    d->dc = dc; d->lp = lp;
+
+    float e = (float)acc / (float)n / 256.0f;     // Q4^2 -> counts^2
+    d->blocks++;
+    if (d->blocks <= WAKE_WARMUP_BLOCKS) {
+        d->baseline += (e - d->baseline) / (float)d->blocks;
+        return false;
+    }
+
+    d->last_ratio = d->baseline > 0.0f ? sqrtf(e / d->baseline) : 0.0f;
+    if (d->last_ratio > d->peak_ratio) d->peak_ratio = d->last_ratio;
+    bool over = e > d->ratio * d->ratio * d->baseline && e > WAKE_FLOOR;
+    if (!over) {
+        d->above = 0;
+        d->baseline += (e - d->baseline) * (1.0f / (1 << WAKE_BASE_SHIFT));
+    } else {
+        d->above++;
+    }
+    if (d->refractory) { d->refractory--; return false; }
+    if (d->above < WAKE_HOLD_BLOCKS) return false;
+    d->refractory = WAKE_REFRACTORY_BLOCKS;
+    d->triggers++;
+    return true;
+}
+
+#endif
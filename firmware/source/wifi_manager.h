@@ -0,0 +1,221 @@
+/*
+ * wifi_manager.h
+ * Non-blocking WiFi bring-up and reconnection, driven from the main loop.
+ *
+ * Boot used to sit in cyw43_arch_wifi_connect_timeout_ms() for up to 3 x 15 s
+ * (plus 2 s pauses) before sampling could start, and a link lost later was
+ * never noticed. Here the join is started with cyw43_arch_wifi_connect_async()
+ * and wifi_poll() advances a small state machine on every loop pass:
+ *
+ *   JOINING --link up + IP--> UP --link lost--> JOINING (driver rejoin)
+ *      |                                           |
+ *      +--fail/timeout--> BACKOFF --due--> JOINING +
+ *
+ * Failed or timed-out joins leave the AP and retry with exponential backoff
+ * (WIFI_BACKOFF_MIN_MS doubling to WIFI_BACKOFF_MAX_MS). lwIP's link and
+ * status callbacks on the STA netif flag a change; while up, the driver's
+ * link status is only re-read on a callback or every WIFI_CHECK_MS, so a
+ * missed callback delays detection by at most that.
+ * Transitions to and from UP are reported once through the on_change hook,
+ * with the outage length when the link comes back. Sampling runs meanwhile;
+ * records wait in the flash log until the uplink is up.
+ */
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+#include "flash_config.h"
+
+#define WIFI_JOIN_TIMEOUT_MS    20000   // association + DHCP
+#define WIFI_BACKOFF_MIN_MS     2000
+#define WIFI_BACKOFF_MAX_MS     60000
+#define WIFI_CHECK_MS           1000    // link status re-read while up without a callback
+
+enum WifiState { WIFI_OFF = 0, WIFI_JOINING, WIFI_UP, WIFI_BACKOFF };
+
+struct WifiManager {
+    WifiState state;
+    bool ready;                 // cyw43 initialised in STA mode
+    volatile bool changed;      // set by the netif callbacks
+    bool restart;               // rejoin requested by wifi_restart()
+    uint32_t join_started_ms;
+    uint32_t retry_at_ms;
+    uint32_t backoff_ms;
+    uint32_t down_since_ms;     // start of the current outage (boot for the first join)
+    int last_status;            // last cyw43 link status seen
+    uint32_t checked_ms;
+
+    // Stats since boot
+    uint32_t attempts, connects, drops, failures, callbacks;
+    uint32_t first_up_ms;       // boot -> first link with an address, 0 = not yet
+    uint32_t last_outage_ms, max_outage_ms;
+};
+
+static WifiManager g_wifi;
+
+static const char* wifi_state_name(WifiState s) {
+    switch (s) {
+        case WIFI_JOINING: return "joining";
+        case WIFI_UP:      return "up";
+        case WIFI_BACKOFF: return "backoff";
+        default:           return "off";
+    }
+}
+
+static const char* wifi_status_name(int status) {
+    switch (status) {
+        case CYW43_LINK_DOWN:    return "down";
+        case CYW43_LINK_JOIN:    return "joined";
+        case CYW43_LINK_NOIP:    return "no IP";
+        case CYW43_LINK_UP:      return "up";
+        case CYW43_LINK_FAIL:    return "failed";
+        case CYW43_LINK_NONET:   return "no network";
+        case CYW43_LINK_BADAUTH: return "bad auth";
+        default:                 return "?";
+    }
+}
+
+// --- lwIP callbacks (run from cyw43_arch_poll in poll mode) ---
+
+static void wifi_netif_cb(struct netif* netif) {
+    (void)netif;
+    g_wifi.changed = true;
+    g_wifi.callbacks++;
+}
+
+// --- State machine ---
+
+static void wifi_begin_join(uint32_t now) {
+    g_wifi.attempts++;
+    g_wifi.join_started_ms = now;
+    g_wifi.state = WIFI_JOINING;
+    int err = cyw43_arch_wifi_connect_async(sys_config.wifi_ssid, sys_config.wifi_pass, CYW43_AUTH_WPA2_AES_PSK);
+    if (err) printf("[NET] Join request failed (%d)\n", err);
+}
+
+static void wifi_schedule_retry(uint32_t now, int status) {
+    g_wifi.failures++;
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    if (status == CYW43_LINK_BADAUTH) g_wifi.backoff_ms = WIFI_BACKOFF_MAX_MS;
+    else g_wifi.backoff_ms = g_wifi.backoff_ms ? g_wifi.backoff_ms * 2 : WIFI_BACKOFF_MIN_MS;
+    if (g_wifi.backoff_ms > WIFI_BACKOFF_MAX_MS) g_wifi.backoff_ms = WIFI_BACKOFF_MAX_MS;
+    g_wifi.retry_at_ms = now + g_wifi.backoff_ms;
+    g_wifi.state = WIFI_BACKOFF;
+    printf("[NET] Join failed (link %s), retry in %u s\n", wifi_status_name(status), (unsigned)(g_wifi.backoff_ms / 1000));
+}
+
+// Starts the first join without waiting for it. Returns false if the radio
+// could not be initialised or no SSID is configured.
+static bool wifi_init() {
+    memset(&g_wifi, 0, sizeof(g_wifi));
+    if (cyw43_arch_init()) { printf("[ERR] WiFi init failed\n"); return false; }
+    cyw43_arch_enable_sta_mode();
+    g_wifi.ready = true;
+
+    struct netif* n = &cyw43_state.netif[CYW43_ITF_STA];
+    netif_set_link_callback(n, wifi_netif_cb);
+    netif_set_status_callback(n, wifi_netif_cb);
+
+    if (strlen(sys_config.wifi_ssid) == 0) { printf("[NET] No SSID configured\n"); return false; }
+    printf("[NET] Connecting to %s in the background...\n", sys_config.wifi_ssid);
+    wifi_begin_join(to_ms_since_boot(get_absolute_time()));
+    return true;
+}
+
+// Drops the current association and joins again on the next wifi_poll(),
+// e.g. after the credentials changed.
+static void wifi_restart() {
+    if (g_wifi.ready && strlen(sys_config.wifi_ssid) > 0) g_wifi.restart = true;
+}
+
+// Advances the state machine; returns true while the link is up with an
+// address. on_change(up, outage_ms) is called on each transition to or from UP.
+static bool wifi_poll(void (*on_change)(bool up, uint32_t outage_ms)) {
+    if (!g_wifi.ready) return false;
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (g_wifi.restart) {
+        g_wifi.restart = false;
+        cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+        if (g_wifi.state == WIFI_UP) {
+            g_wifi.drops++;
+            g_wifi.down_since_ms = now;
+            if (on_change) on_change(false, 0);
+        }
+        g_wifi.backoff_ms = 0;
+        wifi_begin_join(now);
+        return false;
+    }
+    if (g_wifi.state == WIFI_OFF) return false;
+    if (g_wifi.state == WIFI_UP && !g_wifi.changed && now - g_wifi.checked_ms < WIFI_CHECK_MS) return true;
+    g_wifi.changed = false;
+    g_wifi.checked_ms = now;
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    if (status != g_wifi.last_status) {
+        if (g_wifi.state != WIFI_BACKOFF && status != CYW43_LINK_UP) printf("[NET] Link %s\n", wifi_status_name(status));
+        g_wifi.last_status = status;
+    }
+
+    switch (g_wifi.state) {
+        case WIFI_UP:
+            if (status == CYW43_LINK_UP) return true;
+            // Lost association or address. The driver rejoins on its own at
+            // first; the join timeout falls back to leave + backoff.
+            g_wifi.drops++;
+            g_wifi.down_since_ms = now;
+            g_wifi.join_started_ms = now;
+            g_wifi.state = WIFI_JOINING;
+            printf("[NET] Connection lost (%s)\n", wifi_status_name(status));
+            if (on_change) on_change(false, 0);
+            return false;
+
+        case WIFI_JOINING:
+            if (status == CYW43_LINK_UP) {
+                uint32_t outage = now - g_wifi.down_since_ms;
+                g_wifi.state = WIFI_UP;
+                g_wifi.backoff_ms = 0;
+                g_wifi.connects++;
+                if (!g_wifi.first_up_ms) g_wifi.first_up_ms = now;
+                else {
+                    g_wifi.last_outage_ms = outage;
+                    if (outage > g_wifi.max_outage_ms) g_wifi.max_outage_ms = outage;
+                }
+                printf("[NET] Connected! IP: %s (%u ms)\n",
+                       ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])), (unsigned)outage);
+                if (on_change) on_change(true, outage);
+                return true;
+            }
+            if (status == CYW43_LINK_FAIL || status == CYW43_LINK_NONET || status == CYW43_LINK_BADAUTH ||
+                now - g_wifi.join_started_ms > WIFI_JOIN_TIMEOUT_MS) {
+                wifi_schedule_retry(now, status);
+            }
+            return false;
+
+        case WIFI_BACKOFF:
+            if ((int32_t)(now - g_wifi.retry_at_ms) >= 0) wifi_begin_join(now);
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+static void wifi_print_status() {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    printf("[NET] WiFi %s (link %s), SSID '%s'", wifi_state_name(g_wifi.state),
+           wifi_status_name(g_wifi.last_status), sys_config.wifi_ssid);
+    if (g_wifi.state == WIFI_UP) printf(", IP %s\n", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+    else if (g_wifi.state == WIFI_BACKOFF) printf(", retry in %u ms\n", (unsigned)(g_wifi.retry_at_ms - now));
+    else printf("\n");
+    printf("[NET] %u joins, %u connects, %u drops, %u failed joins, %u link callbacks\n",
+           (unsigned)g_wifi.attempts, (unsigned)g_wifi.connects, (unsigned)g_wifi.drops,
+           (unsigned)g_wifi.failures, (unsigned)g_wifi.callbacks);
+    printf("[NET] First link %u ms after boot, last reconnect %u ms, longest %u ms\n",
+           (unsigned)g_wifi.first_up_ms, (unsigned)g_wifi.last_outage_ms, (unsigned)g_wifi.max_outage_ms);
+}
+
+#endif
@@ -3,10 +3,12 @@
 HappyBees Audio Capture Tool
 
 Captures raw audio from the Pico firmware and saves as WAV file.
-Uses the firmware 'a' command to stream raw ADC samples.
+Uses the firmware 'a' command to stream raw ADC samples, or with --binary
+the 'ab' command to stream CRC-checked, compressed frames (see audio_codec.py).
 
 Usage:
     python tools/audio_capture.py -d /dev/tty.usbmodem2101 -o pico_audio.wav
+    python tools/audio_capture.py -d /dev/tty.usbmodem2101 --binary --codec rice -t 60
     python tools/audio_capture.py --list
 """
 
@@ -26,6 +28,8 @@ except ImportError:
     print("ERROR: pyserial not installed. Run: pip install pyserial")
     sys.exit(1)
 
+import audio_codec
+
 SAMPLE_RATE = 16000
 
 
@@ -110,6 +114,66 @@ def capture_audio(device, duration=6, verbose=False):
     return samples
 
 
+def capture_audio_framed(device, duration=6, codec="rice", verbose=False):
+    """Capture framed binary audio. duration 0 streams until Ctrl+C."""
+    print(f"Connecting to {device}...")
+
+    try:
+        ser = serial.Serial(device, 115200, timeout=10)
+    except serial.SerialException as e:
+        print(f"ERROR: Could not open {device}: {e}")
+        return None
+
+    print("Connected!")
+    time.sleep(0.5)
+    ser.reset_input_buffer()
+
+    label = f"{duration}s" if duration > 0 else "until Ctrl+C"
+    print(f"\nStreaming {codec} audio ({label})...")
+    print("=" * 40)
+    ser.write(f"ab {codec} {duration}\n".encode())
+
+    while True:
+        line = ser.readline().decode('utf-8', errors='ignore').strip()
+        if verbose:
+            print(f"  > {line}")
+        if line.startswith("BIN:"):
+            break
+        if not line or "ERROR" in line:
+            print(f"ERROR: No stream header ({line or 'timeout'})")
+            ser.close()
+            return None
+
+    def read(n):
+        try:
+            return ser.read(n)
+        except KeyboardInterrupt:
+            # Any byte stops the stream; keep reading up to the end frame.
+            ser.write(b"x")
+            return ser.read(n)
+
+    t_start = time.time()
+    samples, stats = audio_codec.read_frames(read, verbose)
+    elapsed = time.time() - t_start
+
+    while True:
+        line = ser.readline().decode('utf-8', errors='ignore').strip()
+        if line.startswith("[STREAM]"):
+            print(line)
+            break
+        if not line:
+            break
+    ser.close()
+
+    raw_bytes = len(samples) * 2
+    print(f"Frames: {stats['frames']}, CRC errors: {stats['crc_errors']}, gaps: {stats['gaps']}")
+    if stats["bytes"]:
+        print(f"Wire: {stats['bytes']} B ({raw_bytes / stats['bytes']:.2f}x vs 16-bit), "
+              f"{stats['bytes'] / max(elapsed, 1e-3) / 1000:.1f} kB/s")
+
+    return np.array(samples, dtype=np.uint16)
+
+
 def process_audio(raw_adc, verbose=False):
     """Process raw ADC data for WAV file."""
     if verbose:
@@ -141,7 +205,10 @@ def main():
     parser = argparse.ArgumentParser(description="HappyBees Audio Capture")
     parser.add_argument('-d', '--device', help='Serial device')
     parser.add_argument('-o', '--output', default='pico_audio.wav', help='Output WAV file')
-    parser.add_argument('-t', '--time', type=int, default=6, help='Capture duration (1-6)')
+    parser.add_argument('-t', '--time', type=int, default=6, help='Capture duration (1-6, or 0 = until Ctrl+C with --binary)')
+    parser.add_argument('--binary', action='store_true', help='Use framed compressed streaming')
+    parser.add_argument('--codec', choices=sorted(audio_codec.CODEC_NAMES), default='rice',
+                        help='Codec for --binary (default: rice)')
     parser.add_argument('--play', action='store_true', help='Play audio after capture')
     parser.add_argument('--list', action='store_true', help='List available ports')
     parser.add_argument('-v', '--verbose', action='store_true')
@@ -155,8 +222,11 @@ def main():
         print("ERROR: No device specified. Use -d /dev/tty.usbmodem* or --list")
         return
 
-    raw_samples = capture_audio(args.device, args.time, args.verbose)
-    if raw_samples is None:
+    if args.binary:
+        raw_samples = capture_audio_framed(args.device, args.time, args.codec, args.verbose)
+    else:
+        raw_samples = capture_audio(args.device, args.time, args.verbose)
+    if raw_samples is None or len(raw_samples) == 0:
         return
 
     processed = process_audio(raw_samples, args.verbose)
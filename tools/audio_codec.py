@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""
+HappyBees Audio Codec
+
+Decoders for the framed binary audio stream and the 12-bit sample codecs
+implemented in firmware/source/audio_codec.h (PACK12, IMA-ADPCM, Rice).
+
+Frame layout (little-endian):
+    sync u16 (0xBEE5) | version u8 | codec u8 | seq u32 | samples u16 |
+    payload_len u16 | payload | crc32 u32 (over header + payload)
+
+Event clips uploaded to the backend (clips/<node>/<id>.<codec>) are the same
+payloads without frame headers: fixed-size blocks of --block-samples samples.
+
+Usage:
+    python tools/audio_codec.py capture.bin -o capture.wav
+    python tools/audio_codec.py clips/pico-hive-001/pico-hive-001-7.adpcm --clip adpcm -o event.wav
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+STREAM_SYNC = 0xBEE5
+STREAM_HDR = struct.Struct("<HBBIHH")
+CRC_BYTES = 4
+
+CODEC_PACK12 = 0
+CODEC_ADPCM = 1
+CODEC_RICE = 2
+CODEC_NAMES = {"pack12": CODEC_PACK12, "adpcm": CODEC_ADPCM, "rice": CODEC_RICE}
+
+RICE_ESCAPE = 16
+RICE_RAW_BITS = 13
+
+IMA_STEP = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+IMA_INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def decode_pack12(payload, n):
+    """3 bytes -> 2 samples; a trailing odd sample uses 2 bytes."""
+    out = []
+    p = 0
+    for _ in range(n // 2):
+        b0, b1, b2 = payload[p], payload[p + 1], payload[p + 2]
+        out.append(b0 | ((b1 & 0x0F) << 8))
+        out.append((b1 >> 4) | (b2 << 4))
+        p += 3
+    if n & 1:
+        out.append(payload[p] | ((payload[p + 1] & 0x0F) << 8))
+    return out
+
+
+def _s16_to_adc(v):
+    return max(0, min(4095, (v >> 4) + 2048))
+
+
+def decode_adpcm(payload, n):
+    """IMA-ADPCM block: predictor i16, index u8, pad, low nibble first."""
+    if n == 0:
+        return []
+    pred, index = struct.unpack_from("<hB", payload, 0)
+    out = [_s16_to_adc(pred)]
+    for i in range(n - 1):
+        byte = payload[4 + (i >> 1)]
+        code = (byte >> 4) if (i & 1) else (byte & 0x0F)
+        step = IMA_STEP[index]
+        delta = step >> 3
+        if code & 4:
+            delta += step
+        if code & 2:
+            delta += step >> 1
+        if code & 1:
+            delta += step >> 2
+        pred = pred - delta if (code & 8) else pred + delta
+        pred = max(-32768, min(32767, pred))
+        index = max(0, min(88, index + IMA_INDEX[code & 7]))
+        out.append(_s16_to_adc(pred))
+    return out
+
+
+class _BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def bit(self):
+        b = (self.data[self.pos >> 3] >> (7 - (self.pos & 7))) & 1
+        self.pos += 1
+        return b
+
+    def bits(self, n):
+        v = 0
+        for _ in range(n):
+            v = (v << 1) | self.bit()
+        return v
+
+
+def decode_rice(payload, n):
+    """Delta + zigzag + Rice(k), k in the first byte, 16-one escape to raw 13 bits."""
+    if n == 0:
+        return []
+    k = payload[0]
+    r = _BitReader(payload[1:])
+    prev = r.bits(12)
+    out = [prev]
+    for _ in range(n - 1):
+        q = 0
+        while q < RICE_ESCAPE and r.bit():
+            q += 1
+        if q == RICE_ESCAPE:
+            u = r.bits(RICE_RAW_BITS)
+        else:
+            u = (q << k) | (r.bits(k) if k else 0)
+        d = (u >> 1) ^ -(u & 1)
+        prev += d
+        out.append(prev)
+    return out
+
+
+DECODERS = {CODEC_PACK12: decode_pack12, CODEC_ADPCM: decode_adpcm, CODEC_RICE: decode_rice}
+
+
+def decode_payload(codec, payload, n):
+    return DECODERS[codec](payload, n)
+
+
+def block_bytes(codec, block_samples):
+    """Encoded size of one fixed-size clip block (PACK12 and ADPCM only)."""
+    if codec == CODEC_ADPCM:
+        return 4 + block_samples // 2
+    if codec == CODEC_PACK12:
+        return (block_samples * 3 + 1) // 2
+    raise ValueError("Clips use fixed-size blocks: pack12 or adpcm")
+
+
+def decode_clip(data, codec, block_samples=512):
+    """Decode a headerless clip made of consecutive fixed-size blocks."""
+    size = block_bytes(codec, block_samples)
+    samples = []
+    for p in range(0, len(data) - size + 1, size):
+        samples.extend(decode_payload(codec, data[p:p + size], block_samples))
+    return samples
+
+
+def read_frames(read, verbose=False):
+    """
+    Parse frames from a byte source (read(n) -> bytes) until the end frame.
+    Resynchronises on the sync word after a CRC failure.
+    Returns (samples, stats).
+    """
+    samples = []
+    stats = {"frames": 0, "crc_errors": 0, "gaps": 0, "bytes": 0}
+    expected_seq = 0
+    buf = b""
+
+    while True:
+        while len(buf) < STREAM_HDR.size:
+            chunk = read(STREAM_HDR.size - len(buf))
+            if not chunk:
+                return samples, stats
+            buf += chunk
+
+        sync, _version, codec, seq, n, plen = STREAM_HDR.unpack_from(buf)
+        if sync != STREAM_SYNC:
+            buf = buf[1:]
+            continue
+
+        body = buf[STREAM_HDR.size:]
+        need = plen + CRC_BYTES - len(body)
+        while need > 0:
+            chunk = read(need)
+            if not chunk:
+                return samples, stats
+            body += chunk
+            need -= len(chunk)
+
+        payload = body[:plen]
+        (crc,) = struct.unpack_from("<I", body, plen)
+        if zlib.crc32(buf[:STREAM_HDR.size] + payload) != crc:
+            stats["crc_errors"] += 1
+            if verbose:
+                print(f"  CRC error at seq {seq}")
+            buf = buf[1:] + body
+            continue
+
+        stats["bytes"] += STREAM_HDR.size + plen + CRC_BYTES
+        buf = body[plen + CRC_BYTES:]
+        if n == 0:
+            return samples, stats
+        if seq != expected_seq:
+            stats["gaps"] += 1
+            if verbose:
+                print(f"  Gap: expected seq {expected_seq}, got {seq}")
+        expected_seq = seq + 1
+        stats["frames"] += 1
+        samples.extend(decode_payload(codec, payload, n))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a framed HappyBees audio stream")
+    parser.add_argument("input", help="Raw binary stream (frames only) or event clip")
+    parser.add_argument("--clip", choices=["pack12", "adpcm"], help="Input is an event clip with this codec")
+    parser.add_argument("--block-samples", type=int, default=512, help="Samples per clip block")
+    parser.add_argument("-o", "--output", default="decoded.wav", help="Output WAV file")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        if args.clip:
+            samples = decode_clip(f.read(), CODEC_NAMES[args.clip], args.block_samples)
+            print(f"Clip: {len(samples)} samples")
+        else:
+            samples, stats = read_frames(f.read, args.verbose)
+            print(f"Frames: {stats['frames']}, CRC errors: {stats['crc_errors']}, gaps: {stats['gaps']}")
+    if not samples:
+        print("ERROR: No samples decoded")
+        sys.exit(1)
+
+    import numpy as np
+    import scipy.io.wavfile
+    from audio_capture import SAMPLE_RATE, process_audio
+
+    scipy.io.wavfile.write(args.output, SAMPLE_RATE, process_audio(np.array(samples, dtype=np.uint16)))
+    print(f"Saved: {args.output}")
+
+
+if __name__ == "__main__":
+    main()
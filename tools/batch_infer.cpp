@@ -0,0 +1,298 @@
+/*
+ * HappyBees Batch Inference Runner
+ *
+ * Runs the summer model over an archive of recordings with the firmware's own
+ * code: the feature stage (firmware/source/bee_features.h over bee_dsp.h) and
+ * run_classifier() from the Edge Impulse SDK on the posix port. This checks a
+ * model or DSP change against recordings without the Python reimplementation
+ * in mac_shim.py.
+ *
+ * Every --every seconds of each WAV (default 6, so back to back) is one 6 s
+ * capture: 187 windows, DC from the mean of the capture, bins averaged and
+ * density = sqrt(mean square), as process_and_compute_features(). The spike
+ * ratio uses the mean density of the file's last BEE_HISTORY_SIZE captures, as
+ * on a node that has recorded the file from its start. Temperature, humidity and
+ * hour are not in the recordings; they are set with --temp, --hum and --hour
+ * (defaults as mac_shim.py and the firmware's fixed hour).
+ *
+ * Files are spread over a work-stealing pool: every worker starts with its
+ * share of the files, takes the next from the back of its own queue and, once
+ * that is empty, steals from the front of another's, so a few long recordings
+ * do not leave the other cores idle. Each worker has its own impulse handle,
+ * feature buffers and DSP state (BEE_DSP_STATE is thread_local here). Rows
+ * are written in input order, whatever the thread count: file, offset,
+ * density, the 20 features, one score per label, the top label and the
+ * cascade gate's p_event.
+ *
+ * --scaling runs the whole batch again at 1, 2, 4 ... --threads workers
+ * without writing rows and prints files/s and speedup per thread count.
+ *
+ * Build (from the repository root; this compiles the SDK too, a few minutes):
+ *   FW=firmware; SDK=$FW/edge-impulse-sdk
+ *   g++ -O2 -std=c++17 -pthread -DTF_LITE_STATIC_MEMORY -DEIDSP_USE_CMSIS_DSP=0 \
+ *       -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN=0 -I $FW -I $FW/source -I $FW/mode_summer \
+ *       -I $SDK/third_party/flatbuffers/include -I $SDK/third_party/gemmlowp -I $SDK/third_party/ruy \
+ *       tools/batch_infer.cpp \
+ *       $(find $SDK/classifier $SDK/dsp $SDK/tensorflow $SDK/porting/posix $FW/mode_summer/tflite-model \
+ *              -name '*.cc' -o -name '*.cpp' -o -name '*.c') \
+ *       -o batch_infer
+ *
+ * Run:
+ *   ./batch_infer recordings/ -o results.csv
+ *   ./batch_infer day1.wav day2.wav --threads 8 --temp 34 --hum 60
+ *   ./batch_infer recordings/ --scaling
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BEE_DSP_STATE static thread_local
+#include "bee_features.h"
+#include "cascade_gate.h"
+#include "wav_reader.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+#define SAMPLE_RATE_HZ      16000
+#define CAPTURE_SECONDS     6
+#define AUDIO_BUFFER_SIZE   (SAMPLE_RATE_HZ * CAPTURE_SECONDS)
+#define NUM_FEATURES        BEE_SUMMER_FEATURES
+
+struct Options {
+    float gain = 0.4f;                  // CONFIG_DEFAULT_GAIN
+    float temp = 25.0f, hum = 50.0f, hour = BEE_DEFAULT_HOUR;
+    double every_s = CAPTURE_SECONDS;
+};
+
+struct Row {
+    double offset_s;
+    float density;
+    float features[NUM_FEATURES];
+    float scores[EI_CLASSIFIER_LABEL_COUNT];
+    int top;                            // index of the highest score, -1 if run_classifier failed
+    float p_event;
+};
+
+struct FileResult {
+    bool ok = false;
+    std::vector<Row> rows;
+};
+
+// One worker's files. The owner pops from the back, thieves take the front.
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> files;
+};
+
+struct Worker {
+    ei_impulse_handle_t handle;
+    std::vector<uint16_t> adc;
+    BeeHistory history;
+
+    Worker() : handle(ei_default_impulse.impulse) { }
+};
+
+static void classify(Worker* w, Row* row) {
+    signal_t signal;
+    numpy::signal_from_buffer(row->features, NUM_FEATURES, &signal);
+    ei_impulse_result_t result = {0};
+    row->top = -1;
+    if (run_classifier(&w->handle, &signal, &result, false) != EI_IMPULSE_OK) return;
+    row->top = 0;
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        row->scores[ix] = result.classification[ix].value;
+        if (row->scores[ix] > row->scores[row->top]) row->top = (int)ix;
+    }
+}
+
+static void run_file(Worker* w, const Options& opt, const std::string& path, FileResult* out) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    out->rows.clear();
+    if (!wav_read_pcm16(path.c_str(), &pcm, &rate)) return;
+    if (rate != SAMPLE_RATE_HZ) { fprintf(stderr, "%s: %u Hz, need %d Hz\n", path.c_str(), rate, SAMPLE_RATE_HZ); return; }
+    w->adc.resize(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) w->adc[i] = wav_to_adc(pcm[i]);
+
+    bee_history_clear(&w->history);
+    const size_t step = std::max<size_t>(1, (size_t)(opt.every_s * SAMPLE_RATE_HZ));
+    BeeCapture cap;
+    for (size_t off = 0; off + AUDIO_BUFFER_SIZE <= w->adc.size(); off += step) {
+        Row row;
+        memset(&row, 0, sizeof(row));
+        row.offset_s = off / (double)SAMPLE_RATE_HZ;
+        row.density = bee_capture_samples(&cap, &w->adc[off], AUDIO_BUFFER_SIZE, opt.gain);
+        bee_history_push(&w->history, row.density);
+        bee_summer_vector(cap.bins, opt.temp, opt.hum, opt.hour, bee_spike_ratio(&w->history, row.density),
+                          row.features);
+        classify(w, &row);
+        row.p_event = gate_p_event(row.features);
+        out->rows.push_back(row);
+    }
+    out->ok = true;
+}
+
+// Next file for worker `self`: its own queue first, then steal.
+static bool next_file(std::vector<WorkQueue>& queues, size_t self, size_t* file) {
+    {
+        std::lock_guard<std::mutex> guard(queues[self].lock);
+        if (!queues[self].files.empty()) {
+            *file = queues[self].files.back();
+            queues[self].files.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkQueue& victim = queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.files.empty()) {
+            *file = victim.files.front();
+            victim.files.pop_front();
+            return true;
+        }
+    }
+    return false;   // files are only ever removed, so every queue is empty for good
+}
+
+// Runs all files on `threads` workers; returns the wall time in seconds.
+static double run_batch(const std::vector<std::string>& paths, const Options& opt, size_t threads,
+                        std::vector<FileResult>* results, uint64_t* steals) {
+    std::vector<WorkQueue> queues(threads);
+    for (size_t i = 0; i < paths.size(); i++) queues[i % threads].files.push_back(i);
+    results->assign(paths.size(), FileResult());
+    std::atomic<uint64_t> stolen(0);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            Worker w;
+            size_t file;
+            while (next_file(queues, t, &file)) {
+                if (file % threads != t) stolen++;
+                run_file(&w, opt, paths[file], &(*results)[file]);
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    *steals = stolen;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool is_wav(const std::filesystem::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return ext == ".wav";
+}
+
+static void collect(const char* arg, std::vector<std::string>* paths) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(arg, ec)) {
+        std::vector<std::string> found;
+        for (auto it = std::filesystem::recursive_directory_iterator(arg, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && is_wav(it->path())) found.push_back(it->path().string());
+        }
+        std::sort(found.begin(), found.end());
+        paths->insert(paths->end(), found.begin(), found.end());
+    }
+    else {
+        paths->push_back(arg);
+    }
+}
+
+static void write_csv(FILE* f, const std::vector<std::string>& paths, const std::vector<FileResult>& results) {
+    fprintf(f, "file,offset_s,density,temp,hum,hour,spike");
+    for (int k = 4; k < NUM_FEATURES; k++) fprintf(f, ",bin%d", k);
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) fprintf(f, ",%s", ei_classifier_inferencing_categories[ix]);
+    fprintf(f, ",label,p_event\n");
+    for (size_t i = 0; i < paths.size(); i++) {
+        for (const Row& r : results[i].rows) {
+            fprintf(f, "%s,%.3f,%.6g", paths[i].c_str(), r.offset_s, r.density);
+            for (int k = 0; k < NUM_FEATURES; k++) fprintf(f, ",%.6g", r.features[k]);
+            for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) fprintf(f, ",%.5f", r.scores[ix]);
+            fprintf(f, ",%s,%.5f\n", r.top >= 0 ? ei_classifier_inferencing_categories[r.top] : "error", r.p_event);
+        }
+    }
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s dir|file.wav... [-o out.csv] [--threads N] [--every S] [--gain G]\n"
+                    "       [--temp C] [--hum RH] [--hour H] [--scaling]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    Options opt;
+    const char* out_path = NULL;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool scaling = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = (size_t)std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--every") && i + 1 < argc) opt.every_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--gain") && i + 1 < argc) opt.gain = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--temp") && i + 1 < argc) opt.temp = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hum") && i + 1 < argc) opt.hum = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hour") && i + 1 < argc) opt.hour = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--scaling")) scaling = true;
+        else if (argv[i][0] == '-') { usage(argv[0]); return 1; }
+        else collect(argv[i], &paths);
+    }
+    if (paths.empty()) { usage(argv[0]); return 1; }
+    if (opt.every_s <= 0) opt.every_s = CAPTURE_SECONDS;
+
+    bee_dsp_init();
+    // The TFLite engine maps the model on its first call through function
+    // statics; make that call here, before the workers race for it.
+    {
+        Worker w;
+        Row row;
+        memset(&row, 0, sizeof(row));
+        classify(&w, &row);
+        if (row.top < 0) { fprintf(stderr, "run_classifier failed\n"); return 1; }
+    }
+
+    std::vector<FileResult> results;
+    uint64_t steals;
+    double secs = run_batch(paths, opt, threads, &results, &steals);
+
+    size_t files = 0, captures = 0, errors = 0;
+    for (const FileResult& r : results) {
+        if (!r.ok) continue;
+        files++;
+        captures += r.rows.size();
+        for (const Row& row : r.rows) if (row.top < 0) errors++;
+    }
+    FILE* f = out_path ? fopen(out_path, "w") : stdout;
+    if (!f) { fprintf(stderr, "%s: cannot write\n", out_path); return 1; }
+    if (!scaling || out_path) write_csv(f, paths, results);
+    if (out_path) fclose(f);
+
+    fprintf(stderr, "%zu of %zu files, %zu captures (%.1f h of audio) in %.2f s on %zu threads: "
+                    "%.1f files/s, %.0f captures/s, %llu stolen\n",
+            files, paths.size(), captures, captures * opt.every_s / 3600.0, secs, threads,
+            files / secs, captures / secs, (unsigned long long)steals);
+    if (errors) fprintf(stderr, "run_classifier failed on %zu captures\n", errors);
+
+    if (scaling) {
+        fprintf(stderr, "\nthreads   seconds   files/s   speedup   efficiency\n");
+        double base = 0;
+        for (size_t t = 1; ; t = std::min(t * 2, threads)) {
+            double s = run_batch(paths, opt, t, &results, &steals);
+            if (t == 1) base = s;
+            fprintf(stderr, "%7zu %9.2f %9.1f %8.2fx %10.0f%%\n", t, s, files / s, base / s, 100.0 * base / s / t);
+            if (t == threads) break;
+        }
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * HappyBees Feature Extension
+ *
+ * CPython binding of firmware/source/bee_features.h, the summer feature stage
+ * main.cpp runs on the node. bee_features.py wraps it with the NumPy API;
+ * this file only moves buffers in and out:
+ *
+ *   capture_features(adc, n, length, gain, threads, bins_out, density_out)
+ *       n captures of `length` uint16 ADC samples each, back to back, into
+ *       n x NUM_FREQ_BINS float64 bin means and n float32 densities. The
+ *       captures are split over `threads` workers (0: one per core) with the
+ *       GIL released; each has its own filter state (BEE_DSP_STATE is
+ *       thread_local here), so the result does not depend on the split.
+ *
+ *   summer_features(bins, density, temp, hum, hour, history, n, out)
+ *       n consecutive captures into n x BEE_SUMMER_FEATURES float32 vectors,
+ *       the spike ratio running over `history` (float32 densities of the
+ *       captures before, oldest first) and then over these captures.
+ *
+ * All buffers must be C-contiguous; sizes are checked against n, dtypes are
+ * the wrapper's job.
+ *
+ * Build: see setup.py.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#define BEE_DSP_STATE static thread_local
+#include "bee_features.h"
+
+static bool check_size(const Py_buffer* buf, Py_ssize_t expected, const char* name) {
+    if (buf->len != expected) {
+        PyErr_Format(PyExc_ValueError, "%s: %zd bytes, expected %zd", name, buf->len, expected);
+        return false;
+    }
+    return true;
+}
+
+static void capture_range(const uint16_t* adc, size_t length, float gain, size_t begin, size_t end,
+                          double* bins, float* density) {
+    BeeCapture cap;
+    for (size_t i = begin; i < end; i++) {
+        density[i] = bee_capture_samples(&cap, adc + i * length, length, gain);
+        memcpy(bins + i * NUM_FREQ_BINS, cap.bins, sizeof(cap.bins));
+    }
+}
+
+static PyObject* capture_features(PyObject*, PyObject* args) {
+    Py_buffer adc, bins, density;
+    Py_ssize_t n, length;
+    float gain;
+    int threads;
+    if (!PyArg_ParseTuple(args, "y*nnfiw*w*", &adc, &n, &length, &gain, &threads, &bins, &density)) return NULL;
+
+    PyObject* ret = NULL;
+    if (n < 0 || length < 0) {
+        PyErr_SetString(PyExc_ValueError, "n and length must be >= 0");
+    } else if (check_size(&adc, n * length * (Py_ssize_t)sizeof(uint16_t), "adc") &&
+               check_size(&bins, n * NUM_FREQ_BINS * (Py_ssize_t)sizeof(double), "bins_out") &&
+               check_size(&density, n * (Py_ssize_t)sizeof(float), "density_out")) {
+        size_t workers = threads > 0 ? (size_t)threads : std::max(1u, std::thread::hardware_concurrency());
+        workers = std::min(workers, std::max<size_t>(1, (size_t)n));
+        const uint16_t* a = (const uint16_t*)adc.buf;
+        double* b = (double*)bins.buf;
+        float* d = (float*)density.buf;
+
+        Py_BEGIN_ALLOW_THREADS
+        if (workers == 1) {
+            capture_range(a, (size_t)length, gain, 0, (size_t)n, b, d);
+        } else {
+            std::vector<std::thread> pool;
+            for (size_t t = 0; t < workers; t++) {
+                size_t begin = (size_t)n * t / workers, end = (size_t)n * (t + 1) / workers;
+                pool.emplace_back(capture_range, a, (size_t)length, gain, begin, end, b, d);
+            }
+            for (std::thread& th : pool) th.join();
+        }
+        Py_END_ALLOW_THREADS
+
+        ret = Py_None;
+        Py_INCREF(ret);
+    }
+    PyBuffer_Release(&adc);
+    PyBuffer_Release(&bins);
+    PyBuffer_Release(&density);
+    return ret;
+}
+
+static PyObject* summer_features(PyObject*, PyObject* args) {
+    Py_buffer bins, density, temp, hum, hour, history, out;
+    Py_ssize_t n;
+    if (!PyArg_ParseTuple(args, "y*y*y*y*y*y*nw*", &bins, &density, &temp, &hum, &hour, &history, &n, &out)) {
+        return NULL;
+    }
+
+    PyObject* ret = NULL;
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must be >= 0");
+    } else if (check_size(&bins, n * NUM_FREQ_BINS * (Py_ssize_t)sizeof(double), "bins") &&
+               check_size(&density, n * (Py_ssize_t)sizeof(float), "density") &&
+               check_size(&temp, n * (Py_ssize_t)sizeof(float), "temp") &&
+               check_size(&hum, n * (Py_ssize_t)sizeof(float), "hum") &&
+               check_size(&hour, n * (Py_ssize_t)sizeof(float), "hour") &&
+               check_size(&out, n * BEE_SUMMER_FEATURES * (Py_ssize_t)sizeof(float), "out")) {
+        const float* prior = (const float*)history.buf;
+        size_t prior_count = (size_t)history.len / sizeof(float);
+        BeeHistory h;
+        bee_history_clear(&h);
+        for (size_t i = prior_count > BEE_HISTORY_SIZE ? prior_count - BEE_HISTORY_SIZE : 0; i < prior_count; i++) {
+            bee_history_push(&h, prior[i]);
+        }
+
+        const double* b = (const double*)bins.buf;
+        const float* d = (const float*)density.buf;
+        const float* t = (const float*)temp.buf;
+        const float* rh = (const float*)hum.buf;
+        const float* hr = (const float*)hour.buf;
+        float* o = (float*)out.buf;
+        for (Py_ssize_t i = 0; i < n; i++) {
+            bee_history_push(&h, d[i]);
+            bee_summer_vector(b + i * NUM_FREQ_BINS, t[i], rh[i], hr[i], bee_spike_ratio(&h, d[i]),
+                              o + i * BEE_SUMMER_FEATURES);
+        }
+        ret = Py_None;
+        Py_INCREF(ret);
+    }
+    PyBuffer_Release(&bins);
+    PyBuffer_Release(&density);
+    PyBuffer_Release(&temp);
+    PyBuffer_Release(&hum);
+    PyBuffer_Release(&hour);
+    PyBuffer_Release(&history);
+    PyBuffer_Release(&out);
+    return ret;
+}
+
+static PyMethodDef methods[] = {
+    { "capture_features", capture_features, METH_VARARGS, "Bin means and densities of n captures." },
+    { "summer_features", summer_features, METH_VARARGS, "Summer model vectors of n consecutive captures." },
+    { NULL, NULL, 0, NULL },
+};
+
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "_bee_features", "Firmware summer feature stage (bee_features.h).", -1, methods,
+};
+
+PyMODINIT_FUNC PyInit__bee_features(void) {
+    bee_dsp_init();     // shared tables, before any worker runs
+    PyObject* m = PyModule_Create(&module);
+    if (!m) return NULL;
+    PyModule_AddIntConstant(m, "FFT_SIZE", FFT_SIZE);
+    PyModule_AddIntConstant(m, "FFT_HOP", FFT_HOP);
+    PyModule_AddIntConstant(m, "NUM_FREQ_BINS", NUM_FREQ_BINS);
+    PyModule_AddIntConstant(m, "FIRST_BIN", BEE_FIRST_BIN);
+    PyModule_AddIntConstant(m, "SUMMER_FEATURES", BEE_SUMMER_FEATURES);
+    PyModule_AddIntConstant(m, "HISTORY_SIZE", BEE_HISTORY_SIZE);
+    PyModule_AddIntConstant(m, "DSP_FIXED", BEE_DSP_FIXED);
+    return m;
+}
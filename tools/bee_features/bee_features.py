@@ -0,0 +1,96 @@
+"""
+HappyBees Feature Library
+
+The firmware's summer feature stage (firmware/source/bee_features.h) for
+Python, through the _bee_features extension: the same biquads, window and DFT
+in the same float arithmetic as the node, so features computed here match the
+firmware's bit for bit. Batches of captures run on all cores with the GIL
+released.
+
+Build the extension first (see setup.py):
+    pip install ./tools/bee_features
+
+Usage:
+    import bee_features as bf
+    adc = bf.wav_to_adc(pcm16)                         # int16 WAV samples
+    bins, density = bf.capture_features(adc.reshape(-1, bf.CAPTURE_SAMPLES))
+    x = bf.summer_features(bins, density, temp=25.0, hum=50.0)
+"""
+
+import numpy as np
+
+import _bee_features as _ext
+
+SAMPLE_RATE = 16000
+CAPTURE_SECONDS = 6
+CAPTURE_SAMPLES = SAMPLE_RATE * CAPTURE_SECONDS
+DEFAULT_GAIN = 0.4      # CONFIG_DEFAULT_GAIN
+DEFAULT_HOUR = 14.0     # the node has no wall clock
+
+FFT_SIZE = _ext.FFT_SIZE
+NUM_FREQ_BINS = _ext.NUM_FREQ_BINS
+FIRST_BIN = _ext.FIRST_BIN
+SUMMER_FEATURES = _ext.SUMMER_FEATURES
+HISTORY_SIZE = _ext.HISTORY_SIZE
+
+
+def wav_to_adc(pcm):
+    """int16 PCM (as audio_capture.py records) to 12-bit ADC counts, as tools/wav_reader.h."""
+    pcm = np.asarray(pcm)
+    if pcm.dtype != np.int16:
+        raise TypeError(f"expected int16 samples, got {pcm.dtype}")
+    # C division truncates towards zero
+    v = np.trunc(pcm.astype(np.int32) / 16).astype(np.int32) + 2048
+    return np.clip(v, 0, 4095).astype(np.uint16)
+
+
+def float_to_adc(audio):
+    """Float audio in [-1, 1] (a sound card) to 12-bit ADC counts around mid-scale."""
+    v = np.rint(np.asarray(audio, dtype=np.float64) * 2048.0) + 2048
+    return np.clip(v, 0, 4095).astype(np.uint16)
+
+
+def capture_features(adc, gain=DEFAULT_GAIN, threads=0):
+    """Bin means and density of each capture.
+
+    adc: uint16 ADC samples, one capture (1-D) or one capture per row (2-D).
+    Returns (bins, density): float64 [n, NUM_FREQ_BINS] and float32 [n], or
+    [NUM_FREQ_BINS] and a float for a single capture. threads=0 uses every core.
+    """
+    adc = np.ascontiguousarray(adc, dtype=np.uint16)
+    single = adc.ndim == 1
+    if single:
+        adc = adc[np.newaxis, :]
+    if adc.ndim != 2:
+        raise ValueError("adc must be 1-D or 2-D")
+    n, length = adc.shape
+    bins = np.empty((n, NUM_FREQ_BINS), dtype=np.float64)
+    density = np.empty(n, dtype=np.float32)
+    _ext.capture_features(adc, n, length, float(gain), int(threads), bins, density)
+    if single:
+        return bins[0], float(density[0])
+    return bins, density
+
+
+def summer_features(bins, density, temp=25.0, hum=50.0, hour=DEFAULT_HOUR, history=None):
+    """Summer model input for consecutive captures, as fill_summer_features().
+
+    bins, density: capture_features() of the captures in order. temp, hum and
+    hour are scalars or one value per capture. history: densities of earlier
+    captures (oldest first) for the spike ratio; none for a fresh node.
+    Returns float32 [n, SUMMER_FEATURES].
+    """
+    bins = np.ascontiguousarray(np.atleast_2d(bins), dtype=np.float64)
+    density = np.ascontiguousarray(np.atleast_1d(density), dtype=np.float32)
+    n = len(density)
+    if bins.shape != (n, NUM_FREQ_BINS):
+        raise ValueError(f"bins must be [{n}, {NUM_FREQ_BINS}], got {list(bins.shape)}")
+
+    def per_capture(v):
+        return np.ascontiguousarray(np.broadcast_to(np.asarray(v, dtype=np.float32), (n,)))
+
+    prior = np.ascontiguousarray(np.zeros(0) if history is None else history, dtype=np.float32)
+    out = np.empty((n, SUMMER_FEATURES), dtype=np.float32)
+    _ext.summer_features(bins, density, per_capture(temp), per_capture(hum), per_capture(hour),
+                         prior, n, out)
+    return out
@@ -0,0 +1,30 @@
+"""
+Builds the bee_features module (the firmware feature stage for Python).
+
+    pip install ./tools/bee_features
+    # or, to use it from this directory:
+    cd tools/bee_features && python setup.py build_ext --inplace
+"""
+
+import os
+from setuptools import Extension, setup
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FIRMWARE_SOURCE = os.path.normpath(os.path.join(HERE, '..', '..', 'firmware', 'source'))
+
+setup(
+    name='bee_features',
+    version='0.1.0',
+    description='HappyBees firmware feature stage',
+    py_modules=['bee_features'],
+    ext_modules=[
+        Extension(
+            '_bee_features',
+            sources=['_bee_features.cpp'],
+            include_dirs=[FIRMWARE_SOURCE],
+            extra_compile_args=['-O2', '-std=c++17'],
+            language='c++',
+        ),
+    ],
+    install_requires=['numpy'],
+)
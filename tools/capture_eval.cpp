@@ -0,0 +1,202 @@
+/*
+ * HappyBees Adaptive Capture Evaluator
+ *
+ * Replays recorded WAVs through the firmware's feature DSP
+ * (firmware/source/bee_dsp.h) and adaptive stopping rule
+ * (firmware/source/feature_estimator.h), both built unchanged, and compares
+ * the adaptive features with those of a fixed 6 s capture at the same spot.
+ *
+ * Every --every seconds of each recording is one capture, run two ways: the
+ * fixed batch path (187 windows, DC from the mean of the whole capture) and
+ * the adaptive one (windows streamed with the running-mean DC until
+ * est_done()). Both are scored against the batch features of the longest
+ * adaptive capture (EST_MAX_WINDOWS) at the same spot, which stands in for the
+ * true averages. The error of a capture is the largest relative error over
+ * bins 4..19 and density; the table gives its mean and 90th percentile for
+ * both paths, with the adaptive mean and longest capture time and how many
+ * captures ran past 6 s or hit the maximum.
+ *
+ * WAVs are 16-bit PCM at 16 kHz as written by audio_capture.py, mapped back
+ * to 12-bit counts with that tool's scaling (int16 = (adc - mean) / 2048 * 32767).
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -I firmware/source tools/capture_eval.cpp -o capture_eval
+ *   ./capture_eval day1.wav day2.wav
+ *   ./capture_eval day1.wav day2.wav --every 30 --sweep 0.02 0.10 0.01
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bee_dsp.h"
+#include "feature_estimator.h"
+#include "wav_reader.h"
+
+#define SAMPLE_RATE_HZ      16000
+#define CAPTURE_SECONDS     6
+#define AUDIO_BUFFER_SIZE   (SAMPLE_RATE_HZ * CAPTURE_SECONDS)
+#define GAIN                0.4f        // CONFIG_DEFAULT_GAIN
+
+struct Recording {
+    std::string name;
+    std::vector<uint16_t> adc;
+};
+
+struct Features {
+    double bins[NUM_FREQ_BINS];
+    double density;
+    uint32_t windows;
+};
+
+struct Result {
+    int captures, extended, capped;
+    double seconds, max_seconds;
+    std::vector<double> err_fixed, err_adaptive;   // per capture, worst feature
+};
+
+static bool load_recording(const char* path, Recording* rec) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    if (!wav_read_pcm16(path, &pcm, &rate)) return false;
+    if (rate != SAMPLE_RATE_HZ) { fprintf(stderr, "%s: %u Hz, need %d Hz\n", path, rate, SAMPLE_RATE_HZ); return false; }
+    rec->name = wav_base_name(path);
+    rec->adc.resize(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) rec->adc[i] = wav_to_adc(pcm[i]);
+    return true;
+}
+
+// process_and_compute_features() over `samples`, DC from their mean.
+static void features_fixed(const uint16_t* s, int samples, Features* f) {
+    double dc = 0;
+    for (int i = 0; i < samples; i++) dc += s[i];
+    dc /= samples;
+    memset(f, 0, sizeof(*f));
+    f->windows = (samples - FFT_SIZE) / FFT_HOP + 1;
+    reset_filters();
+    double sumsq = 0;
+    float mags[NUM_FREQ_BINS];
+    for (uint32_t w = 0; w < f->windows; w++) {
+        sumsq += bee_dsp_window(s + w * FFT_HOP, (float)dc, GAIN, mags);
+        for (int k = 0; k < NUM_FREQ_BINS; k++) f->bins[k] += mags[k];
+    }
+    for (int k = 0; k < NUM_FREQ_BINS; k++) f->bins[k] /= f->windows;
+    f->density = sqrt(sumsq / (f->windows * FFT_SIZE));
+}
+
+// capture_and_process_adaptive(): windows as they arrive, running-mean DC.
+static void features_adaptive(const uint16_t* s, float rel_ci, Features* f) {
+    FeatureEstimator est;
+    est_init(&est, rel_ci);
+    float mags[NUM_FREQ_BINS];
+    uint64_t sum = 0, count = 0;
+    reset_filters();
+    while (!est_done(&est)) {
+        const uint16_t* blk = s + est.n * FFT_SIZE;
+        for (int i = 0; i < FFT_SIZE; i++) sum += blk[i];
+        count += FFT_SIZE;
+        double sumsq = bee_dsp_window(blk, (float)((double)sum / count), GAIN, mags);
+        est_add(&est, mags, sumsq / FFT_SIZE);
+    }
+    for (int k = 0; k < NUM_FREQ_BINS; k++) f->bins[k] = est.mean[k];
+    f->density = est_density(&est);
+    f->windows = est.n;
+}
+
+// Largest relative error over the features the summer model uses.
+static double worst_error(const Features& f, const Features& truth) {
+    double worst = fabs(f.density - truth.density) / truth.density;
+    for (int k = EST_FIRST_BIN; k <= EST_LAST_BIN; k++) {
+        double e = fabs(f.bins[k] - truth.bins[k]) / truth.bins[k];
+        if (e > worst) worst = e;
+    }
+    return worst;
+}
+
+static Result evaluate(const std::vector<Recording>& recs, float rel_ci, double every_s, bool verbose) {
+    Result r = {0, 0, 0, 0, 0, {}, {}};
+    const int need = EST_MAX_WINDOWS * FFT_SIZE;
+    const size_t step = (size_t)(every_s * SAMPLE_RATE_HZ);
+    for (const Recording& rec : recs) {
+        for (size_t off = 0; off + need <= rec.adc.size(); off += step) {
+            Features truth, fixed, ad;
+            features_fixed(&rec.adc[off], need, &truth);
+            if (truth.density <= 0) continue;
+            features_fixed(&rec.adc[off], AUDIO_BUFFER_SIZE, &fixed);
+            features_adaptive(&rec.adc[off], rel_ci, &ad);
+            double secs = ad.windows * (double)FFT_SIZE / SAMPLE_RATE_HZ;
+            r.captures++;
+            r.seconds += secs;
+            if (secs > r.max_seconds) r.max_seconds = secs;
+            if (ad.windows > fixed.windows) r.extended++;
+            if (ad.windows >= EST_MAX_WINDOWS) r.capped++;
+            r.err_fixed.push_back(worst_error(fixed, truth));
+            r.err_adaptive.push_back(worst_error(ad, truth));
+            if (verbose) printf("  %-32s %7.1f s  %5.2f s  error fixed %5.1f%%, adaptive %5.1f%%\n",
+                                rec.name.c_str(), off / (double)SAMPLE_RATE_HZ, secs,
+                                r.err_fixed.back() * 100.0, r.err_adaptive.back() * 100.0);
+        }
+    }
+    return r;
+}
+
+static double mean_of(const std::vector<double>& v) {
+    double sum = 0;
+    for (double x : v) sum += x;
+    return v.empty() ? 0.0 : sum / v.size();
+}
+
+static double p90_of(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[(v.size() - 1) * 9 / 10];
+}
+
+static void print_row(float rel_ci, const Result& r) {
+    if (!r.captures) { printf("%5.1f%%  no captures\n", rel_ci * 100.0f); return; }
+    printf("%5.1f%% %8d %7.2f s %6.2f s %5d/%-3d %7.1f%% %6.1f%% %9.1f%% %6.1f%%\n", rel_ci * 100.0f, r.captures,
+           r.seconds / r.captures, r.max_seconds, r.extended, r.capped,
+           100.0 * mean_of(r.err_fixed), 100.0 * p90_of(r.err_fixed),
+           100.0 * mean_of(r.err_adaptive), 100.0 * p90_of(r.err_adaptive));
+}
+
+int main(int argc, char** argv) {
+    std::vector<Recording> recs;
+    float rel_ci = EST_DEFAULT_CI, sweep_lo = 0, sweep_hi = 0, sweep_step = 0;
+    double every_s = 60.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--ci") && i + 1 < argc) rel_ci = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--every") && i + 1 < argc) every_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--sweep") && i + 3 < argc) {
+            sweep_lo = (float)atof(argv[++i]); sweep_hi = (float)atof(argv[++i]); sweep_step = (float)atof(argv[++i]);
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s file.wav... [--ci FRACTION] [--every S] [--sweep LO HI STEP]\n", argv[0]);
+            return 1;
+        }
+        else {
+            Recording rec;
+            if (load_recording(argv[i], &rec)) recs.push_back(std::move(rec));
+        }
+    }
+    if (recs.empty()) { fprintf(stderr, "no recordings\n"); return 1; }
+    if (every_s <= 0) every_s = 60.0;
+
+    bee_dsp_init();
+    printf("%zu recordings, a capture every %.0f s, fixed %d s, adaptive %d..%d windows\n\n",
+           recs.size(), every_s, CAPTURE_SECONDS, EST_MIN_WINDOWS, EST_MAX_WINDOWS);
+    const char* header = "                                             fixed 6 s        adaptive\n"
+                         "    CI captures    mean      max  >6s/max   err    p90       err    p90\n";
+    if (sweep_step > 0) {
+        printf("%s", header);
+        for (float c = sweep_lo; c <= sweep_hi + 1e-6f; c += sweep_step) print_row(c, evaluate(recs, c, every_s, false));
+    } else {
+        Result res = evaluate(recs, rel_ci, every_s, true);
+        printf("\n%s", header);
+        print_row(rel_ci, res);
+    }
+    return 0;
+}
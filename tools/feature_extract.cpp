@@ -0,0 +1,371 @@
+/*
+ * HappyBees Feature Extractor
+ *
+ * Turns an archive of recordings into a feature store (tools/feature_store.h)
+ * with the firmware's own feature stage (firmware/source/bee_features.h), so
+ * training sweeps load features with tools/feature_store.py instead of
+ * recomputing them.
+ *
+ * Every --every seconds of each WAV (default 6, back to back) is one 6 s
+ * capture, featurized as on the node (and as tools/batch_infer.cpp does): DC
+ * from the capture mean, the spike ratio over the file's last BEE_HISTORY_SIZE
+ * captures, temperature, humidity and hour from --temp, --hum and --hour. Per
+ * row the store also keeps the label, the density, the node (the WAV's
+ * directory name), the source file, the offset in it and a unix time: the
+ * file's modification time minus its length (audio_capture.py writes the file
+ * when the recording ends), plus the offset.
+ *
+ * With --climate, a CSV of `unix_time,temp,hum` readings, each capture instead
+ * takes the last reading at or before its time and the local hour of that
+ * time, so the climate features vary across the store as they do in training
+ * data (training/train_summer.py refuses a store where they are constant).
+ *
+ * Labels come from --labels, a CSV of `file,label` lines (file as given on the
+ * command line or its base name, label a class index); unlisted files get
+ * --label (default -1, unlabelled).
+ *
+ * The row count is known from the WAV headers before any audio is read, so
+ * the store is created at its final size and the workers write each file's
+ * rows straight into it. A file that cannot be read back or holds fewer
+ * captures than planned (truncated or rewritten meanwhile) keeps its rows
+ * with label -1 and zero features, which training drops, and the rest of the
+ * store is written as usual. --zstd N compresses it afterwards (needs a build
+ * with -DFEATURE_STORE_ZSTD=1 -lzstd).
+ *
+ * --synthetic N skips the audio and writes N generated rows through the same
+ * path, to time the writer on corpus-sized stores.
+ *
+ * Build (from the repository root):
+ *   g++ -O2 -std=c++17 -pthread -I firmware/source tools/feature_extract.cpp -o feature_extract
+ *
+ * Run:
+ *   ./feature_extract recordings/ -o summer.bfs --labels labels.csv --temp 34 --hum 60
+ *   ./feature_extract recordings/ -o summer.bfs --labels labels.csv --climate climate.csv
+ *   ./feature_extract --synthetic 10000000 -o bench.bfs
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BEE_DSP_STATE static thread_local
+#include "bee_features.h"
+#include "feature_store.h"
+#include "wav_reader.h"
+
+#define SAMPLE_RATE_HZ      16000
+#define CAPTURE_SECONDS     6
+#define AUDIO_BUFFER_SIZE   (SAMPLE_RATE_HZ * CAPTURE_SECONDS)
+
+struct Reading {
+    int64_t time;
+    float temp, hum;
+};
+
+struct Options {
+    float gain = 0.4f;                  // CONFIG_DEFAULT_GAIN
+    float temp = 25.0f, hum = 50.0f, hour = BEE_DEFAULT_HOUR;
+    double every_s = CAPTURE_SECONDS;
+    int32_t label = -1;
+    std::vector<Reading> climate;       // --climate, by time; empty for the constants
+};
+
+struct Source {
+    std::string path;
+    uint64_t first_row = 0;
+    uint64_t rows = 0;
+    int32_t label;
+    uint32_t node, name;                // string table indexes
+    int64_t start_time;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static bool is_wav(const std::filesystem::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav";
+}
+
+static void collect(const char* arg, std::vector<std::string>* paths) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(arg, ec)) {
+        std::vector<std::string> found;
+        for (auto it = std::filesystem::recursive_directory_iterator(arg, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && is_wav(it->path())) found.push_back(it->path().string());
+        }
+        std::sort(found.begin(), found.end());
+        paths->insert(paths->end(), found.begin(), found.end());
+    }
+    else {
+        paths->push_back(arg);
+    }
+}
+
+// `file,label` lines; a first line whose label is not a number is a header
+static bool read_labels(const char* path, std::map<std::string, int32_t>* labels) {
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "%s: cannot open\n", path); return false; }
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        char* comma = strrchr(line, ',');
+        if (!comma) continue;
+        *comma = 0;
+        char* end;
+        long v = strtol(comma + 1, &end, 10);
+        if (end == comma + 1 || *end) continue;
+        (*labels)[line] = (int32_t)v;
+    }
+    fclose(f);
+    return true;
+}
+
+// `unix_time,temp,hum` lines; lines that are not three numbers (a header) are skipped
+static bool read_climate(const char* path, std::vector<Reading>* readings) {
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "%s: cannot open\n", path); return false; }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        long long t;
+        Reading r;
+        if (sscanf(line, "%lld,%f,%f", &t, &r.temp, &r.hum) != 3) continue;
+        r.time = (int64_t)t;
+        readings->push_back(r);
+    }
+    fclose(f);
+    std::sort(readings->begin(), readings->end(), [](const Reading& a, const Reading& b) { return a.time < b.time; });
+    if (readings->empty()) { fprintf(stderr, "%s: no readings\n", path); return false; }
+    return true;
+}
+
+// Climate features for a capture at unix time t: the constants, or the last
+// reading at or before t (the first one for earlier captures) and t's hour.
+static void climate_at(const Options& opt, int64_t t, float* temp, float* hum, float* hour) {
+    if (opt.climate.empty()) { *temp = opt.temp; *hum = opt.hum; *hour = opt.hour; return; }
+    auto it = std::upper_bound(opt.climate.begin(), opt.climate.end(), t,
+                               [](int64_t v, const Reading& r) { return v < r.time; });
+    const Reading& r = it == opt.climate.begin() ? *it : *(it - 1);
+    time_t tt = (time_t)t;
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    *temp = r.temp; *hum = r.hum; *hour = (float)tm.tm_hour;
+}
+
+static uint64_t captures_in(size_t frames, size_t step) {
+    return frames < AUDIO_BUFFER_SIZE ? 0 : (frames - AUDIO_BUFFER_SIZE) / step + 1;
+}
+
+// Row counts and metadata from the WAV headers; drops files that cannot be used.
+static uint64_t plan(FeatureStore* store, const std::vector<std::string>& paths, const Options& opt,
+                     const std::map<std::string, int32_t>& labels, std::vector<Source>* sources) {
+    const size_t step = std::max<size_t>(1, (size_t)(opt.every_s * SAMPLE_RATE_HZ));
+    uint64_t rows = 0;
+    for (const std::string& path : paths) {
+        uint32_t rate;
+        size_t frames;
+        if (!wav_info_pcm16(path.c_str(), &rate, &frames)) continue;
+        if (rate != SAMPLE_RATE_HZ) { fprintf(stderr, "%s: %u Hz, need %d Hz\n", path.c_str(), rate, SAMPLE_RATE_HZ); continue; }
+        Source src;
+        src.path = path;
+        src.first_row = rows;
+        src.rows = captures_in(frames, step);
+        auto it = labels.find(path);
+        if (it == labels.end()) it = labels.find(wav_base_name(path));
+        src.label = it != labels.end() ? it->second : opt.label;
+        std::string dir = std::filesystem::path(path).parent_path().filename().string();
+        src.node = fstore_string(store, dir.empty() ? "." : dir);
+        src.name = fstore_string(store, path);
+        struct stat st;
+        src.start_time = stat(path.c_str(), &st) == 0 ? (int64_t)st.st_mtime - (int64_t)(frames / SAMPLE_RATE_HZ) : 0;
+        sources->push_back(src);
+        rows += src.rows;
+    }
+    return rows;
+}
+
+// Featurizes one file into its planned rows. Returns false, writing nothing,
+// if it no longer holds them; a file that grew keeps its planned captures.
+static bool extract_file(FeatureStore* store, const Options& opt, const Source& src, std::vector<uint16_t>* adc) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    if (!wav_read_pcm16(src.path.c_str(), &pcm, &rate)) return false;
+    adc->resize(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) (*adc)[i] = wav_to_adc(pcm[i]);
+
+    const size_t step = std::max<size_t>(1, (size_t)(opt.every_s * SAMPLE_RATE_HZ));
+    if (captures_in(adc->size(), step) < src.rows) {
+        fprintf(stderr, "%s: shorter than when it was planned, rows left unlabelled\n", src.path.c_str());
+        return false;
+    }
+    BeeHistory history;
+    bee_history_clear(&history);
+    BeeCapture cap;
+    FeatureStoreRow row;
+    row.label = src.label;
+    row.node = src.node;
+    row.source = src.name;
+    for (uint64_t j = 0; j < src.rows; j++) {
+        size_t off = j * step;
+        row.density = bee_capture_samples(&cap, &(*adc)[off], AUDIO_BUFFER_SIZE, opt.gain);
+        bee_history_push(&history, row.density);
+        row.offset_s = (float)(off / (double)SAMPLE_RATE_HZ);
+        row.unix_time = src.start_time + (int64_t)(off / SAMPLE_RATE_HZ);
+        float temp, hum, hour;
+        climate_at(opt, row.unix_time, &temp, &hum, &hour);
+        bee_summer_vector(cap.bins, temp, hum, hour, bee_spike_ratio(&history, row.density), row.features);
+        fstore_put(store, src.first_row + j, &row);
+    }
+    return true;
+}
+
+// The rows of a file extract_file() gave up on: unlabelled, zero features.
+static void skip_file(FeatureStore* store, const Options& opt, const Source& src) {
+    const size_t step = std::max<size_t>(1, (size_t)(opt.every_s * SAMPLE_RATE_HZ));
+    FeatureStoreRow row;
+    memset(&row, 0, sizeof(row));
+    row.label = -1;
+    row.node = src.node;
+    row.source = src.name;
+    for (uint64_t j = 0; j < src.rows; j++) {
+        size_t off = j * step;
+        row.offset_s = (float)(off / (double)SAMPLE_RATE_HZ);
+        row.unix_time = src.start_time + (int64_t)(off / SAMPLE_RATE_HZ);
+        fstore_put(store, src.first_row + j, &row);
+    }
+}
+
+// Generated rows for --synthetic, split into contiguous ranges per thread
+static void synthetic_rows(FeatureStore* store, uint64_t begin, uint64_t end) {
+    FeatureStoreRow row;
+    uint32_t x = (uint32_t)begin * 2654435761u + 1;
+    for (uint64_t r = begin; r < end; r++) {
+        for (int k = 0; k < BEE_SUMMER_FEATURES; k++) {
+            x = x * 1664525u + 1013904223u;
+            row.features[k] = (float)(x >> 8) / (float)(1 << 24);
+        }
+        row.label = (int32_t)(x >> 31);
+        row.density = row.features[4];
+        row.node = (uint32_t)(r % 16);
+        row.source = 0;
+        row.offset_s = (float)((r % 600) * CAPTURE_SECONDS);
+        row.unix_time = 1700000000 + (int64_t)r * CAPTURE_SECONDS;
+        fstore_put(store, r, &row);
+    }
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s dir|file.wav... -o out.bfs [--threads N] [--every S] [--gain G]\n"
+                    "       [--temp C] [--hum RH] [--hour H] [--climate climate.csv]\n"
+                    "       [--labels labels.csv] [--label N]\n"
+                    "       [--zstd LEVEL] [--block-rows N]\n"
+                    "       %s --synthetic ROWS -o out.bfs [--threads N] [--zstd LEVEL]\n", argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    Options opt;
+    const char* out_path = NULL;
+    const char* labels_path = NULL;
+    const char* climate_path = NULL;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t synthetic = 0;
+    int zstd_level = 0;
+    uint32_t block_rows = 65536;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = (size_t)std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--every") && i + 1 < argc) opt.every_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--gain") && i + 1 < argc) opt.gain = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--temp") && i + 1 < argc) opt.temp = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hum") && i + 1 < argc) opt.hum = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hour") && i + 1 < argc) opt.hour = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--climate") && i + 1 < argc) climate_path = argv[++i];
+        else if (!strcmp(argv[i], "--labels") && i + 1 < argc) labels_path = argv[++i];
+        else if (!strcmp(argv[i], "--label") && i + 1 < argc) opt.label = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--synthetic") && i + 1 < argc) synthetic = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--zstd") && i + 1 < argc) zstd_level = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--block-rows") && i + 1 < argc) block_rows = (uint32_t)std::max(1, atoi(argv[++i]));
+        else if (argv[i][0] == '-') { usage(argv[0]); return 1; }
+        else collect(argv[i], &paths);
+    }
+    if (!out_path || (paths.empty() && !synthetic)) { usage(argv[0]); return 1; }
+    if (opt.every_s <= 0) opt.every_s = CAPTURE_SECONDS;
+
+    std::map<std::string, int32_t> labels;
+    if (labels_path && !read_labels(labels_path, &labels)) return 1;
+    if (climate_path && !read_climate(climate_path, &opt.climate)) return 1;
+
+    FeatureStore store;
+    std::vector<Source> sources;
+    auto t0 = Clock::now();
+    uint64_t rows = synthetic;
+    if (!synthetic) rows = plan(&store, paths, opt, labels, &sources);
+    else fstore_string(&store, "synthetic");
+    if (!fstore_create(&store, out_path, rows)) return 1;
+    double plan_s = seconds_since(t0);
+
+    // The workers share the store; every file (or synthetic range) owns its rows.
+    bee_dsp_init();
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> skipped(0);
+    std::atomic<uint64_t> skipped_rows(0);
+    auto t1 = Clock::now();
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            if (synthetic) {
+                synthetic_rows(&store, rows * t / threads, rows * (t + 1) / threads);
+                return;
+            }
+            std::vector<uint16_t> adc;
+            for (size_t i; (i = next++) < sources.size(); ) {
+                if (extract_file(&store, opt, sources[i], &adc)) continue;
+                skip_file(&store, opt, sources[i]);
+                skipped++;
+                skipped_rows += sources[i].rows;
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    double fill_s = seconds_since(t1);
+
+    double raw_mb = 0;
+    for (const FeatureStoreColumn& c : store.columns) raw_mb += c.bytes / 1e6;
+    FeatureStoreMeta meta = { (float)SAMPLE_RATE_HZ, (float)CAPTURE_SECONDS, opt.gain, (float)opt.every_s };
+    auto t2 = Clock::now();
+    if (!fstore_finish(&store, &meta, zstd_level, block_rows)) return 1;
+    double finish_s = seconds_since(t2);
+
+    struct stat st;
+    double mb = stat(out_path, &st) == 0 ? st.st_size / 1e6 : 0;
+    if (synthetic) {
+        fprintf(stderr, "%llu synthetic rows on %zu threads: fill %.2f s (%.0f MB/s), finish %.2f s\n",
+                (unsigned long long)rows, threads, fill_s, raw_mb / fill_s, finish_s);
+    } else {
+        fprintf(stderr, "%zu of %zu files, %llu captures (%.1f h of audio) on %zu threads: "
+                        "plan %.2f s, features %.2f s (%.0f captures/s), finish %.2f s\n",
+                sources.size(), paths.size(), (unsigned long long)rows, rows * opt.every_s / 3600.0, threads,
+                plan_s, fill_s, rows / fill_s, finish_s);
+    }
+    if (skipped) {
+        fprintf(stderr, "%zu files skipped: their %llu rows are unlabelled\n", (size_t)skipped,
+                (unsigned long long)skipped_rows);
+    }
+    fprintf(stderr, "%s: %.1f MB%s\n", out_path, mb, zstd_level > 0 ? " (zstd)" : "");
+    return 0;
+}
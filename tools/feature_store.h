@@ -0,0 +1,332 @@
+/*
+ * feature_store.h
+ * Writer for the HappyBees feature store (.bfs): summer feature rows in a
+ * columnar file that tools/feature_store.py maps straight into NumPy, so
+ * retraining reads features instead of recomputing them.
+ *
+ * Layout (little-endian):
+ *   FeatureStoreHeader     128 bytes at offset 0
+ *   column table           one FeatureStoreColumn (64 bytes) per column
+ *   column data            each column's values for all rows, back to back.
+ *                          The BEE_SUMMER_FEATURES feature columns form one
+ *                          contiguous column-major float32 block; every other
+ *                          column starts on a 64-byte boundary.
+ *   strings                NUL-terminated names, indexed by the node and
+ *                          source columns
+ *   block index            zstd stores only, one FeatureStoreBlock per block
+ *
+ * An uncompressed store is written in place: fstore_create() sizes the file
+ * for a known row count and maps it, fstore_put() stores a row straight into
+ * the mapping (rows do not overlap, so worker threads fill theirs without a
+ * lock) and fstore_finish() appends the strings and writes the header. Built
+ * with FEATURE_STORE_ZSTD=1 (link -lzstd), fstore_finish() can instead
+ * rewrite every column as zstd blocks of block_rows rows; that store is
+ * smaller but is decompressed on load rather than mapped.
+ *
+ * format_version covers this layout, feature_version is the extractor's
+ * BEE_FEATURES_VERSION; readers refuse a format they do not know and report
+ * the feature version so stores from an older feature stage are not mixed in.
+ */
+#ifndef FEATURE_STORE_H
+#define FEATURE_STORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#if FEATURE_STORE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "bee_features.h"
+
+#define FSTORE_MAGIC            "BEEFEAT"   // 8 bytes with the NUL
+#define FSTORE_FORMAT_VERSION   1
+#define FSTORE_ALIGN            64
+#define FSTORE_FLAG_DSP_FIXED   0x1         // features from the integer DSP path
+
+enum { FSTORE_F32 = 1, FSTORE_I32 = 2, FSTORE_U32 = 3, FSTORE_I64 = 4 };
+enum { FSTORE_RAW = 0, FSTORE_ZSTD = 1 };
+enum { FSTORE_FEATURE = 0, FSTORE_LABEL = 1, FSTORE_META = 2 };
+
+struct FeatureStoreHeader {
+    char magic[8];
+    uint16_t format_version;
+    uint16_t header_bytes;
+    uint16_t column_bytes;          // size of one column table entry
+    uint16_t columns;
+    uint32_t feature_version;       // BEE_FEATURES_VERSION
+    uint32_t flags;
+    uint64_t rows;
+    uint64_t column_table;          // file offsets of the sections
+    uint64_t strings;
+    uint64_t string_bytes;
+    uint32_t string_count;
+    uint32_t block_rows;            // rows per zstd block, 0 if uncompressed
+    uint64_t block_index;
+    uint64_t blocks;
+    int64_t created;                // unix time
+    float sample_rate;
+    float capture_seconds;
+    float gain;
+    float every_s;                  // seconds between captures in a recording
+    uint8_t reserved[24];
+};
+
+struct FeatureStoreColumn {
+    char name[24];
+    uint8_t dtype;
+    uint8_t codec;
+    uint8_t role;
+    uint8_t reserved0;
+    uint32_t first_block;           // index of its first FeatureStoreBlock
+    uint64_t offset;
+    uint64_t bytes;                 // as stored
+    uint8_t reserved[16];
+};
+
+struct FeatureStoreBlock {
+    uint64_t offset;
+    uint32_t bytes;                 // compressed
+    uint32_t rows;
+};
+
+static_assert(sizeof(FeatureStoreHeader) == 128, "feature store header must stay 128 bytes");
+static_assert(sizeof(FeatureStoreColumn) == 64, "feature store column entry must stay 64 bytes");
+static_assert(sizeof(FeatureStoreBlock) == 16, "feature store block entry must stay 16 bytes");
+
+// One capture as the extractor produces it
+struct FeatureStoreRow {
+    float features[BEE_SUMMER_FEATURES];    // bee_summer_vector()
+    int32_t label;                          // class index, -1 if unlabelled
+    float density;
+    uint32_t node;                          // fstore_string() indexes
+    uint32_t source;
+    float offset_s;                         // capture start within the recording
+    int64_t unix_time;
+};
+
+enum {
+    FSTORE_COL_LABEL = BEE_SUMMER_FEATURES,
+    FSTORE_COL_DENSITY, FSTORE_COL_NODE, FSTORE_COL_SOURCE, FSTORE_COL_OFFSET, FSTORE_COL_TIME,
+    FSTORE_COLUMNS
+};
+
+struct FeatureStoreMeta {
+    float sample_rate;
+    float capture_seconds;
+    float gain;
+    float every_s;
+};
+
+struct FeatureStore {
+    std::string path;
+    int fd = -1;
+    uint8_t* map = NULL;
+    size_t map_bytes = 0;
+    uint64_t rows = 0;
+    std::vector<FeatureStoreColumn> columns;
+    std::vector<std::string> strings;
+    std::map<std::string, uint32_t> string_index;
+};
+
+static uint64_t fstore_align(uint64_t x) {
+    return (x + FSTORE_ALIGN - 1) / FSTORE_ALIGN * FSTORE_ALIGN;
+}
+
+static size_t fstore_dtype_size(uint8_t dtype) {
+    return dtype == FSTORE_I64 ? 8 : 4;
+}
+
+static void fstore_schema(std::vector<FeatureStoreColumn>* cols) {
+    static const char* const leading[4] = { "temp", "hum", "hour", "spike" };
+    static const struct { const char* name; uint8_t dtype, role; } tail[FSTORE_COLUMNS - BEE_SUMMER_FEATURES] = {
+        { "label", FSTORE_I32, FSTORE_LABEL }, { "density", FSTORE_F32, FSTORE_META },
+        { "node", FSTORE_U32, FSTORE_META }, { "source", FSTORE_U32, FSTORE_META },
+        { "offset_s", FSTORE_F32, FSTORE_META }, { "unix_time", FSTORE_I64, FSTORE_META },
+    };
+    cols->assign(FSTORE_COLUMNS, FeatureStoreColumn());
+    for (int i = 0; i < FSTORE_COLUMNS; i++) {
+        FeatureStoreColumn* c = &(*cols)[i];
+        memset(c, 0, sizeof(*c));
+        if (i < 4) snprintf(c->name, sizeof(c->name), "%s", leading[i]);
+        else if (i < BEE_SUMMER_FEATURES) snprintf(c->name, sizeof(c->name), "bin%d", BEE_FIRST_BIN + i - 4);
+        else snprintf(c->name, sizeof(c->name), "%s", tail[i - BEE_SUMMER_FEATURES].name);
+        c->dtype = i < BEE_SUMMER_FEATURES ? (uint8_t)FSTORE_F32 : tail[i - BEE_SUMMER_FEATURES].dtype;
+        c->role = i < BEE_SUMMER_FEATURES ? (uint8_t)FSTORE_FEATURE : tail[i - BEE_SUMMER_FEATURES].role;
+    }
+}
+
+// Creates `path` for exactly `rows` rows and maps it for fstore_put().
+static bool fstore_create(FeatureStore* s, const char* path, uint64_t rows) {
+    s->path = path;
+    s->rows = rows;
+    fstore_schema(&s->columns);
+    uint64_t off = fstore_align(sizeof(FeatureStoreHeader) + FSTORE_COLUMNS * sizeof(FeatureStoreColumn));
+    for (int i = 0; i < FSTORE_COLUMNS; i++) {
+        FeatureStoreColumn* c = &s->columns[i];
+        if (i >= BEE_SUMMER_FEATURES) off = fstore_align(off);     // the feature block stays contiguous
+        c->offset = off;
+        c->bytes = rows * fstore_dtype_size(c->dtype);
+        off += c->bytes;
+    }
+    s->map_bytes = off;
+
+    s->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (s->fd < 0) { fprintf(stderr, "%s: cannot create\n", path); return false; }
+    if (ftruncate(s->fd, (off_t)s->map_bytes) != 0) {
+        fprintf(stderr, "%s: cannot size to %zu bytes\n", path, s->map_bytes);
+        close(s->fd); s->fd = -1; return false;
+    }
+    void* m = mmap(NULL, s->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (m == MAP_FAILED) { fprintf(stderr, "%s: cannot map\n", path); close(s->fd); s->fd = -1; return false; }
+    s->map = (uint8_t*)m;
+    return true;
+}
+
+// Index of `name` in the string table, added on first use. Not thread-safe:
+// intern names before the workers start.
+static uint32_t fstore_string(FeatureStore* s, const std::string& name) {
+    auto it = s->string_index.find(name);
+    if (it != s->string_index.end()) return it->second;
+    uint32_t ix = (uint32_t)s->strings.size();
+    s->strings.push_back(name);
+    s->string_index[name] = ix;
+    return ix;
+}
+
+static inline void fstore_put(FeatureStore* s, uint64_t row, const FeatureStoreRow* r) {
+    const void* src[FSTORE_COLUMNS];
+    for (int i = 0; i < BEE_SUMMER_FEATURES; i++) src[i] = &r->features[i];
+    src[FSTORE_COL_LABEL] = &r->label;
+    src[FSTORE_COL_DENSITY] = &r->density;
+    src[FSTORE_COL_NODE] = &r->node;
+    src[FSTORE_COL_SOURCE] = &r->source;
+    src[FSTORE_COL_OFFSET] = &r->offset_s;
+    src[FSTORE_COL_TIME] = &r->unix_time;
+    for (int i = 0; i < FSTORE_COLUMNS; i++) {
+        size_t n = fstore_dtype_size(s->columns[i].dtype);
+        memcpy(s->map + s->columns[i].offset + row * n, src[i], n);
+    }
+}
+
+static bool fstore_pwrite(int fd, const void* buf, size_t n, uint64_t off) {
+    const uint8_t* p = (const uint8_t*)buf;
+    while (n) {
+        ssize_t w = pwrite(fd, p, n, (off_t)off);
+        if (w <= 0) return false;
+        p += w; n -= (size_t)w; off += (uint64_t)w;
+    }
+    return true;
+}
+
+static void fstore_release(FeatureStore* s) {
+    if (s->map) munmap(s->map, s->map_bytes);
+    if (s->fd >= 0) close(s->fd);
+    s->map = NULL;
+    s->fd = -1;
+}
+
+#if FEATURE_STORE_ZSTD
+// Writes the columns of the mapping as zstd blocks to `fd` from `off` on,
+// filling in the column entries and `blocks`. Returns the end offset, 0 on error.
+static uint64_t fstore_compress(FeatureStore* s, int fd, uint64_t off, int level, uint32_t block_rows,
+                                std::vector<FeatureStoreBlock>* blocks) {
+    std::vector<uint8_t> out;
+    for (FeatureStoreColumn& c : s->columns) {
+        size_t size = fstore_dtype_size(c.dtype);
+        const uint8_t* src = s->map + c.offset;
+        c.codec = FSTORE_ZSTD;
+        c.first_block = (uint32_t)blocks->size();
+        c.offset = off;
+        for (uint64_t row = 0; row < s->rows; row += block_rows) {
+            uint32_t n = (uint32_t)(s->rows - row < block_rows ? s->rows - row : block_rows);
+            out.resize(ZSTD_compressBound((size_t)n * size));
+            size_t bytes = ZSTD_compress(out.data(), out.size(), src + row * size, (size_t)n * size, level);
+            if (ZSTD_isError(bytes) || !fstore_pwrite(fd, out.data(), bytes, off)) return 0;
+            blocks->push_back({ off, (uint32_t)bytes, n });
+            off += bytes;
+        }
+        c.bytes = off - c.offset;
+    }
+    return off;
+}
+#endif
+
+// Appends the strings (and block index), writes the header and closes the
+// store. zstd_level > 0 rewrites the columns as zstd blocks of block_rows
+// rows (needs FEATURE_STORE_ZSTD). Removes the file on error.
+static bool fstore_finish(FeatureStore* s, const FeatureStoreMeta* meta, int zstd_level, uint32_t block_rows) {
+    FeatureStoreHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FSTORE_MAGIC, sizeof(h.magic));
+    h.format_version = FSTORE_FORMAT_VERSION;
+    h.header_bytes = sizeof(FeatureStoreHeader);
+    h.column_bytes = sizeof(FeatureStoreColumn);
+    h.columns = FSTORE_COLUMNS;
+    h.feature_version = BEE_FEATURES_VERSION;
+    h.flags = BEE_DSP_FIXED ? FSTORE_FLAG_DSP_FIXED : 0;
+    h.rows = s->rows;
+    h.column_table = sizeof(FeatureStoreHeader);
+    h.string_count = (uint32_t)s->strings.size();
+    h.created = (int64_t)time(NULL);
+    h.sample_rate = meta->sample_rate;
+    h.capture_seconds = meta->capture_seconds;
+    h.gain = meta->gain;
+    h.every_s = meta->every_s;
+
+    std::string blob;
+    for (const std::string& str : s->strings) blob.append(str.c_str(), str.size() + 1);
+
+    int fd = s->fd;
+    std::string tmp_path;
+    std::vector<FeatureStoreBlock> blocks;
+    uint64_t end = s->map_bytes;
+    bool ok = true;
+    if (zstd_level > 0) {
+#if FEATURE_STORE_ZSTD
+        tmp_path = s->path + ".tmp";
+        fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        h.block_rows = block_rows ? block_rows : 65536;
+        end = fd < 0 ? 0 : fstore_compress(s, fd, fstore_align(h.column_table + FSTORE_COLUMNS * sizeof(FeatureStoreColumn)),
+                                           zstd_level, h.block_rows, &blocks);
+        ok = end != 0;
+#else
+        (void)block_rows;
+        fprintf(stderr, "%s: built without FEATURE_STORE_ZSTD, cannot compress\n", s->path.c_str());
+        ok = false;
+#endif
+    }
+    if (ok) {
+        h.strings = fstore_align(end);
+        h.string_bytes = blob.size();
+        h.block_index = fstore_align(h.strings + h.string_bytes);
+        h.blocks = blocks.size();
+        ok = fstore_pwrite(fd, blob.data(), blob.size(), h.strings) &&
+             fstore_pwrite(fd, blocks.data(), blocks.size() * sizeof(FeatureStoreBlock), h.block_index) &&
+             fstore_pwrite(fd, s->columns.data(), FSTORE_COLUMNS * sizeof(FeatureStoreColumn), h.column_table) &&
+             fstore_pwrite(fd, &h, sizeof(h), 0);
+    }
+    if (!tmp_path.empty()) {
+        if (fd >= 0) close(fd);
+        fstore_release(s);
+        ok = ok && rename(tmp_path.c_str(), s->path.c_str()) == 0;
+        if (!ok) unlink(tmp_path.c_str());
+    } else {
+        fstore_release(s);
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", s->path.c_str());
+        unlink(s->path.c_str());
+    }
+    return ok;
+}
+
+#endif
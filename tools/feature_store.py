@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+HappyBees Feature Store Reader
+
+Loads the feature stores (.bfs) tools/feature_extract.cpp writes; the layout
+is described in tools/feature_store.h. Uncompressed stores are memory-mapped:
+every column, and the [rows, 20] feature matrix, is a read-only NumPy view of
+the file, so opening one costs nothing however many rows it holds. zstd stores
+are decompressed on load and need the `zstandard` package.
+
+Usage:
+    python tools/feature_store.py summer.bfs          # print header and columns
+
+    from feature_store import FeatureStore
+    store = FeatureStore('summer.bfs')
+    X, y = store.features, store.labels               # float32 [n, 20], int32 [n]
+    nodes = store.strings_of('node')                  # node name per row
+"""
+
+import argparse
+import os
+import re
+import sys
+
+import numpy as np
+
+MAGIC = b'BEEFEAT\0'
+FORMAT_VERSION = 1
+FLAG_DSP_FIXED = 0x1
+CODEC_RAW, CODEC_ZSTD = 0, 1
+ROLE_FEATURE, ROLE_LABEL, ROLE_META = 0, 1, 2
+DTYPES = {1: np.dtype('<f4'), 2: np.dtype('<i4'), 3: np.dtype('<u4'), 4: np.dtype('<i8')}
+
+HEADER = np.dtype([
+    ('magic', 'S8'), ('format_version', '<u2'), ('header_bytes', '<u2'), ('column_bytes', '<u2'),
+    ('columns', '<u2'), ('feature_version', '<u4'), ('flags', '<u4'), ('rows', '<u8'),
+    ('column_table', '<u8'), ('strings', '<u8'), ('string_bytes', '<u8'), ('string_count', '<u4'),
+    ('block_rows', '<u4'), ('block_index', '<u8'), ('blocks', '<u8'), ('created', '<i8'),
+    ('sample_rate', '<f4'), ('capture_seconds', '<f4'), ('gain', '<f4'), ('every_s', '<f4'),
+    ('reserved', 'V24'),
+])
+COLUMN = np.dtype([
+    ('name', 'S24'), ('dtype', 'u1'), ('codec', 'u1'), ('role', 'u1'), ('reserved0', 'u1'),
+    ('first_block', '<u4'), ('offset', '<u8'), ('bytes', '<u8'), ('reserved', 'V16'),
+])
+BLOCK = np.dtype([('offset', '<u8'), ('bytes', '<u4'), ('rows', '<u4')])
+assert HEADER.itemsize == 128 and COLUMN.itemsize == 64 and BLOCK.itemsize == 16
+
+FEATURES_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'firmware', 'source', 'bee_features.h')
+
+
+def bee_features_version():
+    """BEE_FEATURES_VERSION of this checkout's feature stage (firmware/source/bee_features.h)."""
+    with open(FEATURES_HEADER) as f:
+        m = re.search(r'^#define\s+BEE_FEATURES_VERSION\s+(\d+)', f.read(), re.M)
+    if not m:
+        raise ValueError(f"{FEATURES_HEADER}: no BEE_FEATURES_VERSION")
+    return int(m.group(1))
+
+
+class FeatureStore:
+    """A feature store; columns are views of the mapped file (or arrays, for zstd)."""
+
+    def __init__(self, path):
+        self.path = path
+        self._map = np.memmap(path, dtype=np.uint8, mode='r')
+        if len(self._map) < HEADER.itemsize:
+            raise ValueError(f"{path}: too short for a feature store")
+        h = self._map[:HEADER.itemsize].view(HEADER)[0]
+        if bytes(self._map[:len(MAGIC)]) != MAGIC:
+            raise ValueError(f"{path}: not a feature store")
+        if h['format_version'] != FORMAT_VERSION:
+            raise ValueError(f"{path}: format version {h['format_version']}, this reader knows {FORMAT_VERSION}")
+        self.header = h
+        self.rows = int(h['rows'])
+        self.feature_version = int(h['feature_version'])
+        self.dsp_fixed = bool(h['flags'] & FLAG_DSP_FIXED)
+
+        start = int(h['column_table'])
+        table = self._map[start:start + int(h['columns']) * COLUMN.itemsize].view(COLUMN)
+        self._table = {c['name'].decode(): c for c in table}
+        self.column_names = list(self._table)
+        self.feature_names = [c['name'].decode() for c in table if c['role'] == ROLE_FEATURE]
+
+        start = int(h['block_index'])
+        self._blocks = self._map[start:start + int(h['blocks']) * BLOCK.itemsize].view(BLOCK)
+        start = int(h['strings'])
+        blob = bytes(self._map[start:start + int(h['string_bytes'])])
+        self.strings = [s.decode() for s in blob.split(b'\0')[:int(h['string_count'])]]
+        self._cache = {}
+
+    def column(self, name):
+        """One column, rows long."""
+        if name not in self._cache:
+            c = self._table[name]
+            dtype = DTYPES[int(c['dtype'])]
+            if c['codec'] == CODEC_RAW:
+                self._cache[name] = np.frombuffer(self._map, dtype=dtype, count=self.rows, offset=int(c['offset']))
+            elif c['codec'] == CODEC_ZSTD:
+                self._cache[name] = self._decompress(c, dtype)
+            else:
+                raise ValueError(f"{self.path}: column {name} has unknown codec {c['codec']}")
+        return self._cache[name]
+
+    def _decompress(self, c, dtype):
+        try:
+            import zstandard
+        except ImportError:
+            raise RuntimeError(f"{self.path} is zstd-compressed; pip install zstandard") from None
+        out = np.empty(self.rows, dtype=dtype)
+        dctx = zstandard.ZstdDecompressor()
+        row = 0
+        for b in self._blocks[int(c['first_block']):]:
+            if row >= self.rows:
+                break
+            n = int(b['rows'])
+            data = self._map[int(b['offset']):int(b['offset']) + int(b['bytes'])]
+            out[row:row + n] = np.frombuffer(dctx.decompress(bytes(data), max_output_size=n * dtype.itemsize),
+                                             dtype=dtype)
+            row += n
+        return out
+
+    @property
+    def features(self):
+        """float32 [rows, 20] in model input order; a zero-copy view when uncompressed."""
+        first = self._table[self.feature_names[0]]
+        if first['codec'] == CODEC_RAW:
+            # the feature columns are one contiguous column-major block
+            block = np.frombuffer(self._map, dtype='<f4', count=self.rows * len(self.feature_names),
+                                  offset=int(first['offset']))
+            return block.reshape(len(self.feature_names), self.rows).T
+        return np.stack([self.column(n) for n in self.feature_names], axis=1)
+
+    @property
+    def labels(self):
+        return self.column('label')
+
+    def strings_of(self, name):
+        """The string-table names a node or source column points at, one per row."""
+        return np.asarray(self.strings, dtype=object)[self.column(name)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='HappyBees feature store summary')
+    parser.add_argument('store', help='.bfs file from feature_extract')
+    args = parser.parse_args()
+
+    try:
+        store = FeatureStore(args.store)
+    except ValueError as e:
+        print(f"[ERROR] {e}")
+        sys.exit(1)
+    h = store.header
+    current = bee_features_version()
+    print(f"{args.store}: {store.rows} rows, feature version {store.feature_version}"
+          f"{f' (this checkout computes {current})' if store.feature_version != current else ''}"
+          f"{' (integer DSP)' if store.dsp_fixed else ''}")
+    print(f"  gain {h['gain']:.3f}, {h['capture_seconds']:.0f} s captures every {h['every_s']:.0f} s, "
+          f"{h['sample_rate']:.0f} Hz")
+    if h['block_rows']:
+        print(f"  zstd, {int(h['blocks'])} blocks of {int(h['block_rows'])} rows")
+    labels = store.labels
+    values, counts = np.unique(labels, return_counts=True)
+    print("  labels: " + ", ".join(f"{v}: {c}" for v, c in zip(values, counts)))
+    print(f"  nodes: {len(np.unique(store.column('node')))}, sources: {len(np.unique(store.column('source')))}")
+    print(f"\n  {'column':<10} {'dtype':<8} {'min':>12} {'max':>12} {'mean':>12}")
+    for name in store.column_names:
+        v = store.column(name)
+        if len(v):
+            print(f"  {name:<10} {str(v.dtype):<8} {v.min():12.6g} {v.max():12.6g} {v.mean():12.6g}")
+
+
+if __name__ == "__main__":
+    main()
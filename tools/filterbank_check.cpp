@@ -0,0 +1,185 @@
+/*
+ * HappyBees Mel Filterbank Check
+ *
+ * Checks the SDK's sparse mel filterbank (sparse_filterbank in
+ * dsp/speechpy/feature.hpp) against the dense paths it replaced, over FFT
+ * sizes 128..1024 and 16..128 filters at 16 kHz:
+ *
+ *   weights   build(..., true) holds exactly the non-zero weights of
+ *             feature::filterbanks(), the dense num_filters x coefficients
+ *             matrix mfe_v3() used, quantized or not (EIDSP_QUANTIZE_FILTERBANK)
+ *   mfe_v3    apply() on random power spectra is bit-identical to
+ *             numpy::dot_by_row() over the transposed dense matrix (its
+ *             scalar loop, as on the node: host SIMD is switched off, the
+ *             AVX2 path fuses multiply-adds and rounds differently)
+ *   mfe       apply() with build(..., false) matches the per-frame triangle
+ *             loop mfe() used to run within MFE_REL_TOL; it sums the middle
+ *             bin in order instead of first, so the last bits may differ
+ *
+ * and prints the weights each path stores and the time per frame of both
+ * kernels. Any mismatch makes the exit status 1.
+ *
+ * Build and run (from the repository root; the SDK quantizes the filterbank
+ * by default, add -DEIDSP_QUANTIZE_FILTERBANK=0 for float weights):
+ *   g++ -O2 -std=c++17 -I firmware tools/filterbank_check.cpp \
+ *       firmware/edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp \
+ *       firmware/edge-impulse-sdk/dsp/memory.cpp \
+ *       firmware/edge-impulse-sdk/dsp/fft_plans.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp -o filterbank_check
+ *   ./filterbank_check
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+
+#define SAMPLE_RATE     16000
+#define FRAMES          8
+#define MFE_REL_TOL     1e-6
+#define MIN_BENCH_NS    50e6    // run each kernel at least this long
+
+using namespace ei;
+using speechpy::sparse_filterbank;
+
+// Mean time per call of fn(), repeated until MIN_BENCH_NS has passed
+template <typename Fn>
+static double ns_per_call(Fn fn) {
+    uint64_t calls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double ns = 0;
+    do {
+        for (int i = 0; i < 20; i++) fn();
+        calls += 20;
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    } while (ns < MIN_BENCH_NS);
+    return ns / calls;
+}
+
+// The triangle loop mfe() ran per frame before the sparse filterbank
+static void mfe_reference(const float* ps, const uint16_t* bins, int num_filters, float* out) {
+    for (int i = 0; i < num_filters; i++) {
+        size_t left = bins[i], middle = bins[i + 1], right = bins[i + 2];
+        out[i] = ps[middle];
+        for (size_t bin = left + 1; bin < right; bin++) {
+            if (bin < middle) out[i] += ((static_cast<float>(bin) - left) / (middle - left)) * ps[bin];
+            if (bin > middle) out[i] += ((right - static_cast<float>(bin)) / (right - middle)) * ps[bin];
+        }
+    }
+}
+
+static float sparse_weight(const sparse_filterbank& fb, int filter, int bin) {
+    const float* w = fb.weights;
+    for (int i = 0; i < filter; i++) w += fb.length[i];
+    int k = bin - fb.start[filter];
+    return (k >= 0 && k < fb.length[filter]) ? w[k] : 0.0f;
+}
+
+static int g_failures = 0;
+
+static void check(int fft, int filters) {
+    const int coefficients = fft / 2 + 1;
+    char what[32];
+    snprintf(what, sizeof(what), "%d/%d", fft, filters);
+
+    std::vector<uint16_t> edges(filters + 2);
+    sparse_filterbank v3, legacy;
+    if (speechpy::feature::filterbank_edges(edges.data(), filters, coefficients, SAMPLE_RATE, 0, SAMPLE_RATE / 2) != EIDSP_OK ||
+        v3.build(edges.data(), filters, coefficients, true) != EIDSP_OK ||
+        legacy.build(edges.data(), filters, coefficients, false) != EIDSP_OK) {
+        printf("%-10s build failed\n", what);
+        g_failures++;
+        return;
+    }
+
+    // As mfe_v3() allocated it; output_transposed swaps rows and cols
+#if EIDSP_QUANTIZE_FILTERBANK
+    quantized_matrix_t dense(filters, coefficients, &numpy::dequantize_zero_one);
+    quantized_matrix_t dense_t(filters, coefficients, &numpy::dequantize_zero_one);
+#else
+    matrix_t dense(filters, coefficients);
+    matrix_t dense_t(filters, coefficients);
+#endif
+    if (speechpy::feature::filterbanks(&dense, filters, coefficients, SAMPLE_RATE, 0, SAMPLE_RATE / 2) != EIDSP_OK ||
+        speechpy::feature::filterbanks(&dense_t, filters, coefficients, SAMPLE_RATE, 0, SAMPLE_RATE / 2, true) != EIDSP_OK) {
+        printf("%-10s filterbanks() failed\n", what);
+        g_failures++;
+        return;
+    }
+
+    // Weights: every dense entry, zeros included, from the sparse runs
+    int weight_diffs = 0;
+    for (int i = 0; i < filters; i++) {
+        for (int bin = 0; bin < coefficients; bin++) {
+#if EIDSP_QUANTIZE_FILTERBANK
+            float want = numpy::dequantize_zero_one(dense.buffer[i * coefficients + bin]);
+#else
+            float want = dense.buffer[i * coefficients + bin];
+#endif
+            if (sparse_weight(v3, i, bin) != want) weight_diffs++;
+        }
+    }
+    int v3_stored = 0;
+    for (int i = 0; i < filters; i++) v3_stored += v3.length[i];
+
+    // Kernels on random power spectra
+    std::vector<float> ps(FRAMES * coefficients);
+    srand((unsigned)(fft * 1000 + filters));
+    for (float& p : ps) p = (float)rand() / RAND_MAX * 100.0f;
+    matrix_t dense_out(FRAMES, filters);
+    std::vector<float> sparse_out(FRAMES * filters), ref_out(FRAMES * filters), legacy_out(FRAMES * filters);
+
+    int v3_diffs = 0;
+    double mfe_worst = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        float* frame = &ps[f * coefficients];
+        memset(dense_out.get_row_ptr(f), 0, filters * sizeof(float));
+        numpy::dot_by_row(f, frame, coefficients, &dense_t, &dense_out);
+        v3.apply(frame, &sparse_out[f * filters]);
+        mfe_reference(frame, edges.data(), filters, &ref_out[f * filters]);
+        legacy.apply(frame, &legacy_out[f * filters]);
+        for (int i = 0; i < filters; i++) {
+            if (memcmp(&sparse_out[f * filters + i], dense_out.get_row_ptr(f) + i, sizeof(float)) != 0) v3_diffs++;
+            float ref = ref_out[f * filters + i];
+            double rel = fabs((double)legacy_out[f * filters + i] - ref) / (fabs(ref) > 1e-30 ? fabs(ref) : 1.0);
+            mfe_worst = fmax(mfe_worst, rel);
+        }
+    }
+
+    float* frame = ps.data();
+    double t_dense = ns_per_call([&] { numpy::dot_by_row(0, frame, coefficients, &dense_t, &dense_out); });
+    double t_sparse = ns_per_call([&] { v3.apply(frame, sparse_out.data()); });
+    double t_ref = ns_per_call([&] { mfe_reference(frame, edges.data(), filters, ref_out.data()); });
+    double t_legacy = ns_per_call([&] { legacy.apply(frame, legacy_out.data()); });
+
+    bool ok = weight_diffs == 0 && v3_diffs == 0 && mfe_worst <= MFE_REL_TOL;
+    printf("%-10s %6d %6d %8.2f %8.2f %6.0fx %8.2f %8.2f %6.1fx %5d %5d  %.2g %s\n", what,
+           filters * coefficients, v3_stored, t_dense / 1000.0, t_sparse / 1000.0, t_dense / t_sparse,
+           t_ref / 1000.0, t_legacy / 1000.0, t_ref / t_legacy, weight_diffs, v3_diffs, mfe_worst,
+           ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+int main() {
+#if EIDSP_HOST_SIMD_ACTIVE
+    host_simd::set_level(host_simd::LEVEL_NONE);
+#endif
+    printf("EIDSP_QUANTIZE_FILTERBANK=%d, %d Hz, %d frames per case\n\n", (int)EIDSP_QUANTIZE_FILTERBANK, SAMPLE_RATE, FRAMES);
+    printf("                weights          mfe_v3 us/frame          mfe us/frame      mismatches\n");
+    printf("fft/filt     dense sparse    dense   sparse  speedup      loop   sparse speedup weight  v3  mfe rel\n");
+    const int ffts[] = { 128, 256, 512, 1024 };
+    const int filters[] = { 16, 32, 40, 64, 128 };
+    for (int fft : ffts) {
+        for (int n : filters) check(fft, n);
+    }
+    if (g_failures) {
+        printf("\n%d case(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("\nAll cases match\n");
+    return 0;
+}
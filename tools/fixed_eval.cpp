@@ -0,0 +1,157 @@
+/*
+ * HappyBees Fixed-Point DSP Evaluator
+ *
+ * Replays recorded WAVs through both paths of the firmware's window DSP
+ * (firmware/source/bee_dsp.h, built unchanged with BEE_DSP_INTEGER=1): the
+ * float chain and the integer one that BEE_DSP_FIXED=1 selects. Every
+ * --every seconds of each recording is one 6 s capture (187 windows, DC from
+ * the mean of the capture, as process_and_compute_features()), featurized
+ * both ways. The table gives, per feature the summer model uses (bins 4..19
+ * and density), the mean and largest relative error of the integer features
+ * against the float ones, followed by the time per window of each path on
+ * this host.
+ *
+ * Host timings only compare the two paths; on the Cortex-M33 the integer
+ * path also avoids the 80 KB of float DFT tables.
+ *
+ * WAVs are 16-bit PCM at 16 kHz as written by audio_capture.py, mapped back
+ * to 12-bit counts with that tool's scaling (int16 = (adc - mean) / 2048 * 32767).
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -I firmware/source tools/fixed_eval.cpp -o fixed_eval
+ *   ./fixed_eval day1.wav day2.wav
+ *   ./fixed_eval day1.wav --every 10 --gain 2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define BEE_DSP_INTEGER     1       // both paths in one build
+#include "bee_dsp.h"
+#include "wav_reader.h"
+
+#define SAMPLE_RATE_HZ      16000
+#define CAPTURE_SECONDS     6
+#define AUDIO_BUFFER_SIZE   (SAMPLE_RATE_HZ * CAPTURE_SECONDS)
+#define CAPTURE_WINDOWS     ((AUDIO_BUFFER_SIZE - FFT_SIZE) / FFT_HOP + 1)
+#define NUM_FEATURES        (NUM_FREQ_BINS - BEE_FIRST_BIN + 1)   // bins, then density
+
+typedef double (*WindowFn)(const uint16_t*, float, float, float*);
+
+struct Recording {
+    std::string name;
+    std::vector<uint16_t> adc;
+};
+
+struct Features {
+    double f[NUM_FEATURES];
+};
+
+struct ErrorStats {
+    double sum[NUM_FEATURES], max[NUM_FEATURES];
+    int captures;
+};
+
+static bool load_recording(const char* path, Recording* rec) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    if (!wav_read_pcm16(path, &pcm, &rate)) return false;
+    if (rate != SAMPLE_RATE_HZ) { fprintf(stderr, "%s: %u Hz, need %d Hz\n", path, rate, SAMPLE_RATE_HZ); return false; }
+    rec->name = wav_base_name(path);
+    rec->adc.resize(pcm.size());
+    for (size_t i = 0; i < pcm.size(); i++) rec->adc[i] = wav_to_adc(pcm[i]);
+    return true;
+}
+
+// One 6 s capture through `fn`, as process_and_compute_features().
+static void capture_features(WindowFn fn, const uint16_t* s, float gain, Features* out) {
+    double dc = 0;
+    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) dc += s[i];
+    dc /= AUDIO_BUFFER_SIZE;
+    double bins[NUM_FREQ_BINS] = {0};
+    double sumsq = 0;
+    float mags[NUM_FREQ_BINS];
+    reset_filters();
+    for (int w = 0; w < CAPTURE_WINDOWS; w++) {
+        sumsq += fn(s + w * FFT_HOP, (float)dc, gain, mags);
+        for (int k = 0; k < NUM_FREQ_BINS; k++) bins[k] += mags[k];
+    }
+    for (int k = BEE_FIRST_BIN; k < NUM_FREQ_BINS; k++) out->f[k - BEE_FIRST_BIN] = bins[k] / CAPTURE_WINDOWS;
+    out->f[NUM_FEATURES - 1] = sqrt(sumsq / (CAPTURE_WINDOWS * FFT_SIZE));
+}
+
+// Mean time per window of `fn` over every whole window of the recordings.
+static double ns_per_window(WindowFn fn, const std::vector<Recording>& recs, float gain) {
+    float mags[NUM_FREQ_BINS];
+    volatile float sink = 0;
+    uint64_t windows = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const Recording& rec : recs) {
+        reset_filters();
+        for (size_t off = 0; off + FFT_SIZE <= rec.adc.size(); off += FFT_HOP, windows++) {
+            sink = sink + (float)fn(&rec.adc[off], 2048.0f, gain, mags) + mags[NUM_FREQ_BINS - 1];
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return windows ? std::chrono::duration<double, std::nano>(t1 - t0).count() / windows : 0.0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<Recording> recs;
+    double every_s = 60.0;
+    float gain = 0.4f;                  // CONFIG_DEFAULT_GAIN
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--every") && i + 1 < argc) every_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--gain") && i + 1 < argc) gain = (float)atof(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s file.wav... [--every S] [--gain G]\n", argv[0]);
+            return 1;
+        }
+        else {
+            Recording rec;
+            if (load_recording(argv[i], &rec)) recs.push_back(std::move(rec));
+        }
+    }
+    if (recs.empty()) { fprintf(stderr, "no recordings\n"); return 1; }
+    if (every_s <= 0) every_s = 60.0;
+
+    bee_dsp_init();
+    ErrorStats err;
+    memset(&err, 0, sizeof(err));
+    const size_t step = (size_t)(every_s * SAMPLE_RATE_HZ);
+    for (const Recording& rec : recs) {
+        for (size_t off = 0; off + AUDIO_BUFFER_SIZE <= rec.adc.size(); off += step) {
+            Features ref, fx;
+            capture_features(bee_dsp_window_float, &rec.adc[off], gain, &ref);
+            capture_features(bee_dsp_window_fixed, &rec.adc[off], gain, &fx);
+            double worst = 0;
+            for (int i = 0; i < NUM_FEATURES; i++) {
+                double e = ref.f[i] > 0 ? fabs(fx.f[i] - ref.f[i]) / ref.f[i] : 0.0;
+                err.sum[i] += e;
+                if (e > err.max[i]) err.max[i] = e;
+                if (e > worst) worst = e;
+            }
+            err.captures++;
+            printf("  %-32s %7.1f s  worst error %.4f%%\n", rec.name.c_str(), off / (double)SAMPLE_RATE_HZ, worst * 100.0);
+        }
+    }
+    if (!err.captures) { fprintf(stderr, "no captures (recordings shorter than %d s)\n", CAPTURE_SECONDS); return 1; }
+
+    printf("\n%d captures, gain %.2f\n\n feature   mean err    max err\n", err.captures, gain);
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        char label[16];
+        if (i < NUM_FEATURES - 1) snprintf(label, sizeof(label), "bin %d", i + BEE_FIRST_BIN);
+        else snprintf(label, sizeof(label), "density");
+        printf(" %-8s %8.4f%% %9.4f%%\n", label, 100.0 * err.sum[i] / err.captures, 100.0 * err.max[i]);
+    }
+
+    double ns_float = ns_per_window(bee_dsp_window_float, recs, gain);
+    double ns_fixed = ns_per_window(bee_dsp_window_fixed, recs, gain);
+    printf("\nper window: float %.1f us, integer %.1f us (%.2fx)\n", ns_float / 1000.0, ns_fixed / 1000.0,
+           ns_fixed > 0 ? ns_float / ns_fixed : 0.0);
+    return 0;
+}
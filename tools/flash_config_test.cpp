@@ -0,0 +1,225 @@
+/*
+ * HappyBees Config Store Test
+ *
+ * Drives firmware/source/flash_config.h on the RAM flash simulator (FlashSim,
+ * FLASH_OPS_HOST) through what a node's config sees over its life:
+ *
+ *   journal      saves round-trip, fill a sector and compact into the other
+ *                one, alternating, with one erase per sector's worth of saves
+ *   power loss   a cut at every point of a save, both in the middle of a
+ *                sector and in the save that compacts into the other sector
+ *                (erase done, record not yet programmed): the next boot loads
+ *                either the previous or the new config, never defaults, and
+ *                the save after it lands
+ *   migration    records written by v1 .. v6 firmware load their fields and
+ *                take defaults for the newer ones; the pre-journal raw v1
+ *                layout is migrated, and again after a cut during migration
+ *
+ * Each check prints ok / FAIL; any failure makes the exit status 1.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -DFLASH_OPS_HOST -I firmware/source tools/flash_config_test.cpp -o flash_config_test
+ *   ./flash_config_test
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_config.h"
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-70s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+// A config that differs from the defaults in every field, numbered by n.
+static void make_config(SystemConfig* c, uint32_t n) {
+    config_defaults(c);
+    snprintf(c->wifi_ssid, sizeof(c->wifi_ssid), "hive-net-%u", (unsigned)n);
+    snprintf(c->wifi_pass, sizeof(c->wifi_pass), "pass-%u", (unsigned)n);
+    snprintf(c->server_ip, sizeof(c->server_ip), "10.0.%u.%u", (unsigned)(n / 250 % 250), (unsigned)(n % 250));
+    c->server_port = 9000 + (int)n;
+    snprintf(c->node_id, sizeof(c->node_id), "hive-%u", (unsigned)n);
+    c->gain = 0.5f + 0.01f * (float)(n % 50);
+    c->sample_interval_s = 60 + n;
+    c->mqtt_port = (uint16_t)(1900 + n);
+    c->transport = TRANSPORT_MQTT;
+    c->wake_ratio = 2.5f;
+    c->gate_margin = 0.1f;
+    c->clip_seq = 100 + n;
+    c->adapt_ci = 0.05f;
+}
+
+static bool same(const SystemConfig* a, const SystemConfig* b) {
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+static void test_journal() {
+    printf("Journal:\n");
+    FlashSim sim;
+    FlashOps ops;
+    flash_sim_init(&sim, &ops, CONFIG_STORE_SECTORS);
+    ConfigStore st;
+    SystemConfig cfg, back;
+    check(!config_store_load(&st, &ops, &back), "empty store has no record");
+
+    const int saves = 5 * CONFIG_SLOTS_PER_SECTOR + 3;
+    bool ok = true;
+    for (int i = 1; i <= saves; i++) {
+        make_config(&cfg, (uint32_t)i);
+        ok &= config_store_save(&st, &cfg);
+        ConfigStore again;
+        ok &= config_store_load(&again, &ops, &back) && same(&back, &cfg) && again.seq == (uint32_t)i;
+    }
+    check(ok, "every save is what the next boot loads");
+    check(sim.erases == (uint32_t)(saves - 1) / CONFIG_SLOTS_PER_SECTOR, "one erase per sector of saves");
+    flash_sim_free(&sim);
+}
+
+// Runs `before` saves, cuts power after `cut` programmed bytes of the next
+// one, reboots and saves again. Returns false if either boot loads anything
+// but a config that was saved.
+static bool cut_save(int before, int32_t cut, bool* landed) {
+    FlashSim sim;
+    FlashOps ops;
+    flash_sim_init(&sim, &ops, CONFIG_STORE_SECTORS);
+    ConfigStore st;
+    SystemConfig prev, next, back;
+    config_store_load(&st, &ops, &back);
+    for (int i = 1; i <= before; i++) {
+        make_config(&prev, (uint32_t)i);
+        config_store_save(&st, &prev);
+    }
+
+    make_config(&next, (uint32_t)before + 1);
+    sim.fail_after = cut;
+    config_store_save(&st, &next);
+    sim.fail_after = -1;
+
+    bool ok = config_store_load(&st, &ops, &back) && (same(&back, &prev) || same(&back, &next));
+    *landed = ok && same(&back, &next);
+
+    SystemConfig after;
+    make_config(&after, 1000);
+    ok &= config_store_save(&st, &after);
+    ok &= config_store_load(&st, &ops, &back) && same(&back, &after);
+    flash_sim_free(&sim);
+    return ok;
+}
+
+static void test_power_loss() {
+    printf("Power loss:\n");
+    const int32_t record = (int32_t)(sizeof(ConfigRecHdr) + sizeof(SystemConfig));
+    const int cases[] = { 3, CONFIG_SLOTS_PER_SECTOR, 2 * CONFIG_SLOTS_PER_SECTOR };
+    const char* names[] = {
+        "mid-sector save",
+        "save compacting into sector 1",
+        "save compacting back into sector 0",
+    };
+    for (int c = 0; c < 3; c++) {
+        int bad = 0, old = 0;
+        for (int32_t cut = 0; cut <= record; cut++) {
+            bool landed;
+            if (!cut_save(cases[c], cut, &landed)) bad++;
+            if (!landed) old++;
+        }
+        char what[128];
+        snprintf(what, sizeof(what), "%s: %d cuts, %d load the previous config", names[c], (int)record + 1, old);
+        check(bad == 0 && old > 0, what);
+    }
+}
+
+static void test_versions() {
+    printf("Migration:\n");
+    const struct { uint16_t version; uint16_t size; } layouts[] = {
+        { 1, (uint16_t)CONFIG_V1_SIZE },
+        { 2, (uint16_t)offsetof(SystemConfig, mqtt_port) },
+        { 3, (uint16_t)offsetof(SystemConfig, wake_ratio) },
+        { 4, (uint16_t)offsetof(SystemConfig, gate_margin) },
+        { 5, (uint16_t)offsetof(SystemConfig, clip_seq) },
+        { 6, (uint16_t)offsetof(SystemConfig, adapt_ci) },
+    };
+    for (const auto& l : layouts) {
+        FlashSim sim;
+        FlashOps ops;
+        flash_sim_init(&sim, &ops, CONFIG_STORE_SECTORS);
+        SystemConfig old;
+        make_config(&old, 7);
+
+        // A record as firmware of that version wrote it: its prefix only
+        uint8_t page[FLASH_OPS_PAGE];
+        memset(page, 0xFF, sizeof(page));
+        ConfigRecHdr h = { CONFIG_REC_MAGIC, l.version, l.size, 42, 0 };
+        memcpy(page + sizeof(h), &old, l.size);
+        h.crc = config_rec_crc(&h, page + sizeof(h));
+        memcpy(page, &h, sizeof(h));
+        ops.program(ops.ctx, config_slot_off(0, 0), page, FLASH_OPS_PAGE);
+
+        ConfigStore st;
+        SystemConfig back, want;
+        config_defaults(&want);
+        memcpy(&want, &old, l.size);
+        bool ok = config_store_load(&st, &ops, &back) && same(&back, &want) && st.seq == 42;
+
+        // The next save writes the current version after it
+        ok &= config_store_save(&st, &back);
+        SystemConfig again;
+        ok &= config_store_load(&st, &ops, &again) && same(&again, &want) && st.next_slot == 2;
+        char what[96];
+        snprintf(what, sizeof(what), "v%u record loads, newer fields default, resaves as v%d",
+                 (unsigned)l.version, CONFIG_VERSION);
+        check(ok, what);
+        flash_sim_free(&sim);
+    }
+
+    // Pre-journal: raw v1 config at the start of the last sector
+    for (int cut_first = 1; cut_first >= 0; cut_first--) {
+        FlashSim sim;
+        FlashOps ops;
+        flash_sim_init(&sim, &ops, CONFIG_STORE_SECTORS);
+        SystemConfig legacy;
+        make_config(&legacy, 3);
+        flash_write_bytes(&ops, (CONFIG_STORE_SECTORS - 1) * FLASH_OPS_SECTOR, &legacy, CONFIG_V1_SIZE);
+
+        ConfigStore st;
+        SystemConfig back, want;
+        config_defaults(&want);
+        memcpy(&want, &legacy, CONFIG_V1_SIZE);
+        bool ok = !config_store_load(&st, &ops, &back);
+        if (cut_first) {
+            sim.fail_after = 20;                // power fails during the first journal record
+            config_store_migrate(&st, &back);
+            sim.fail_after = -1;
+            ok &= !config_store_load(&st, &ops, &back);
+        }
+        ok &= config_store_migrate(&st, &back) && same(&back, &want);
+        ok &= config_store_load(&st, &ops, &back) && same(&back, &want);
+
+        // Compaction into the legacy sector retires the old layout for good
+        SystemConfig cfg = back;
+        for (int i = 0; i < 2 * CONFIG_SLOTS_PER_SECTOR; i++) {
+            cfg.gain = 0.01f * (float)i;
+            ok &= config_store_save(&st, &cfg);
+        }
+        uint32_t magic;
+        ops.read(ops.ctx, (CONFIG_STORE_SECTORS - 1) * FLASH_OPS_SECTOR, &magic, sizeof(magic));
+        ok &= config_store_load(&st, &ops, &back) && same(&back, &cfg) && magic != CONFIG_MAGIC;
+        check(ok, cut_first ? "legacy v1 layout migrates after a cut during migration"
+                            : "legacy v1 layout migrates, compaction retires it");
+        flash_sim_free(&sim);
+    }
+}
+
+int main() {
+    test_journal();
+    test_power_loss();
+    test_versions();
+    if (g_failures) {
+        printf("\n%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("\nAll checks passed\n");
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ * HappyBees Record Log Test
+ *
+ * Drives firmware/source/flash_log.h on the RAM flash simulator (FlashSim,
+ * FLASH_OPS_HOST) and checks what the node relies on after a reboot:
+ *
+ *   replay       records come back once, in order, with their payloads, and
+ *                a persisted ACK survives a reboot
+ *   wraparound   a small region wrapped many times keeps the newest records,
+ *                counts the overwritten unacknowledged ones as dropped, and
+ *                keeps sequence numbers running across reboots
+ *   torn write   a power cut part-way through a record (cut points every
+ *                3 bytes across it) loses only that record; the boot scan
+ *                closes the sector and appends continue in the next one
+ *   CRC          a record with a flipped bit in its payload or header is
+ *                never replayed, and records in later sectors still are
+ *
+ * Each check prints ok / FAIL; any failure makes the exit status 1.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -DFLASH_OPS_HOST -I firmware/source tools/flash_log_test.cpp -o flash_log_test
+ *   ./flash_log_test
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "flash_log.h"
+
+#define PAYLOAD_BYTES   88          // a feature record
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+// Payload derived from a tag, so every replayed record can be verified.
+static void make_payload(uint32_t tag, uint8_t* p) {
+    memcpy(p, &tag, sizeof(tag));
+    for (int i = sizeof(tag); i < PAYLOAD_BYTES; i++) p[i] = (uint8_t)(tag * 31 + i);
+}
+
+static bool payload_ok(const LogRecHdr& h, const uint8_t* p, uint32_t* tag) {
+    uint8_t want[PAYLOAD_BYTES];
+    if (h.len != PAYLOAD_BYTES) return false;
+    memcpy(tag, p, sizeof(*tag));
+    make_payload(*tag, want);
+    return memcmp(p, want, PAYLOAD_BYTES) == 0;
+}
+
+static uint32_t append(FlashLog* log, uint32_t tag) {
+    uint8_t p[PAYLOAD_BYTES];
+    make_payload(tag, p);
+    return log_append(log, LOG_FEATURES, p, PAYLOAD_BYTES);
+}
+
+// Replays and acknowledges everything pending; returns the tags in order,
+// or stops at the first record whose payload does not verify.
+static std::vector<uint32_t> replay(FlashLog* log, bool* intact) {
+    std::vector<uint32_t> tags;
+    LogRecHdr h;
+    uint8_t buf[LOG_MAX_PAYLOAD];
+    *intact = true;
+    while (log_peek(log, &h, buf)) {
+        uint32_t tag;
+        if (!payload_ok(h, buf, &tag) || h.seq != tag) { *intact = false; break; }
+        tags.push_back(tag);
+        log_ack(log, &h);
+    }
+    return tags;
+}
+
+static bool consecutive(const std::vector<uint32_t>& tags, uint32_t first, uint32_t last) {
+    if (tags.size() != last - first + 1) return false;
+    for (size_t i = 0; i < tags.size(); i++) if (tags[i] != first + i) return false;
+    return true;
+}
+
+static void test_replay() {
+    printf("Replay:\n");
+    FlashSim sim;
+    FlashOps ops;
+    flash_sim_init(&sim, &ops, 8);
+    FlashLog log;
+    log_init(&log, &ops, NULL);
+    for (uint32_t i = 1; i <= 100; i++) append(&log, i);
+
+    log_init(&log, &ops, NULL);
+    check(log.next_seq == 101 && log_pending(&log) == 100, "reboot finds all 100 records pending");
+    check(log.boot == 2, "boot number advances");
+
+    LogRecHdr h;
+    uint8_t buf[LOG_MAX_PAYLOAD];
+    for (int i = 0; i < 40 && log_peek(&log, &h, buf); i++) log_ack(&log, &h);
+    log_commit_ack(&log);
+    log_init(&log, &ops, NULL);
+    check(log.acked_seq == 40 && log_pending(&log) == 60, "persisted ACK survives a reboot");
+
+    bool intact;
+    std::vector<uint32_t> tags = replay(&log, &intact);
+    check(intact && consecutive(tags, 41, 100), "replay returns 41..100 in order, payloads intact");
+    check(!log_peek(&log, &h, buf) && log.dropped == 0, "drained log, nothing dropped");
+    flash_sim_free(&sim);
+}
+
+static void test_wraparound() {
+    printf("Wraparound:\n");
+    FlashSim sim;
+    FlashOps ops;
+    flash_sim_init(&sim, &ops, 4);
+    FlashLog log;
+    log_init(&log, &ops, NULL);
+
+    // ~36 records per sector: 1000 records wrap the 4-sector circle ~7 times
+    const uint32_t total = 1000;
+    for (uint32_t i = 1; i <= total; i++) append(&log, i);
+    uint32_t dropped = log.dropped;
+    check(dropped > 0 && log_pending(&log) + dropped == total, "overwritten records are counted as dropped");
+    check(sim.erases >= 4 * 6, "every sector recycled several times");
+
+    log_init(&log, &ops, NULL);
+    check(log.next_seq == total + 1, "reboot resumes the sequence after the last record");
+
+    bool intact;
+    std::vector<uint32_t> tags = replay(&log, &intact);
+    check(intact && !tags.empty() && tags.back() == total && consecutive(tags, tags.front(), total),
+          "replay after wrap is the newest records, in order");
+    check(tags.size() <= 4 * ((FLASH_OPS_SECTOR - sizeof(LogSectorHdr)) / log_align(sizeof(LogRecHdr) + PAYLOAD_BYTES)),
+          "no more records than the region holds");
+
+    // Acked wrap: nothing pending may be dropped when the circle comes round
+    log_commit_ack(&log);
+    uint32_t before = log.dropped;
+    for (uint32_t i = total + 1; i <= total + 300; i++) {
+        append(&log, i);
+        LogRecHdr h;
+        uint8_t buf[LOG_MAX_PAYLOAD];
+        while (log_peek(&log, &h, buf)) log_ack(&log, &h);
+    }
+    check(log.dropped == before && log_pending(&log) == 0, "acknowledged records wrap without drops");
+    flash_sim_free(&sim);
+}
+
+static void test_torn_write() {
+    printf("Torn write:\n");
+    const uint32_t rec_bytes = log_align(sizeof(LogRecHdr) + PAYLOAD_BYTES);
+    uint32_t bad = 0, cuts = 0;
+    for (uint32_t cut = 1; cut < rec_bytes; cut += 3) {
+        FlashSim sim;
+        FlashOps ops;
+        flash_sim_init(&sim, &ops, 4);
+        FlashLog log;
+        log_init(&log, &ops, NULL);
+        for (uint32_t i = 1; i <= 10; i++) append(&log, i);
+
+        sim.fail_after = (int32_t)cut;          // power fails inside record 11
+        append(&log, 11);
+        sim.fail_after = -1;
+        LogRecHdr r;
+        if (log_read_record(&log, log.head_sector, log.head_off - rec_bytes, &r, NULL) > 0) {
+            flash_sim_free(&sim);               // the cut came after the last programmed byte
+            break;
+        }
+
+        log_init(&log, &ops, NULL);
+        bool torn_ok = log.torn == 1 && log.next_seq == 11 && log.head_off == FLASH_OPS_SECTOR;
+        append(&log, 11);                       // the node logs its next record
+        append(&log, 12);
+        bool intact;
+        std::vector<uint32_t> tags = replay(&log, &intact);
+        if (!torn_ok || !intact || !consecutive(tags, 1, 12)) bad++;
+        cuts++;
+        flash_sim_free(&sim);
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "%u cut points: torn record lost, sector closed, 1..12 replay", (unsigned)cuts);
+    check(bad == 0, what);
+
+    // A cut as the next sector is opened: neither erase nor header lands
+    FlashSim sim;
+    FlashOps ops;
+    flash_sim_init(&sim, &ops, 4);
+    FlashLog log;
+    log_init(&log, &ops, NULL);
+    uint32_t n = 0;
+    while (log.head_off + log_align(sizeof(LogRecHdr) + PAYLOAD_BYTES) <= FLASH_OPS_SECTOR) append(&log, ++n);
+    sim.fail_after = 0;                         // the next append opens sector 1
+    append(&log, ++n);
+    sim.fail_after = -1;
+    log_init(&log, &ops, NULL);
+    append(&log, log.next_seq);
+    bool intact;
+    std::vector<uint32_t> tags = replay(&log, &intact);
+    check(intact && !tags.empty() && consecutive(tags, 1, tags.back()), "cut during a sector header keeps earlier records");
+    flash_sim_free(&sim);
+}
+
+// Flips one programmed bit of the record with sequence `seq`.
+static bool corrupt(FlashSim* sim, FlashLog* log, uint32_t seq, uint32_t byte_in_record) {
+    for (uint32_t s = 0; s < log->sectors; s++) {
+        uint32_t off = sizeof(LogSectorHdr);
+        LogRecHdr h;
+        int n;
+        while ((n = log_read_record(log, s, off, &h, NULL)) > 0) {
+            if (h.type != LOG_ACK && h.seq == seq) {
+                uint8_t* p = sim->mem + s * FLASH_OPS_SECTOR + off + byte_in_record;
+                for (int b = 0; b < 8; b++) {
+                    if (*p & (1u << b)) { *p &= (uint8_t)~(1u << b); return true; }
+                }
+                return false;
+            }
+            off += n;
+        }
+    }
+    return false;
+}
+
+static void test_crc() {
+    printf("CRC rejection:\n");
+    const uint32_t targets[][2] = {
+        { 5, sizeof(LogRecHdr) + 40 },          // payload bit
+        { 12, 0 },                              // header magic
+        { 20, offsetof(LogRecHdr, seq) },       // header sequence number
+    };
+    for (const auto& t : targets) {
+        FlashSim sim;
+        FlashOps ops;
+        flash_sim_init(&sim, &ops, 8);
+        FlashLog log;
+        log_init(&log, &ops, NULL);
+        for (uint32_t i = 1; i <= 120; i++) append(&log, i);   // ~3.3 sectors
+        bool flipped = corrupt(&sim, &log, t[0], t[1]);
+
+        log_init(&log, &ops, NULL);
+        LogRecHdr h;
+        uint8_t buf[LOG_MAX_PAYLOAD];
+        bool intact = true, seen = false, later = false;
+        while (log_peek(&log, &h, buf)) {
+            uint32_t tag;
+            if (!payload_ok(h, buf, &tag) || h.seq != tag) intact = false;
+            if (h.seq == t[0]) seen = true;
+            if (h.seq > 40) later = true;
+            log_ack(&log, &h);
+        }
+        char what[96];
+        snprintf(what, sizeof(what), "record %u with a bit flipped at byte %u is rejected",
+                 (unsigned)t[0], (unsigned)t[1]);
+        check(flipped && intact && !seen && later, what);
+        flash_sim_free(&sim);
+    }
+}
+
+int main() {
+    test_replay();
+    test_wraparound();
+    test_torn_write();
+    test_crc();
+    if (g_failures) {
+        printf("\n%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("\nAll checks passed\n");
+    return 0;
+}
@@ -5,9 +5,14 @@ HappyBees Mac Shim
 Reference ML implementation that runs on Mac/PC using the computer's microphone.
 Used to establish ground truth for model predictions and verify firmware parity.
 
+Features come from the firmware's own feature stage when the bee_features
+module is built (tools/bee_features, see setup.py there); otherwise, or with
+--scipy-dsp, from the scipy reimplementation below.
+
 Usage:
     python tools/mac_shim.py --model summer --verbose
     python tools/mac_shim.py --model winter --mock-temp 30.0
+    python tools/mac_shim.py --scipy-dsp
 """
 
 import argparse
@@ -24,6 +29,12 @@ except ImportError:
     print("ERROR: TensorFlow not installed. Run: pip install tensorflow")
     sys.exit(1)
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'bee_features'))
+try:
+    import bee_features
+except ImportError:
+    bee_features = None
+
 # Constants matching firmware
 SAMPLE_RATE = 16000
 DURATION = 6
@@ -141,7 +152,10 @@ def main():
     parser.add_argument('--mock-humidity', type=float, default=50.0)
     parser.add_argument('--verbose', action='store_true')
     parser.add_argument('--no-loop', action='store_true')
+    parser.add_argument('--scipy-dsp', action='store_true', help='use the scipy pipeline, not bee_features')
     args = parser.parse_args()
+    firmware_dsp = bee_features is not None and not args.scipy_dsp
+    print(f"DSP: {'firmware (bee_features)' if firmware_dsp else 'scipy reimplementation'}")
 
     model_path = get_model_path(args.model)
     print(f"Loading TFLite model: {model_path}")
@@ -181,10 +195,14 @@ def main():
             if args.verbose:
                 print(f"[DSP] Raw stats: min={recording.min():.3f}, max={recording.max():.3f}")
 
-            processed_audio = process_audio(recording, args.verbose)
-            fft_mags = compute_fft_features(processed_audio, args.verbose)
-
-            current_density = np.sqrt(np.mean(processed_audio ** 2))
+            if firmware_dsp:
+                # the sound card's [-1, 1] maps to the ADC's +-2048 counts, so gain 1
+                fft_mags, current_density = bee_features.capture_features(
+                    bee_features.float_to_adc(recording), gain=1.0)
+            else:
+                processed_audio = process_audio(recording, args.verbose)
+                fft_mags = compute_fft_features(processed_audio, args.verbose)
+                current_density = np.sqrt(np.mean(processed_audio ** 2))
             state.update_density(current_density)
             state.update_temp(args.mock_temp)
 
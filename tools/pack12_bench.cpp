@@ -0,0 +1,96 @@
+/*
+ * HappyBees Packed Capture Benchmark
+ *
+ * Host counterpart of the firmware's `cap bench N`: fills a 6 s capture
+ * (96000 12-bit samples) with pseudo-random ADC values, packs it block by
+ * block with pack12_encode() as capture_store_push() does, then times
+ * pack12_decode() over the whole buffer in 512-sample windows, the way the
+ * DSP loop reads it through capture_store_read(). The unpacked buffer read
+ * with memcpy is the baseline. Every window is compared against the input,
+ * odd lengths included, and a mismatch fails the run (exit status 1).
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -I firmware/source tools/pack12_bench.cpp -o pack12_bench
+ *   ./pack12_bench [iterations]
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "audio_codec.h"
+
+#define SAMPLES         (16000 * 6)
+#define WINDOW          512             // RING_BLOCK_SAMPLES
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Packs and unpacks lengths 0..n and checks every sample survives.
+static int check_round_trip(const std::vector<uint16_t>& in) {
+    std::vector<uint8_t> packed(PACK12_BYTES(WINDOW + 8));
+    std::vector<uint16_t> out(WINDOW + 8);
+    int bad = 0;
+    for (int n = 0; n <= WINDOW + 7; n++) {
+        size_t bytes = pack12_encode(in.data(), n, packed.data());
+        pack12_decode(packed.data(), n, out.data());
+        if (bytes != (size_t)PACK12_BYTES(n) || memcmp(out.data(), in.data(), n * sizeof(uint16_t)) != 0) bad++;
+    }
+    return bad;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    if (iterations <= 0) iterations = 200;
+
+    std::vector<uint16_t> adc(SAMPLES);
+    srand(1);
+    for (uint16_t& s : adc) s = (uint16_t)(rand() & 0x0FFF);
+
+    std::vector<uint8_t> store(PACK12_BYTES(SAMPLES));
+    for (int off = 0; off < SAMPLES; off += WINDOW) {
+        int n = SAMPLES - off < WINDOW ? SAMPLES - off : WINDOW;
+        pack12_encode(&adc[off], n, &store[off / 2 * 3]);
+    }
+
+    int failures = check_round_trip(adc);
+    std::vector<uint16_t> window(WINDOW);
+    for (int off = 0; off < SAMPLES; off += WINDOW) {
+        int n = SAMPLES - off < WINDOW ? SAMPLES - off : WINDOW;
+        pack12_decode(&store[off / 2 * 3], n, window.data());
+        if (memcmp(window.data(), &adc[off], n * sizeof(uint16_t)) != 0) failures++;
+    }
+
+    uint32_t check = 0;
+    double t0 = now_ms();
+    for (int it = 0; it < iterations; it++) {
+        for (int off = 0; off < SAMPLES; off += WINDOW) {
+            int n = SAMPLES - off < WINDOW ? SAMPLES - off : WINDOW;
+            pack12_decode(&store[off / 2 * 3], n, window.data());
+            check += window[it % WINDOW];
+        }
+    }
+    double t_unpack = now_ms() - t0;
+
+    t0 = now_ms();
+    for (int it = 0; it < iterations; it++) {
+        for (int off = 0; off < SAMPLES; off += WINDOW) {
+            int n = SAMPLES - off < WINDOW ? SAMPLES - off : WINDOW;
+            memcpy(window.data(), &adc[off], n * sizeof(uint16_t));
+            check += window[it % WINDOW];
+        }
+    }
+    double t_copy = now_ms() - t0;
+
+    double samples = (double)SAMPLES * iterations;
+    printf("Store:  %d B packed vs %d B uint16 (-%d%%)\n", PACK12_BYTES(SAMPLES), SAMPLES * 2,
+           100 - PACK12_BYTES(SAMPLES) * 100 / (SAMPLES * 2));
+    printf("Unpack: %.2f ns/sample, %.3f ms per 6 s buffer\n", t_unpack * 1e6 / samples, t_unpack / iterations);
+    printf("Copy:   %.2f ns/sample, %.3f ms per 6 s buffer (chk %u)\n", t_copy * 1e6 / samples,
+           t_copy / iterations, (unsigned)check);
+    printf("Round trip: %s\n", failures ? "FAILED" : "exact");
+    return failures ? 1 : 0;
+}
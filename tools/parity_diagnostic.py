@@ -5,6 +5,10 @@ HappyBees Parity Diagnostic Tool
 Analyzes audio files and shows intermediate DSP values at each stage.
 Used to verify firmware calculations match the reference implementation.
 
+With the bee_features module built (tools/bee_features), WAV files from
+audio_capture.py also go through the firmware's own feature stage and the
+report shows how far the scipy pipeline is from it.
+
 Usage:
     python tools/parity_diagnostic.py pico_audio.wav
     python tools/parity_diagnostic.py pico_audio.wav --gain 0.35
@@ -12,10 +16,18 @@ Usage:
 """
 
 import argparse
+import os
+import sys
 import numpy as np
 import scipy.signal
 import scipy.io.wavfile
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'bee_features'))
+try:
+    import bee_features
+except ImportError:
+    bee_features = None
+
 SAMPLE_RATE = 16000
 FFT_SIZE = 512
 FFT_HOP = 512
@@ -90,6 +102,16 @@ def analyze_audio(audio_data, source_name, gain_compensation=1.0):
     print(f"  RMS density:  {rms_density:.6f}")
     print(f"  Bins[4-7]:    {bins[4]:.6f}, {bins[5]:.6f}, {bins[6]:.6f}, {bins[7]:.6f}")
 
+    if bee_features is not None and audio_data.dtype == np.int16:
+        fw_bins, fw_density = bee_features.capture_features(
+            bee_features.wav_to_adc(audio_data), gain=gain_compensation)
+        lo, hi = bee_features.FIRST_BIN, bee_features.NUM_FREQ_BINS
+        worst = np.max(np.abs(bins[lo:hi] - fw_bins[lo:hi]) / (np.abs(fw_bins[lo:hi]) + 1e-9))
+        print(f"\n[FIRMWARE] bee_features (the node's own DSP):")
+        print(f"  RMS density:  {fw_density:.6f}")
+        print(f"  Bins[4-7]:    {fw_bins[4]:.6f}, {fw_bins[5]:.6f}, {fw_bins[6]:.6f}, {fw_bins[7]:.6f}")
+        print(f"  Bins[{lo}-{hi - 1}] worst relative difference from scipy: {worst * 100:.2f}%")
+
     return {'rms_density': rms_density, 'bins': bins}
 
 
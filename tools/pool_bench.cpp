@@ -0,0 +1,109 @@
+/*
+ * HappyBees Pool Allocator Benchmark
+ *
+ * Builds firmware/source/pool_alloc.cpp off-target (POOL_ALLOC_HOST) and runs
+ * the firmware's own `pool bench`: one summer inference's allocation pattern
+ * (TFLite arena, output tensor list, DSP matrix, small SDK structs) against
+ * malloc and the pool. Host malloc is far faster than newlib's on the RP2350,
+ * so the ratio here is a lower bound for the node; the absolute numbers on
+ * the node come from `pool bench N` on the serial console.
+ *
+ * Before timing it checks the per-inference rewind of POOL_MODE_RESET:
+ *   - a clean frame rewinds to its mark
+ *   - a frame block still live blocks the rewind, even when a block from
+ *     before the frame was freed in between (same live count)
+ *   - blocks kept from before the frame survive a rewind
+ *   - ei_calloc refuses an nitems * size that overflows
+ * and exits non-zero if any of them fails.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -DPOOL_ALLOC_HOST -I firmware -I firmware/source \
+ *       tools/pool_bench.cpp firmware/source/pool_alloc.cpp -o pool_bench
+ *   ./pool_bench [iterations]
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool_alloc.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+static uint32_t carved() {
+    PoolStats s;
+    pool_get_stats(&s);
+    return s.carved;
+}
+
+static uint32_t resets() {
+    PoolStats s;
+    pool_get_stats(&s);
+    return s.resets;
+}
+
+static void check_rewind() {
+    printf("Reset-per-inference rewind:\n");
+    pool_init(POOL_MODE_RESET);
+
+    // Survives every inference, like the impulse handle's state.
+    void* kept = ei_malloc(200);
+    void* before = ei_malloc(40);
+    uint32_t mark = carved();
+
+    pool_inference_begin();
+    void* a = ei_malloc(7764);
+    void* b = ei_calloc(10, 8);
+    ei_free(b);
+    ei_free(a);
+    uint32_t r = resets();
+    pool_inference_done();
+    check(resets() == r + 1 && carved() == mark, "clean frame rewinds to its mark");
+
+    pool_inference_begin();
+    void* leak = ei_malloc(48);
+    ei_free(before);                        // live count back where it started
+    r = resets();
+    pool_inference_done();
+    check(resets() == r && carved() > mark, "live frame block blocks the rewind");
+    ei_free(leak);
+
+    pool_inference_begin();
+    void* c = ei_malloc(48);
+    ei_free(c);
+    r = resets();
+    pool_inference_done();
+    check(resets() == r + 1, "rewinds again once the block is freed");
+
+    memset(kept, 0x5A, 200);
+    pool_inference_begin();
+    void* d = ei_malloc(200);               // must not be handed the kept block
+    check(d != kept, "blocks from before the frame survive");
+    ei_free(d);
+    pool_inference_done();
+    ei_free(kept);
+
+    check(ei_calloc(SIZE_MAX / 4, 8) == NULL, "ei_calloc rejects nitems * size overflow");
+    pool_init(POOL_MODE_PERSISTENT);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+
+    check_rewind();
+    printf("\n");
+    pool_benchmark(iterations);
+    pool_print_stats();
+
+    if (g_failures) {
+        printf("\n%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
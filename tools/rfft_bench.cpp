@@ -0,0 +1,105 @@
+/*
+ * HappyBees Real FFT Benchmark
+ *
+ * Times the SDK's numpy::rfft, which now runs power-of-two sizes on the
+ * compile-time-twiddle transform in dsp/pow2_rfft.hpp, against the kissfft
+ * path it replaces: numpy::software_rfft, which builds a kiss_fftr config on
+ * every call, and kiss_fftr alone with a config built once. The three outputs
+ * are compared bin by bin. The sizes cover 512 (bee_dsp.h's window) and the
+ * 256 / 1024 points of the spectrogram and MFE blocks.
+ *
+ * Sizes that are not powers of two (e.g. 40 for an MFCC DCT, 400 for 25 ms
+ * frames) stay on kissfft in both columns. Built with
+ * -DEIDSP_FFT_PLAN_CACHE_SIZE=<bytes>, software_rfft takes its config from
+ * the plan cache (dsp/fft_plans.hpp) instead of building one per call, which
+ * brings it down to the "kiss only" time; the cache counters are printed at
+ * the end.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -I firmware tools/rfft_bench.cpp \
+ *       firmware/edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp \
+ *       firmware/edge-impulse-sdk/dsp/memory.cpp \
+ *       firmware/edge-impulse-sdk/dsp/fft_plans.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp -o rfft_bench
+ *   ./rfft_bench
+ *   ./rfft_bench 40 400 1000       (add -DEIDSP_FFT_PLAN_CACHE_SIZE=32768 to compare)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+
+#define MIN_BENCH_NS    200e6   // run each variant at least this long
+
+using ei::fft_complex_t;
+
+// Mean time per call of fn(), repeated until MIN_BENCH_NS has passed
+template <typename Fn>
+static double ns_per_call(Fn fn) {
+    uint64_t calls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double ns = 0;
+    do {
+        for (int i = 0; i < 100; i++) fn();
+        calls += 100;
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    } while (ns < MIN_BENCH_NS);
+    return ns / calls;
+}
+
+static double max_diff(const std::vector<fft_complex_t>& a, const std::vector<fft_complex_t>& b) {
+    double worst = 0;
+    for (size_t k = 0; k < a.size(); k++) worst = fmax(worst, hypot(a[k].r - b[k].r, a[k].i - b[k].i));
+    return worst;
+}
+
+static void bench(size_t n) {
+    const size_t bins = n / 2 + 1;
+    std::vector<float> x(n), work(n);
+    std::vector<fft_complex_t> out_pow2(bins), out_sw(bins), out_kiss(bins);
+    srand((unsigned)n);
+    for (size_t i = 0; i < n; i++) x[i] = (float)rand() / RAND_MAX - 0.5f;
+
+    kiss_fftr_cfg cfg = kiss_fftr_alloc((int)n, 0, NULL, NULL, NULL);
+    if (!cfg) { fprintf(stderr, "kiss_fftr_alloc(%zu) failed\n", n); return; }
+
+    int ret = ei::numpy::rfft(x.data(), n, out_pow2.data(), bins, n);
+    if (ret != ei::EIDSP_OK) { fprintf(stderr, "rfft(%zu) failed (%d)\n", n, ret); free(cfg); return; }
+    work = x;
+    ei::numpy::software_rfft(work.data(), out_sw.data(), n, bins);
+    kiss_fftr(cfg, x.data(), (kiss_fft_cpx*)out_kiss.data());
+
+    double t_rfft = ns_per_call([&] { ei::numpy::rfft(x.data(), n, out_pow2.data(), bins, n); });
+    double t_sw = ns_per_call([&] { work = x; ei::numpy::software_rfft(work.data(), out_sw.data(), n, bins); });
+    double t_kiss = ns_per_call([&] { kiss_fftr(cfg, x.data(), (kiss_fft_cpx*)out_kiss.data()); });
+    free(cfg);
+
+    printf("%5zu %10.2f %10.2f %10.2f %8.2fx %8.2fx   %.2g\n", n, t_rfft / 1000.0, t_sw / 1000.0, t_kiss / 1000.0,
+           t_sw / t_rfft, t_kiss / t_rfft, fmax(max_diff(out_pow2, out_sw), max_diff(out_pow2, out_kiss)));
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back((size_t)atoi(argv[i]));
+    if (sizes.empty()) sizes = { 256, 512, 1024 };
+
+    printf("                      us per call            speedup of rfft\n");
+    printf("    N      rfft   sw_rfft  kiss only  vs sw_rfft  vs kiss   max diff\n");
+    for (size_t n : sizes) {
+        if (n < 2 || (n & 1)) { fprintf(stderr, "skipping N=%zu (must be even)\n", n); continue; }
+        bench(n);
+    }
+
+    ei::ei_fft_plan_stats_t st;
+    ei::ei_fft_plan_get_stats(&st);
+    if (EIDSP_FFT_PLAN_CACHE_SIZE > 0) {
+        printf("\nplan cache %d B in %d slots: %u hits, %u builds, %u evictions, %u uncached\n",
+               (int)EIDSP_FFT_PLAN_CACHE_SIZE, (int)EIDSP_FFT_PLAN_CACHE_SLOTS,
+               (unsigned)st.hits, (unsigned)st.builds, (unsigned)st.evictions, (unsigned)st.uncached);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * HappyBees Rolling Feature Check
+ *
+ * Feeds recorded WAVs through the live-mode feature path the way live_poll()
+ * does: every 512-sample block goes through bee_dsp_window() with the DC from
+ * roll_dc() and into firmware/source/rolling_features.h. At each hop the
+ * running sums (roll_bins(), roll_density()) are checked against brute-force
+ * averages over the same last ROLL_WINDOWS windows, recomputed from scratch.
+ * This covers the add/subtract updates, the wrap-around resum and
+ * floating-point drift over long runs.
+ *
+ * Prints, per recording, the results checked, the resums and the largest
+ * relative error of the bins and of the density. Any error above
+ * ROLL_REL_TOL makes the exit status 1.
+ *
+ * WAVs are 16-bit PCM at 16 kHz as written by audio_capture.py (see
+ * wav_reader.h). --seconds limits each recording (default 300, 0 = all).
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -I firmware/source tools/rolling_check.cpp -o rolling_check
+ *   ./rolling_check day1.wav day2.wav
+ *   ./rolling_check day1.wav --seconds 0 --hop 8 --gain 2.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "rolling_features.h"
+#include "wav_reader.h"
+
+#define SAMPLE_RATE_HZ      16000
+#define ROLL_REL_TOL        1e-6
+
+struct Window {
+    float mags[NUM_FREQ_BINS];
+    float mean_square;
+};
+
+static double rel_err(double got, double want) {
+    return fabs(got - want) / (fabs(want) > 1e-12 ? fabs(want) : 1.0);
+}
+
+// Runs one recording; returns false if any result is off by more than ROLL_REL_TOL.
+static bool check_recording(const char* path, double seconds, uint32_t hop, float gain) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    if (!wav_read_pcm16(path, &pcm, &rate)) return false;
+    if (rate != SAMPLE_RATE_HZ) { fprintf(stderr, "%s: %u Hz, need %d Hz\n", path, rate, SAMPLE_RATE_HZ); return false; }
+    size_t samples = pcm.size();
+    if (seconds > 0 && (size_t)(seconds * SAMPLE_RATE_HZ) < samples) samples = (size_t)(seconds * SAMPLE_RATE_HZ);
+
+    static RollingFeatures roll;
+    roll_init(&roll, hop);
+    reset_filters();
+    std::vector<Window> history;
+    uint16_t blk[FFT_SIZE];
+    double worst_bin = 0, worst_density = 0;
+    uint32_t results = 0;
+
+    for (size_t off = 0; off + FFT_SIZE <= samples; off += FFT_SIZE) {
+        uint32_t raw_sum = 0;
+        for (int i = 0; i < FFT_SIZE; i++) {
+            blk[i] = wav_to_adc(pcm[off + i]);
+            raw_sum += blk[i] & 0x0FFF;
+        }
+        Window w;
+        double sumsq = bee_dsp_window(blk, roll_dc(&roll, blk), gain, w.mags);
+        w.mean_square = (float)(sumsq / FFT_SIZE);
+        history.push_back(w);
+        if (!roll_add(&roll, w.mags, w.mean_square, raw_sum)) continue;
+
+        // Brute force over the last ROLL_WINDOWS windows
+        double want[NUM_FREQ_BINS] = {0}, ms = 0;
+        for (size_t i = history.size() - ROLL_WINDOWS; i < history.size(); i++) {
+            for (int k = 0; k < NUM_FREQ_BINS; k++) want[k] += history[i].mags[k];
+            ms += history[i].mean_square;
+        }
+        double got[NUM_FREQ_BINS];
+        roll_bins(&roll, got);
+        for (int k = 0; k < NUM_FREQ_BINS; k++) worst_bin = fmax(worst_bin, rel_err(got[k], want[k] / ROLL_WINDOWS));
+        double density = sqrt(fmax(ms / ROLL_WINDOWS, 0.0));
+        worst_density = fmax(worst_density, rel_err(roll_density(&roll), density));
+        results++;
+    }
+
+    bool ok = results > 0 && worst_bin <= ROLL_REL_TOL && worst_density <= ROLL_REL_TOL;
+    printf("  %-28s %7.1f s  %5u results  %3u resums  bins %.2g  density %.2g  %s\n", wav_base_name(path).c_str(),
+           samples / (double)SAMPLE_RATE_HZ, (unsigned)results, (unsigned)roll.resums, worst_bin, worst_density,
+           ok ? "ok" : (results ? "FAIL" : "FAIL (shorter than one window)"));
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> paths;
+    double seconds = 300;
+    uint32_t hop = ROLL_DEFAULT_HOP;
+    float gain = 0.4f;                  // CONFIG_DEFAULT_GAIN
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--hop") && i + 1 < argc) hop = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gain") && i + 1 < argc) gain = (float)atof(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s file.wav... [--seconds S] [--hop N] [--gain G]\n", argv[0]);
+            return 1;
+        }
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) { fprintf(stderr, "no recordings\n"); return 1; }
+
+    bee_dsp_init();
+    printf("%d windows per result, a result every %u windows, gain %.2f\n\n", ROLL_WINDOWS, (unsigned)hop, gain);
+    int failures = 0;
+    for (const char* p : paths) if (!check_recording(p, seconds, hop, gain)) failures++;
+    if (failures) {
+        printf("\n%d recording(s) failed\n", failures);
+        return 1;
+    }
+    printf("\nAll results match\n");
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * HappyBees Scheduler Simulation
+ *
+ * Host build of firmware/source/sample_scheduler.h against a virtual clock
+ * (the time_us_64 the node passes to sched_init() is replaced by a counter
+ * this program advances). First it checks the scheduler's contract:
+ *
+ *   - jobs start on a fixed grid anchored at the first job; after a job
+ *     that overruns, the missed slot runs once, late, and any others it
+ *     covered are skipped instead of run back to back
+ *   - the uplink window opens after each job and closes after
+ *     SCHED_UPLINK_MAX_MS even with records left
+ *   - records logged between jobs (a command, a live result) open a window
+ *     at once without moving the job grid
+ *   - naps never exceed SCHED_NAP_MAX_MS or run past the next job
+ *   - with the interval at 0 there are no jobs or naps and the uplink is
+ *     always open
+ *
+ * then runs sched_simulate(), the same loop as the node's `sched sim`, over
+ * a few job and uplink costs at the default 15 min cadence. Any failed check
+ * makes the exit status 1.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -I firmware/source tools/sched_sim.cpp -o sched_sim
+ *   ./sched_sim [jobs]
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "sample_scheduler.h"
+
+static uint64_t g_now_us = 0;
+static uint64_t fake_time_us_64() { return g_now_us; }
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+static void test_grid() {
+    SampleScheduler s;
+    g_now_us = 5000000;
+    sched_init(&s, fake_time_us_64);
+    sched_set_interval(&s, 60);
+
+    check(sched_due(&s) && !sched_due(&s), "first job is due at once, then not again");
+    sched_job_begin(&s);
+    g_now_us += 2000000;
+    sched_job_end(&s);
+
+    g_now_us = 5000000 + 59999000;
+    bool early = sched_due(&s);
+    g_now_us = 5000000 + 60000000 + 1500;
+    bool on_time = sched_due(&s);
+    check(!early && on_time && s.max_late_ms == 1, "second job is due on the grid, not before");
+
+    // A 150 s job ends past the next two slots: one runs late, one is skipped
+    sched_job_begin(&s);
+    check(!sched_due(&s), "no job is due while one runs");
+    g_now_us += 150000000;
+    sched_job_end(&s);
+    check(sched_due(&s) && s.skipped == 1 && s.max_late_ms == 90001, "overrun runs one job late, skips the rest");
+    check(s.next_due_us == 5000000 + 4 * 60000000ull, "grid stays anchored at the first job");
+}
+
+static void test_uplink_and_naps() {
+    SampleScheduler s;
+    g_now_us = 0;
+    sched_init(&s, fake_time_us_64);
+    sched_set_interval(&s, 900);
+
+    sched_due(&s);
+    sched_job_begin(&s);
+    check(!sched_uplink_open(&s), "uplink closed during a job");
+    g_now_us += 3000000;
+    sched_job_end(&s);
+    check(sched_uplink_open(&s) && sched_nap_ms(&s, false) == 0, "uplink opens after the job, no naps meanwhile");
+
+    g_now_us += SCHED_UPLINK_MAX_MS * 1000ull - 1;
+    bool still = sched_uplink_open(&s);
+    g_now_us += 1;
+    check(still && !sched_uplink_open(&s) && s.uplink_us == SCHED_UPLINK_MAX_MS * 1000ull,
+          "uplink window closes after SCHED_UPLINK_MAX_MS");
+
+    check(sched_nap_ms(&s, false) == SCHED_NAP_MAX_MS && sched_nap_ms(&s, true) == 0,
+          "idle naps are bounded, none while busy");
+    g_now_us = 900000000 - 40000;
+    check(sched_nap_ms(&s, false) == 40, "nap ends at the next job");
+    g_now_us = 900000000;
+    check(sched_nap_ms(&s, false) == 0 && sched_due(&s), "no nap once the job is due");
+
+    sched_uplink_begin(&s);
+    sched_job_begin(&s);
+    check(!s.uplink && s.uplinks == 2, "a job closes an open reconnect window");
+    sched_job_end(&s);
+}
+
+static void test_records_between_jobs() {
+    SampleScheduler s;
+    g_now_us = 0;
+    sched_init(&s, fake_time_us_64);
+    sched_set_interval(&s, 900);
+    sched_due(&s);
+    sched_job_begin(&s);
+    g_now_us += 3000000;
+    sched_job_end(&s);
+    sched_uplink_done(&s);                      // drained
+
+    g_now_us = 300000000;                       // a commanded run 5 min later logs records
+    check(sched_idle(&s) && !sched_uplink_open(&s), "idle with the window closed between jobs");
+    sched_uplink_begin(&s);
+    check(sched_uplink_open(&s) && sched_nap_ms(&s, false) == 0 && s.uplinks == 2,
+          "records between jobs open a window at once, no naps");
+    sched_uplink_done(&s);
+    check(s.next_due_us == 900000000 && !sched_due(&s), "job grid unchanged");
+}
+
+static void test_off() {
+    SampleScheduler s;
+    g_now_us = 0;
+    sched_init(&s, fake_time_us_64);
+    sched_set_interval(&s, 0);
+    g_now_us += 3600000000ull;
+    check(!sched_due(&s) && sched_uplink_open(&s) && !sched_idle(&s) && sched_nap_ms(&s, false) == 0,
+          "interval 0: no jobs, no naps, uplink always open");
+}
+
+int main(int argc, char** argv) {
+    int jobs = argc > 1 ? atoi(argv[1]) : 96;
+
+    printf("Scheduler contract:\n");
+    test_grid();
+    test_uplink_and_naps();
+    test_records_between_jobs();
+    test_off();
+
+    const uint32_t costs[][2] = {
+        { 6500, 500 },          // summer job, a few records
+        { 6500, 5000 },         // records backed up after an outage
+        { 6500, 45000 },        // more than one window's worth per job
+    };
+    for (const auto& c : costs) {
+        printf("\n");
+        sched_simulate(jobs, 900, c[0], c[1]);
+    }
+
+    if (g_failures) {
+        printf("\n%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * HappyBees DSP Scratch Arena Test
+ *
+ * Checks the SDK's scratch arena for DSP temporaries (ei_dsp_scratch_t and
+ * ei_dsp_scratch_scope in dsp/memory.hpp) on the host:
+ *   - freeing the newest block pops it, a block freed out of order is popped
+ *     with the block above it, and the end of the scope drops the rest
+ *   - nested scopes release in LIFO order: an inner scope on the same arena
+ *     allocates above the outer blocks and rewinds to them, one on another
+ *     arena leaves the outer arena alone and hands it back when it ends
+ *   - a request that does not fit goes to ei_malloc and is counted, and its
+ *     free goes back to ei_free without touching the arena
+ *
+ * Then runs an MFE block (40 filters, FFT 512) and a spectrogram block over
+ * 1 s of noise at 16 kHz through extract_mfe_features() and
+ * extract_spectrogram_features(), without an arena, with a
+ * SCRATCH_ARENA_SIZE arena as run_classifier() opens it
+ * (EIDSP_SCRATCH_ARENA_SIZE) and with a 512 B arena that forces fallbacks.
+ * The output must be bit-identical in all three; it prints the heap calls
+ * per block and the arena's peak. Any failure makes the exit status 1.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -I firmware tools/scratch_arena_test.cpp \
+ *       firmware/edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp \
+ *       firmware/edge-impulse-sdk/dsp/memory.cpp \
+ *       firmware/edge-impulse-sdk/dsp/fft_plans.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp -o scratch_arena_test
+ *   ./scratch_arena_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+
+#ifndef SCRATCH_ARENA_SIZE
+#define SCRATCH_ARENA_SIZE  16384   // the firmware's DSP_SCRATCH_SIZE
+#endif
+#define SAMPLE_RATE         16000
+#define SMALL_ARENA_SIZE    512
+
+using namespace ei;
+
+// Heap calls that reach the porting layer (overrides the weak posix ones)
+static uint32_t g_heap_calls = 0;
+
+void *ei_malloc(size_t size) { g_heap_calls++; return malloc(size); }
+void *ei_calloc(size_t nitems, size_t size) { g_heap_calls++; return calloc(nitems, size); }
+void ei_free(void *ptr) { free(ptr); }
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-60s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) g_failures++;
+}
+
+static bool in_arena(const ei_dsp_scratch_t* arena, const void* p) {
+    return (const uint8_t*)p >= arena->base && (const uint8_t*)p < arena->base + arena->size;
+}
+
+static void check_lifo() {
+    printf("Bump and pop:\n");
+    static uint8_t buf[1024] __attribute__((aligned(8)));
+    ei_dsp_scratch_t arena;
+    ei_dsp_scratch_init(&arena, buf, sizeof(buf));
+    {
+        ei_dsp_scratch_scope scope(&arena);
+        void* a = ei_dsp_malloc(100);
+        size_t after_a = arena.used;
+        void* b = ei_dsp_malloc(200);
+        check(in_arena(&arena, a) && in_arena(&arena, b) && (uint8_t*)b > (uint8_t*)a, "blocks come from the arena in order");
+        check(((uintptr_t)a & 7) == 0 && ((uintptr_t)b & 7) == 0, "blocks are 8-byte aligned");
+        ei_dsp_free(b, 200);
+        check(arena.used == after_a, "freeing the newest block pops it");
+        void* c = ei_dsp_malloc(200);
+        check(c == b, "the next block reuses its bytes");
+        ei_dsp_free(a, 100);
+        check(arena.used > after_a, "a block freed out of order stays until the one above goes");
+        ei_dsp_free(c, 200);
+        check(arena.used == 0 && arena.top == 0, "freeing the block above pops both");
+        ei_dsp_malloc(300);
+        check(arena.used > 0, "a block left live at the end of the scope");
+    }
+    check(!arena.active && arena.used == 0 && arena.top == 0, "is dropped when the scope ends");
+    check(arena.allocs == 4 && arena.fallbacks == 0 && arena.scopes == 1, "allocs and scopes are counted");
+    ei_dsp_scratch_current = nullptr;
+}
+
+static void check_nested() {
+    printf("Nested scopes:\n");
+    static uint8_t buf_a[1024] __attribute__((aligned(8)));
+    static uint8_t buf_b[1024] __attribute__((aligned(8)));
+    ei_dsp_scratch_t a, b;
+    ei_dsp_scratch_init(&a, buf_a, sizeof(buf_a));
+    ei_dsp_scratch_init(&b, buf_b, sizeof(buf_b));
+    {
+        ei_dsp_scratch_scope outer(&a);
+        float* kept = (float*)ei_dsp_malloc(64 * sizeof(float));
+        for (int i = 0; i < 64; i++) kept[i] = (float)i;
+        size_t outer_used = a.used, outer_top = a.top;
+        {
+            ei_dsp_scratch_scope inner(&a);
+            void* p = ei_dsp_calloc(128, sizeof(float));
+            check(in_arena(&a, p) && (uint8_t*)p > (uint8_t*)kept, "inner scope on the same arena allocates above the outer block");
+            {
+                ei_dsp_scratch_scope other(&b);
+                void* q = ei_dsp_malloc(256);
+                check(in_arena(&b, q) && a.used > outer_used, "scope on another arena takes over, the outer blocks stay");
+            }
+            check(ei_dsp_scratch_current == &a && !b.active && b.used == 0, "which is released and hands the arena back");
+            void* r = ei_dsp_malloc(32);
+            check(in_arena(&a, r) && (uint8_t*)r > (uint8_t*)p, "allocations continue above the inner block");
+        }
+        check(a.active && a.used == outer_used && a.top == outer_top, "inner scope rewinds to the outer block");
+        bool intact = true;
+        for (int i = 0; i < 64; i++) intact &= kept[i] == (float)i;
+        check(intact, "which still holds its data");
+        void* s = ei_dsp_malloc(16);
+        check((uint8_t*)s == a.base + outer_used + sizeof(ei_dsp_scratch_header_t), "the next outer block goes right above it");
+        ei_dsp_free(s, 16);
+        ei_dsp_free(kept, 64 * sizeof(float));
+        check(a.used == 0 && a.top == 0, "outer blocks pop in LIFO order");
+    }
+    check(!a.active && a.used == 0 && a.scopes == 2 && b.scopes == 1, "outer scope ends with both arenas released");
+    ei_dsp_scratch_current = nullptr;
+}
+
+static void check_fallback() {
+    printf("Heap fallback:\n");
+    static uint8_t buf[256] __attribute__((aligned(8)));
+    ei_dsp_scratch_t arena;
+    ei_dsp_scratch_init(&arena, buf, sizeof(buf));
+
+    uint32_t calls = g_heap_calls;
+    void* outside = ei_dsp_malloc(64);
+    check(outside && !in_arena(&arena, outside) && g_heap_calls == calls + 1, "no scope: ei_dsp_malloc goes to the heap");
+    ei_dsp_free(outside, 64);
+    {
+        ei_dsp_scratch_scope scope(&arena);
+        void* a = ei_dsp_malloc(100);
+        size_t used = arena.used;
+        calls = g_heap_calls;
+        uint8_t* big = (uint8_t*)ei_dsp_malloc(400);
+        check(big && !in_arena(&arena, big) && g_heap_calls == calls + 1, "a request that does not fit goes to ei_malloc");
+        check(arena.fallbacks == 1 && arena.fallback_bytes == 400 && arena.used == used, "and is counted without moving the arena");
+        memset(big, 0xA5, 400);
+        uint8_t* zeroed = (uint8_t*)ei_dsp_calloc(300, 1);
+        bool clear = zeroed && !in_arena(&arena, zeroed);
+        for (int i = 0; clear && i < 300; i++) clear = zeroed[i] == 0;
+        check(clear && arena.fallbacks == 2, "ei_dsp_calloc falls back zeroed");
+        void* fits = ei_dsp_malloc(64);
+        check(in_arena(&arena, fits), "a smaller request still fits in the arena");
+        ei_dsp_free(big, 400);
+        ei_dsp_free(zeroed, 300);
+        check(arena.used > used, "freeing heap blocks leaves the arena alone");
+        ei_dsp_free(fits, 64);
+        ei_dsp_free(a, 100);
+        check(arena.used == 0, "and the arena still pops its own");
+        check(arena.peak <= arena.size && arena.allocs == 2, "peak stays within the buffer");
+    }
+    ei_dsp_scratch_current = nullptr;
+}
+
+// 1 s of deterministic noise, as the microphone would deliver it
+static std::vector<float> g_audio;
+
+static int get_audio(size_t offset, size_t length, float* out) {
+    memcpy(out, g_audio.data() + offset, length * sizeof(float));
+    return 0;
+}
+
+typedef int (*extract_fn)(signal_t*, matrix_t*, void*, const float);
+
+struct BlockRun {
+    std::vector<float> out;
+    uint32_t heap_calls;
+    int ret;
+};
+
+static BlockRun run_block(extract_fn fn, void* config, size_t n_features, ei_dsp_scratch_t* arena) {
+    signal_t signal;
+    signal.total_length = g_audio.size();
+    signal.get_data = &get_audio;
+    BlockRun r;
+    r.out.assign(n_features, 0.0f);
+    matrix_t output(1, n_features, r.out.data());
+    uint32_t calls = g_heap_calls;
+    if (arena) {
+        ei_dsp_scratch_scope scope(arena);
+        r.ret = fn(&signal, &output, config, SAMPLE_RATE);
+    }
+    else {
+        r.ret = fn(&signal, &output, config, SAMPLE_RATE);
+    }
+    r.heap_calls = g_heap_calls - calls;
+    ei_dsp_scratch_current = nullptr;
+    return r;
+}
+
+static void check_block(const char* name, extract_fn fn, void* config, size_t n_features) {
+    static uint8_t full_buf[SCRATCH_ARENA_SIZE] __attribute__((aligned(8)));
+    static uint8_t small_buf[SMALL_ARENA_SIZE] __attribute__((aligned(8)));
+    ei_dsp_scratch_t full, small;
+    ei_dsp_scratch_init(&full, full_buf, sizeof(full_buf));
+    ei_dsp_scratch_init(&small, small_buf, sizeof(small_buf));
+
+    BlockRun heap = run_block(fn, config, n_features, nullptr);
+    BlockRun arena = run_block(fn, config, n_features, &full);
+    BlockRun tight = run_block(fn, config, n_features, &small);
+
+    printf("%s (%zu features):\n", name, n_features);
+    printf("    heap calls: %u without an arena, %u with %u B (peak %u B), %u with %u B (%u fallbacks)\n",
+           (unsigned)heap.heap_calls, (unsigned)arena.heap_calls, (unsigned)SCRATCH_ARENA_SIZE,
+           (unsigned)full.peak, (unsigned)tight.heap_calls, (unsigned)SMALL_ARENA_SIZE, (unsigned)small.fallbacks);
+    check(heap.ret == 0 && arena.ret == 0 && tight.ret == 0, "extraction succeeds in all three");
+    check(heap.out == arena.out, "arena output is bit-identical to the heap's");
+    check(heap.out == tight.out, "so is the output with fallbacks");
+    check(arena.heap_calls == 0 && full.fallbacks == 0, "the arena serves every temporary");
+    check(small.fallbacks > 0 && !small.active && small.used == 0, "the small arena falls back and is released");
+}
+
+static void check_blocks() {
+    g_audio.resize(SAMPLE_RATE);
+    uint32_t x = 12345;
+    for (float& s : g_audio) {
+        x = x * 1664525u + 1013904223u;
+        s = (float)((int32_t)(x >> 16) - 32768) * 0.25f;
+    }
+
+    ei_dsp_config_mfe_t mfe = { 1, 4, 1, nullptr, 0, 0.032f, 0.016f, 40, 512, 0, 0, 101, -72 };
+    check_block("MFE v4, 40 filters, FFT 512", &extract_mfe_features, &mfe,
+                speechpy::feature::calculate_mfe_buffer_size(SAMPLE_RATE, SAMPLE_RATE, mfe.frame_length,
+                    mfe.frame_stride, mfe.num_filters, mfe.implementation_version).rows * mfe.num_filters);
+
+    ei_dsp_config_spectrogram_t spec = { 2, 4, 1, nullptr, 0, 0.032f, 0.016f, 256, -72, false };
+    check_block("Spectrogram v4, FFT 256", &extract_spectrogram_features, &spec,
+                speechpy::feature::calculate_mfe_buffer_size(SAMPLE_RATE, SAMPLE_RATE, spec.frame_length,
+                    spec.frame_stride, spec.fft_length / 2 + 1, spec.implementation_version).rows
+                    * (spec.fft_length / 2 + 1));
+}
+
+int main() {
+    printf("DSP scratch arena, %u B (SCRATCH_ARENA_SIZE)\n\n", (unsigned)SCRATCH_ARENA_SIZE);
+    check_lifo();
+    check_nested();
+    check_fallback();
+    check_blocks();
+    if (g_failures) {
+        printf("\n%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("\nAll checks passed\n");
+    return 0;
+}
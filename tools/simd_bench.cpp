@@ -0,0 +1,178 @@
+/*
+ * HappyBees Host SIMD Benchmark
+ *
+ * Runs the SDK's numpy statistics and matrix helpers at every level of
+ * dsp/host_simd.hpp this CPU supports: the scalar loops, SSE2 and AVX2 + FMA.
+ * Each helper is called through its usual numpy API, so this is the code the
+ * offline featurization tools run. For every helper and level the table
+ * gives the time per call, the speedup over the scalar loops and the largest
+ * difference from the scalar result, scaled by (1 + |scalar value|). A
+ * difference above --tol fails the run (exit status 1), which makes this the
+ * check to run after touching the kernels.
+ *
+ * The row and axis-0 statistics run on one rows x cols matrix (default
+ * 32 x 2048, offset from zero so the centered moments matter); dot multiplies
+ * a 99 x 257 matrix by a 257 x 40 one, the shape of an MFE filterbank on
+ * 512-point frames.
+ *
+ * Build and run (from the repository root):
+ *   g++ -O2 -std=c++17 -I firmware tools/simd_bench.cpp \
+ *       firmware/edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp \
+ *       firmware/edge-impulse-sdk/dsp/memory.cpp \
+ *       firmware/edge-impulse-sdk/dsp/fft_plans.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp \
+ *       firmware/edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp -o simd_bench
+ *   ./simd_bench
+ *   ./simd_bench --rows 3 --cols 16000 --tol 1e-4
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+
+#if !EIDSP_HOST_SIMD_ACTIVE
+#error "host SIMD is not active: needs an x86-64 GCC / Clang build with EIDSP_USE_HOST_SIMD=1"
+#endif
+
+#define MIN_BENCH_NS    100e6   // run each variant at least this long
+
+using ei::matrix_t;
+namespace host_simd = ei::host_simd;
+
+struct Op {
+    const char *name;
+    std::function<void(std::vector<float>*)> run;   // output of one call
+};
+
+// Mean time per call of fn(), repeated until MIN_BENCH_NS has passed
+template <typename Fn>
+static double ns_per_call(Fn fn) {
+    uint64_t calls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double ns = 0;
+    do {
+        for (int i = 0; i < 10; i++) fn();
+        calls += 10;
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    } while (ns < MIN_BENCH_NS);
+    return ns / calls;
+}
+
+static double max_diff(const std::vector<float>& a, const std::vector<float>& ref) {
+    double worst = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        worst = fmax(worst, fabs((double)a[i] - ref[i]) / (1.0 + fabs((double)ref[i])));
+    }
+    return worst;
+}
+
+static void fill(std::vector<float>* v, float offset) {
+    for (float& x : *v) {
+        // sum of uniforms, roughly normal, skewed a little by the square
+        float u = 0;
+        for (int k = 0; k < 4; k++) u += (float)rand() / RAND_MAX - 0.5f;
+        x = offset + u + 0.3f * u * u;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t rows = 32, cols = 2048;
+    double tol = 1e-4;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rows") && i + 1 < argc) rows = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cols") && i + 1 < argc) cols = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tol") && i + 1 < argc) tol = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--rows R] [--cols C] [--tol T]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rows == 0 || cols == 0) { fprintf(stderr, "rows and cols must be > 0\n"); return 1; }
+
+    srand(1);
+    std::vector<float> data(rows * cols), work(rows * cols);
+    fill(&data, 3.0f);
+    std::vector<float> a(99 * 257), b(257 * 40);
+    fill(&a, 0.0f);
+    fill(&b, 0.5f);
+
+    matrix_t in(rows, cols, data.data());
+    matrix_t mut(rows, cols, work.data());
+    matrix_t m1(99, 257, a.data());
+    matrix_t m2(257, 40, b.data());
+
+    // out-of-place helpers write a fresh output; in-place ones get a copy of data first
+    auto per_row = [&](int (*fn)(matrix_t*, matrix_t*)) {
+        return [&, fn](std::vector<float>* out) {
+            out->resize(rows);
+            matrix_t o(rows, 1, out->data());
+            fn(&in, &o);
+        };
+    };
+    auto per_col = [&](int (*fn)(matrix_t*, matrix_t*)) {
+        return [&, fn](std::vector<float>* out) {
+            out->resize(cols);
+            matrix_t o(cols, 1, out->data());
+            fn(&in, &o);
+        };
+    };
+    std::vector<Op> ops = {
+        { "sum", [&](std::vector<float>* out) { out->assign(1, ei::numpy::sum(data.data(), data.size())); } },
+        { "scale", [&](std::vector<float>* out) { work = data; ei::numpy::scale(&mut, 0.37f); *out = work; } },
+        { "add", [&](std::vector<float>* out) { work = data; ei::numpy::add(&mut, -2.5f); *out = work; } },
+        { "dot", [&](std::vector<float>* out) {
+            out->resize(99 * 40);
+            matrix_t o(99, 40, out->data());
+            ei::numpy::dot(&m1, &m2, &o);
+        } },
+        { "rms", per_row(ei::numpy::rms) },
+        { "mean", per_row(ei::numpy::mean) },
+        { "stdev", per_row(ei::numpy::stdev) },
+        { "skew", per_row(ei::numpy::skew) },
+        { "kurtosis", per_row(ei::numpy::kurtosis) },
+        { "mean_axis0", per_col(ei::numpy::mean_axis0) },
+        { "std_axis0", per_col(ei::numpy::std_axis0) },
+    };
+
+    const int top = host_simd::get_level();
+    printf("%u x %u matrix, best level on this CPU: %s\n\n", rows, cols, host_simd::level_name(top));
+    printf("  op           level     us/call   speedup   max diff\n");
+
+    // scale and add time a copy of the matrix too; the copy is timed alone
+    // and subtracted so the column shows the helper itself
+    double copy_ns = ns_per_call([&] { work = data; });
+
+    int failures = 0;
+    for (const Op& op : ops) {
+        std::vector<float> ref, out;
+        double scalar_ns = 0;
+        for (int level = host_simd::LEVEL_NONE; level <= top; level++) {
+            host_simd::set_level(level);
+            op.run(&out);
+            double ns = ns_per_call([&] { op.run(&out); });
+            if (!strcmp(op.name, "scale") || !strcmp(op.name, "add")) ns = fmax(ns - copy_ns, 1.0);
+            if (level == host_simd::LEVEL_NONE) {
+                ref = out;
+                scalar_ns = ns;
+            }
+            double diff = max_diff(out, ref);
+            bool ok = diff <= tol;
+            if (!ok) failures++;
+            printf("  %-12s %-7s %9.2f %8.2fx   %.2g%s\n", op.name, host_simd::level_name(level), ns / 1000.0,
+                   scalar_ns / ns, diff, ok ? "" : "  FAIL");
+        }
+    }
+    host_simd::set_level(top);
+
+    if (failures) {
+        printf("\n%d result(s) differ from the scalar loops by more than %g\n", failures, tol);
+        return 1;
+    }
+    printf("\nall results within %g of the scalar loops\n", tol);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * HappyBees Wake-on-Sound Evaluator
+ *
+ * Replays recorded WAVs through the firmware's wake detector
+ * (firmware/source/wake_detector.h, built unchanged) and reports how often it
+ * would wake the full pipeline and which labelled events it would miss.
+ *
+ * WAVs are 16-bit PCM as written by audio_capture.py. They are point-sampled
+ * down to WAKE_RATE_HZ like the ADC and mapped back to 12-bit counts with
+ * that tool's scaling (int16 = (adc - mean) / 2048 * 32767).
+ *
+ * The optional labels file has one event per line: "file.wav,start_s,end_s"
+ * (file name without directory; lines starting with # are ignored). An event
+ * counts as caught when a trigger falls between its start and end plus
+ * --slack seconds. Triggers outside every event are false wakes.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++17 -I firmware/source tools/wake_eval.cpp -o wake_eval
+ *   ./wake_eval day1.wav day2.wav --labels events.csv
+ *   ./wake_eval day1.wav day2.wav --labels events.csv --sweep 1.5 4 0.25
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "wake_detector.h"
+#include "wav_reader.h"
+
+#define BLOCK_SAMPLES 512   // RING_BLOCK_SAMPLES on the device
+
+struct Event { std::string file; double start, end; };
+
+struct Recording {
+    std::string path, name;
+    std::vector<uint16_t> adc;      // 12-bit counts at WAKE_RATE_HZ
+};
+
+struct Result { double hours; int triggers, false_wakes, events, missed; };
+
+// Converts a recording to ADC counts at WAKE_RATE_HZ, point-sampled like the ADC.
+static bool load_recording(const char* path, Recording* rec) {
+    std::vector<int16_t> pcm;
+    uint32_t rate;
+    if (!wav_read_pcm16(path, &pcm, &rate)) return false;
+    if (rate < WAKE_RATE_HZ) { fprintf(stderr, "%s: %u Hz is below %d Hz\n", path, rate, WAKE_RATE_HZ); return false; }
+    rec->path = path;
+    rec->name = wav_base_name(path);
+    for (double pos = 0; pos < pcm.size(); pos += (double)rate / WAKE_RATE_HZ) rec->adc.push_back(wav_to_adc(pcm[(size_t)pos]));
+    return true;
+}
+
+static std::vector<Event> load_labels(const char* path) {
+    std::vector<Event> out;
+    FILE* f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "%s: cannot open\n", path); exit(1); }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char* a = strtok(line, ","); char* b = strtok(NULL, ","); char* c = strtok(NULL, ",\r\n");
+        if (a && b && c) out.push_back({wav_base_name(a), atof(b), atof(c)});
+    }
+    fclose(f);
+    return out;
+}
+
+// Runs the detector over every recording, each with fresh state as after a boot.
+static Result evaluate(const std::vector<Recording>& recs, const std::vector<Event>& events,
+                       float ratio, double slack, bool verbose) {
+    Result r = {0, 0, 0, 0, 0};
+    for (const Recording& rec : recs) {
+        WakeDetector d;
+        wake_init(&d, ratio);
+        std::vector<double> triggers;
+        for (size_t off = 0; off + BLOCK_SAMPLES <= rec.adc.size(); off += BLOCK_SAMPLES) {
+            if (wake_feed(&d, &rec.adc[off], BLOCK_SAMPLES))
+                triggers.push_back((double)(off + BLOCK_SAMPLES) / WAKE_RATE_HZ);
+        }
+        r.hours += rec.adc.size() / (double)WAKE_RATE_HZ / 3600.0;
+        r.triggers += (int)triggers.size();
+
+        std::vector<bool> explained(triggers.size(), false);
+        for (const Event& e : events) {
+            if (e.file != rec.name) continue;
+            r.events++;
+            bool caught = false;
+            for (size_t i = 0; i < triggers.size(); i++) {
+                if (triggers[i] >= e.start && triggers[i] <= e.end + slack) { caught = true; explained[i] = true; }
+            }
+            if (!caught) {
+                r.missed++;
+                if (verbose) printf("  missed  %s %.1f-%.1f s\n", rec.name.c_str(), e.start, e.end);
+            }
+        }
+        for (size_t i = 0; i < triggers.size(); i++) {
+            if (explained[i]) continue;
+            r.false_wakes++;
+            if (verbose) printf("  false   %s %.1f s\n", rec.name.c_str(), triggers[i]);
+        }
+        if (verbose) printf("  %-32s %6.1f min, %3zu triggers, peak ratio %.2f\n",
+                            rec.name.c_str(), rec.adc.size() / (double)WAKE_RATE_HZ / 60.0, triggers.size(), d.peak_ratio);
+    }
+    return r;
+}
+
+static void print_row(float ratio, const Result& r) {
+    printf("%6.2f %9.1f %10.1f %8d/%-4d %7.1f%%\n", ratio, r.hours ? r.triggers / r.hours : 0.0,
+           r.hours ? r.false_wakes / r.hours : 0.0, r.missed, r.events, r.events ? 100.0 * r.missed / r.events : 0.0);
+}
+
+int main(int argc, char** argv) {
+    std::vector<Recording> recs;
+    std::vector<Event> events;
+    float ratio = WAKE_DEFAULT_RATIO, sweep_lo = 0, sweep_hi = 0, sweep_step = 0;
+    double slack = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--labels") && i + 1 < argc) events = load_labels(argv[++i]);
+        else if (!strcmp(argv[i], "--ratio") && i + 1 < argc) ratio = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--slack") && i + 1 < argc) slack = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--sweep") && i + 3 < argc) {
+            sweep_lo = (float)atof(argv[++i]); sweep_hi = (float)atof(argv[++i]); sweep_step = (float)atof(argv[++i]);
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s file.wav... [--labels events.csv] [--ratio R] [--slack S] [--sweep LO HI STEP]\n", argv[0]);
+            return 1;
+        }
+        else {
+            Recording rec;
+            if (load_recording(argv[i], &rec)) recs.push_back(std::move(rec));
+        }
+    }
+    if (recs.empty()) { fprintf(stderr, "no recordings\n"); return 1; }
+
+    printf("%zu recordings, %zu labelled events, %d Hz, %d-sample blocks\n\n",
+           recs.size(), events.size(), WAKE_RATE_HZ, BLOCK_SAMPLES);
+    if (sweep_step > 0) {
+        printf(" ratio  wakes/h  false/h     missed    miss\n");
+        for (float r = sweep_lo; r <= sweep_hi + 1e-6f; r += sweep_step) print_row(r, evaluate(recs, events, r, slack, false));
+    } else {
+        Result res = evaluate(recs, events, ratio, slack, true);
+        printf("\n ratio  wakes/h  false/h     missed    miss\n");
+        print_row(ratio, res);
+    }
+    return 0;
+}
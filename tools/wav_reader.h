@@ -0,0 +1,89 @@
+/*
+ * wav_reader.h
+ * Minimal 16-bit PCM WAV loader for the host-side firmware evaluators.
+ *
+ * Recordings from audio_capture.py are int16 = (adc - mean) / 2048 * 32767,
+ * so wav_to_adc() maps them back to 12-bit counts around mid-scale for code
+ * that expects raw ADC samples.
+ */
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Opens a 16-bit PCM WAV and leaves it at the start of the sample data.
+// Prints the reason and returns NULL on anything else.
+static FILE* wav_open_pcm16(const char* path, uint16_t* channels, uint32_t* rate_hz, uint32_t* data_bytes) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { fprintf(stderr, "%s: cannot open\n", path); return NULL; }
+    char riff[12];
+    if (fread(riff, 1, 12, f) != 12 || memcmp(riff, "RIFF", 4) || memcmp(riff + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a WAV file\n", path); fclose(f); return NULL;
+    }
+    uint16_t format = 0, bits = 0;
+    *channels = 0; *rate_hz = 0;
+    char id[4]; uint32_t size;
+    while (fread(id, 1, 4, f) == 4 && fread(&size, 4, 1, f) == 1) {
+        if (!memcmp(id, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16) break;
+            memcpy(&format, fmt, 2); memcpy(channels, fmt + 2, 2);
+            memcpy(rate_hz, fmt + 4, 4); memcpy(&bits, fmt + 14, 2);
+            fseek(f, size - 16 + (size & 1), SEEK_CUR);
+        } else if (!memcmp(id, "data", 4)) {
+            if (format != 1 || bits != 16 || !*channels || !*rate_hz) break;
+            *data_bytes = size;
+            return f;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    fprintf(stderr, "%s: need 16-bit PCM (format %u, %u bits)\n", path, format, bits);
+    return NULL;
+}
+
+// Sample rate and length (per channel) of a 16-bit PCM WAV, without reading
+// it. Counts only the samples the file holds, as wav_read_pcm16() returns
+// them: a recording cut short keeps the header's full data size.
+static inline bool wav_info_pcm16(const char* path, uint32_t* rate_hz, size_t* frames) {
+    uint16_t channels; uint32_t bytes;
+    FILE* f = wav_open_pcm16(path, &channels, rate_hz, &bytes);
+    if (!f) return false;
+    long data = ftell(f);
+    long end = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    fclose(f);
+    if (data >= 0 && end >= data && (uint64_t)(end - data) < bytes) bytes = (uint32_t)(end - data);
+    *frames = bytes / 2 / channels;
+    return true;
+}
+
+// Reads the first channel of a 16-bit PCM WAV. Prints the reason and
+// returns false on anything else.
+static bool wav_read_pcm16(const char* path, std::vector<int16_t>* samples, uint32_t* rate_hz) {
+    uint16_t channels; uint32_t bytes;
+    FILE* f = wav_open_pcm16(path, &channels, rate_hz, &bytes);
+    if (!f) return false;
+    std::vector<int16_t> pcm(bytes / 2);
+    pcm.resize(fread(pcm.data(), 2, pcm.size(), f));
+    fclose(f);
+    samples->resize(pcm.size() / channels);
+    for (size_t i = 0; i < samples->size(); i++) (*samples)[i] = pcm[i * channels];
+    return true;
+}
+
+static inline uint16_t wav_to_adc(int16_t s) {
+    int v = s / 16 + 2048;
+    return (uint16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v));
+}
+
+static inline std::string wav_base_name(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+#endif
@@ -1,3 +1,6 @@
+import argparse
+import os
+import sys
 import pandas as pd
 import numpy as np
 import torch
@@ -88,12 +91,36 @@ def get_summer_data():
     return df_clean[feature_names].values.astype(np.float32), df_clean['target'].values.astype(np.longlong), len(feature_names)
 
 
+def get_summer_data_from_store(path):
+    """Features and labels from a feature store (tools/feature_extract.cpp); unlabelled rows are dropped.
+
+    Refuses a store from another feature stage than this checkout's, and one
+    whose temperature, humidity or hour never changes: min-max scaling would
+    turn such a column into zeros and the model would learn to ignore it.
+    """
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'tools'))
+    from feature_store import FeatureStore, bee_features_version
+    store = FeatureStore(path)
+    current = bee_features_version()
+    if store.feature_version != current:
+        raise SystemExit(f"[ERROR] {path} has feature version {store.feature_version}, this checkout computes "
+                         f"{current} (BEE_FEATURES_VERSION); re-extract it with tools/feature_extract")
+    print(f"☀️ Loading Summer Data from {path} ({store.rows} rows, feature version {store.feature_version})...")
+    labelled = store.labels >= 0
+    X = store.features[labelled]
+    constant = [name for name, col in zip(store.feature_names[:3], X[:, :3].T) if len(col) and col.min() == col.max()]
+    if constant:
+        raise SystemExit(f"[ERROR] {path}: {', '.join(constant)} constant over the labelled rows; "
+                         f"extract with --climate for per-capture readings")
+    return X.astype(np.float32), store.labels[labelled].astype(np.longlong), X.shape[1]
+
+
 # ==========================================
 # 4. EXPORT ROUTINE
 # ==========================================
-def bake_and_export():
+def bake_and_export(store=None):
     # --- SUMMER ---
-    X_summer, y_summer, n_feats_summer = get_summer_data()
+    X_summer, y_summer, n_feats_summer = get_summer_data_from_store(store) if store else get_summer_data()
     min_summer = np.percentile(X_summer, 1, axis=0)
     max_summer = np.percentile(X_summer, 99, axis=0)
     X_summer_clipped = np.clip(X_summer, min_summer, max_summer)
@@ -139,4 +166,7 @@ def bake_and_export():
     print("✅ Saved 'summer_bee_smart_v7.onnx'")
 
 if __name__ == "__main__":
-    bake_and_export()
\ No newline at end of file
+    parser = argparse.ArgumentParser(description='Train and export the summer model')
+    parser.add_argument('--store', help='feature store (.bfs) to train on instead of D1_sensor_data.csv')
+    args = parser.parse_args()
+    bake_and_export(args.store)
\ No newline at end of file